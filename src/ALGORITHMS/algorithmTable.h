@@ -33,6 +33,7 @@
 /* Switch Algorithm table */
 
 extern void     nullSchedulingAlgorithm();
+extern void     bvn();
 extern void     fifo();
 extern void     future();
 extern void     gs_lqf();
@@ -57,6 +58,8 @@ extern void     mcast_random();
 extern void     mcast_tatra();
 extern void     mcast_wt_fanout();
 extern void     mcast_wt_residue();
+extern void     merge_lqf();
+extern void     merge_ocf();
 extern void     mucf();
 extern void     neural();
 extern void     opf();
@@ -66,6 +69,7 @@ extern void     pri_lqf();
 extern void     pri_mcast_random();
 extern void     pri_ocf();
 extern void     pri_islip();
+extern void     pri_strict();
 extern void     pri_combo();
 extern void     pristrict_lqf();
 extern void     pristrict_ocf();
@@ -75,6 +79,7 @@ extern void     wwfa();
 
 FunctionTable algorithmTable[] = {
 	{"null",    "Null algorithm. Does nothing",   (void *) nullSchedulingAlgorithm},
+    {"bvn",     "Birkhoff-von Neumann frame built from measured rates", (void *) bvn},
     {"fifo",    "Random FIFO. Single FIFO per input",    (void *) fifo},
     {"future", "Extension to Karol/Eng/Obara Recycle Algorithm, also includes multiple iterations", (void *) future},
     {"gs_lqf", "Gale-Shapley Algorithm. Weight = occupancy", (void *) gs_lqf},
@@ -86,9 +91,9 @@ FunctionTable algorithmTable[] = {
     {"lpf",     "Maximum, using Matthew J. Saltzman's code. Weight = port occupancy", (void *) lpf},
     {"lpf_delay", "Maximum, using Matthew J. Saltzman's code. Weight = port occupancy", (void *) lpf_delay},
     {"lqf", "Maximum, using Matthew J. Saltzman's code. Weight = occupancy", (void *) lqf},
-    {"maximum", "Tom Anderson's depth-first-search algorithm", (void *) maximum},
-    {"maxrand", "Maximum, with randomization of choice", (void *) maxrand},
-    {"maxsize", "Maximum, using Matthew J. Saltzman's code", (void *) maxsize},
+    {"maximum", "Maximum size, Hopcroft-Karp warm started from last match", (void *) maximum},
+    {"maxrand", "Maximum size, Hopcroft-Karp with randomization of choice", (void *) maxrand},
+    {"maxsize", "Maximum size, Hopcroft-Karp with seeded randomization", (void *) maxsize},
     {"mcast_conc_residue", "Multicast:concentrate residue", (void *) mcast_conc_residue},
     {"mcast_dist_residue", "Multicast:distribute residue", (void *) mcast_dist_residue},
     {"mcast_random", "Multicast: random assignment", (void *) mcast_random},
@@ -96,6 +101,8 @@ FunctionTable algorithmTable[] = {
     {"mcast_tatra", "Multicast: Tatra, Balaji, McKeown and Ahuja", (void *) mcast_tatra},
     {"mcast_wt_fanout", "Multicast: Weights for fanout", (void *) mcast_wt_fanout},
     {"mcast_wt_residue", "Multicast: Weights for residue", (void *) mcast_wt_residue},
+    {"merge_lqf", "Random permutation merged into last match. Weight = occupancy", (void *) merge_lqf},
+    {"merge_ocf", "Random permutation merged into last match. Weight = celltime", (void *) merge_ocf},
     {"mucf", "Iterative most urgent cell first (smallest cushion)", (void *) mucf},
     {"neural",  "Mustafa Mehmet Ali's neural net: Globecom 89", (void *) neural},
     {"ocf", "Maximum, using Matthew J. Saltzman's code. Weight = celltime", (void *) ocf},
@@ -108,8 +115,9 @@ FunctionTable algorithmTable[] = {
     {"pri_ocf", "Maximum with priorities, using Matthew J. Saltzman's code. Weight = celltime", (void *) pri_ocf},
     {"pri_islip", "islip with \"strict\" priorities", (void *) pri_islip},
     {"pri_combo", "pri_fifo with pri_mcast_random", (void *) pri_combo},
-    {"pristrict_lqf", "Maximum with strict priorities, using Matthew J. Saltzman's code. Weight = occupancy", (void *) pristrict_lqf},
-    {"pristrict_ocf", "Maximum, with strict priorities, using Matthew J. Saltzman's code. Weight = celltime", (void *) pristrict_ocf},
+    {"pri_strict", "Strict priorities over any unicast algorithm", (void *) pri_strict},
+    {"pristrict_lqf", "lqf with strict priorities (pri_strict lqf)", (void *) pristrict_lqf},
+    {"pristrict_ocf", "ocf with strict priorities (pri_strict ocf)", (void *) pristrict_ocf},
     {"rr",      "A Basic round robin algorithm",    (void *) rr},
   	{"islip", "Slip to avoid starvation", (void *) islip},
     {"wwfa", "Wrapped Wavefront Arbitrator", (void *) wwfa},
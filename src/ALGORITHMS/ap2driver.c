@@ -61,40 +61,23 @@
 #include <stdio.h> 
 #include <stdlib.h>
 #include "assign2.h"
+#include "sim.h"
+#include "miscfns.h"
 int **
-ap2driver(n, graph)
-  int n;
+ap2driver(ws, graph)
+  Ap2Workspace *ws;
 int **graph;
 {
-
-  static int   *ccost, **cost;
-  static int   *idual, *jdual;
-  static int    *assn;
-  int    z, i,j;
+  int   n = ws->n;
+  int   *assn = ws->assn;
+  int    z, i;
 
   int    printflag = 0;
 
-  if( !ccost )
-    {
-      ccost = (int *) malloc(n * n * sizeof(int));
-      cost = (int **) malloc(n * sizeof(int *));
-      idual = (int *) malloc(n * sizeof(int));
-      jdual = (int *) malloc(n * sizeof(int));
-      assn = (int *) malloc(n * sizeof(int));
-    }
-
-  for ( cost[0] = ccost, i = 1;  i < n;  i++ )
-    cost[i] = cost[i - 1] + n;
-
-  for ( i = 0;  i < n;  i++ )
-    for ( j = 0;  j < n;  j++ )
-      {
-	/* Modify graph 1<->0 */
-	/* cost[i][j] = graph[i][j]==0 ? 1:0;*/
-	cost[i][j] = -1*graph[i][j];
-      }
+  /* Maximum weight is minimum cost */
+  matrixNegate(ws->cost, graph, n, n);
 
-  z = assign2(ccost, assn, idual, jdual, &n, &n);
+  z = assign2(ws->ccost, assn, ws->idual, ws->jdual, &n, &ws->stride);
 
   if ( printflag ) {
     printf("assignment\n");
@@ -102,42 +85,34 @@ int **graph;
       printf("%d ", assn[i] + 1);
     printf("\nidual\n");
     for (i = 0;  i < n;  i++)
-      printf("%d ", idual[i]);
+      printf("%d ", ws->idual[i]);
     printf("\njdual\n");
     for (i = 0;  i < n;  i++)
-      printf("%d ", jdual[i]);
+      printf("%d ", ws->jdual[i]);
     printf("\n");
   }
 
-  return(assign2graph(n, graph, assn));
+  return(assign2graph(n, graph, assn, ws->match));
 
 }
 
 int **
-assign2graph(n, graph, assn)
+assign2graph(n, graph, assn, match)
   int n;
 int **graph;
 int *assn;
+int **match;
 {
-  static int **match=NULL;
   int i,j;
 
-  if(!match)
-    {
-      match = (int **) malloc( n * sizeof(int *) );
-      for(i=0; i<n; i++)
-	match[i] = (int *) malloc( n * sizeof(int) );
-    }
-
   /* Fill in match array from assn  */
+  matrixClear(match, n, n);
   for(i=0; i<n; i++)
-    for(j=0; j<n; j++)
-      {
-	if( (assn[i]==j) && (graph[i][j]) )
-	  match[i][j] = 1;
-	else
-	  match[i][j] = 0;
-      }
+    {
+      j = assn[i];
+      if( (j >= 0) && (j < n) && (graph[i][j]) )
+	match[i][j] = 1;
+    }
 	
   return(match);
 }
@@ -43,6 +43,9 @@
 **--
 **/
 
+#ifndef _ASSIGN2_H_
+#define _ASSIGN2_H_
+
 /*
 **
 **  INCLUDE FILES
@@ -72,7 +75,22 @@
 #define CLOCKS_PER_SEC 1000000
 #endif
 
+/*
+**  Workspace for ap2driver(): the cost matrix, duals and assignment for
+**  an n x n problem.  Each caller owns one, see layoutAp2Workspace().
+*/
+typedef struct {
+  int	n;
+  int	stride;		/* Row length of ccost, padded to cache lines */
+  int	*ccost, **cost;
+  int	*idual, *jdual;
+  int	*assn;
+  int	**match;
+} Ap2Workspace;
+
 int **assign2graph();
 int **ap2driver();
 int assign2();
 
+#endif /* _ASSIGN2_H_ */
+
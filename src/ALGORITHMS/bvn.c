@@ -0,0 +1,490 @@
+/* ****************************************************************
+ * Copyright Stanford University 1998,99 - All Rights Reserved
+ ****************************************************************** 
+
+ * Permission to use, copy, modify, and distribute this software 
+ * and its documentation for any purpose is hereby granted without 
+ * fee, provided that the above copyright notice appears in all copies
+ * and that both the copyright notice, this permission notice, and 
+ * the following disclaimer appear in supporting documentation, and 
+ * that the name of Stanford University, not be used in advertising or 
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.
+ * 
+ * STANFORD UNIVERSITY, DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND 
+ * FITNESS. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE FOR ANY 
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER 
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION 
+ * OF CONTRACT, NEGLIGENCE OR OTHER ACTION, ARISING OUT OF OR IN 
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * The Sim Web Site : http://klamath.stanford.edu/tools/SIM
+ * The SIM Mailing List: sim-simulator@lists.stanford.edu
+
+ * Send mail to the above email address with "subscribe sim-simulator" in
+ * the body of the message.
+ *
+ */
+
+
+#include <string.h>
+#include "sim.h"
+#include "algorithm.h"
+#include "miscfns.h"
+#include "hopcroftKarp.h"
+
+extern void FatalError(char*);
+
+/*
+  Birkhoff-von Neumann frame scheduling (Chang, Chen and Huang,
+  "Birkhoff-von Neumann input buffered crossbar switches", Infocom 2000).
+
+  The rate matrix is measured over a window of cell times: arrivals to
+  each VOQ are the cells scheduled from it during the window plus its
+  growth. The rates are scaled to a frame of F cell times, rounded to
+  whole cells, and the spare capacity of each input and output is filled
+  in so that every row and column adds up to F. That matrix is the sum
+  of at most F weighted permutations (Birkhoff-von Neumann), found with
+  the Hopcroft-Karp engine one perfect matching at a time. Each
+  permutation is then replayed for as many cell times as its weight, one
+  after the other, frame after frame. A permutation whose VOQ is empty
+  leaves that output idle.
+
+  At the end of each window the new rates are compared with those of
+  the frame being replayed, and the frame is only rebuilt when some
+  input or output's rates have moved by more than the drift threshold
+  (the sum over its VOQs of the absolute change). Scheduling a cell
+  time costs O(N); measuring costs O(N^2) once per window.
+
+  Until the first window has been measured, the frame is that of
+  uniform traffic.
+
+  A switch with more inputs than outputs (or vice versa) is padded out
+  to a square one with ports that have no traffic.
+*/
+
+#define DEFAULT_WINDOW_PER_PORT 100
+#define DEFAULT_FRAME_PER_PORT 8
+#define DEFAULT_DRIFT 0.2
+
+typedef struct {
+  int n;		/* Ports on each side of the square rate matrix */
+  int window;		/* Cell times over which rates are measured */
+  int frameLength;	/* F: cell times in a frame */
+  double drift;		/* Change in a port's rates that rebuilds the frame */
+
+  /* Measurement of the current window */
+  long windowStart;	/* Cell time at which the window started */
+  int **departures;	/* Cells scheduled from each VOQ this window */
+  int **startLength;	/* Length of each VOQ when the window started */
+
+  double **rate;	/* Rates the current frame was built for */
+  double **newRate;	/* Rates measured over the last window */
+  double *lineChange;	/* Change in rates of each input, then output */
+
+  /* Building a frame */
+  int **frame;		/* Cells per frame [input][output] */
+  int *rowSlack;	/* Cells still to be given to each input */
+  int *colSlack;	/* Cells still to be given to each output */
+  HopcroftKarp *hk;
+
+  /* The frame: permutation[p*n+output] is the input connected to */
+  /* output during the weight[p] cell times of permutation p.     */
+  int maxPermutations;
+  int numPermutations;
+  int *permutation;
+  int *weight;
+  int current;		/* Permutation being replayed */
+  int remaining;	/* Cell times left in it */
+
+  long numFrames;	/* Frames built so far */
+  long totalPermutations;	/* Permutations in all of them */
+} BvnState;
+
+static BvnState *createBvnState();
+static void layoutBvnState();
+static void measureRates();
+static void buildFrame();
+static void fillFrame();
+static void decomposeFrame();
+
+
+void
+bvn(action, aSwitch, argc, argv)
+  SwitchAction action;
+Switch *aSwitch;
+int argc;
+char **argv;
+{
+  BvnState *state;
+  int input, output, fabricOutput, *permutation;
+  struct List *fifo;
+
+  if(debug_algorithm)
+    printf("Algorithm 'bvn()' called by switch %d\n", aSwitch->switchNumber);
+	
+  switch(action) {
+  case SCHEDULING_USAGE:
+    fprintf(stderr, "Options for \"bvn\" scheduling algorithm:\n");
+    fprintf(stderr, "    -w window over which rates are measured. Default: %d x number of ports\n", DEFAULT_WINDOW_PER_PORT);
+    fprintf(stderr, "    -f frame length. Default: %d x number of ports\n", DEFAULT_FRAME_PER_PORT);
+    fprintf(stderr, "    -d drift in a port's rates that rebuilds the frame. Default: %g\n", DEFAULT_DRIFT);
+    break;
+  case SCHEDULING_INIT:	
+    if(debug_algorithm) printf("	SCHEDULING_INIT\n");
+			
+    if( aSwitch->scheduler.schedulingState == NULL )
+      {
+	extern int opterr;
+	extern int optopt;
+	extern int optind;
+	extern char *optarg;
+	int c, n;
+	int window = NONE, frameLength = NONE;
+	double drift = DEFAULT_DRIFT;
+
+	n = aSwitch->numInputs;
+	if( aSwitch->numOutputs > n )
+	  n = aSwitch->numOutputs;
+
+	opterr=0;
+	optind=1;
+	while( (c = getopt(argc, argv, "w:f:d:")) != EOF)
+	  switch (c)
+	    {
+	    case 'w':
+	      window = atoi(optarg);
+	      break;
+	    case 'f':
+	      frameLength = atoi(optarg);
+	      break;
+	    case 'd':
+	      drift = atof(optarg);
+	      break;
+	    case '?':
+	      fprintf(stderr, "-------------------------------\n");
+	      fprintf(stderr, "bvn: Unrecognized option -%c\n", optopt);
+	      bvn(SCHEDULING_USAGE);
+	      fprintf(stderr, "--------------------------------\n");
+	      exit(1);
+	    default:
+	      break;
+	    }
+	if( window == NONE )
+	  window = DEFAULT_WINDOW_PER_PORT * n;
+	if( frameLength == NONE )
+	  frameLength = DEFAULT_FRAME_PER_PORT * n;
+	if( window < 1 || frameLength < 1 )
+	  FatalError("bvn: window and frame length must be positive");
+
+	state = createBvnState(n, window, frameLength);
+	state->drift = drift;
+	aSwitch->scheduler.schedulingState = state;
+
+	/* Start with the frame for uniform traffic. */
+	for(input=0; input<n; input++)
+	  for(output=0; output<n; output++)
+	    state->rate[input][output] = 1.0/n;
+	buildFrame(state);
+
+	printf("Window %d Frame %d Drift %g\n", window, frameLength, drift);
+      }
+    break;
+
+  case SCHEDULING_EXEC:
+    if(debug_algorithm) printf("	SCHEDULING_EXEC\n");
+
+    state = (BvnState *) aSwitch->scheduler.schedulingState;
+    if( now - state->windowStart >= state->window )
+      measureRates(aSwitch, state);
+
+    /* Replay the current permutation. */
+    permutation = &state->permutation[state->current * state->n];
+    for(output=0; output<aSwitch->numOutputs; output++)
+      {
+	input = permutation[output];
+	if( input >= aSwitch->numInputs )
+	  continue;
+	fifo = aSwitch->inputBuffer[input]->fifo[output];
+	if( fifo->number )
+	  {
+	    fabricOutput = output * aSwitch->fabric.Xbar_numOutputLines;
+	    aSwitch->fabric.Xbar_matrix[fabricOutput].input = input;
+	    aSwitch->fabric.Xbar_matrix[fabricOutput].cell = 
+	      (Cell *) fifo->head->Object;
+	    state->departures[input][output]++;
+	  }
+      }
+    if( --state->remaining == 0 )
+      {
+	state->current = (state->current + 1) % state->numPermutations;
+	state->remaining = state->weight[state->current];
+      }
+    break;
+
+  case SCHEDULING_REPORT_STATS:
+    state = (BvnState *) aSwitch->scheduler.schedulingState;
+    printf("bvn: %ld frames built, %.1f permutations per frame\n",
+	   state->numFrames, 
+	   (double) state->totalPermutations / state->numFrames);
+    break;
+
+  default:
+    break;
+  }
+
+  if(debug_algorithm)
+    printf("Algorithm 'bvn()' completed for switch %d\n", aSwitch->switchNumber);
+}
+
+/***********************************************************************/
+/* At the end of a window: estimate each VOQ's arrival rate and rebuild */
+/* the frame if some input or output has drifted far enough.            */
+static void
+measureRates(aSwitch, state)
+  Switch *aSwitch;
+BvnState *state;
+{
+  int input, output, length, n = state->n;
+  long elapsed = now - state->windowStart;
+  double change, maxChange = 0.0;
+  double **swap;
+
+  memset(state->lineChange, 0, 2 * n * sizeof(double));
+  for(input=0; input<n; input++)
+    for(output=0; output<n; output++)
+      {
+	if( input < aSwitch->numInputs && output < aSwitch->numOutputs )
+	  length = aSwitch->inputBuffer[input]->fifo[output]->number;
+	else
+	  length = 0;
+	state->newRate[input][output] = (double)
+	  (state->departures[input][output] + length 
+	   - state->startLength[input][output]) / elapsed;
+	state->startLength[input][output] = length;
+	state->departures[input][output] = 0;
+
+	change = state->newRate[input][output] - state->rate[input][output];
+	if( change < 0 )
+	  change = -change;
+	state->lineChange[input] += change;
+	state->lineChange[n + output] += change;
+      }
+  for(input=0; input<2*n; input++)
+    if( state->lineChange[input] > maxChange )
+      maxChange = state->lineChange[input];
+
+  if(debug_algorithm)
+    printf("bvn: rates drifted by %f at time %ld\n", maxChange, now);
+
+  /* The first frame was only a guess: always replace it. */
+  if( maxChange > state->drift || state->numFrames == 1 )
+    {
+      swap = state->rate;
+      state->rate = state->newRate;
+      state->newRate = swap;
+      buildFrame(state);
+    }
+  state->windowStart = now;
+}
+
+/***********************************************************************/
+/* Scale rate[][] to a frame, complete it and decompose it.             */
+static void
+buildFrame(state)
+  BvnState *state;
+{
+  int input, output, n = state->n, F = state->frameLength;
+  double sum, maxLine = 0.0, scale;
+
+  /* Largest total rate through any input or output. */
+  for(input=0; input<n; input++)
+    {
+      sum = 0.0;
+      for(output=0; output<n; output++)
+	sum += state->rate[input][output];
+      if( sum > maxLine )
+	maxLine = sum;
+    }
+  for(output=0; output<n; output++)
+    {
+      sum = 0.0;
+      for(input=0; input<n; input++)
+	sum += state->rate[input][output];
+      if( sum > maxLine )
+	maxLine = sum;
+    }
+
+  /* An overloaded port gets the whole frame; the rest keep their rates. */
+  scale = F;
+  if( maxLine > 1.0 )
+    scale = F / maxLine;
+
+  for(input=0; input<n; input++)
+    state->rowSlack[input] = F;
+  for(output=0; output<n; output++)
+    state->colSlack[output] = F;
+  for(input=0; input<n; input++)
+    for(output=0; output<n; output++)
+      {
+	state->frame[input][output] = 
+	  (int) (state->rate[input][output] * scale);
+	state->rowSlack[input] -= state->frame[input][output];
+	state->colSlack[output] -= state->frame[input][output];
+      }
+
+  fillFrame(state, scale);
+  decomposeFrame(state);
+
+  state->numFrames++;
+  state->totalPermutations += state->numPermutations;
+}
+
+/* 
+   Hand out the cells left over by rounding down so that every row and
+   column adds up to F: first one more cell to each VOQ whose rate was
+   rounded down, then (north-west corner rule) the rest, to VOQs with
+   traffic before any others.
+*/
+static void
+fillFrame(state, scale)
+  BvnState *state;
+double scale;
+{
+  int input, output, pass, cells, n = state->n;
+  double exact;
+
+  for(input=0; input<n; input++)
+    for(output=0; output<n; output++)
+      {
+	exact = state->rate[input][output] * scale;
+	if( state->rowSlack[input] > 0 && state->colSlack[output] > 0 &&
+	    exact > state->frame[input][output] )
+	  {
+	    state->frame[input][output]++;
+	    state->rowSlack[input]--;
+	    state->colSlack[output]--;
+	  }
+      }
+
+  for(pass=0; pass<2; pass++)
+    for(input=0; input<n; input++)
+      for(output=0; output<n && state->rowSlack[input] > 0; output++)
+	{
+	  if( pass == 0 && state->rate[input][output] <= 0.0 )
+	    continue;
+	  cells = state->rowSlack[input];
+	  if( state->colSlack[output] < cells )
+	    cells = state->colSlack[output];
+	  if( cells <= 0 )
+	    continue;
+	  state->frame[input][output] += cells;
+	  state->rowSlack[input] -= cells;
+	  state->colSlack[output] -= cells;
+	}
+}
+
+/*
+   Every row and column of frame[][] adds up to F, so its non-zero
+   entries hold a perfect matching (Hall's theorem). Take it for as many
+   cell times as its smallest entry, subtract, and repeat: each round
+   empties at least one entry. The matcher is warm started from the
+   last permutation, so each round only repairs the edges just removed.
+*/
+static void
+decomposeFrame(state)
+  BvnState *state;
+{
+  int input, output, cells, left, n = state->n;
+  int *permutation;
+  HopcroftKarp *hk = state->hk;
+
+  hopcroftKarpClearRequests(hk);
+  for(input=0; input<n; input++)
+    for(output=0; output<n; output++)
+      if( state->frame[input][output] )
+	hopcroftKarpAddRequest(hk, input, output);
+
+  state->numPermutations = 0;
+  for(left=state->frameLength; left > 0; left -= cells)
+    {
+      if( hopcroftKarpMatch(hk) != n || 
+	  state->numPermutations == state->maxPermutations )
+	FatalError("bvn: frame has no perfect matching");
+
+      permutation = &state->permutation[state->numPermutations * n];
+      cells = left;
+      for(input=0; input<n; input++)
+	{
+	  output = hk->match[input];
+	  permutation[output] = input;
+	  if( state->frame[input][output] < cells )
+	    cells = state->frame[input][output];
+	}
+      for(input=0; input<n; input++)
+	{
+	  output = hk->match[input];
+	  state->frame[input][output] -= cells;
+	  if( state->frame[input][output] == 0 )
+	    hopcroftKarpRemoveRequest(hk, input, output);
+	}
+      state->weight[state->numPermutations++] = cells;
+    }
+
+  state->current = 0;
+  state->remaining = state->weight[0];
+}
+
+/***********************************************************************/
+static void
+layoutBvnState(block, state, n, maxPermutations)
+  ScratchBlock *block;
+BvnState *state;
+int n, maxPermutations;
+{
+  state->departures = scratchGraph(block, n, n);
+  state->startLength = scratchGraph(block, n, n);
+  state->frame = scratchGraph(block, n, n);
+  state->rate = scratchDoubleGraph(block, n, n);
+  state->newRate = scratchDoubleGraph(block, n, n);
+  state->lineChange = scratchDoubles(block, 2*n);
+  state->rowSlack = scratchInts(block, n);
+  state->colSlack = scratchInts(block, n);
+  state->permutation = scratchInts(block, maxPermutations * n);
+  state->weight = scratchInts(block, maxPermutations);
+}
+
+static BvnState *
+createBvnState(n, window, frameLength)
+  int n, window, frameLength;
+{
+  BvnState *state = (BvnState *) malloc(sizeof(BvnState));
+  ScratchBlock block;
+  int pass;
+
+  memset(state, 0, sizeof(BvnState));
+  state->n = n;
+  state->window = window;
+  state->frameLength = frameLength;
+  state->windowStart = now;
+
+  /* Each permutation takes at least one cell time of the frame and */
+  /* empties at least one entry of it.                              */
+  state->maxPermutations = n*n - 2*n + 2;
+  if( state->maxPermutations > frameLength || n < 2 )
+    state->maxPermutations = frameLength;
+
+  scratchBegin(&block);
+  for(pass=0; pass<2; pass++)
+    {
+      if( pass )
+	scratchAllocate(&block);
+      layoutBvnState(&block, state, n, state->maxPermutations);
+    }
+  state->hk = createHopcroftKarp(n, n);
+  return(state);
+}
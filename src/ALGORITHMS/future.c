@@ -39,7 +39,13 @@ static InputSchedulerState *createInScheduler();
 static OutputSchedulerState *createOutScheduler();
 static void createScheduleState();
 static long nextScheduledTime();
-static struct TimeEntry *createTimeEntry();
+static int pickRecycled();
+static void removeRecycled();
+static void growWheel();
+static void rewheelBitset();
+
+/* Smallest calendar, in cell times */
+#define MIN_WHEEL_SIZE 64
 
 /*  Determines switch configuration 					*/
 /*  Configuration is filled into aSwitch->fabric.interconnect.matrix array 	*/
@@ -50,13 +56,13 @@ static struct TimeEntry *createTimeEntry();
 
 	foreach input
 		foreach output
-			if new cell arrived, add a copy to toBeScheduledList[output]
-			if(!empty) remove element from toBeScheduledList[output]
+			if new cell arrived, count it pending for output
+			if(pending) take one cell pending for output
 				Get scheduled time from output scheduler and
 					return recycled slot from previous cycle
-				Find location of scheduled time in timeList. 
-				If location used, set as recyclable.
-				else place in timeList.
+				If time already reserved in the calendar,
+					set as recyclable and leave pending.
+				else reserve it.
 		end
 	end
 
@@ -66,6 +72,14 @@ static struct TimeEntry *createTimeEntry();
 	Else, return next time free.
 	If given recycled slot, add to recycleList.
 
+	A recycled time is free for any input but the one that returned
+	it; the first returned goes first. With -E, the earliest recycled
+	time not reserved at the input goes instead, or, once recycleList
+	is full, the earliest of all.
+
+	Each input's calendar is a bitset, so reserving, checking for a
+	clash and sending are single bit operations that do not grow with
+	the times reserved.
 */
 
 
@@ -88,6 +102,7 @@ char **argv;
     fprintf(stderr, "Options for \"future\" scheduling algorithm:\n");
     fprintf(stderr, "    -N num_iterations.   Default: 1\n");
     fprintf(stderr, "    -M recycle_list_max. Default: 1\n");
+    fprintf(stderr, "    -E recycle the earliest time free at the input\n");
     break;
   case SCHEDULING_INIT:	
     if(debug_algorithm)
@@ -108,12 +123,17 @@ char **argv;
 	createScheduleState(aSwitch);
 	scheduleState = ( SchedulerState * ) aSwitch->scheduler.schedulingState;
 	scheduleState->numIterations=1;
+	scheduleState->earliestFree=0;
+	scheduleState->lastExec=NONE;
 
 	opterr=0;
 	optind=1;
-	while( (c = getopt(argc, argv, "M:N:")) != EOF )
+	while( (c = getopt(argc, argv, "EM:N:")) != EOF )
 	  switch (c)
 	    {
+	    case 'E':
+	      scheduleState->earliestFree = 1;
+	      break;
 	    case 'M':
 	      recycleListMax = atol(optarg);
 	      break;
@@ -133,6 +153,8 @@ char **argv;
 
 	printf("numIterations  %d\n", scheduleState->numIterations);
 	printf("recycleListMax %d\n", recycleListMax);
+	if( scheduleState->earliestFree )
+	  printf("Recycling the earliest time free at the input\n");
 
 
 	/* Set the max length of recycleList */
@@ -141,6 +163,10 @@ char **argv;
 	  {
 	    outputSchedule=scheduleState->outputSched[output];
 	    outputSchedule->recycleListMax = recycleListMax;
+	    outputSchedule->recycledTime = (long *)
+	      malloc( sizeof(long) * (recycleListMax + 1) );
+	    outputSchedule->recycledInput = (int *)
+	      malloc( sizeof(int) * (recycleListMax + 1) );
 	  }
       }
 
@@ -148,21 +174,28 @@ char **argv;
 
   case SCHEDULING_EXEC:
     {
-      int iteration;
+      int iteration, wordIndex, bit;
+      long timeValue;
       InputBuffer  *inputBuffer;
       Cell *aCell;
-      struct TimeEntry *aTimeEntry, *tmpTimeEntry;
-      struct Element *anElement, *tmpElement;
+      BitsetWord word;
 
       scheduleState = (SchedulerState *) aSwitch->scheduler.schedulingState;
 
+      /* A crossbar with speedup calls again for each extra phase. An */
+      /* input only ever reserves one cell time, so the cell time's    */
+      /* reservation went out in the first phase: leave the rest empty */
+      /* rather than count the new arrivals twice.                     */
+      if( scheduleState->lastExec == now )
+	break;
+      scheduleState->lastExec = now;
+
       if(debug_algorithm)
 	{
 	  printf("	CONFIG\n");
 	  printf("    Num iterations: %d\n", scheduleState->numIterations);
 	}
 
-
       for(input=0; input<aSwitch->numInputs; input++)
 	{
 	  inputSchedule = scheduleState->inputSched[input];
@@ -178,105 +211,72 @@ char **argv;
 		    {
 		      if(debug_algorithm)
 			printf("Input %d: New cell arrived for output %d\n", input, output);
-		      aTimeEntry = createTimeEntry();
-		      aTimeEntry->output = output;
-		      anElement = createElement(aTimeEntry);
-		      addElement(inputSchedule->toBeScheduledList[output], anElement);
+		      inputSchedule->numPending[output]++;
+		      BITSET_SET(inputSchedule->pendingOutputs, output);
+		      scheduleState->numPending++;
 		      break;
 		    }
 		}
 	    }
 	}
 
-      for(iteration=0; iteration<scheduleState->numIterations; iteration++)
+      for(iteration=0; iteration<scheduleState->numIterations
+	    && scheduleState->numPending; iteration++)
 	{
 	  for(input=0; input<aSwitch->numInputs; input++)
 	    {
 	      inputSchedule = scheduleState->inputSched[input];
-	      inputBuffer = aSwitch->inputBuffer[input];
 
-	      for(output=0; output<aSwitch->numOutputs; output++)
+	      EVERY_BIT_SET(inputSchedule->pendingOutputs, 
+			    BITSET_NUM_WORDS(aSwitch->numOutputs),
+			    wordIndex, word, output)
 		{
-		  if( inputSchedule->toBeScheduledList[output]->number )
+		  if(debug_algorithm)
 		    {
-		      anElement = removeElement(inputSchedule->toBeScheduledList[output]);
-		      aTimeEntry = (struct TimeEntry *) anElement->Object;
-		      if(debug_algorithm)
-			{
-			  printf("Input %d: Removed timeEntry\n", input);
-			  printf("Scheduling: recycling %d\n", 
-				 inputSchedule->recyclableTimeValue[output]);
-			}
-		      aTimeEntry->timeValue = nextScheduledTime(aSwitch, input, aTimeEntry->output, inputSchedule->recyclableTimeValue[output]);
-		      inputSchedule->recyclableTimeValue[output] = NONE;
+		      printf("Input %d: Removed timeEntry\n", input);
+		      printf("Scheduling: recycling %ld\n", 
+			     inputSchedule->recyclableTimeValue[output]);
+		    }
+		  timeValue = nextScheduledTime(aSwitch, input, output, 
+				    inputSchedule->recyclableTimeValue[output]);
+		  inputSchedule->recyclableTimeValue[output] = NONE;
 
-		      if(debug_algorithm)
-			printf("To be scheduled for time %d\n", aTimeEntry->timeValue);
-
-		      /* Find location in of scheduled timeEntry in timeList */
-						
-		      tmpElement = inputSchedule->timeList->head;
-		      while(tmpElement)
-			{		
-			  tmpTimeEntry=(struct TimeEntry *)tmpElement->Object;
-			  /* List is FIFO. Head is time least in future */
-			  /* If scheduled time is newer than entry, add it
-			     before tmpTimeEntry */
-			  if(aTimeEntry->timeValue < tmpTimeEntry->timeValue)
-			    {
-			      addElementBefore(inputSchedule->timeList, 
-					       tmpElement, anElement );
-			      break;
-			    }
-
-			  /* Clash!!! */
-			  /* Put it back on the toBeScheduledList */
-			  if(aTimeEntry->timeValue==tmpTimeEntry->timeValue)
-			    {
-			      inputSchedule->recyclableTimeValue[output] 
-				= aTimeEntry->timeValue;
-			      addElementAtHead( 
-					       inputSchedule->toBeScheduledList[output], 
-					       (struct Element *) anElement);
-			      break;
-			    }
-			  if( tmpElement == inputSchedule->timeList->tail)
-			    {
-			      addElement(inputSchedule->timeList,anElement);
-			      break;
-			    }
-			  tmpElement= tmpElement->next;
-			}
-		      /* If list is/was empty add this entry to it */
-		      if(!inputSchedule->timeList->number)
-			{
-			  addElement( inputSchedule->timeList, anElement );
-			}
-							
+		  if(debug_algorithm)
+		    printf("To be scheduled for time %ld\n", timeValue);
+
+		  bit = (int) (timeValue & (scheduleState->wheelSize - 1));
+
+		  /* Clash!!! */
+		  /* Leave it pending */
+		  if( BITSET_IS_SET(inputSchedule->reserved, bit) )
+		    {
+		      inputSchedule->recyclableTimeValue[output] = timeValue;
+		      continue;
 		    }
+
+		  BITSET_SET(inputSchedule->reserved, bit);
+		  inputSchedule->reservedOutput[bit] = output;
+		  if( --inputSchedule->numPending[output] == 0 )
+		    BITSET_RESET(inputSchedule->pendingOutputs, output);
+		  scheduleState->numPending--;
 		}
 	    }
 
 	}
 
       /* Configure Switch */
+      bit = (int) (now & (scheduleState->wheelSize - 1));
       for(input=0; input<aSwitch->numInputs; input++)
 	{
-	  /* Check to see if head of input timeList is for now. */
+	  /* Check to see if this input reserved now. */
 	  inputSchedule = scheduleState->inputSched[input];
-	  if( inputSchedule->timeList->number )
+	  if( BITSET_IS_SET(inputSchedule->reserved, bit) )
 	    {
-	      anElement = inputSchedule->timeList->head;
-	      aTimeEntry = ( struct TimeEntry *) anElement->Object;
-	      if( aTimeEntry->timeValue == now )
-		{
-		  removeElement( inputSchedule->timeList );
-		  aSwitch->fabric.Interconnect.Crossbar.Matrix[aTimeEntry->output].input = input;
-		  aSwitch->fabric.Interconnect.Crossbar.Matrix[aTimeEntry->output].cell 
-		  = aSwitch->inputBuffer[input]->fifo[aTimeEntry->output]->head->Object;
-		  destroyElement( anElement );
-		  free(aTimeEntry);
-		}
+	      BITSET_RESET(inputSchedule->reserved, bit);
+	      output = inputSchedule->reservedOutput[bit];
+	      aSwitch->fabric.Interconnect.Crossbar.Matrix[output].input = input;
+	      aSwitch->fabric.Interconnect.Crossbar.Matrix[output].cell 
+		= aSwitch->inputBuffer[input]->fifo[output]->head->Object;
 	    }
 	}
 
@@ -298,76 +298,54 @@ nextScheduledTime(aSwitch, input, output, recyclableTimeValue)
   Switch *aSwitch;
 int input;
 int output;
-int recyclableTimeValue;
+long recyclableTimeValue;
 {
   SchedulerState          *scheduleState=aSwitch->scheduler.schedulingState;
   OutputSchedulerState    *outputSchedule=scheduleState->outputSched[output];
   long returnValue=NONE;
-  struct TimeEntry *aTimeEntry, *recyclableTimeEntry;
-  struct Element *anElement, *nextElement;
-
+  int i;
 
   /* Update nextFreeTime in case t hasn't happened yet */
   if( outputSchedule->nextFreeTime < now )
     outputSchedule->nextFreeTime = now;
 
-  /* Remove any obsolete, unusable timeEntries from recyclable list */
-  anElement = outputSchedule->recycleList->head;
-  while( anElement )
-    {
-      aTimeEntry = (struct TimeEntry *) anElement->Object;
-      if( aTimeEntry->timeValue < now )
-	{
-	  /* Remove and destroy */
-	  nextElement = (struct Element *) anElement->next;
-	  deleteElement( outputSchedule->recycleList, 
-			 (struct Element *) anElement );
-	  destroyElement(anElement);	
-	  if(debug_algorithm)
-	    printf("Output %d: Deleted obsolete time entry for time %d at time %ld\n", output, aTimeEntry->timeValue, now);
-	  free(aTimeEntry);
+  /* Remove any obsolete, unusable times from recycleList */
+  for(i=0; i<outputSchedule->numRecycled; )
+    if( outputSchedule->recycledTime[i] < now )
+      {
+	if(debug_algorithm)
+	  printf("Output %d: Deleted obsolete time entry for time %ld at time %ld\n", output, outputSchedule->recycledTime[i], now);
+	removeRecycled(outputSchedule, i);
+      }
+    else
+      i++;
 
-	  anElement = nextElement;
-	}
-      else
-	anElement = anElement->next;
+  /* If can use a recycled time then do so. Else get the next time */
+  i = pickRecycled(scheduleState, outputSchedule, input);
+  if( i != NONE )
+    {
+      if(debug_algorithm)
+	printf("Returning recycled entry.\n"); 
+      returnValue = outputSchedule->recycledTime[i];
+      removeRecycled(outputSchedule, i);
     }
-
-  /* If can use a recycled time entry then do so. Else get the next time */
-  anElement = outputSchedule->recycleList->head;
-  while( anElement )
+  else
     {
-      aTimeEntry = (struct TimeEntry *) anElement->Object;
-      nextElement = (struct Element *) anElement->next;
-      /* Check that the entry did not come from this input */
-      if( aTimeEntry->input != input )
-	{
-	  deleteElement( outputSchedule->recycleList, anElement );
-	  if(debug_algorithm)
-	    printf("Returning recycled entry.\n"); 
-	  returnValue = aTimeEntry->timeValue;
-	  destroyElement(anElement);
-	  free(aTimeEntry);
-	  break;
-	}
-      anElement = nextElement;
+      returnValue = outputSchedule->nextFreeTime++;
+      while( returnValue - now >= scheduleState->wheelSize )
+	growWheel(aSwitch);
     }
-  if( returnValue == NONE )
-    returnValue = outputSchedule->nextFreeTime++;
 
   if( recyclableTimeValue != NONE )
     {
       /* Add to list if list is not full. Else drop the timeValue */
-      if( outputSchedule->recycleList->number < outputSchedule->recycleListMax )
+      if( outputSchedule->numRecycled < outputSchedule->recycleListMax )
 	{
 	  if(debug_algorithm)
 	    printf("Adding returned recycled entry to list.\n"); 
-	  recyclableTimeEntry = createTimeEntry();
-	  recyclableTimeEntry->timeValue = recyclableTimeValue;
-	  recyclableTimeEntry->output = output;
-	  recyclableTimeEntry->input = input;
-	  anElement = createElement(recyclableTimeEntry);
-	  addElement(outputSchedule->recycleList, anElement);
+	  i = outputSchedule->numRecycled++;
+	  outputSchedule->recycledTime[i] = recyclableTimeValue;
+	  outputSchedule->recycledInput[i] = input;
 	}
       else
 	outputSchedule->droppedRecyclableEntries++;
@@ -376,22 +354,106 @@ int recyclableTimeValue;
   return(returnValue);
 }
 
+/*
+  The place in recycleList of the time to hand input, or NONE.
+  Normally the first not returned by input itself. With -E, the
+  earliest not reserved at input, or if there is none and the list is
+  full, the earliest: input passes it on when it clashes, rather than
+  it blocking the times returned after it.
+*/
+static int
+pickRecycled(scheduleState, outputSchedule, input)
+  SchedulerState *scheduleState;
+OutputSchedulerState *outputSchedule;
+int input;
+{
+  BitsetWord *reserved = scheduleState->inputSched[input]->reserved;
+  long *recycledTime = outputSchedule->recycledTime;
+  int i, best = NONE, earliest = NONE;
 
+  for(i=0; i<outputSchedule->numRecycled; i++)
+    {
+      if( !scheduleState->earliestFree )
+	{
+	  if( outputSchedule->recycledInput[i] != input )
+	    return(i);
+	  continue;
+	}
+      if( earliest == NONE || recycledTime[i] < recycledTime[earliest] )
+	earliest = i;
+      if( !BITSET_IS_SET(reserved, 
+			 recycledTime[i] & (scheduleState->wheelSize - 1))
+	  && (best == NONE || recycledTime[i] < recycledTime[best]) )
+	best = i;
+    }
+  if( best == NONE 
+      && outputSchedule->numRecycled >= outputSchedule->recycleListMax )
+    best = earliest;
+  return(best);
+}
 
-/***********************************************************************/
+/* Take the time at place i out of recycleList, keeping the order */
+static void
+removeRecycled(outputSchedule, i)
+  OutputSchedulerState *outputSchedule;
+int i;
+{
+  for(outputSchedule->numRecycled--; i<outputSchedule->numRecycled; i++)
+    {
+      outputSchedule->recycledTime[i] = outputSchedule->recycledTime[i+1];
+      outputSchedule->recycledInput[i] = outputSchedule->recycledInput[i+1];
+    }
+}
 
-static
-struct TimeEntry *
-createTimeEntry()
+/*
+  Double every calendar. The times held all lie in [now, now +
+  wheelSize), so each moves to its bit in the bigger wheel.
+*/
+static void
+growWheel(aSwitch)
+  Switch *aSwitch;
 {
-  struct TimeEntry *aTimeEntry;
+  SchedulerState *scheduleState=aSwitch->scheduler.schedulingState;
+  InputSchedulerState *inputSchedule;
+  int oldSize = scheduleState->wheelSize, newSize = 2 * oldSize;
+  int input, bit, *reservedOutput;
 
-  aTimeEntry = (struct TimeEntry *) malloc( sizeof(struct TimeEntry) );
+  for(input=0; input<aSwitch->numInputs; input++)
+    {
+      inputSchedule = scheduleState->inputSched[input];
+      reservedOutput = (int *) malloc(newSize * sizeof(int));
+      for(bit=0; bit<oldSize; bit++)
+	if( BITSET_IS_SET(inputSchedule->reserved, bit) )
+	  reservedOutput[(now + ((bit - now) & (oldSize-1))) & (newSize-1)]
+	    = inputSchedule->reservedOutput[bit];
+      free(inputSchedule->reservedOutput);
+      inputSchedule->reservedOutput = reservedOutput;
+      rewheelBitset(&inputSchedule->reserved, oldSize);
+    }
+  scheduleState->wheelSize = newSize;
+  if(debug_algorithm)
+    printf("future: calendars grown to %d times at time %ld\n", newSize, now);
+}
 
-  return(aTimeEntry);
+static void
+rewheelBitset(set, oldSize)
+  BitsetWord **set;
+int oldSize;
+{
+  BitsetWord *newSet = createBitset(2 * oldSize);
+  int bit;
+
+  for(bit=0; bit<oldSize; bit++)
+    if( BITSET_IS_SET(*set, bit) )
+      BITSET_SET(newSet, (now + ((bit - now) & (oldSize-1))) & (2*oldSize-1));
+  destroyBitset(*set);
+  *set = newSet;
 }
 
 
+
+/***********************************************************************/
+
 /* Create schedule state variables for aSwitch */
 static void
 createScheduleState(aSwitch)
@@ -403,6 +465,10 @@ createScheduleState(aSwitch)
   scheduleState = (SchedulerState *) malloc(sizeof(SchedulerState));
   aSwitch->scheduler.schedulingState = scheduleState;
 
+  scheduleState->numPending = 0;
+  scheduleState->wheelSize = MIN_WHEEL_SIZE;
+  while( scheduleState->wheelSize < 2 * aSwitch->numOutputs )
+    scheduleState->wheelSize *= 2;
 	
   scheduleState->inputSched = (InputSchedulerState **) 
     malloc( aSwitch->numInputs * sizeof(InputSchedulerState *) );
@@ -427,15 +493,18 @@ int input;
 
   inputSchedule[input] = (InputSchedulerState *) malloc( sizeof( InputSchedulerState ) );
 
-  inputSchedule[input]->timeList = createList("timeEntryList");
+  inputSchedule[input]->reserved = createBitset(scheduleState->wheelSize);
+  inputSchedule[input]->reservedOutput = (int *)
+    malloc( sizeof(int) * scheduleState->wheelSize );
 	
-  inputSchedule[input]->toBeScheduledList = (struct List **)
-    malloc( sizeof(struct List *) * aSwitch->numOutputs );
-  inputSchedule[input]->recyclableTimeValue = (int *)
+  inputSchedule[input]->numPending = (int *)
     malloc( sizeof(int) * aSwitch->numOutputs );
+  inputSchedule[input]->pendingOutputs = createBitset(aSwitch->numOutputs);
+  inputSchedule[input]->recyclableTimeValue = (long *)
+    malloc( sizeof(long) * aSwitch->numOutputs );
   for(output=0; output<aSwitch->numOutputs; output++)
     {
-      inputSchedule[input]->toBeScheduledList[output] = createList("2beScheduled");
+      inputSchedule[input]->numPending[output] = 0;
       inputSchedule[input]->recyclableTimeValue[output] = NONE;
     }	
 
@@ -455,7 +524,9 @@ int output;
 
   outputSchedule[output]->nextFreeTime = 0;
   outputSchedule[output]->droppedRecyclableEntries = 0;
-  outputSchedule[output]->recycleList = createList("RecycleList");
+  outputSchedule[output]->recycledTime = NULL;
+  outputSchedule[output]->recycledInput = NULL;
+  outputSchedule[output]->numRecycled = 0;
 
   return(outputSchedule[output]);
 }
@@ -31,26 +31,32 @@
  */
 
 
-/* Structures specific to ROUND ROBIN algorithm */
+/* Structures specific to the future algorithm */
 
-struct TimeEntry {
-	int timeValue;			/* The time that this entry is scheduled */
-	int output;				/* The output to which this entry refers */
-	int input;				/* The input from whence it came */
-};
+/*
+  Reservations are kept in calendars: bitsets with one bit per cell
+  time, over a wheel of wheelSize (a power of two) times from now on.
+  Time t is bit t % wheelSize. The wheel grows when a time is handed
+  out beyond its end. Each output keeps its recycled times in the
+  order they were returned, with the input that returned each.
+*/
 
 typedef struct {
-	struct List *timeList;			/* timeList of scheduled times to send */
-	struct List **toBeScheduledList;	/* pointer to one list for each output:
-                                       TimeEntries waiting to be scheduled */
-	int  *recyclableTimeValue; 		/* To be recycled time: one for each o/p */
+	BitsetWord *reserved;		/* Times this input will send at */
+	int  *reservedOutput;		/* ... and to which output, by bit */
+	int  *numPending;		/* Cells waiting for a time: one for */
+					/* each o/p */
+	BitsetWord *pendingOutputs;	/* Outputs with numPending > 0 */
+	long *recyclableTimeValue; 	/* To be recycled time: one for each o/p */
 } InputSchedulerState;
 
 typedef struct {
 	long 	nextFreeTime;
 	long	droppedRecyclableEntries; /* Number that have been dropped */
-	struct List *recycleList;
-	int		recycleListMax;	/* Maximum number of entries in recycle list */
+	long	*recycledTime;		/* Recycled times, oldest returned first */
+	int	*recycledInput;		/* ... and the input that returned each */
+	int	numRecycled;
+	int	recycleListMax;	/* Maximum number of recycled times held */
 } OutputSchedulerState;
 
 typedef struct {
@@ -59,5 +65,8 @@ typedef struct {
 	OutputSchedulerState **outputSched; /* Ptr to array of ptrs to output	*/
 										/* scheduler state. 1 per output.	*/
 	int numIterations;
+	int earliestFree;		/* -E: recycle earliest time free at input */
+	int numPending;			/* Cells waiting for a time, all inputs */
+	int wheelSize;			/* Times covered by each calendar */
+	long lastExec;			/* Cell time last scheduled */
 } SchedulerState;
-
@@ -30,24 +30,18 @@
  *
  */
 
-#include <string.h>
 #include "sim.h"
 #include "algorithm.h"
-#include "assign2.h"
+#include "miscfns.h"
+#include "gsaMatch.h"
 
 
 /*  Determines switch configuration 					*/
 /*  Configuration is filled into aSwitch->fabric.Xbar_matrix array 	*/
-/*  Finds maximum sized match using M Saltzman's code */
+/*  Finds a stable match by Gale-Shapley, outputs proposing to inputs,	*/
+/*  each preferring the longest queue. */
 
-static int **makeGraph();
-static int **shuffleGraph();
-static int **unshuffleGraph();
-static int **makeGraph();
-static void printGraph();
-static void clearGraph();
-extern int **gsaMatch();
-static int **findgsaMatch();
+static int findgsaMatch();
 
 
 void
@@ -70,28 +64,30 @@ char **argv;
     if(debug_algorithm)
       printf("	SCHEDULING_INIT\n");
 
+    /* Working buffers for this switch */
+    if( aSwitch->scheduler.schedulingState == NULL )
+      aSwitch->scheduler.schedulingState = createGsSchedulerState(aSwitch);
     break;
 
   case SCHEDULING_EXEC:
     {
-      int **match, size=0;
+      GsSchedulerState *state =
+	(GsSchedulerState *) aSwitch->scheduler.schedulingState;
+      int size;
       int numFabricOutputs = 
 	aSwitch->numOutputs*aSwitch->fabric.Xbar_numOutputLines;
 
-      match = findgsaMatch(aSwitch);
+      size = findgsaMatch(aSwitch);
 	
       for(output=0; output<numFabricOutputs; output++)
 	{
-	  for(input=0; input<aSwitch->numInputs; input++)
+	  input = state->gsa.fiance[output];
+	  if( input != NONE )
 	    {
-	      if(match[input][output])
-		{
-		  size++;
-		  aSwitch->fabric.Xbar_matrix[output].input = input;
-		  if(input!=NONE)
-		    aSwitch->fabric.Xbar_matrix[output].cell = (Cell *)
-		      aSwitch->inputBuffer[input]->fifo[output]->head->Object;
-		}
+	      aSwitch->fabric.Xbar_matrix[output].input = input;
+	      aSwitch->fabric.Xbar_matrix[output].cell = (Cell *)
+		aSwitch->inputBuffer[input]->fifo[output /
+		  aSwitch->fabric.Xbar_numOutputLines]->head->Object;
 	    }
 	}
       if( debug_algorithm )
@@ -111,202 +107,46 @@ char **argv;
 }
 
 
-static int **
-unshuffleGraph(graph, si, so, n)
-  int **graph;
-int *si, *so;
-int n;
-{
-  int input, output;
-
-  static int **newgraph=NULL;
-  if( !newgraph )
-    newgraph = makeGraph(n);
-
-  /* UnShuffle the graph */
-  for(input=0; input<n; input++)
-    for(output=0; output<n; output++)
-      newgraph[input][output] = graph[si[input]][so[output]];
-
-  return(newgraph);
-}
-static int **
-shuffleGraph(graph, si, so, n)
-  int **graph;
-int *si, *so;
-int n;
-{
-  static unsigned short int mySeed[3];
-  static int init=0;
-
-  int input, output;
-  int selection;
-  static int **newgraph=NULL;
-
-  if( !newgraph )
-    newgraph = makeGraph(n);
-
-  for(input=0; input<n; input++)
-    si[input]=NONE;
-  for(output=0; output<n; output++)
-    so[output]=NONE;
-
-  if(!init)
-    {
-      mySeed[0] = 0x1243;
-      mySeed[1] = 0xab43;
-      mySeed[2] = 0xfc92;
-      init=1;
-    }
-  /* Shuffle set of inputs */
-  for(input=0; input<n; input++)
-    {
-      do {
-	selection = nrand48(mySeed)%n;
-      } while(si[selection] != NONE);
-      si[selection] = input;
-    }
-  /* Shuffle set of outputs */
-  for(output=0; output<n; output++)
-    {
-      do {
-	selection = nrand48(mySeed)%n;
-      } while(so[selection] != NONE);
-      so[selection] = output;
-    }
-
-  /* Shuffle the graph */
-  for(input=0; input<n; input++)
-    for(output=0; output<n; output++)
-      newgraph[si[input]][so[output]] = graph[input][output];
-
-  return(newgraph);
-	
-}
-
 /***********************************************************************/
-static int **
-makeGraph(n)
-  int n;
-{
-  int input;
-  int **graph;
-
-  graph = (int **) malloc(sizeof(int *) * n);
-  for(input=0;input<n; input++)
-    graph[input] = (int *) malloc(sizeof(int)*n);
-
-  return(graph);
-}
-
-static 
-void
-clearGraph(graph, n)
-  int **graph;
-int n;
-{
-  int input;
-  for(input=0;input<n; input++)
-    memset(graph[input], 0, sizeof(int)*n);
-}
-
-static void
-printGraph(graph, aSwitch)
-  int **graph;
-Switch *aSwitch;
-{
-  int input, output, numFabricOutputs;
-
-  numFabricOutputs = aSwitch->numOutputs*aSwitch->fabric.Xbar_numOutputLines;
-  for(input=0;input<aSwitch->numInputs; input++)
-    {
-      for(output=0;output<numFabricOutputs; output++)
-	{
-	  printf("%1d ", graph[input][output]);
-	}
-      printf("\n");
-    }
-}
 
 static
-int **
+int
 findgsaMatch(aSwitch)
   Switch *aSwitch;
 {
-  int input, output, fabricOutput, index;
-
-  static int **graph=NULL;
-  static int *si=NULL;
-  static int *so=NULL;
-  int **match=NULL;
-  int **newgraph;	
-  int weight;
-  int n, numFabricOutputs;
-
-  InputBuffer *inputBuffer;
+  int input, output;
 
-  numFabricOutputs = aSwitch->numOutputs*aSwitch->fabric.Xbar_numOutputLines;
-  n = (numFabricOutputs > aSwitch->numInputs) ? numFabricOutputs : 
-    aSwitch->numInputs;
+  GsSchedulerState *state =
+    (GsSchedulerState *) aSwitch->scheduler.schedulingState;
+  GsaState *gsa = &state->gsa;
+  struct List *fifo;
+  long key;
+  int size;
 
   if(debug_algorithm)
     {
       printf("	SCHEDULING_EXEC\n");
     }
 
-
-  if( !graph )
-    graph = makeGraph(n);
-  if( !si )
-    {
-      si = (int *)malloc(sizeof(int)*n);
-    }
-  if( !so )
-    {
-      so = (int *)malloc(sizeof(int)*n);
-    }
-
-  clearGraph(graph,n);
-
-  /* Fill in request graph */
-  weight=0;
-  for(input=0; input<aSwitch->numInputs; input++)
+  /* Bring each output's preference order up to date: only the */
+  /* queues whose length may have changed are looked at.  */
+  while( (output = nextFifoChange(&state->changes, &input)) != NONE )
     {
-      inputBuffer = aSwitch->inputBuffer[input];
-      for(output=0; output<aSwitch->numOutputs; output++)
-	{
-	  for(index=0,
-		fabricOutput=output*aSwitch->fabric.Xbar_numOutputLines;
-	      index<aSwitch->fabric.Xbar_numOutputLines;
-	      index++, fabricOutput++)
-	    {
-	      graph[input][fabricOutput]=inputBuffer->fifo[output]->number;
-	      weight += inputBuffer->fifo[output]->number;
-	    }
-	}
+      fifo = aSwitch->inputBuffer[input]->fifo[output];
+      key = (long) fifo->number;
+      gsaSetKey(gsa, output, input, key);
     }
-  /* printf(" %d ", weight); */
 
+  size = gsaMatch(gsa);
 
-  if(debug_algorithm) 
-    {
-      printf("Traffic:\n");
-      printGraph(graph, aSwitch);
-    }
-
-  /* RANDOMIZE GRAPH */
-  newgraph = shuffleGraph(graph, si, so, n);
-
-  match = gsaMatch(n, n, n, newgraph);
-	
-  /* UN-RANDOMIZE GRAPH */
-  newgraph = unshuffleGraph(match, si, so, n);
   if(debug_algorithm) 
     {
       printf("Match:\n");
-      printGraph(newgraph, aSwitch);
+      for(output=0; output<gsa->numMen; output++)
+	if( gsa->fiance[output] != NONE )
+	  printf("%d -> %d\n", gsa->fiance[output], output);
       printf("\n");
     }
 
-  return(newgraph);
+  return(size);
 }
@@ -33,257 +33,326 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-struct Person {
-  int index;
-  struct Person **prefList;
-  int prefNext;
-  struct Person *fiance;
-};
-
-int compare();
-static int prefers();
-static void makeManPrefList();
-static void makeWomanPrefList();
-
-int **graph=NULL;  /* Arranged: int[woman][man] */
-
-int **
-gsaMatch(iterations, numMen, numWomen, aGraph)
-  int iterations;
-int numMen,numWomen;
-int **aGraph; /* incoming request graph */
+#include "sim.h"
+#include "miscfns.h"
+#include "gsaMatch.h"
+
+static int tieStart();
+static int tieEnd();
+static void swapPlaces();
+static int nextWoman();
+static void sortTie();
+static int intcompare();
+
+void
+layoutGsaState(ScratchBlock *block, GsaState *state, int numMen, 
+	       int numWomen, int menPerOrder)
 {
-  static int **matchGraph=NULL;
-  static struct Person *Men=NULL, *Women=NULL;
-  struct Person *aMan, *aWoman;
-  int man, woman;
-
-  /************* INITIALIZE ****************/
-  graph = aGraph;
-  if(!matchGraph)
+  int numOrders = numMen / menPerOrder;
+  int o, woman;
+
+  state->numMen = numMen;
+  state->numWomen = numWomen;
+  state->menPerOrder = menPerOrder;
+  state->pref = (PrefOrder *) 
+    scratchCarve(block, sizeof(PrefOrder) * numOrders);
+  for( o=0; o<numOrders; o++)
     {
-      matchGraph = (int **) malloc(sizeof(int *)*numWomen);
-      for(woman=0; woman<numWomen;woman++)
+      int *order = scratchInts(block, numWomen);
+      int *rank = scratchInts(block, numWomen);
+      long *key = (long *) scratchCarve(block, sizeof(long) * numWomen);
+      int *sorted = scratchInts(block, numWomen);
+
+      if( state->pref )
 	{
-	  matchGraph[woman] = (int *) malloc(sizeof(int)*numMen);
+	  state->pref[o].order = order;
+	  state->pref[o].rank = rank;
+	  state->pref[o].key = key;
+	  state->pref[o].sorted = sorted;
+	  /* Every key starts at 0, so any order is sorted */
+	  for( woman=0; woman<numWomen; woman++)
+	    {
+	      order[woman] = rank[woman] = woman;
+	      sorted[woman] = NONE;
+	    }
 	}
     }
-  if(!Men)
+  state->fiance = scratchInts(block, numMen);
+  state->fianceOf = scratchInts(block, numWomen);
+  state->prefNext = scratchInts(block, numMen);
+  state->queue = scratchInts(block, numMen);
+  state->draw = scratchInts(block, numWomen);
+  state->drawn = scratchInts(block, numWomen);
+  state->slot = 0;
+}
+
+GsSchedulerState *
+createGsSchedulerState(Switch *aSwitch)
+{
+  GsSchedulerState *state =
+    (GsSchedulerState *) malloc(sizeof(GsSchedulerState));
+  int lines = aSwitch->fabric.Xbar_numOutputLines;
+  ScratchBlock block;
+  int pass;
+
+  scratchBegin(&block);
+  for(pass=0; pass<2; pass++)
     {
-      Men   = (struct Person *) malloc(sizeof(struct Person) * numMen);
-      for( man=0; man<numMen; man++)
-	{
-	  aMan = &Men[man];
-	  aMan->index = man;
-	  aMan->prefList = (struct Person **) 
-	    malloc(sizeof(struct Person *) * numWomen);
-	}
+      if( pass )
+	scratchAllocate(&block);
+      layoutGsaState(&block, &state->gsa, aSwitch->numOutputs * lines,
+		     aSwitch->numInputs, lines);
+      layoutFifoChanges(&block, &state->changes, aSwitch->numInputs,
+			aSwitch->numOutputs);
     }
 
-  if(!Women)
-    {
-      Women = (struct Person *) malloc(sizeof(struct Person) * numWomen);
-      for( woman=0; woman<numWomen; woman++)
-	{
-	  aWoman = &Women[woman];
-	  aWoman->index = woman;
-	  aWoman->prefList = (struct Person **) 
-	    malloc(sizeof(struct Person * ) * numMen);
+  /* The orders start out empty: have them look at every fifo. */
+  noteAllFifosChanged(&state->changes, aSwitch->numInputs);
+  aSwitch->scheduler.fifoChanged = gsFifoChanged;
+  return(state);
+}
 
-	}
+/* The input action's report of a fifo that gained or lost cells */
+void
+gsFifoChanged(Switch *aSwitch, int input, int fifo)
+{
+  GsSchedulerState *state =
+    (GsSchedulerState *) aSwitch->scheduler.schedulingState;
+
+  if( fifo < aSwitch->numOutputs )
+    noteFifoChange(&state->changes, input, fifo);
+}
+
+/*
+ * Give woman a new key in order o and move her to her new place.
+ * Women with equal keys are kept together but in no particular order.
+ * Each tie she passes trades its end member with her, which keeps it
+ * in one piece, so a change of one (as queue lengths make) costs only
+ * a search for the end of one tie.
+ */
+void
+gsaSetKey(GsaState *state, int o, int woman, long key)
+{
+  PrefOrder *p = &state->pref[o];
+  int *order = p->order;
+  long *k = p->key;
+  int n = state->numWomen;
+  int r = p->rank[woman];
+  int start, end;
+
+  if( k[woman] == key )
+    return;
+  k[woman] = key;
+
+  while( r > 0 && k[order[r-1]] < key )
+    {
+      start = tieStart(p, r-1);
+      swapPlaces(p, start, r);
+      r = start;
     }
+  while( r < n-1 && k[order[r+1]] > key )
+    {
+      end = tieEnd(p, r+1, n);
+      swapPlaces(p, r, end);
+      r = end;
+    }
+}
+
+/*
+ * Men-proposing Gale-Shapley over the current orders.  Each slot the
+ * women are drawn in a new random order, the same for every man, and
+ * each man tries the women of a tie in that order; the men start
+ * proposing from a random man.  Only the orders carry over from the
+ * last slot, not the engagements: a man kept engaged may trade up and
+ * leave a woman who has already turned others away, and the match
+ * would no longer be stable.  Each tie a man reaches is sorted by the
+ * draw once per slot, so a proposal costs only a step along his order.
+ * Returns the number of engagements; the match is left in fiance[] and
+ * fianceOf[].
+ */
+int
+gsaMatch(GsaState *state)
+{
+  int numMen = state->numMen, numWomen = state->numWomen;
+  int *fiance = state->fiance, *fianceOf = state->fianceOf;
+  int *queue = state->queue, *draw = state->draw;
+  int head = 0, numQueued = 0, first;
+  int man, woman, other, rival, size = 0;
 
-  for( man=0; man<numMen; man++)
+  /* This slot's draw: a random permutation of the women */
+  for( woman=0; woman<numWomen; woman++)
     {
-      aMan = &Men[man];
-      /* Place women on man's preference list */
-      makeManPrefList(aMan, Women, numWomen);
-      aMan->fiance = NULL;
-      aMan->prefNext = 0;
+      other = (int)(lrand48() % (woman + 1));
+      draw[woman] = draw[other];
+      draw[other] = woman;
+      fianceOf[woman] = NONE;
     }
   for( woman=0; woman<numWomen; woman++)
+    state->drawn[draw[woman]] = woman;
+  state->slot++;
+  first = (int)(lrand48() % numMen);
+  for( man=first; numQueued<numMen; man=(man+1)%numMen)
     {
-      aWoman = &Women[woman];
-      /* Place men on woman's preference list */
-      makeWomanPrefList(aWoman, Men, numMen);
-      aWoman->fiance = NULL;
-      aWoman->prefNext = 0;
+      fiance[man] = NONE;
+      state->prefNext[man] = 0;
+      queue[numQueued++] = man;
     }
-  /************* END INITIALIZE ****************/
 
-  for(;iterations; iterations--)
+  /* Only free men are queued, each at most once */
+  while( numQueued )
     {
-      /* Every free man proposes to next woman on preference list */
-      for( man=0; man<numMen; man++)
+      man = queue[head];
+      head = (head + 1) % numMen;
+      numQueued--;
+
+      woman = nextWoman(state, man);
+      if( woman == NONE )
+	continue;		/* Nobody acceptable left */
+
+      rival = fianceOf[woman];
+      if( rival == NONE 
+	 || gsaKey(state, rival / state->menPerOrder, woman)
+	    < gsaKey(state, man / state->menPerOrder, woman) )
 	{
-	  aMan = &Men[man];
-	
-	  if( !aMan->fiance )
+	  if( rival == NONE )
+	    size++;
+	  else
 	    {
-	      aWoman = aMan->prefList[aMan->prefNext++];
-	      /* Ignore unacceptable partners */
-	      if( graph[aWoman->index][man] == 0 )
-		continue;
-	      if( !aWoman->fiance )
-		{
-		  aWoman->fiance = aMan;
-		  aMan->fiance = aWoman;
-		}
-	      else if( prefers(aWoman, aMan) )
-		{
-		  aWoman->fiance->fiance = NULL;
-		  aWoman->fiance = aMan;
-		  aMan->fiance = aWoman;
-		}
-	      else
-		{
-		}
+	      fiance[rival] = NONE;
+	      queue[(head + numQueued++) % numMen] = rival;
 	    }
+	  fiance[man] = woman;
+	  fianceOf[woman] = man;
 	}
+      else
+	queue[(head + numQueued++) % numMen] = man;
     }
-  for(man=0; man<numMen; man++)
-    for(woman=0; woman<numWomen; woman++)
-      matchGraph[woman][man] = 0;
-  for(man=0; man<numMen; man++)
-    {
-      if(Men[man].fiance)
-	matchGraph[Men[man].fiance->index][man] = 1;
-    }
-  return(matchGraph);
-}
 
-/***********************************************************************/
-
-static struct Person *currentMan; /* Set aMan for compare operation */
+  return(size);
+}
 
-int
-compareWomen(woman1, woman2)
-  struct Person **woman1, **woman2;
+/*
+ * The next woman man should propose to, or NONE once only the
+ * unacceptable are left.  prefNext is the place he has reached; on
+ * reaching a new tie he has it sorted by the draw, if no other man of
+ * his order has already done so this slot.
+ */
+static int
+nextWoman(state, man)
+  GsaState *state;
+int man;
 {
-
-  if( graph[(*woman1)->index][currentMan->index] > 
-      graph[(*woman2)->index][currentMan->index] )
-    return(-1);
-  if( graph[(*woman1)->index][currentMan->index] < 
-      graph[(*woman2)->index][currentMan->index] )
-    return(1);
-  return(0);
+  PrefOrder *p = &state->pref[man / state->menPerOrder];
+  int t = state->prefNext[man];
+  long k;
+
+  if( t >= state->numWomen || (k = p->key[p->order[t]]) == 0 )
+    return(NONE);
+  if( t == 0 || p->key[p->order[t-1]] != k )
+    sortTie(state, p, t);
+  state->prefNext[man] = t + 1;
+  return(p->order[t]);
 }
 
-static void makeManPrefList(aMan, Women, numWomen)
-  struct Person *aMan;
-struct Person *Women;
-int numWomen;
+/* Put the tie starting at place start in this slot's draw order */
+static void
+sortTie(state, p, start)
+  GsaState *state;
+PrefOrder *p;
+int start;
 {
-  int woman;
-
-  for(woman=0; woman<numWomen; woman++)
+  int t, end;
+
+  if( p->sorted[start] == state->slot )
+    return;
+  p->sorted[start] = state->slot;
+  end = tieEnd(p, start, state->numWomen);
+  for( t=start; t<=end; t++ )
+    p->order[t] = state->draw[p->order[t]];
+  qsort(&p->order[start], end - start + 1, sizeof(int), intcompare);
+  for( t=start; t<=end; t++ )
     {
-      aMan->prefList[woman] = &Women[woman];
+      p->order[t] = state->drawn[p->order[t]];
+      p->rank[p->order[t]] = t;
     }
-  currentMan = aMan; /* Set aMan for compare operation */
-  qsort(aMan->prefList, numWomen, sizeof(struct Person *), compareWomen);
-
 }
 
+/***********************************************************************/
 
-static struct Person *currentWoman; /* Set Woman for compare operation */
-
-int
-compareMen(man1, man2)
-  struct Person **man1, **man2;
-{
-
-  if( graph[currentWoman->index][(*man1)->index] > 
-      graph[currentWoman->index][(*man2)->index] )
-    return(-1);
-  if( graph[currentWoman->index][(*man1)->index] < 
-      graph[currentWoman->index][(*man2)->index] )
-    return(1);
-  return(0);
-}
-
-static void makeWomanPrefList(aWoman, Men, numMen)
-  struct Person *aWoman;
-struct Person *Men;
-int numMen;
+/* First place of the tie holding order[r]: gallop up, then bisect */
+static int
+tieStart(p, r)
+  PrefOrder *p;
+int r;
 {
-  int man;
+  long k = p->key[p->order[r]];
+  int lo = -1, hi = r, step;
 
-  for(man=0; man<numMen; man++)
+  for( step=1; hi-step >= 0; step <<= 1 )
     {
-      aWoman->prefList[man] = &Men[man];
+      if( p->key[p->order[hi-step]] != k )
+	{
+	  lo = hi - step;
+	  break;
+	}
+      hi -= step;
     }
-  currentWoman = aWoman; /* Set woman for compare operation */
-  qsort(aWoman->prefList, numMen, sizeof(struct Person *), compareMen);
-
+  while( hi - lo > 1 )
+    {
+      int mid = (lo + hi) / 2;
+      if( p->key[p->order[mid]] == k )
+	hi = mid;
+      else
+	lo = mid;
+    }
+  return(hi);
 }
 
-
+/* Last place of the tie holding order[r], among n */
 static int
-prefers(aWoman, aMan) 
-  struct Person *aWoman, *aMan;
+tieEnd(p, r, n)
+  PrefOrder *p;
+int r, n;
 {
-  int fianceValue, proposerValue;
-
-  fianceValue    = graph[aWoman->index][aWoman->fiance->index];
-  proposerValue   = graph[aWoman->index][aMan->index];
-  if( proposerValue > fianceValue )
-    return(1);
-  else
-    return(0);
-}
+  long k = p->key[p->order[r]];
+  int lo = r, hi = n, step;
 
-/********** TEMP ************/
-
-#ifdef TEST
-static int **makeGraph();
-main(argc, argv)
-  int argc;
-char **argv;
-{
-  int man, woman, num, times;
-  long lrand48();
-
-  num = atoi(argv[1]);
-  times = atoi(argv[2]);
-  graph = makeGraph(num);
-  for(man=0;man<num;man++)
-    for(woman=0;woman<num;woman++)
-      /* graph[woman][man] = (man+1)*(woman+1); */
-      graph[woman][man] = lrand48()%10; 
-
-  printGraph(num);
-  for(;times;times--)
-    gsa(num, num, num);
-  printGraph(num);
-	
+  for( step=1; lo+step < n; step <<= 1 )
+    {
+      if( p->key[p->order[lo+step]] != k )
+	{
+	  hi = lo + step;
+	  break;
+	}
+      lo += step;
+    }
+  while( hi - lo > 1 )
+    {
+      int mid = (lo + hi) / 2;
+      if( p->key[p->order[mid]] == k )
+	lo = mid;
+      else
+	hi = mid;
+    }
+  return(lo);
 }
-static int **
-makeGraph(n)
-  int n;
-{
-  int input;
-  int **graph;
 
-  graph = (int **) malloc(sizeof(int *) * n);
-  for(input=0;input<n; input++)
-    graph[input] = (int *) malloc(sizeof(int)*n);
+static void
+swapPlaces(p, a, b)
+  PrefOrder *p;
+int a, b;
+{
+  int woman = p->order[a];
 
-  return(graph);
+  p->order[a] = p->order[b];
+  p->order[b] = woman;
+  p->rank[p->order[a]] = a;
+  p->rank[woman] = b;
 }
 
-printGraph(n)
-  int n;
+static int
+intcompare(i, j)
+  const void *i, *j;
 {
-  int i,j;
-
-  for(i=0;i<n;i++)
-    {
-      for(j=0;j<n;j++)
-	printf("%1d  ", graph[i][j]);
-      printf("\n");
-    }
-
+  return(*(const int *) i - *(const int *) j);
 }
-#endif
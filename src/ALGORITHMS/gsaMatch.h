@@ -0,0 +1,89 @@
+
+/* ****************************************************************
+ * Copyright Stanford University 1998,99 - All Rights Reserved
+ ****************************************************************** 
+
+ * Permission to use, copy, modify, and distribute this software 
+ * and its documentation for any purpose is hereby granted without 
+ * fee, provided that the above copyright notice appears in all copies
+ * and that both the copyright notice, this permission notice, and 
+ * the following disclaimer appear in supporting documentation, and 
+ * that the name of Stanford University, not be used in advertising or 
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.
+ * 
+ * STANFORD UNIVERSITY, DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND 
+ * FITNESS. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE FOR ANY 
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER 
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION 
+ * OF CONTRACT, NEGLIGENCE OR OTHER ACTION, ARISING OUT OF OR IN 
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * The Sim Web Site : http://klamath.stanford.edu/tools/SIM
+ * The SIM Mailing List: sim-simulator@lists.stanford.edu
+
+ * Send mail to the above email address with "subscribe sim-simulator" in
+ * the body of the message.
+ *
+ */
+
+
+#ifndef _GSAMATCH_H_
+#define _GSAMATCH_H_
+
+/*
+ * Gale-Shapley stable matching between men (fabric outputs, who
+ * propose) and women (inputs), with preferences kept from slot to slot.
+ *
+ * The men of one output share a preference order over the women,
+ * sorted by key, largest first; ties are broken afresh each slot by a
+ * random draw shared by all the men.  A woman prefers the man whose
+ * order gives her the larger key.  Key 0 means the pair is
+ * unacceptable (an empty queue).  gsaSetKey() moves one woman within
+ * one order, so a slot costs only as much as the keys that changed.
+ * The first man of an order to reach a tie in a slot sorts it by the
+ * draw, and the men then walk the order one place per proposal.
+ */
+
+typedef struct {
+  int *order;		/* [numWomen] women, best first */
+  int *rank;		/* [numWomen] each woman's place in order */
+  long *key;		/* [numWomen] each woman's key */
+  int *sorted;		/* [numWomen] slot the tie starting here was */
+			/* last sorted by the draw */
+} PrefOrder;
+
+/* Per-switch state for gsaMatch() */
+typedef struct {
+  int numMen, numWomen;
+  int menPerOrder;	/* Men sharing each order: man/menPerOrder */
+  PrefOrder *pref;	/* [numMen/menPerOrder] */
+  int *fiance;		/* [man] woman he is engaged to, or NONE */
+  int *fianceOf;	/* [woman] man she is engaged to, or NONE */
+  int *prefNext;	/* [man] next place he proposes to */
+  int *queue;		/* [numMen] ring of free men still proposing */
+  int *draw;		/* [woman] her place in this slot's random draw */
+  int *drawn;		/* [place] the woman drawn there */
+  int slot;		/* Count of gsaMatch() calls */
+} GsaState;
+
+#define gsaKey(state, order, woman)	((state)->pref[order].key[woman])
+
+/* Scheduling state of gs_lqf and gs_ocf */
+typedef struct {
+  GsaState gsa;
+  FifoChanges changes;	/* Fifos whose keys may have changed */
+} GsSchedulerState;
+
+void layoutGsaState(ScratchBlock *block, GsaState *state,
+		    int numMen, int numWomen, int menPerOrder);
+GsSchedulerState *createGsSchedulerState(Switch *aSwitch);
+void gsFifoChanged(Switch *aSwitch, int input, int fifo);
+void gsaSetKey(GsaState *state, int order, int woman, long key);
+int gsaMatch(GsaState *state);
+
+#endif /* _GSAMATCH_H_ */
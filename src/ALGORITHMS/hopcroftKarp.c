@@ -0,0 +1,262 @@
+/* ****************************************************************
+ * Copyright Stanford University 1998,99 - All Rights Reserved
+ ****************************************************************** 
+
+ * Permission to use, copy, modify, and distribute this software 
+ * and its documentation for any purpose is hereby granted without 
+ * fee, provided that the above copyright notice appears in all copies
+ * and that both the copyright notice, this permission notice, and 
+ * the following disclaimer appear in supporting documentation, and 
+ * that the name of Stanford University, not be used in advertising or 
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.
+ * 
+ * STANFORD UNIVERSITY, DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND 
+ * FITNESS. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE FOR ANY 
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER 
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION 
+ * OF CONTRACT, NEGLIGENCE OR OTHER ACTION, ARISING OUT OF OR IN 
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * The Sim Web Site : http://klamath.stanford.edu/tools/SIM
+ * The SIM Mailing List: sim-simulator@lists.stanford.edu
+
+ * Send mail to the above email address with "subscribe sim-simulator" in
+ * the body of the message.
+ *
+ */
+
+
+#include <string.h>
+#include "sim.h"
+#include "hopcroftKarp.h"
+
+/*  Maximum size matching engine shared by maximum, maxrand, maxsize */
+/*  and the crossbar's comparison with the maximum size match.       */
+
+#define HK_INFINITY (1<<30)
+
+static int buildLayers();
+static int augment();
+
+HopcroftKarp *
+createHopcroftKarp(numInputs, numOutputs)
+  int numInputs;
+int numOutputs;
+{
+  HopcroftKarp *hk;
+  int input, output;
+
+  hk = (HopcroftKarp *) malloc(sizeof(HopcroftKarp));
+  hk->numInputs = numInputs;
+  hk->numOutputs = numOutputs;
+  hk->numWords = BITSET_NUM_WORDS(numOutputs);
+  hk->adjacency = (BitsetWord *) 
+    malloc(sizeof(BitsetWord) * numInputs * hk->numWords);
+
+  hk->match = (int *) malloc(sizeof(int) * numInputs);
+  hk->inputMatch = (int *) malloc(sizeof(int) * numInputs);
+  hk->outputMatch = (int *) malloc(sizeof(int) * numOutputs);
+  hk->dist = (int *) malloc(sizeof(int) * numInputs);
+  hk->queue = (int *) malloc(sizeof(int) * numInputs);
+
+  hk->inputPerm = (int *) malloc(sizeof(int) * numInputs);
+  hk->inputUnperm = (int *) malloc(sizeof(int) * numInputs);
+  hk->outputPerm = (int *) malloc(sizeof(int) * numOutputs);
+  hk->outputUnperm = (int *) malloc(sizeof(int) * numOutputs);
+
+  for(input=0; input<numInputs; input++)
+    {
+      hk->match[input] = NONE;
+      hk->inputPerm[input] = hk->inputUnperm[input] = input;
+    }
+  for(output=0; output<numOutputs; output++)
+    hk->outputPerm[output] = hk->outputUnperm[output] = output;
+
+  hopcroftKarpClearRequests(hk);
+  return(hk);
+}
+
+/* 
+ * Relabel inputs and outputs with new Fisher-Yates permutations.
+ * Uses nrand48(seed), or lrand48() if seed is NULL.
+ * Must be called before the requests for this slot are added.
+ */
+void
+hopcroftKarpShuffle(hk, seed)
+  HopcroftKarp *hk;
+unsigned short *seed;
+{
+  int i, j, tmp;
+
+  for(i=hk->numInputs-1; i>0; i--)
+    {
+      j = (seed ? nrand48(seed) : lrand48()) % (i+1);
+      tmp = hk->inputUnperm[i];
+      hk->inputUnperm[i] = hk->inputUnperm[j];
+      hk->inputUnperm[j] = tmp;
+    }
+  for(i=0; i<hk->numInputs; i++)
+    hk->inputPerm[hk->inputUnperm[i]] = i;
+
+  for(i=hk->numOutputs-1; i>0; i--)
+    {
+      j = (seed ? nrand48(seed) : lrand48()) % (i+1);
+      tmp = hk->outputUnperm[i];
+      hk->outputUnperm[i] = hk->outputUnperm[j];
+      hk->outputUnperm[j] = tmp;
+    }
+  for(i=0; i<hk->numOutputs; i++)
+    hk->outputPerm[hk->outputUnperm[i]] = i;
+}
+
+void
+hopcroftKarpClearRequests(hk)
+  HopcroftKarp *hk;
+{
+  memset(hk->adjacency, 0, 
+	 sizeof(BitsetWord) * hk->numInputs * hk->numWords);
+}
+
+/* 
+ * Find a maximum size match of the current requests, starting from
+ * whatever part of last slot's match is still requested.
+ * Leaves the result in hk->match[] and returns its size.
+ */
+int
+hopcroftKarpMatch(hk)
+  HopcroftKarp *hk;
+{
+  int input, output, permInput, permOutput;
+  int size=0;
+
+  for(input=0; input<hk->numInputs; input++)
+    hk->inputMatch[input] = NONE;
+  for(output=0; output<hk->numOutputs; output++)
+    hk->outputMatch[output] = NONE;
+
+  /* Warm start: keep last slot's edges that are still requested. */
+  for(input=0; input<hk->numInputs; input++)
+    {
+      if( (output = hk->match[input]) == NONE )
+	continue;
+      permInput = hk->inputPerm[input];
+      permOutput = hk->outputPerm[output];
+      if( BITSET_IS_SET(&hk->adjacency[permInput*hk->numWords], permOutput) )
+	{
+	  hk->inputMatch[permInput] = permOutput;
+	  hk->outputMatch[permOutput] = permInput;
+	}
+    }
+
+  /* Each phase augments along a maximal set of shortest disjoint paths. */
+  while( buildLayers(hk) )
+    {
+      for(permInput=0; permInput<hk->numInputs; permInput++)
+	if( hk->inputMatch[permInput] == NONE )
+	  augment(hk, permInput);
+    }
+
+  for(input=0; input<hk->numInputs; input++)
+    {
+      permOutput = hk->inputMatch[hk->inputPerm[input]];
+      if( permOutput == NONE )
+	hk->match[input] = NONE;
+      else
+	{
+	  hk->match[input] = hk->outputUnperm[permOutput];
+	  size++;
+	}
+    }
+  return(size);
+}
+
+void
+hopcroftKarpPrint(fp, hk)
+  FILE *fp;
+HopcroftKarp *hk;
+{
+  int input;
+
+  for(input=0; input<hk->numInputs; input++)
+    if( hk->match[input] != NONE )
+      fprintf(fp, "%d->%d ", input, hk->match[input]);
+  fprintf(fp, "\n");
+}
+
+/***********************************************************************/
+/* Breadth first search from all free inputs, alternating along */
+/* requested then matched edges. Returns 1 if a free output was reached. */
+static int
+buildLayers(hk)
+  HopcroftKarp *hk;
+{
+  int head=0, tail=0;
+  int input, output, next, wordIndex;
+  BitsetWord word;
+
+  hk->freeDist = HK_INFINITY;
+  for(input=0; input<hk->numInputs; input++)
+    {
+      if( hk->inputMatch[input] == NONE )
+	{
+	  hk->dist[input] = 0;
+	  hk->queue[tail++] = input;
+	}
+      else
+	hk->dist[input] = HK_INFINITY;
+    }
+
+  while( head < tail )
+    {
+      input = hk->queue[head++];
+      if( hk->dist[input] >= hk->freeDist )
+	continue;
+      EVERY_BIT_SET(&hk->adjacency[input*hk->numWords], hk->numWords,
+		    wordIndex, word, output)
+	{
+	  next = hk->outputMatch[output];
+	  if( next == NONE )
+	    {
+	      if( hk->freeDist == HK_INFINITY )
+		hk->freeDist = hk->dist[input] + 1;
+	    }
+	  else if( hk->dist[next] == HK_INFINITY )
+	    {
+	      hk->dist[next] = hk->dist[input] + 1;
+	      hk->queue[tail++] = next;
+	    }
+	}
+    }
+  return( hk->freeDist != HK_INFINITY );
+}
+
+/* Depth first search along the layers built above. */
+static int
+augment(hk, input)
+  HopcroftKarp *hk;
+int input;
+{
+  int output, next, wordIndex;
+  BitsetWord word;
+
+  EVERY_BIT_SET(&hk->adjacency[input*hk->numWords], hk->numWords,
+		wordIndex, word, output)
+    {
+      next = hk->outputMatch[output];
+      if( next == NONE ? 
+	  (hk->freeDist == hk->dist[input] + 1) :
+	  (hk->dist[next] == hk->dist[input] + 1 && augment(hk, next)) )
+	{
+	  hk->inputMatch[input] = output;
+	  hk->outputMatch[output] = input;
+	  return(1);
+	}
+    }
+  hk->dist[input] = HK_INFINITY;
+  return(0);
+}
@@ -0,0 +1,95 @@
+/* ****************************************************************
+ * Copyright Stanford University 1998,99 - All Rights Reserved
+ ****************************************************************** 
+
+ * Permission to use, copy, modify, and distribute this software 
+ * and its documentation for any purpose is hereby granted without 
+ * fee, provided that the above copyright notice appears in all copies
+ * and that both the copyright notice, this permission notice, and 
+ * the following disclaimer appear in supporting documentation, and 
+ * that the name of Stanford University, not be used in advertising or 
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.
+ * 
+ * STANFORD UNIVERSITY, DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND 
+ * FITNESS. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE FOR ANY 
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER 
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION 
+ * OF CONTRACT, NEGLIGENCE OR OTHER ACTION, ARISING OUT OF OR IN 
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * The Sim Web Site : http://klamath.stanford.edu/tools/SIM
+ * The SIM Mailing List: sim-simulator@lists.stanford.edu
+
+ * Send mail to the above email address with "subscribe sim-simulator" in
+ * the body of the message.
+ *
+ */
+
+
+#ifndef _HOPCROFTKARP_H_
+#define _HOPCROFTKARP_H_
+
+/*
+ * Maximum size bipartite matching (Hopcroft and Karp, SIAM J. Comput. 1973)
+ * over per-input adjacency bitsets. Runs in O(E sqrt(N)).
+ *
+ * The matching found in the previous slot is kept and used as the
+ * starting point for the next one: edges that are still requested are
+ * re-matched first, so only the change in the request graph needs to
+ * be augmented.
+ *
+ * Randomized tie-breaking is done by relabelling inputs and outputs with
+ * a fresh Fisher-Yates permutation (hopcroftKarpShuffle()) before the
+ * requests are added.
+ *
+ * Usage, each slot:
+ *   hopcroftKarpShuffle(hk, seed);   (optional)
+ *   hopcroftKarpClearRequests(hk);
+ *   hopcroftKarpAddRequest(hk, input, output); ... 
+ *   (or hopcroftKarpRemoveRequest() to change the last slot's requests)
+ *   size = hopcroftKarpMatch(hk);
+ *   hk->match[input] is now the output matched to input, or NONE.
+ */
+
+typedef struct {
+  int numInputs;
+  int numOutputs;
+  int numWords;		/* Words in each adjacency row */
+  BitsetWord *adjacency;/* numInputs rows of requests, in permuted labels */
+
+  int *match;		/* Result: output matched to each input, or NONE */
+
+  /* Working state, all in permuted labels. */
+  int *inputMatch;	/* Output matched to each input, or NONE */
+  int *outputMatch;	/* Input matched to each output, or NONE */
+  int *dist;		/* BFS layer of each input */
+  int *queue;		/* BFS queue of inputs */
+  int freeDist;		/* Length of shortest augmenting path this phase */
+
+  /* Relabelling used for randomized tie-breaking. */
+  int *inputPerm;	/* Permuted label of each input */
+  int *outputPerm;	/* Permuted label of each output */
+  int *inputUnperm;	/* Input with each permuted label */
+  int *outputUnperm;	/* Output with each permuted label */
+} HopcroftKarp;
+
+extern HopcroftKarp *createHopcroftKarp(int numInputs, int numOutputs);
+extern void hopcroftKarpShuffle(HopcroftKarp *hk, unsigned short *seed);
+extern void hopcroftKarpClearRequests(HopcroftKarp *hk);
+extern int hopcroftKarpMatch(HopcroftKarp *hk);
+extern void hopcroftKarpPrint(FILE *fp, HopcroftKarp *hk);
+
+#define hopcroftKarpAddRequest(hk, input, output) \
+  BITSET_SET(&(hk)->adjacency[(hk)->inputPerm[input]*(hk)->numWords], \
+	     (hk)->outputPerm[output])
+
+#define hopcroftKarpRemoveRequest(hk, input, output) \
+  BITSET_RESET(&(hk)->adjacency[(hk)->inputPerm[input]*(hk)->numWords], \
+	       (hk)->outputPerm[output])
+
+#endif
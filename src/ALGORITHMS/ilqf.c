@@ -33,12 +33,16 @@
 
 #include "sim.h"
 #include "algorithm.h"
+#include "miscfns.h"
+#include "tournament.h"
 #include "ilqf.h"
 #include "scheduleStats.h"
 
 static int selectGrant();
 static int selectAccept();
+static int retireMatched();
 static void createScheduleState();
+static void queueChanged();
 static InputSchedulerState *createInScheduler();
 static OutputSchedulerState *createOutScheduler();
 
@@ -143,22 +147,32 @@ char **argv;
 	  outputSchedule->grant=NONE;
 	}
 
-      /* Check for newly arrived cells at head of input queues. */
-      for(input=0; input<aSwitch->numInputs; input++)
-	for(output=0; output<aSwitch->numOutputs; output++)
-	  {
-	    fifo = aSwitch->inputBuffer[input]->fifo[output];
-	    if( fifo->number )
-	      {
-		aCell = fifo->head->Object;
-		scheduleCellStats(SCHEDULE_CELL_STATS_HEAD_ARRIVAL,
-				  aSwitch, aCell);
-	      }
-	  }
+      scheduleState->numMatched = 0;
+
+      /* Bring the grant tournaments up to date with the fifos whose */
+      /* cells changed, and note newly arrived cells at their heads.  */
+      while( (output = nextFifoChange(&scheduleState->changes, &input))
+	     != NONE )
+	{
+	  long key = TOURNAMENT_EMPTY;
+
+	  fifo = aSwitch->inputBuffer[input]->fifo[output];
+	  if( fifo->number )
+	    {
+	      aCell = fifo->head->Object;
+	      scheduleCellStats(SCHEDULE_CELL_STATS_HEAD_ARRIVAL,
+				aSwitch, aCell);
+	      key = (long) fifo->number;
+	    }
+	  tournamentSet(&scheduleState->grantTree[output], input, key);
+	}
       /************* END INITIALIZE ****************/
 
       for(iteration=0; iteration<scheduleState->numIterations; iteration++)
 	{
+	  for(input=0; input<aSwitch->numInputs; input++)
+	    scheduleState->numGranted[input] = 0;
+
 	  for(output=0; output<aSwitch->numOutputs; output++)
 	    {
 
@@ -172,6 +186,8 @@ char **argv;
 		{
 		  outputSchedule = scheduleState->outputSched[output];
 		  outputSchedule->grant = input;
+		  scheduleState->granted[input]
+		    [scheduleState->numGranted[input]++] = output;
 		}
 	    }
 	
@@ -185,6 +201,7 @@ char **argv;
 		outputSchedule = scheduleState->outputSched[output];
 		inputSchedule->accept = output;
 		outputSchedule->accept = input;
+		scheduleState->numMatched++;
 	      }
 	    }
 	}
@@ -198,6 +215,17 @@ char **argv;
 	      aSwitch->inputBuffer[input]->fifo[output]->head->Object;
 	}
 
+      /* Put the retired inputs back for the next slot */
+      while( scheduleState->numRetired > 0 )
+	{
+	  int k = --scheduleState->numRetired;
+
+	  tournamentSet(&scheduleState->grantTree[scheduleState->retired[k]
+						  / aSwitch->numInputs],
+			scheduleState->retired[k] % aSwitch->numInputs,
+			scheduleState->retiredKey[k]);
+	}
+
       break;
     }
 
@@ -234,17 +262,14 @@ int output;
   int input;
   SchedulerState	*scheduleState=(SchedulerState *)aSwitch->scheduler.schedulingState;
   OutputSchedulerState *outputSchedule=scheduleState->outputSched[output];
+  Tournament *tree=&scheduleState->grantTree[output];
   InputBuffer  *inputBuffer;
   Cell *aCell;
 
-  int maxQueueOccupancy=0;
-  static int *maxQueue=(int *) NULL;
+  long maxKey;
   int numEqual=0;
   int selection;
 
-  if( maxQueue == (int *) NULL)
-    maxQueue = (int *) malloc( (1+aSwitch->numInputs) * sizeof(int));
-
 	/* Check to see if output has already been accepted by an input from
        an earlier iteration */
   if( outputSchedule->accept != NONE )
@@ -258,39 +283,25 @@ int output;
   /* Pick input with longest queue */
   /*********************************/
 
-  for(input=0; input<aSwitch->numInputs; input++)
-    {
-      inputBuffer = aSwitch->inputBuffer[input];
-      if ( scheduleState->inputSched[input]->accept == NONE )
-	{
-	  if(inputBuffer->fifo[output]->number > maxQueueOccupancy) 
-	    {
-	      numEqual=0;
-	      maxQueue[numEqual] = input;
-	      maxQueueOccupancy = inputBuffer->fifo[output]->number;
-	    }
-	  else if( inputBuffer->fifo[output]->number == maxQueueOccupancy)
-	    {
-	      numEqual++;
-	      maxQueue[numEqual] = input;
-	    }
-	}
-    }
+  /* Inputs matched in an earlier iteration leave as they reach the top */
+  while( scheduleState->numMatched > 0
+	 && tournamentMax(tree) != TOURNAMENT_EMPTY
+	 && retireMatched(aSwitch, output) )
+    ;
+  maxKey = tournamentMax(tree);
+  numEqual = tournamentNumMax(tree) - 1;
 
-  if( maxQueueOccupancy == 0 )
+  if( maxKey == TOURNAMENT_EMPTY )
     {
       if(debug_algorithm)
 	printf("No inputs requested output %d. None granted.\n", output);
       return(NONE);
     }
 
-  if( numEqual == 0 )
-    input = maxQueue[0];
-  else
-    {
-      selection  = (int)lrand48()%(numEqual+1); 
-      input = maxQueue[ selection ];
-    }
+  selection = 0;
+  if( numEqual > 0 )
+    selection  = (int)lrand48()%(numEqual+1); 
+  input = tournamentSelect(tree, selection);
   inputBuffer = aSwitch->inputBuffer[input];
 
 	/* STATS */
@@ -316,37 +327,31 @@ int input;
     */
   SchedulerState	*scheduleState=(SchedulerState *)aSwitch->scheduler.schedulingState;
   InputSchedulerState *inputSchedule=scheduleState->inputSched[input];
-  OutputSchedulerState *outputSchedule;
   InputBuffer  *inputBuffer=aSwitch->inputBuffer[input];
   Cell *aCell;
-  int output;
+  int output, k;
 
-  static int *maxQueue=(int *) NULL;
+  int *maxQueue=scheduleState->maxQueue;
   int maxQueueOccupancy=0;
   int numEqual=0;
 
-  if( maxQueue == (int *) NULL)
-    maxQueue = (int *) malloc( (1+aSwitch->numOutputs) * sizeof(int));
-
   if( inputSchedule->accept != NONE )
     return( NONE );
 
-  for( output=0; output<aSwitch->numOutputs; output++ )
+  /* The outputs that granted to input, in order */
+  for( k=0; k<scheduleState->numGranted[input]; k++ )
     {
-      outputSchedule = scheduleState->outputSched[output];
-      if( outputSchedule->grant == input )
+      output = scheduleState->granted[input][k];
+      if(inputBuffer->fifo[output]->number > maxQueueOccupancy)
 	{
-	  if(inputBuffer->fifo[output]->number > maxQueueOccupancy)
-	    {
-	      numEqual = 0;
-	      maxQueue[numEqual] = output;
-	      maxQueueOccupancy = inputBuffer->fifo[output]->number;
-	    }
-	  else if(inputBuffer->fifo[output]->number == maxQueueOccupancy)
-	    {
-	      numEqual++;
-	      maxQueue[numEqual] = output;
-	    }
+	  numEqual = 0;
+	  maxQueue[numEqual] = output;
+	  maxQueueOccupancy = inputBuffer->fifo[output]->number;
+	}
+      else if(inputBuffer->fifo[output]->number == maxQueueOccupancy)
+	{
+	  numEqual++;
+	  maxQueue[numEqual] = output;
 	}
     }
 
@@ -380,12 +385,41 @@ int input;
 }
 
 
+/* Takes the matched inputs among those tied at the top of output's   */
+/* grant tree out of it for the rest of the slot; returns how many.    */
+static int
+retireMatched(aSwitch, output)
+  Switch *aSwitch;
+int output;
+{
+  SchedulerState	*scheduleState=(SchedulerState *)aSwitch->scheduler.schedulingState;
+  Tournament *tree=&scheduleState->grantTree[output];
+  int input, rank, k;
+  int numRetired=0;
+
+  /* From the last, so that removing one leaves the ranks below it */
+  for(rank=tournamentNumMax(tree)-1; rank>=0; rank--)
+    {
+      input = tournamentSelect(tree, rank);
+      if( scheduleState->inputSched[input]->accept == NONE )
+	continue;
+      k = scheduleState->numRetired++;
+      scheduleState->retired[k] = output * aSwitch->numInputs + input;
+      scheduleState->retiredKey[k] = tournamentKey(tree, input);
+      tournamentSet(tree, input, TOURNAMENT_EMPTY);
+      numRetired++;
+    }
+  return(numRetired);
+}
+
 /* Create schedule state variables for aSwitch */
 static void 
 createScheduleState(aSwitch)
   Switch *aSwitch;
 {
   SchedulerState *scheduleState;
+  ScratchBlock block;
+  int pass;
 
 
   int input, output;
@@ -403,9 +437,49 @@ createScheduleState(aSwitch)
     malloc( aSwitch->numOutputs * sizeof(OutputSchedulerState *) );
   for(output=0; output<aSwitch->numOutputs; output++)
     scheduleState->outputSched[output] = createOutScheduler(aSwitch, output);
+
+  scheduleState->grantTree = (Tournament *)
+    malloc( aSwitch->numOutputs * sizeof(Tournament) );
+  scratchBegin(&block);
+  for(pass=0; pass<2; pass++)
+    {
+      if( pass )
+	scratchAllocate(&block);
+      scheduleState->maxQueue = scratchInts(&block, 1+((aSwitch->numInputs >
+        aSwitch->numOutputs) ? aSwitch->numInputs : aSwitch->numOutputs));
+      for(output=0; output<aSwitch->numOutputs; output++)
+	layoutTournament(&block, &scheduleState->grantTree[output],
+			 aSwitch->numInputs);
+      scheduleState->granted = 
+	scratchGraph(&block, aSwitch->numInputs, aSwitch->numOutputs);
+      scheduleState->numGranted = scratchInts(&block, aSwitch->numInputs);
+      scheduleState->retired = scratchInts(&block,
+					   aSwitch->numInputs * aSwitch->numOutputs);
+      scheduleState->retiredKey = (long *) scratchCarve(&block,
+	aSwitch->numInputs * aSwitch->numOutputs * sizeof(long));
+      layoutFifoChanges(&block, &scheduleState->changes, aSwitch->numInputs,
+		  aSwitch->numOutputs);
+    }
+
+  /* The trees start out empty: have them look at every fifo. */
+  noteAllFifosChanged(&scheduleState->changes, aSwitch->numInputs);
+  scheduleState->numRetired = 0;
+  aSwitch->scheduler.fifoChanged = queueChanged;
 	
 }
 
+/* The input action's report of a fifo that gained or lost cells */
+static void
+queueChanged(aSwitch, input, fifo)
+  Switch *aSwitch;
+  int input, fifo;
+{
+  SchedulerState *scheduleState=aSwitch->scheduler.schedulingState;
+
+  if( fifo < aSwitch->numOutputs )
+    noteFifoChange(&scheduleState->changes, input, fifo);
+}
+
 static InputSchedulerState *
 createInScheduler(aSwitch, input)
   Switch *aSwitch;
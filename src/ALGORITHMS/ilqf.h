@@ -48,4 +48,16 @@ typedef struct {
 	OutputSchedulerState **outputSched; /* Ptr to array of ptrs to output	*/
 										/* scheduler state. 1 per output.	*/
 	int numIterations;
+	int *maxQueue;		/* Inputs or outputs tied for selection by	*/
+						/* selectGrant() and selectAccept().		*/
+	Tournament *grantTree;	/* One per output, a leaf per input, keyed	*/
+							/* on what selectGrant() looks for.			*/
+	int **granted;		/* [input] outputs granting it this iteration */
+	int *numGranted;	/* [input] number of outputs in granted		*/
+	int numMatched;		/* Inputs matched so far this slot			*/
+	int *retired;		/* Leaves (output*numInputs+input) taken out */
+	long *retiredKey;	/* of the grant trees this slot, and their keys */
+	int numRetired;
+	FifoChanges changes;	/* Fifos whose cells changed since the	*/
+							/* grant trees were last brought up to date	*/
 } SchedulerState;
@@ -34,19 +34,28 @@
 #include <string.h> 
 #include "sim.h"
 #include "algorithm.h"
-#include "assign2.h"
+#include "miscfns.h"
 
 
 /*  Determines switch configuration 					*/
 /*  Configuration is filled into aSwitch->fabric.Xbar_matrix array 	*/
 /*  Finds maximum sized match using M Saltzman's code */
 
-static int **makeGraph();
+/* Working buffers for one switch */
+typedef struct {
+	int **graph;		/* Request graph */
+	int **reordered;	/* graph sorted by row and column sums */
+	int **recovered;	/* Match mapped back to real ports */
+	int **match, **grant;	/* Used by iopf_match() */
+	int *si, *so;		/* Input and output ordering */
+	int *col_sum, *row_sum;	/* Tagged sums, sorted */
+	int *col_sumx, *row_sumx;	/* Untagged sums, for debugging */
+} IopfState;
+
+static IopfState *createIopfState();
 static int **ReorderGraph();
 static int **RecoverGraph();
-static int **makeGraph();
 static int printGraph();
-static int clearGraph();
 static int **findIopfMatch();
 static int **iopf_match();
 static    int intcompare();
@@ -72,6 +81,10 @@ char **argv;
 			if(debug_algorithm)
 				printf("	SCHEDULING_INIT\n");
 
+			/* Working buffers for this switch */
+			if( aSwitch->scheduler.schedulingState == NULL )
+				aSwitch->scheduler.schedulingState =
+					createIopfState(matchGraphSize(aSwitch));
 			break;
 
 		case SCHEDULING_EXEC:
@@ -114,16 +127,14 @@ char **argv;
 
 
 static int **
-RecoverGraph(graph, si, so, n)
+RecoverGraph(state, graph, n)
+IopfState *state;
 int **graph;
-int *si, *so;
 int n;
 {
 	int input, output;
-
-	static int **newgraph=NULL;
-	if( !newgraph )
-		newgraph = makeGraph(n);
+	int *si = state->si, *so = state->so;
+	int **newgraph = state->recovered;
 
 	/* UnShuffle the graph */
 	for(input=0; input<n; input++)
@@ -141,35 +152,19 @@ static    int intcompare(i,j)
 
 
 static int **
-ReorderGraph(graph, si, so, n,aSwitch)
+ReorderGraph(state, graph, n, aSwitch)
+IopfState *state;
 int **graph;
-int *si, *so;
 int n;
 Switch *aSwitch;
 {
 	int input, output, age;
-	static int **newgraph=NULL;
-	static int *col_sum=NULL;
-	static int *row_sum=NULL;
-	static int *col_sumx=NULL;
-	static int *row_sumx=NULL;
+	int *si = state->si, *so = state->so;
+	int **newgraph = state->reordered;
+	int *col_sum = state->col_sum, *row_sum = state->row_sum;
+	int *col_sumx = state->col_sumx, *row_sumx = state->row_sumx;
 	InputBuffer *inputBuffer;
 	Cell *aCell;	
-	if( !newgraph )
-		newgraph = makeGraph(n);
-
-	if( !col_sum )
-	   col_sum = (int *) malloc(sizeof(int) * n);
-
-	if( !row_sum )
-	   row_sum = (int *) malloc(sizeof(int) * n);
-
-	if( !col_sumx )
-	   col_sumx = (int *) malloc(sizeof(int) * n);
-
-	if( !row_sumx )
-	   row_sumx = (int *) malloc(sizeof(int) * n);
-
 	for(input=0; input<n; input++)
 		si[input]=NONE;
 	for(output=0; output<n; output++)
@@ -243,30 +238,32 @@ Switch *aSwitch;
 }
 
 /***********************************************************************/
-static int **
-makeGraph(n)
+static IopfState *
+createIopfState(n)
 int n;
 {
-	int input;
-	int **graph;
+	IopfState *state = (IopfState *) malloc(sizeof(IopfState));
+	ScratchBlock block;
+	int pass;
 
-	graph = (int **) malloc(sizeof(int *) * n);
-	for(input=0;input<n; input++)
-		graph[input] = (int *) malloc(sizeof(int)*n);
-
-	return(graph);
-}
-
-static 
-int 
-clearGraph(graph, n)
-int **graph;
-int n;
-{
-	int input;
-	for(input=0;input<n; input++)
-		memset(graph[input], 0, sizeof(int)*n);
-   return (0);
+	scratchBegin(&block);
+	for(pass=0; pass<2; pass++)
+	{
+		if( pass )
+			scratchAllocate(&block);
+		state->graph = scratchGraph(&block, n, n);
+		state->reordered = scratchGraph(&block, n, n);
+		state->recovered = scratchGraph(&block, n, n);
+		state->match = scratchGraph(&block, n, n);
+		state->grant = scratchGraph(&block, n, n);
+		state->si = scratchInts(&block, n);
+		state->so = scratchInts(&block, n);
+		state->col_sum = scratchInts(&block, n);
+		state->row_sum = scratchInts(&block, n);
+		state->col_sumx = scratchInts(&block, n);
+		state->row_sumx = scratchInts(&block, n);
+	}
+	return(state);
 }
 
 static int
@@ -295,9 +292,8 @@ Switch *aSwitch;
 {
 	int input, output, fabricOutput, index;
 
-	static int **graph=NULL;
-	static int *si=NULL;
-	static int *so=NULL;
+	IopfState *state = (IopfState *) aSwitch->scheduler.schedulingState;
+	int **graph = state->graph;
 	int **match=NULL;
 	int **newgraph;	
 	int size;
@@ -315,18 +311,7 @@ Switch *aSwitch;
 	}
 
 
-	if( !graph )
-		graph = makeGraph(n);
-	if( !si )
-	{
-		si = (int *)malloc(sizeof(int)*n);
-	}
-	if( !so )
-	{
-		so = (int *)malloc(sizeof(int)*n);
-	}
-
-	clearGraph(graph,n);
+	matrixClear(graph, n, n);
 
 	/* Fill in request graph */
 	size=0;
@@ -358,13 +343,13 @@ Switch *aSwitch;
 	}
 
 	/* Reorder the columns */
-	newgraph = ReorderGraph(graph, si, so, n, aSwitch); 
+	newgraph = ReorderGraph(state, graph, n, aSwitch); 
 
-	match = iopf_match(n,newgraph, aSwitch);
+	match = iopf_match(state, n, newgraph);
 
 	/*	newgraph= iopf_match(n,graph, aSwitch);*/
 	/* Reverse the reordering */
-	newgraph = RecoverGraph(match, si, so, n); 
+	newgraph = RecoverGraph(state, match, n); 
 	if(debug_algorithm) 
 	{
 		printf("Iopf Match:\n");
@@ -377,26 +362,20 @@ Switch *aSwitch;
 
 /***********************************************************************/
 static int **
-iopf_match(N, graph, aSwitch)
+iopf_match(state, N, graph)
+IopfState *state;
 int N;
 int **graph;
-Switch *aSwitch;
 {
 
 	int input, output, i, iteration;
-	static int **match=NULL;
-	static int **grant=NULL;
-
-	if( !match )
-	  match = makeGraph(N);
-
-	if( !grant )
-	  grant = makeGraph(N);
+	int **match = state->match;
+	int **grant = state->grant;
 
-	clearGraph(match,N);
+	matrixClear(match, N, N);
 	for(iteration=0;iteration<N; iteration++){
 
-	  clearGraph(grant,N);
+	  matrixClear(grant, N, N);
 
 	  /* grant phase */
 	  for(output=0;output<N; output++){
@@ -408,20 +387,18 @@ Switch *aSwitch;
 		 }
 	  }
 	
-	  /* accept phase */
+	  /* accept phase: the lowest numbered grant */
 	  for(input=0;input<N; input++){
-		 for(output=0;output<N; output++){
-			if (grant[input][output] == 1) {
-			  match[input][output] = 1;
-			  for(i=0;i<N; i++){
-				 graph[i][output] = 0; /* clear all request to matched output */
-			  }
-			  for(i=0;i<N; i++){
-				 graph[input][i] = 0; /* clear all request from matched input */
-			  }
-			  break;
+		 output = matrixRowArgmax(grant[input], N);
+		 if (grant[input][output] == 1) {
+			match[input][output] = 1;
+			for(i=0;i<N; i++){
+			  graph[i][output] = 0; /* clear all request to matched output */
+			}
+			for(i=0;i<N; i++){
+			  graph[input][i] = 0; /* clear all request from matched input */
 			}
-		 }	 
+		 }
 	  }		 
 
 	}
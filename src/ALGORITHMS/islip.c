@@ -37,10 +37,13 @@
 #include "scheduleStats.h"
 #include "miscfns.h"
 
+extern void FatalError(char*);
+
 
 static int selectGrant();
 static int selectAccept();
 static void createScheduleState();
+static void queueChanged();
 static InputSchedulerState *createInScheduler();
 static OutputSchedulerState *createOutScheduler();
 
@@ -74,6 +77,7 @@ char **argv;
   case SCHEDULING_USAGE:
     fprintf(stderr, "Options for \"islip\" scheduling algorithm:\n");
     fprintf(stderr, "    -n number_of_iterations. Default: 1\n");
+    fprintf(stderr, "    -p pipelined: n matches in flight, one iteration each per cell time\n");
     break;
   case SCHEDULING_INIT:	
     if(debug_algorithm) printf("	SCHEDULING_INIT\n");
@@ -84,22 +88,26 @@ char **argv;
 	extern int optopt;
 	extern int optind;
 	extern char *optarg;
-	int c;
+	int c, pipelined=0;
 
 
 	/* Allocate scheduler state for this switch */
 	createScheduleState(aSwitch);
 	scheduleState = (SchedulerState *) aSwitch->scheduler.schedulingState;
 	scheduleState->numIterations=1;
+	scheduleState->pipeline=NULL;
 
 	opterr=0;
 	optind=1;
-	while( (c = getopt(argc, argv, "n:")) != EOF)
+	while( (c = getopt(argc, argv, "n:p")) != EOF)
 	  switch (c)
 	    {
 	    case 'n':
 	      scheduleState->numIterations = atoi(optarg);
 	      break;
+	    case 'p':
+	      pipelined = 1;
+	      break;
 	    case '?':
 	      fprintf(stderr, "-------------------------------\n");
 	      fprintf(stderr, "islip: Unrecognized option -%c\n", optopt);
@@ -115,6 +123,16 @@ char **argv;
 	scheduleCellStats( SCHEDULE_CELL_STATS_INIT, aSwitch );
 
 	printf("numIterations %d\n", scheduleState->numIterations);
+
+	if( pipelined )
+	  {
+	    if( aSwitch->fabric.Xbar_numOutputLines != 1 )
+	      FatalError("islip: -p needs one line per output");
+	    scheduleState->pipeline = createPipelineMatch(aSwitch, 
+		       scheduleState->numIterations, PIPELINE_ROUND_ROBIN);
+	    aSwitch->scheduler.fifoChanged = queueChanged;
+	    printf("Pipelined\n");
+	  }
       }
 
     break;
@@ -164,6 +182,15 @@ char **argv;
 	      }
 	  }
 
+      /* Pipelined: the matchings in flight keep their own pointers. */
+      if( scheduleState->pipeline )
+	{
+	  pipelineMatchExec(aSwitch, scheduleState->pipeline);
+	  scheduleStats(SCHEDULE_STATS_NUM_ITERATIONS, aSwitch,
+			&scheduleState->numIterations);
+	  break;
+	}
+
       /* Calculate and update synchronization stats */
       countSynch(aSwitch);
       /***************  END INITIALIZE ***************/
@@ -233,6 +260,13 @@ char **argv;
     }
 
   case SCHEDULING_REPORT_STATS:
+    scheduleState=(SchedulerState *)aSwitch->scheduler.schedulingState;
+    if( scheduleState->pipeline )
+      {
+	/* No synchronization or per cell grant stats when pipelined */
+	scheduleStats( SCHEDULE_STATS_PRINT_NUM_ITERATIONS, aSwitch );
+	break;
+      }
     scheduleStats( SCHEDULE_STATS_PRINT_ALL, aSwitch );
     scheduleCellStats( SCHEDULE_CELL_STATS_PRINT_ALL, aSwitch );
     break;
@@ -537,6 +571,18 @@ int input;
 }
 
 
+/* The input action's report of a fifo that gained or lost cells, */
+/* followed only when pipelined                                   */
+static void
+queueChanged(aSwitch, input, fifo)
+  Switch *aSwitch;
+int input, fifo;
+{
+  SchedulerState *scheduleState=aSwitch->scheduler.schedulingState;
+
+  pipelineMatchFifoChanged(aSwitch, scheduleState->pipeline, input, fifo);
+}
+
 /* Create schedule state variables for aSwitch */
 static void
 createScheduleState(aSwitch)
@@ -35,16 +35,23 @@
 #include "sim.h"
 #include "algorithm.h"
 #include "assign2.h"
+#include "miscfns.h"
 
 
 /*  Determines switch configuration 					*/
 /*  Configuration is filled into aSwitch->fabric.Xbar_matrix array 	*/
 /*  Finds maximum sized match using M Saltzman's code */
 
-static int **makeGraph();
-static int **makeGraph();
+/* Working buffers for one switch */
+typedef struct {
+	int **graph;		/* Request weights */
+	int **occupancy;	/* Queue occupancies, for debugging */
+	int *col_sum, *row_sum;	/* Column and row sums of the weights */
+	Ap2Workspace ap2;
+} LpfState;
+
+static LpfState *createLpfState();
 static int printGraph();
-static int clearGraph();
 static int **findMaxWeightMatch();
 
 
@@ -68,6 +75,10 @@ char **argv;
 			if(debug_algorithm)
 				printf("	SCHEDULING_INIT\n");
 
+			/* Working buffers for this switch */
+			if( aSwitch->scheduler.schedulingState == NULL )
+				aSwitch->scheduler.schedulingState =
+					createLpfState(matchGraphSize(aSwitch));
 			break;
 
 		case SCHEDULING_EXEC:
@@ -110,32 +121,6 @@ char **argv;
 
 
 /***********************************************************************/
-static int **
-makeGraph(n)
-int n;
-{
-	int input;
-	int **graph;
-
-	graph = (int **) malloc(sizeof(int *) * n);
-	for(input=0;input<n; input++)
-		graph[input] = (int *) malloc(sizeof(int)*n);
-
-	return(graph);
-}
-
-static 
-int 
-clearGraph(graph, n)
-int **graph;
-int n;
-{
-	int input;
-	for(input=0;input<n; input++)
-		memset(graph[input], 0, sizeof(int)*n);
-   return (0);
-}
-
 
 static int
 printGraph(graph, aSwitch)
@@ -156,6 +141,28 @@ Switch *aSwitch;
 	return (0);
 }
 
+static LpfState *
+createLpfState(n)
+int n;
+{
+	LpfState *state = (LpfState *) malloc(sizeof(LpfState));
+	ScratchBlock block;
+	int pass;
+
+	scratchBegin(&block);
+	for(pass=0; pass<2; pass++)
+	{
+		if( pass )
+			scratchAllocate(&block);
+		state->graph = scratchGraph(&block, n, n);
+		state->occupancy = scratchGraph(&block, n, n);
+		state->col_sum = scratchInts(&block, n);
+		state->row_sum = scratchInts(&block, n);
+		layoutAp2Workspace(&block, &state->ap2, n);
+	}
+	return(state);
+}
+
 static
 int **
 findMaxWeightMatch(aSwitch)
@@ -163,13 +170,11 @@ Switch *aSwitch;
 {
 	int input, output;
 
-	static int **graph=NULL;
-	static int **occupancy=NULL;
-	static int **lqf_match=NULL;
-	static int *si=NULL;
-	static int *so=NULL;
-	static int *col_sum=NULL;
-	static int *row_sum=NULL;
+	LpfState *state = (LpfState *) aSwitch->scheduler.schedulingState;
+	int **graph = state->graph;
+	int **occupancy = state->occupancy;
+	int *col_sum = state->col_sum;
+	int *row_sum = state->row_sum;
 	int **match=NULL;
 	int all_backlog;
 	int n, numFabricOutputs;
@@ -186,23 +191,8 @@ Switch *aSwitch;
 	}
 
 
-	if( !graph )
-		graph = makeGraph(n);
-   if( !occupancy )
-      occupancy = makeGraph(n);
-   if( !lqf_match )
-      lqf_match = makeGraph(n);
-	if( !si )
-		si = (int *)malloc(sizeof(int)*n);
-	if( !so )
-		so = (int *)malloc(sizeof(int)*n);
-	if( !row_sum )
-		row_sum = (int *)malloc(sizeof(int)*n);
-	if( !col_sum )
-		col_sum = (int *)malloc(sizeof(int)*n);
-
-	clearGraph(graph,n);
-	clearGraph(occupancy,n);
+	matrixClear(graph, n, n);
+	matrixClear(occupancy, n, n);
 	/* clear col. and row sums */
 	for(input=0; input<n; input++){
 	  row_sum[input] = 0;
@@ -250,7 +240,7 @@ Switch *aSwitch;
 		printGraph(graph, aSwitch);
 	} */
 
-	match = ap2driver(n, graph);
+	match = ap2driver(&state->ap2, graph);
 	
 	if(debug_algorithm) 
 	{
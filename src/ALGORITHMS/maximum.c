@@ -35,17 +35,12 @@
 #include <string.h>
 #include "sim.h"
 #include "algorithm.h"
+#include "hopcroftKarp.h"
 
 /*  Determines switch configuration 					*/
 /*  Configuration is filled into aSwitch->fabric.interconnect.matrix array 	*/
-
-static int **makeGraph();
-static void printGraph();
-static void clearGraph();
-static int numOutputsSet();
-static int FindOutputSet();
-static int DepthFirstFromInput();
-static int DepthFirstFromOutput();
+/*  Finds maximum sized match using the Hopcroft-Karp engine, warm	*/
+/*  started from the previous slot's match. 				*/
 
 void
 maximum(action, aSwitch, argc, argv)
@@ -55,6 +50,7 @@ int argc;
 char **argv;
 {
   int input, output;
+  HopcroftKarp *hk;
 
   if(debug_algorithm)
     printf("Algorithm 'maximum()' called by switch %d\n", aSwitch->switchNumber);
@@ -67,14 +63,13 @@ char **argv;
     if(debug_algorithm)
       printf("	SCHEDULING_INIT\n");
 
+    if( aSwitch->scheduler.schedulingState == NULL )
+      aSwitch->scheduler.schedulingState = 
+	createHopcroftKarp(aSwitch->numInputs, aSwitch->numOutputs);
     break;
 
   case SCHEDULING_EXEC:
     {
-      static int **graph=NULL;
-      static int **match=NULL;
-      static int **path=NULL;
-
       InputBuffer *inputBuffer;
 
       if(debug_algorithm)
@@ -82,17 +77,8 @@ char **argv;
 	  printf("	SCHEDULING_EXEC\n");
 	}
 
-
-      if( !graph )
-	graph = makeGraph(aSwitch);
-      if( !match )
-	match = makeGraph(aSwitch);
-      if( !path )
-	path = makeGraph(aSwitch);
-	
-      clearGraph(graph,aSwitch);
-      clearGraph(match,aSwitch);
-      clearGraph(path,aSwitch);
+      hk = (HopcroftKarp *) aSwitch->scheduler.schedulingState;
+      hopcroftKarpClearRequests(hk);
 
       /* Fill in request graph */
       for(input=0; input<aSwitch->numInputs; input++)
@@ -101,41 +87,23 @@ char **argv;
 	  for(output=0; output<aSwitch->numOutputs; output++)
 	    {
 	      if(inputBuffer->fifo[output]->number)
-		graph[input][output]=1;
+		hopcroftKarpAddRequest(hk, input, output);
 	    }
 	}
 
-      if(debug_algorithm)
-	{
-	  printf("Traffic:\n");
-	  printGraph(graph, aSwitch);
-	}
-      for(input=0; input!=aSwitch->numInputs;)
-	{	
-	  for(input=0; input<aSwitch->numInputs; input++)
-	    {	
-	      if( (numOutputsSet(match, input, aSwitch) == 0) &&
-		  DepthFirstFromInput(graph,match,path,input,aSwitch))	
-		{
-		  break;
-		}
-	    }
-	}
+      hopcroftKarpMatch(hk);
       if(debug_algorithm)
 	{
 	  printf("Match:\n");
-	  printGraph(match, aSwitch);
-	  printf("\n");
+	  hopcroftKarpPrint(stdout, hk);
 	}
 
-
-      for(output=0; output<aSwitch->numOutputs; output++)
-	for(input=0; input<aSwitch->numInputs; input++)
-	  if(match[input][output]) {
-	    aSwitch->fabric.Interconnect.Crossbar.Matrix[output].input = input;
-	    aSwitch->fabric.Interconnect.Crossbar.Matrix[output].cell = 
+      for(input=0; input<aSwitch->numInputs; input++)
+	if( (output = hk->match[input]) != NONE ) {
+	  aSwitch->fabric.Interconnect.Crossbar.Matrix[output].input = input;
+	  aSwitch->fabric.Interconnect.Crossbar.Matrix[output].cell = 
 	    aSwitch->inputBuffer[input]->fifo[output]->head->Object; /* Sundar */
-	   }
+	}
       break;
     }
 
@@ -148,118 +116,3 @@ char **argv;
   if(debug_algorithm)
     printf("Algorithm 'maximum()' completed for switch %d\n", aSwitch->switchNumber);
 }
-
-/***********************************************************************/
-static int
-DepthFirstFromInput(graph, match, path, startVertex, aSwitch)
-  int **graph;
-int **match;
-int **path;
-int startVertex;
-Switch *aSwitch;
-{
-  int output;
-
-  for(output=0; output<aSwitch->numOutputs; output++)
-    {
-      if( graph[startVertex][output] && !path[0][output]
-	  && DepthFirstFromOutput(graph, match, path, output, aSwitch) )
-	{
-	  match[startVertex][output] = 1;
-	  return(1);
-	}
-    }
-  return(0);
-}
-
-static int
-DepthFirstFromOutput(graph, match, path, startVertex, aSwitch)
-  int **graph;
-int **match;
-int **path;
-int startVertex;
-Switch *aSwitch;
-{
-  int result;
-
-  int i = FindOutputSet(match, startVertex, aSwitch);
-
-  if( i == NONE )
-    return( 1 );
-
-  path[0][startVertex] = 1;
-
-  if( (result = DepthFirstFromInput(graph, match, path, i, aSwitch)) )
-    match[i][startVertex]=0;
-  path[0][startVertex]=0;
-  return(result);
-}
-
-static int
-FindOutputSet(graph, output, aSwitch)
-  int **graph;
-int output;
-Switch *aSwitch;
-{
-  int input;
-
-  for(input=0; input<aSwitch->numInputs; input++)
-    {	
-      if( graph[input][output] )
-	return(input);
-    }
-  return(NONE);
-}
-
-
-static int
-numOutputsSet(graph, input, aSwitch)
-  int **graph;
-int input;
-Switch *aSwitch;
-{
-  int output, sum=0;
-
-  for(output=0; output<aSwitch->numOutputs; output++)
-    sum += graph[input][output];
-
-  return(sum);
-}
-
-static int **
-makeGraph(aSwitch)
-  Switch *aSwitch;
-{
-  int input;
-  int **graph;
-
-  graph = (int **) malloc(sizeof(int *) * aSwitch->numInputs);
-  for(input=0;input<aSwitch->numInputs; input++)
-    graph[input] = (int *) malloc(sizeof(int)*aSwitch->numOutputs);
-
-  return(graph);
-}
-static void
-clearGraph(graph, aSwitch)
-  int **graph;
-Switch *aSwitch;
-{
-  int input;
-  for(input=0;input<aSwitch->numInputs; input++)
-    memset(graph[input], 0, sizeof(int)*aSwitch->numOutputs);
-}
-static void
-printGraph(graph, aSwitch)
-  int **graph;
-Switch *aSwitch;
-{
-  int input, output;
-  for(input=0;input<aSwitch->numInputs; input++)
-    {
-      for(output=0;output<aSwitch->numOutputs; output++)
-	{
-	  printf("%1d ", graph[input][output]);
-	}
-      printf("\n");
-    }
-}
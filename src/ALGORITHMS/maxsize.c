@@ -33,20 +33,21 @@
 #include <string.h>
 #include "sim.h"
 #include "algorithm.h"
-#include "assign2.h"
+#include "hopcroftKarp.h"
 
 
 /*  Determines switch configuration 					*/
 /*  Configuration is filled into aSwitch->fabric.Xbar_matrix array 	*/
-/*  Finds maximum sized match using M Saltzman's code */
+/*  Finds maximum sized match using the Hopcroft-Karp engine, with	*/
+/*  ties broken by a random relabelling of inputs and outputs.	*/
 
-static int **makeGraph();
-static int **shuffleGraph();
-static int **unshuffleGraph();
-static int **makeGraph();
-static void printGraph();
-static void clearGraph();
-static int **findMaxSizeMatch();
+typedef struct {
+  HopcroftKarp *hk;
+  unsigned short seed[3];	/* Private stream for the relabelling */
+} MaxSizeState;
+
+static HopcroftKarp *createFabricMatcher();
+static void fillRequests();
 
 
 void
@@ -57,6 +58,7 @@ int argc;
 char **argv;
 {
   int input, output;
+  MaxSizeState *state;
 
   if(debug_algorithm)
     printf("Algorithm 'maxsize()' called by switch %d\n", aSwitch->switchNumber);
@@ -69,28 +71,41 @@ char **argv;
     if(debug_algorithm)
       printf("	SCHEDULING_INIT\n");
 
+    if( aSwitch->scheduler.schedulingState == NULL )
+      {
+	state = (MaxSizeState *) malloc(sizeof(MaxSizeState));
+	state->hk = createFabricMatcher(aSwitch);
+	state->seed[0] = 0x1243;
+	state->seed[1] = 0xab43;
+	state->seed[2] = 0xfc92;
+	aSwitch->scheduler.schedulingState = state;
+      }
     break;
 
   case SCHEDULING_EXEC:
     {
-      int **match, size=0;
-      int numFabricOutputs = 
-	aSwitch->numOutputs*aSwitch->fabric.Xbar_numOutputLines;
+      int size;
+
+      state = (MaxSizeState *) aSwitch->scheduler.schedulingState;
 
-      match = findMaxSizeMatch(aSwitch);
+      /* RANDOMIZE GRAPH */
+      hopcroftKarpShuffle(state->hk, state->seed);
+      fillRequests(aSwitch, state->hk);
+      size = hopcroftKarpMatch(state->hk);
+      if(debug_algorithm) 
+	{
+	  printf("Match:\n");
+	  hopcroftKarpPrint(stdout, state->hk);
+	}
 	
-      for(output=0; output<numFabricOutputs; output++)
+      for(input=0; input<aSwitch->numInputs; input++)
 	{
-	  for(input=0; input<aSwitch->numInputs; input++)
+	  if( (output = state->hk->match[input]) != NONE )
 	    {
-	      if(match[input][output])
-		{
-		  size++;
-		  aSwitch->fabric.Xbar_matrix[output].input = input;
-		  if(input!=NONE)
-		    aSwitch->fabric.Xbar_matrix[output].cell = (Cell *)
-		      aSwitch->inputBuffer[input]->fifo[output]->head->Object;
-		}
+	      aSwitch->fabric.Xbar_matrix[output].input = input;
+	      aSwitch->fabric.Xbar_matrix[output].cell = (Cell *)
+		aSwitch->inputBuffer[input]->
+		fifo[output/aSwitch->fabric.Xbar_numOutputLines]->head->Object;
 	    }
 	}
       if( debug_algorithm )
@@ -109,183 +124,42 @@ char **argv;
     printf("Algorithm 'maxsize()' completed for switch %d\n", aSwitch->switchNumber);
 }
 
-
-static int **
-unshuffleGraph(graph, si, so, n)
-  int **graph;
-int *si, *so;
-int n;
-{
-  int input, output;
-
-  static int **newgraph=NULL;
-  if( !newgraph )
-    newgraph = makeGraph(n);
-
-  /* UnShuffle the graph */
-  for(input=0; input<n; input++)
-    for(output=0; output<n; output++)
-      newgraph[input][output] = graph[si[input]][so[output]];
-
-  return(newgraph);
-}
-static int **
-shuffleGraph(graph, si, so, n)
-  int **graph;
-int *si, *so;
-int n;
+/* 
+ * Size of the maximum match for the current VOQ occupancy.
+ * Used by the crossbar (-m) to compare against the scheduler's match.
+ * *matcherState is the caller's own matcher, created on first use.
+ */
+int 
+findSizeMaxMatch(aSwitch, matcherState)
+  Switch *aSwitch;
+void **matcherState;
 {
-  static unsigned short int mySeed[3];
-  static int init=0;
-
-  int input, output;
-  int selection;
-  static int **newgraph=NULL;
-
-  if( !newgraph )
-    newgraph = makeGraph(n);
-
-  for(input=0; input<n; input++)
-    si[input]=NONE;
-  for(output=0; output<n; output++)
-    so[output]=NONE;
-
-  if(!init)
-    {
-      mySeed[0] = 0x1243;
-      mySeed[1] = 0xab43;
-      mySeed[2] = 0xfc92;
-      init=1;
-    }
-  /* Shuffle set of inputs */
-  for(input=0; input<n; input++)
-    {
-      do {
-	selection = nrand48(mySeed)%n;
-      } while(si[selection] != NONE);
-      si[selection] = input;
-    }
-  /* Shuffle set of outputs */
-  for(output=0; output<n; output++)
-    {
-      do {
-	selection = nrand48(mySeed)%n;
-      } while(so[selection] != NONE);
-      so[selection] = output;
-    }
-
-  /* Shuffle the graph */
-  for(input=0; input<n; input++)
-    for(output=0; output<n; output++)
-      newgraph[si[input]][so[output]] = graph[input][output];
+  if( *matcherState == NULL )
+    *matcherState = createFabricMatcher(aSwitch);
 
-  return(newgraph);
-	
+  fillRequests(aSwitch, (HopcroftKarp *) *matcherState);
+  return( hopcroftKarpMatch((HopcroftKarp *) *matcherState) );
 }
 
 /***********************************************************************/
-static int **
-makeGraph(n)
-  int n;
-{
-  int input;
-  int **graph;
-
-  graph = (int **) malloc(sizeof(int *) * n);
-  for(input=0;input<n; input++)
-    graph[input] = (int *) malloc(sizeof(int)*n);
-
-  return(graph);
-}
-
-static 
-void
-clearGraph(graph, n)
-  int **graph;
-int n;
-{
-  int input;
-  for(input=0;input<n; input++)
-    memset(graph[input], 0, sizeof(int)*n);
-}
-
-static void
-printGraph(graph, aSwitch)
-  int **graph;
-Switch *aSwitch;
-{
-  int input, output, numFabricOutputs;
-
-  numFabricOutputs = aSwitch->numOutputs*aSwitch->fabric.Xbar_numOutputLines;
-  for(input=0;input<aSwitch->numInputs; input++)
-    {
-      for(output=0;output<numFabricOutputs; output++)
-	{
-	  printf("%1d ", graph[input][output]);
-	}
-      printf("\n");
-    }
-}
-
-int 
-findSizeMaxMatch(aSwitch)
+static HopcroftKarp *
+createFabricMatcher(aSwitch)
   Switch *aSwitch;
 {
-  int input, output, size=0, numFabricOutputs;
-  int **match = findMaxSizeMatch(aSwitch);
-
-  numFabricOutputs = aSwitch->numOutputs*aSwitch->fabric.Xbar_numOutputLines;
-
-  for(output=0; output<numFabricOutputs; output++)
-    for(input=0; input<aSwitch->numInputs; input++)
-      if(match[input][output])
-	size++;
-  return(size);
-
+  return( createHopcroftKarp(aSwitch->numInputs,
+		     aSwitch->numOutputs*aSwitch->fabric.Xbar_numOutputLines) );
 }
 
-static
-int **
-findMaxSizeMatch(aSwitch)
+/* Each non-empty VOQ requests every output line of its output. */
+static void
+fillRequests(aSwitch, hk)
   Switch *aSwitch;
+HopcroftKarp *hk;
 {
-  int input, output, fabricOutput, index;
-
-  static int **graph=NULL;
-  static int *si=NULL;
-  static int *so=NULL;
-  int **match=NULL;
-  int **newgraph;	
-  int size;
-  int n, numFabricOutputs;
-
+  int input, output, index, fabricOutput;
   InputBuffer *inputBuffer;
 
-  numFabricOutputs = aSwitch->numOutputs*aSwitch->fabric.Xbar_numOutputLines;
-  n = (numFabricOutputs > aSwitch->numInputs) ? numFabricOutputs : 
-    aSwitch->numInputs;
-
-  if(debug_algorithm)
-    {
-      printf("	SCHEDULING_EXEC\n");
-    }
-
-
-  if( !graph )
-    graph = makeGraph(n);
-  if( !si )
-    {
-      si = (int *)malloc(sizeof(int)*n);
-    }
-  if( !so )
-    {
-      so = (int *)malloc(sizeof(int)*n);
-    }
-
-  clearGraph(graph,n);
-
-  /* Fill in request graph */
-  size=0;
+  hopcroftKarpClearRequests(hk);
   for(input=0; input<aSwitch->numInputs; input++)
     {
       inputBuffer = aSwitch->inputBuffer[input];
@@ -297,36 +171,8 @@ findMaxSizeMatch(aSwitch)
 		    fabricOutput=output*aSwitch->fabric.Xbar_numOutputLines;
 		  index<aSwitch->fabric.Xbar_numOutputLines;
 		  index++, fabricOutput++)
-		{
-		  graph[input][fabricOutput]=1;
-		  size++;
-		}
+		hopcroftKarpAddRequest(hk, input, fabricOutput);
 	    }
 	}
     }
-  /* printf(" %d ", size); */
-
-
-  if(debug_algorithm) 
-    {
-      printf("Traffic:\n");
-      printGraph(graph, aSwitch);
-    }
-
-  /* RANDOMIZE GRAPH */
-  newgraph = shuffleGraph(graph, si, so, n);
-
-  match = ap2driver(n, newgraph);
-
-	
-  /* UN-RANDOMIZE GRAPH */
-  newgraph = unshuffleGraph(match, si, so, n);
-  if(debug_algorithm) 
-    {
-      printf("Match:\n");
-      printGraph(newgraph, aSwitch);
-      printf("\n");
-    }
-
-  return(newgraph);
 }
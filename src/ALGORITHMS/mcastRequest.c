@@ -0,0 +1,161 @@
+
+/* ****************************************************************
+ * Copyright Stanford University 1998,99 - All Rights Reserved
+ ****************************************************************** 
+
+ * Permission to use, copy, modify, and distribute this software 
+ * and its documentation for any purpose is hereby granted without 
+ * fee, provided that the above copyright notice appears in all copies
+ * and that both the copyright notice, this permission notice, and 
+ * the following disclaimer appear in supporting documentation, and 
+ * that the name of Stanford University, not be used in advertising or 
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.
+ * 
+ * STANFORD UNIVERSITY, DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND 
+ * FITNESS. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE FOR ANY 
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER 
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION 
+ * OF CONTRACT, NEGLIGENCE OR OTHER ACTION, ARISING OUT OF OR IN 
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * The Sim Web Site : http://klamath.stanford.edu/tools/SIM
+ * The SIM Mailing List: sim-simulator@lists.stanford.edu
+
+ * Send mail to the above email address with "subscribe sim-simulator" in
+ * the body of the message.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+#include "algorithm.h"
+#include "miscfns.h"
+#include "mcastRequest.h"
+
+
+void
+layoutMcastRequest(ScratchBlock *block, McastRequest *request,
+		   int numInputs, int numOutputs)
+{
+  request->numInputs = numInputs;
+  request->numOutputs = numOutputs;
+  request->numWords = BITSET_NUM_WORDS(numOutputs);
+  request->row = scratchBitsets(block, numInputs, numOutputs);
+  request->column = scratchBitsets(block, numOutputs, numInputs);
+  request->requested = scratchBitset(block, numOutputs);
+  request->contended = scratchBitset(block, numOutputs);
+  request->fanout = scratchInts(block, numInputs);
+}
+
+/* Fill in the requests of the cells now at the head of line. */
+void
+loadMcastRequest(Switch *aSwitch, McastRequest *request)
+{
+  int numWords = request->numWords;
+  BitsetWord *row, *requested = request->requested;
+  BitsetWord *contended = request->contended;
+  BitsetWord word;
+  struct List *fifo;
+  Cell *aCell;
+  int input, output, w;
+
+  bitsetClear(requested, request->numOutputs);
+  bitsetClear(contended, request->numOutputs);
+  memset(request->column[0], 0, request->numOutputs *
+	 BITSET_NUM_WORDS(request->numInputs) * sizeof(BitsetWord));
+
+  for(input=0; input<request->numInputs; input++)
+    {
+      row = request->row[input];
+      fifo = aSwitch->inputBuffer[input]->mcastFifo[DEFAULT_PRIORITY];
+      if( !fifo->number )
+	{
+	  bitsetClear(row, request->numOutputs);
+	  request->fanout[input] = 0;
+	  continue;
+	}
+      aCell = (Cell *) fifo->head->Object;
+      bitmapToBitset(&aCell->outputs, row, request->numOutputs);
+      request->fanout[input] = 0;
+      for(w=0; w<numWords; w++)
+	{
+	  contended[w] |= requested[w] & row[w];
+	  requested[w] |= row[w];
+	  request->fanout[input] += BITSET_WORD_COUNT(row[w]);
+	}
+      EVERY_BIT_SET(row, numWords, w, word, output)
+	BITSET_SET(request->column[output], input);
+    }
+}
+
+/* Outputs input requests that other inputs request too. */
+int
+commonWithContended(McastRequest *request, int input)
+{
+  BitsetWord *row = request->row[input];
+  int w, common = 0;
+
+  for(w=0; w<request->numWords; w++)
+    common += BITSET_WORD_COUNT(row[w] & request->contended[w]);
+  return(common);
+}
+
+/*
+ * Each output grants to the heaviest input requesting it, and of
+ * several as heavy to the first at or after grantPointer.  Only the
+ * requests in the output's column are looked at.  Fills in grant[]
+ * and returns the lowest input granted to out of a tie, or NONE.
+ */
+int
+grantMcastByWeight(McastRequest *request, int *weight, int grantPointer,
+		   int *grant)
+{
+  int numInputs = request->numInputs;
+  int numInputWords = BITSET_NUM_WORDS(numInputs);
+  int output, input, w, maxWeight, numTied, best, bestDistance, distance;
+  int firstClashedInput = NONE;
+  BitsetWord word;
+
+  for(output=0; output<request->numOutputs; output++)
+    {
+      maxWeight = -1;
+      numTied = 0;
+      best = NONE;
+      bestDistance = numInputs;
+      EVERY_BIT_SET(request->column[output], numInputWords, w, word, input)
+	{
+	  if( weight[input] < maxWeight )
+	    continue;
+	  if( weight[input] > maxWeight )
+	    {
+	      maxWeight = weight[input];
+	      numTied = 0;
+	      bestDistance = numInputs;
+	    }
+	  numTied++;
+	  distance = (input - grantPointer + numInputs) % numInputs;
+	  if( distance < bestDistance )
+	    {
+	      best = input;
+	      bestDistance = distance;
+	    }
+	}
+      grant[output] = NONE;
+      if( maxWeight >= 0 )
+	{
+	  grant[output] = best;
+	  if( numTied > 1 && 
+	      (firstClashedInput == NONE || best < firstClashedInput) )
+	    firstClashedInput = best;
+	}
+    }
+  return(firstClashedInput);
+}
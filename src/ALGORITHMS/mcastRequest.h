@@ -0,0 +1,65 @@
+
+/* ****************************************************************
+ * Copyright Stanford University 1998,99 - All Rights Reserved
+ ****************************************************************** 
+
+ * Permission to use, copy, modify, and distribute this software 
+ * and its documentation for any purpose is hereby granted without 
+ * fee, provided that the above copyright notice appears in all copies
+ * and that both the copyright notice, this permission notice, and 
+ * the following disclaimer appear in supporting documentation, and 
+ * that the name of Stanford University, not be used in advertising or 
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.
+ * 
+ * STANFORD UNIVERSITY, DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND 
+ * FITNESS. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE FOR ANY 
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER 
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION 
+ * OF CONTRACT, NEGLIGENCE OR OTHER ACTION, ARISING OUT OF OR IN 
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * The Sim Web Site : http://klamath.stanford.edu/tools/SIM
+ * The SIM Mailing List: sim-simulator@lists.stanford.edu
+
+ * Send mail to the above email address with "subscribe sim-simulator" in
+ * the body of the message.
+ *
+ */
+
+
+#ifndef _MCASTREQUEST_H_
+#define _MCASTREQUEST_H_
+
+/*
+ * The requests of the multicast cells at the head of the inputs'
+ * multicast fifos, as bitsets: a row of outputs per input and a
+ * column of inputs per output.  An output's residue is the number of
+ * requests for it beyond the first, so the outputs with a residue are
+ * those contended for, found a word at a time as the outputs a row
+ * requests that the rows before it already requested.  An input's
+ * fanout and its share of the residue are pop counts of its row.
+ */
+typedef struct {
+  int numInputs;
+  int numOutputs;
+  int numWords;			/* Words in a row */
+  BitsetWord **row;		/* [input] outputs its head of line cell wants */
+  BitsetWord **column;		/* [output] inputs requesting it */
+  BitsetWord *requested;	/* Outputs requested by any input */
+  BitsetWord *contended;	/* Outputs requested by more than one input */
+  int *fanout;			/* [input] outputs in its row */
+} McastRequest;
+
+void layoutMcastRequest(ScratchBlock *block, McastRequest *request,
+			int numInputs, int numOutputs);
+void loadMcastRequest(Switch *aSwitch, McastRequest *request);
+int commonWithContended(McastRequest *request, int input);
+int grantMcastByWeight(McastRequest *request, int *weight, int grantPointer,
+		       int *grant);
+
+#endif /* _MCASTREQUEST_H_ */
@@ -33,16 +33,27 @@
 #include <string.h>
 #include "sim.h"
 #include "algorithm.h"
+#include "miscfns.h"
+#include "mcastRequest.h"
 
 /*  Determines switch configuration  for multicast input fifos */
 /*  Configuration is filled into aSwitch->fabric.interconnect.matrix array 	*/
 /* Each output selects randomly and unifromly over the requesting inputs. */
 
-static int vectorSum();
-static int vectorCommon();
-static void vectorPrint();
-static void matrixSubtract();
-static void allocateResidue();
+/* Working buffers for one switch */
+typedef struct {
+  McastRequest request;		/* Head of line requests */
+  int *residue;			/* Residue, per output */
+  BitsetWord *withResidue;	/* Outputs whose residue is not yet given */
+  int *inputAllocated;		/* Inputs that have been given residue */
+  int *mostInput;		/* Inputs tied for selection */
+  BitsetWord **residueAllocate;	/* Residue given to each input */
+  unsigned short int localSeed[3];	/* Breaks ties between inputs */
+} ResidueState;
+
+static ResidueState *createResidueState();
+static int rowCommon();
+static int allocateResidue();
 
 void
 mcast_conc_residue(action, aSwitch, argc, argv)
@@ -52,7 +63,7 @@ int argc;
 char **argv;
 {
   int input, output;
-  static unsigned short int localSeed[3];
+  ResidueState *state;
 
   if(debug_algorithm)
     printf("Algorithm 'mcast_conc_residue()' called by switch %d\n", aSwitch->switchNumber);
@@ -65,17 +76,22 @@ char **argv;
     if(debug_algorithm)
       printf("	SCHEDULING_INIT\n");
 
-    localSeed[0] = 0x4fe7;
-    localSeed[1] = 0x5781;
-    localSeed[2] = 0xab33;
+    if( aSwitch->scheduler.schedulingState == NULL )
+      aSwitch->scheduler.schedulingState = createResidueState(aSwitch);
+    state = (ResidueState *) aSwitch->scheduler.schedulingState;
+    state->localSeed[0] = 0x4fe7;
+    state->localSeed[1] = 0x5781;
+    state->localSeed[2] = 0xab33;
 
     break;
 
   case SCHEDULING_EXEC:
     {
-      int  selection, numEqual, numFabricOutputs, most, common;
-      static int *inputAllocated, *residue=NULL, **request, 
-	**residueAllocate, *mostInput;
+      int  selection, numEqual, numFabricOutputs, most, common, numWords;
+      int *inputAllocated, *residue, numResidue, w;
+      int *mostInput;
+      McastRequest *request;
+      BitsetWord *withResidue, **residueAllocate, word;
       struct List *fifo;
       Cell *aCell;
       unsigned long age, mostAge;
@@ -88,30 +104,18 @@ char **argv;
       numFabricOutputs = aSwitch->numOutputs *
 	aSwitch->fabric.Xbar_numOutputLines;
 
-      if(!residue)
-	{
-	  residue = (int *)  malloc(sizeof(int) * numFabricOutputs);
-	  inputAllocated = (int *) malloc(sizeof(int)*aSwitch->numInputs);
-	  mostInput = (int *)  malloc(sizeof(int) * aSwitch->numInputs);
-
-	  request = (int **) malloc(sizeof(int *) * aSwitch->numInputs);
-	  residueAllocate = 
-	    (int **) malloc(sizeof(int *)*aSwitch->numInputs);
-	  for(input=0;input < aSwitch->numInputs; input++)
-	    {
-	      request[input]=(int *)malloc(sizeof(int)*numFabricOutputs);
-	      residueAllocate[input] = (int *) 
-		malloc(sizeof(int) * numFabricOutputs);
-	    }
-	}
+      state = (ResidueState *) aSwitch->scheduler.schedulingState;
+      request = &state->request;
+      residue = state->residue;
+      withResidue = state->withResidue;
+      inputAllocated = state->inputAllocated;
+      mostInput = state->mostInput;
+      residueAllocate = state->residueAllocate;
+      numWords = request->numWords;
 
       /* INITIALIZE */
-      for(input=0;input < aSwitch->numInputs; input++)
-	{
-	  memset(request[input], 0, sizeof(int) * numFabricOutputs);
-	  memset(residueAllocate[input], 0, sizeof(int)*numFabricOutputs);
-	}
-      memset(residue, 0, sizeof(int) * numFabricOutputs);
+      memset(residueAllocate[0], 0, 
+	     aSwitch->numInputs * numWords * sizeof(BitsetWord));
       memset(inputAllocated, 0, sizeof(int) * aSwitch->numInputs);
 
       /* Mark cells that have newly arrived at head of queue */
@@ -127,52 +131,35 @@ char **argv;
 	}
 
       /* Make the Request matrix and Residue vector */
-      if(debug_algorithm)
+      loadMcastRequest(aSwitch, request);
+      bitsetCopy(withResidue, request->contended, numFabricOutputs);
+      numResidue = 0;
+      EVERY_BIT_SET(request->contended, numWords, w, word, output)
 	{
-	  printf("-------------\n");
-	  printf("Request:\n");
+	  residue[output] = bitsetNumSet(request->column[output],
+					 aSwitch->numInputs) - 1;
+	  numResidue += residue[output];
 	}
-
-      for(input=0; input<aSwitch->numInputs; input++)
-	{
-	  fifo = aSwitch->inputBuffer[input]->mcastFifo[DEFAULT_PRIORITY];
-	  if(fifo->number)
-	    {
-	      aCell = (Cell *) fifo->head->Object;
-	      for(output=0;output<numFabricOutputs;output++)
-		{
-		  /* The range of outputs set by the TRAFFIC algo is different from the
-		     range being checked here. ritesh */
-
-		  if( bitmapIsBitSet(output, &aCell->outputs) )
-		    {
-		      residue[output]++;
-		      request[input][output]=1;
-		    }
-		}
-	    }
-	  if(debug_algorithm)
-	    vectorPrint(stdout, request[input], numFabricOutputs);
-	}
-      for(output=0;output<numFabricOutputs;output++)
-	if( residue[output]>0 ) residue[output]--;
       if(debug_algorithm)
 	{
+	  printf("-------------\n");
+	  printf("Request:\n");
+	  for(input=0; input<aSwitch->numInputs; input++)
+	    bitsetPrint(stdout, request->row[input], numFabricOutputs);
 	  printf("Residue:\n");
-	  vectorPrint(stdout, residue, numFabricOutputs);
+	  bitsetPrint(stdout, withResidue, numFabricOutputs);
 	  printf("-------------\n");
 	}
 
 	
-      while( vectorSum(residue, numFabricOutputs) > 0 )
+      while( numResidue > 0 )
 	{
 	  /* Find input with most in common with residue */
 	  for(input=0, numEqual=NONE, most=0, mostAge=0;
 	      input<aSwitch->numInputs;input++)
 	    {
 	      if( inputAllocated[input] ) continue;
-	      common = 
-		vectorCommon(request[input],residue,numFabricOutputs);	
+	      common = rowCommon(request->row[input], withResidue, numWords);
 	      if(common>most) 
 		{
 		  numEqual=0;
@@ -185,14 +172,12 @@ char **argv;
 		{
 		  aCell = (Cell *) aSwitch->inputBuffer[input]->mcastFifo[DEFAULT_PRIORITY]->head->Object;
 		  age = now - aCell->commonStats.headArrivalTime;
-		  /* printf("input: %d, common: %d age: %lu mostage: %lu\n", input, common, age, mostAge); */
 		  if(age<mostAge)
 		    {
 		      numEqual=0;
 		      most = common;
 		      mostInput[numEqual] = input;
 		      mostAge = age;
-		      /* printf("*******\n");  */
 		    }
 		  else if(age==mostAge)
 		    {
@@ -209,38 +194,39 @@ char **argv;
 	    input = mostInput[0];
 	  else
 	    {
-	      selection  = (int)nrand48(localSeed)%(numEqual+1);
+	      selection  = (int)nrand48(state->localSeed)%(numEqual+1);
 	      input = mostInput[ selection ];
 	    }
-	  allocateResidue(request[input], residue, 
-			  residueAllocate[input], numFabricOutputs);
+	  numResidue -= allocateResidue(request->row[input], residue, 
+					withResidue, residueAllocate[input],
+					numWords);
 	  if(debug_algorithm)
 	    {
 	      printf("Allocating residue to input %d\n", input);
-	      vectorPrint(stdout, request[input], numFabricOutputs);
-	      vectorPrint(stdout, residueAllocate[input], numFabricOutputs);
+	      bitsetPrint(stdout, request->row[input], numFabricOutputs);
+	      bitsetPrint(stdout, residueAllocate[input], numFabricOutputs);
 	    }
 	  inputAllocated[input]=1;
 	}
 
-      /* Subtract residue from request matrix */
-      matrixSubtract(request, 
-		     residueAllocate, aSwitch->numInputs, numFabricOutputs);
-
+      /* Each input sends to the outputs it requests less its residue */
       if(debug_algorithm)
 	printf("Configuration:\n");
       for(input=0; input<aSwitch->numInputs; input++)
 	{
+	  if( !request->fanout[input] )
+	    continue;
+	  aCell = (Cell *)
+	    aSwitch->inputBuffer[input]->mcastFifo[DEFAULT_PRIORITY]->head->Object;
+	  for(w=0; w<numWords; w++)
+	    residueAllocate[input][w] = 
+	      request->row[input][w] & ~residueAllocate[input][w];
 	  if(debug_algorithm)
-	    vectorPrint(stdout, request[input], numFabricOutputs);
-	  for(output=0; output<numFabricOutputs; output++)
+	    bitsetPrint(stdout, residueAllocate[input], numFabricOutputs);
+	  EVERY_BIT_SET(residueAllocate[input], numWords, w, word, output)
 	    {
-	      if(request[input][output])
-		{
-		  aSwitch->fabric.Xbar_matrix[output].input = input;
-		  aSwitch->fabric.Xbar_matrix[output].cell = (Cell *)
-		  aSwitch->inputBuffer[input]->mcastFifo[DEFAULT_PRIORITY]->head->Object;
-		}
+	      aSwitch->fabric.Xbar_matrix[output].input = input;
+	      aSwitch->fabric.Xbar_matrix[output].cell = aCell;
 	    }
 	}
       if(debug_algorithm)
@@ -262,79 +248,70 @@ char **argv;
 
 /***********************************************************************/
 
-static int
-vectorSum(vector, size)
-  int *vector;
-int size;
+static ResidueState *
+createResidueState(aSwitch)
+  Switch *aSwitch;
 {
-  int i,sum=0;
-  for(i=0;i<size;i++)
+  ResidueState *state = (ResidueState *) malloc(sizeof(ResidueState));
+  int numFabricOutputs = aSwitch->numOutputs *
+    aSwitch->fabric.Xbar_numOutputLines;
+  ScratchBlock block;
+  int pass;
+
+  scratchBegin(&block);
+  for(pass=0; pass<2; pass++)
     {
-      sum += vector[i];
+      if( pass )
+	scratchAllocate(&block);
+      layoutMcastRequest(&block, &state->request, aSwitch->numInputs,
+			 numFabricOutputs);
+      state->residue = scratchInts(&block, numFabricOutputs);
+      state->withResidue = scratchBitset(&block, numFabricOutputs);
+      state->inputAllocated = scratchInts(&block, aSwitch->numInputs);
+      state->mostInput = scratchInts(&block, aSwitch->numInputs);
+      state->residueAllocate =
+	scratchBitsets(&block, aSwitch->numInputs, numFabricOutputs);
     }
-  return(sum);
+  return(state);
 }
 
-static int
-vectorCommon(vector1, vector2, size)
-  int *vector1, *vector2;
-int size;
-{	
-  int i, sum=0;
-  for(i=0;i<size;i++)
-    {
-      if(vector1[i]>0 && vector2[i]>0)
-	sum ++;
-    }
-  return(sum);
-}
-
-static void
-vectorPrint(fp, vector, size)
-  FILE *fp;
-int *vector;
-int size;
-{
-  int i;
-  for(i=0;i<size;i++)
-    {
-      fprintf(fp, "%d", vector[i]);
-    }
-  fprintf(fp,"\n");
-}
+/***********************************************************************/
 
-/* Subtracts matrix2 from matrix1, leaving result in matrix1 */
-static void
-matrixSubtract(matrix1, matrix2, rows, cols)
-  int **matrix1, **matrix2;
-int rows, cols;
+/* Outputs in row that have residue left */
+static int
+rowCommon(row, withResidue, numWords)
+  BitsetWord *row, *withResidue;
+int numWords;
 {
-  int i,j;
+  int w, sum=0;
 
-  for(i=0; i< rows; i++)
-    {
-      for(j=0;j<cols;j++)
-	{
-	  matrix1[i][j] = matrix1[i][j] - matrix2[i][j];
-	}
-    }
+  for(w=0; w<numWords; w++)
+    sum += BITSET_WORD_COUNT(row[w] & withResidue[w]);
+  return(sum);
 }
 
-static void
-allocateResidue(request, residue, residueAllocate, size)
-  int *request, *residue, *residueAllocate;
-int size;
+/* Gives the input one unit of the residue of each output it requests */
+/* that has residue left.  Returns the number of units given.          */
+static int
+allocateResidue(row, residue, withResidue, residueAllocate, numWords)
+  BitsetWord *row, *withResidue, *residueAllocate;
+int *residue;
+int numWords;
 {
-  int i;
-  for(i=0;i<size;i++)
+  BitsetWord given, word;
+  int w, output, numGiven = 0;
+
+  for(w=0; w<numWords; w++)
     {
-      if(request[i]>0 && residue[i]>0)
+      given = row[w] & withResidue[w];
+      residueAllocate[w] |= given;
+      numGiven += BITSET_WORD_COUNT(given);
+      for(word=given; word; word &= word-1)
 	{
-	  if(residueAllocate[i])
-	    fprintf(stderr,"Allocating residue twice: output %d\n", i);
-	  residueAllocate[i]=1;
-	  residue[i]--;
+	  output = w * BITSET_WORD_BITS + BITSET_WORD_FFS(word);
+	  if( --residue[output] == 0 )
+	    BITSET_RESET(withResidue, output);
 	}
     }
+  return(numGiven);
 }
-
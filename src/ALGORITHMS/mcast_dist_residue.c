@@ -33,6 +33,8 @@
 #include <string.h>
 #include "sim.h"
 #include "algorithm.h"
+#include "miscfns.h"
+#include "mcastRequest.h"
 
 /*  Determines switch configuration  for multicast input fifos */
 /*  Configuration is filled into aSwitch->fabric.interconnect.matrix array 	*/
@@ -40,11 +42,18 @@
 /* Each output selects randomly and unifromly over the requesting inputs. */
 
 
-static int vectorSum();
-static int vectorCommon();
-static void vectorSubtract();
-static void vectorPrint();
-static void matrixSubtract();
+/* Working buffers for one switch */
+typedef struct {
+  McastRequest request;		/* Head of line requests */
+  int *residue;			/* Residue, per output */
+  BitsetWord *withResidue;	/* Outputs whose residue is not yet given */
+  int *inputAllocated;		/* Inputs that have been given residue */
+  int *leastInput;		/* Inputs tied for selection */
+  BitsetWord **residueAllocate;	/* Residue given to each input */
+} ResidueState;
+
+static ResidueState *createResidueState();
+static int rowCommon();
 static int allocateMinResidue();
 
 
@@ -56,6 +65,7 @@ int argc;
 char **argv;
 {
   int input, output;
+  ResidueState *state;
 
   if(debug_algorithm)
     printf("Algorithm 'mcast_dist_residue()' called by switch %d\n", aSwitch->switchNumber);
@@ -68,13 +78,18 @@ char **argv;
     if(debug_algorithm)
       printf("	SCHEDULING_INIT\n");
 
+    if( aSwitch->scheduler.schedulingState == NULL )
+      aSwitch->scheduler.schedulingState = createResidueState(aSwitch);
+
     break;
 
   case SCHEDULING_EXEC:
     {
       int  selection, numEqual, numFabricOutputs, least, common, amount;
-      static int *inputAllocated, *residue=NULL, **request, 
-	**residueAllocate, *leastInput, *temp;
+      int *inputAllocated, *residue, numResidue, numWords, w;
+      int *leastInput;
+      McastRequest *request;
+      BitsetWord *withResidue, **residueAllocate, word;
       struct List *fifo;
       Cell *aCell;
       unsigned long age, leastAge;
@@ -87,31 +102,18 @@ char **argv;
       numFabricOutputs = aSwitch->numOutputs *
 	aSwitch->fabric.Xbar_numOutputLines;
 
-      if(!residue)
-	{
-	  residue = (int *)  malloc(sizeof(int) * numFabricOutputs);
-	  inputAllocated = (int *) malloc(sizeof(int)*aSwitch->numInputs);
-	  leastInput = (int *)  malloc(sizeof(int) * aSwitch->numInputs);
-	  temp = (int *)  malloc(sizeof(int) * numFabricOutputs);
-
-	  request = (int **) malloc(sizeof(int *) * aSwitch->numInputs);
-	  residueAllocate = 
-	    (int **) malloc(sizeof(int *)*aSwitch->numInputs);
-	  for(input=0;input < aSwitch->numInputs; input++)
-	    {
-	      request[input]=(int *)malloc(sizeof(int)*numFabricOutputs);
-	      residueAllocate[input] = (int *) 
-		malloc(sizeof(int) * numFabricOutputs);
-	    }
-	}
+      state = (ResidueState *) aSwitch->scheduler.schedulingState;
+      request = &state->request;
+      residue = state->residue;
+      withResidue = state->withResidue;
+      inputAllocated = state->inputAllocated;
+      leastInput = state->leastInput;
+      residueAllocate = state->residueAllocate;
+      numWords = request->numWords;
 
       /* INITIALIZE */
-      for(input=0;input<aSwitch->numInputs; input++)
-	{
-	  memset(request[input], 0, sizeof(int) * numFabricOutputs);
-	  memset(residueAllocate[input], 0, sizeof(int)*numFabricOutputs);
-	}
-      memset(residue, 0, sizeof(int) * numFabricOutputs);
+      memset(residueAllocate[0], 0, 
+	     aSwitch->numInputs * numWords * sizeof(BitsetWord));
       memset(inputAllocated, 0, sizeof(int) * aSwitch->numInputs);
 
       /* Mark cells that have newly arrived at head of queue */
@@ -127,52 +129,35 @@ char **argv;
 	}
 
       /* Make the Request matrix and Residue vector */
-      if(debug_algorithm)
+      loadMcastRequest(aSwitch, request);
+      bitsetCopy(withResidue, request->contended, numFabricOutputs);
+      numResidue = 0;
+      EVERY_BIT_SET(request->contended, numWords, w, word, output)
 	{
-	  printf("-------------\n");
-	  printf("Request:\n");
+	  residue[output] = bitsetNumSet(request->column[output],
+					 aSwitch->numInputs) - 1;
+	  numResidue += residue[output];
 	}
-
-      for(input=0; input<aSwitch->numInputs; input++)
-	{
-	  fifo = aSwitch->inputBuffer[input]->mcastFifo[DEFAULT_PRIORITY];
-	  if(fifo->number)
-	    {
-	      aCell = (Cell *) fifo->head->Object;
-	      for(output=0;output<numFabricOutputs;output++)
-		{
-		  if( bitmapIsBitSet(output, &aCell->outputs) )
-		    {
-		      residue[output]++;
-		      request[input][output]=1;
-		    }
-		}
-	    }
-	  if(debug_algorithm)
-	    vectorPrint(stdout, request[input], numFabricOutputs);
-	}
-      for(output=0;output<numFabricOutputs;output++)
-	if( residue[output]>0 ) residue[output]--;
       if(debug_algorithm)
 	{
+	  printf("-------------\n");
+	  printf("Request:\n");
+	  for(input=0; input<aSwitch->numInputs; input++)
+	    bitsetPrint(stdout, request->row[input], numFabricOutputs);
 	  printf("Residue:\n");
-	  vectorPrint(stdout, residue, numFabricOutputs);
+	  bitsetPrint(stdout, withResidue, numFabricOutputs);
 	  printf("-------------\n");
 	}
 	
-      while( vectorSum(residue, numFabricOutputs) > 0 )
+      while( numResidue > 0 )
 	{
-
 	  /* Find input with least in common with residue */
 	  for(input=0, numEqual=NONE, least=numFabricOutputs, leastAge=0;
 	      input<aSwitch->numInputs;input++)
 	    {
 	      if(inputAllocated[input]) continue;
-	      memcpy(temp, request[input], sizeof(int)*numFabricOutputs);
-	      vectorSubtract(temp, residueAllocate[input], 
-			     numFabricOutputs);
-	      common = 
-		vectorCommon(temp,residue,numFabricOutputs);	
+	      common = rowCommon(request->row[input], residueAllocate[input],
+				 withResidue, numWords);
 	      if(common==0) continue;
 
 	      if(common<least) 
@@ -218,36 +203,36 @@ char **argv;
 	      selection  = (int)lrand48()%(numEqual+1);
 	      input = leastInput[ selection ];
 	    }
-	  amount = allocateMinResidue(request[input], residue, 
-				      residueAllocate[input], numFabricOutputs);
+	  amount = allocateMinResidue(request->row[input], residue, withResidue,
+				      residueAllocate[input], numWords);
+	  numResidue -= amount;
 	  if(debug_algorithm)
 	    {
 	      printf("Allocating %d residue to input %d\n", amount,input);
-	      vectorPrint(stdout, request[input], numFabricOutputs);
-	      vectorPrint(stdout, residueAllocate[input], numFabricOutputs);
+	      bitsetPrint(stdout, request->row[input], numFabricOutputs);
+	      bitsetPrint(stdout, residueAllocate[input], numFabricOutputs);
 	    }
 	  inputAllocated[input]=1;
-
 	}
 
-      /* Subtract residue from request matrix */
-      matrixSubtract(request, 
-		     residueAllocate, aSwitch->numInputs, numFabricOutputs);
-
+      /* Each input sends to the outputs it requests less its residue */
       if(debug_algorithm)
 	printf("Configuration:\n");
       for(input=0; input<aSwitch->numInputs; input++)
 	{
+	  if( !request->fanout[input] )
+	    continue;
+	  aCell = (Cell *)
+	    aSwitch->inputBuffer[input]->mcastFifo[DEFAULT_PRIORITY]->head->Object;
+	  for(w=0; w<numWords; w++)
+	    residueAllocate[input][w] = 
+	      request->row[input][w] & ~residueAllocate[input][w];
 	  if(debug_algorithm)
-	    vectorPrint(stdout, request[input], numFabricOutputs);
-	  for(output=0; output<numFabricOutputs; output++)
+	    bitsetPrint(stdout, residueAllocate[input], numFabricOutputs);
+	  EVERY_BIT_SET(residueAllocate[input], numWords, w, word, output)
 	    {
-	      if(request[input][output])
-		{
-		  aSwitch->fabric.Xbar_matrix[output].input = input;
-		  aSwitch->fabric.Xbar_matrix[output].cell = (Cell *)
-		    aSwitch->inputBuffer[input]->mcastFifo[DEFAULT_PRIORITY]->head->Object;
-		}
+	      aSwitch->fabric.Xbar_matrix[output].input = input;
+	      aSwitch->fabric.Xbar_matrix[output].cell = aCell;
 	    }
 	}
       if(debug_algorithm)
@@ -269,96 +254,69 @@ char **argv;
 
 /***********************************************************************/
 
-static int
-vectorSum(vector, size)
-  int *vector;
-int size;
-{
-  int i,sum=0;
-  for(i=0;i<size;i++)
-    {
-      sum += vector[i];
-    }
-  return(sum);
-}
-
-static int
-vectorCommon(vector1, vector2, size)
-  int *vector1, *vector2;
-int size;
-{	
-  int i, sum=0;
-  for(i=0;i<size;i++)
-    {
-      if(vector1[i]>0 && vector2[i]>0)
-	sum ++;
-    }
-  return(sum);
-}
-
-/* Subtracts vector2 from vector1, leaving result in vector1 */
-static void
-vectorSubtract(vector1, vector2, size)
-  int *vector1, *vector2;
-int size;
+static ResidueState *
+createResidueState(aSwitch)
+  Switch *aSwitch;
 {
-  int i;
-
-  for(i=0; i< size; i++)
+  ResidueState *state = (ResidueState *) malloc(sizeof(ResidueState));
+  int numFabricOutputs = aSwitch->numOutputs *
+    aSwitch->fabric.Xbar_numOutputLines;
+  ScratchBlock block;
+  int pass;
+
+  scratchBegin(&block);
+  for(pass=0; pass<2; pass++)
     {
-      vector1[i] = vector1[i] - vector2[i];
+      if( pass )
+	scratchAllocate(&block);
+      layoutMcastRequest(&block, &state->request, aSwitch->numInputs,
+			 numFabricOutputs);
+      state->residue = scratchInts(&block, numFabricOutputs);
+      state->withResidue = scratchBitset(&block, numFabricOutputs);
+      state->inputAllocated = scratchInts(&block, aSwitch->numInputs);
+      state->leastInput = scratchInts(&block, aSwitch->numInputs);
+      state->residueAllocate =
+	scratchBitsets(&block, aSwitch->numInputs, numFabricOutputs);
     }
+  return(state);
 }
 
-static void
-vectorPrint(fp, vector, size)
-  FILE *fp;
-int *vector;
-int size;
-{
-  int i;
-  for(i=0;i<size;i++)
-    {
-      fprintf(fp, "%d", vector[i]);
-    }
-  fprintf(fp,"\n");
-}
+/***********************************************************************/
 
-/* Subtracts matrix2 from matrix1, leaving result in matrix1 */
-static void
-matrixSubtract(matrix1, matrix2, rows, cols)
-  int **matrix1, **matrix2;
-int rows, cols;
+/* Outputs in row, less those in given, that have residue left */
+static int
+rowCommon(row, given, withResidue, numWords)
+  BitsetWord *row, *given, *withResidue;
+int numWords;
 {
-  int i,j;
+  int w, sum=0;
 
-  for(i=0; i< rows; i++)
-    {
-      for(j=0;j<cols;j++)
-	{
-	  matrix1[i][j] = matrix1[i][j] - matrix2[i][j];
-	}
-    }
+  for(w=0; w<numWords; w++)
+    sum += BITSET_WORD_COUNT(row[w] & ~given[w] & withResidue[w]);
+  return(sum);
 }
 
+/* Gives the input one unit of residue: that of the first output it */
+/* requests, and has not been given, that has residue left.          */
 static int
-allocateMinResidue(request, residue, residueAllocate, size)
-  int *request, *residue, *residueAllocate;
-int size;
+allocateMinResidue(row, residue, withResidue, residueAllocate, numWords)
+  BitsetWord *row, *withResidue, *residueAllocate;
+int *residue;
+int numWords;
 {
-  int i;
-  for(i=0;i<size;i++)
+  BitsetWord word;
+  int w, output;
+
+  for(w=0; w<numWords; w++)
     {
-      if(request[i]>0 && residue[i]>0 && residueAllocate[i]==0)
-	{
-	  if(residueAllocate[i])
-	    fprintf(stderr,"Allocating residue twice: output %d\n", i);
-	  residueAllocate[i]=1;
-	  residue[i]--;
-	  return(1);
-	}
+      word = row[w] & ~residueAllocate[w] & withResidue[w];
+      if( !word )
+	continue;
+      output = w * BITSET_WORD_BITS + BITSET_WORD_FFS(word);
+      BITSET_SET(residueAllocate, output);
+      if( --residue[output] == 0 )
+	BITSET_RESET(withResidue, output);
+      return(1);
     }
-  /*fprintf(stderr, "No residue allocated!!!!\n");*/
   return(0);
 }
-
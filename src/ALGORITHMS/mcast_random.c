@@ -39,7 +39,7 @@
 
 /* Each output selects randomly and unifromly over the requesting inputs. */
 
-unsigned short int aSeed[3];
+static unsigned short int aSeed[3];
 
 static int selectInput();
 
@@ -33,8 +33,10 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "sim.h"
 #include "algorithm.h"
+#include "miscfns.h"
 
 #define debug_tatra 0
 #define anim 1
@@ -43,7 +45,7 @@ extern void FatalError(char*);
 #define ANIM_START resetStatsTime
 #define ANIM_FILE "anim.txt"
 
-static int demand_compare();
+static void sortByDemand();
 static void addToTatraMatrix();
 void printTatraMatrix();
 void animPrintTatraMatrix();
@@ -54,12 +56,24 @@ static void vectorPrint();
 #endif
 
 
+typedef struct 
+{
+  int input;
+  int demand;
+} Demand;
+
 typedef struct tatra_state
 {
   int** tatraMatrix;
   int numOutputs, numRows;
   int* peakRow;
   int headRow;
+  BitsetWord **request;		/* [input] outputs its head of line cell wants */
+  Demand *demand;		/* New head of line cells */
+  Demand *sorted;		/* ... sorted by demand */
+  int *numWithDemand;		/* Counting sort's buckets, [0..numOutputs] */
+  unsigned short seed[3];	/* Breaks ties between equal demands */
+  FILE *animFp;
 }TatraState;
 
 /*
@@ -69,12 +83,6 @@ typedef struct tatra_stats
 };
 */
 
-typedef struct 
-{
-  int input;
-  int demand;
-} Demand;
-
 
 void 
 mcast_tatra(action, aSwitch, argc, argv)
@@ -87,7 +95,6 @@ char** argv;
   int headRow;
   TatraState *tatraState;
   int i, j;
-  static FILE *animFp;
 
   switch(action)
     {
@@ -97,33 +104,50 @@ char** argv;
 	
     case SCHEDULING_INIT:
       {
-	int numFabricOutputs;
+	int numFabricOutputs, pass;
+	ScratchBlock block;
+
 	numFabricOutputs = aSwitch->numOutputs * aSwitch->fabric.Xbar_numOutputLines;
 	aSwitch->scheduler.schedulingState = malloc(sizeof(TatraState));
 	tatraState = (TatraState*)aSwitch->scheduler.schedulingState;
-	    
-	tatraMatrix = (int**)malloc(numFabricOutputs * sizeof(int*));
-	for(i = 0; i < numFabricOutputs; i++)
+
+	scratchBegin(&block);
+	for(pass=0; pass<2; pass++)
 	  {
-	    tatraMatrix[i] = (int*)malloc(aSwitch->numInputs * sizeof(int));
-	    tatraState->peakRow = (int*)malloc(aSwitch->numInputs * sizeof(int));
-	    for(j = 0; j < aSwitch->numInputs; j++) {
-	      tatraMatrix[i][j] = NONE;
-	      tatraState->peakRow[j] = NONE;
-	    }
+	    if( pass )
+	      scratchAllocate(&block);
+	    tatraState->tatraMatrix = scratchGraph(&block, numFabricOutputs,
+						   aSwitch->numInputs);
+	    tatraState->peakRow = scratchInts(&block, aSwitch->numInputs);
+	    tatraState->request = scratchBitsets(&block, aSwitch->numInputs,
+						 numFabricOutputs);
+	    tatraState->demand = (Demand *)
+	      scratchCarve(&block, aSwitch->numInputs * sizeof(Demand));
+	    tatraState->sorted = (Demand *)
+	      scratchCarve(&block, aSwitch->numInputs * sizeof(Demand));
+	    tatraState->numWithDemand = scratchInts(&block, numFabricOutputs+1);
 	  }
-	tatraState->tatraMatrix = tatraMatrix;
+	tatraMatrix = tatraState->tatraMatrix;
+	for(j = 0; j < aSwitch->numInputs; j++)
+	  tatraState->peakRow[j] = NONE;
+	for(i = 0; i < numFabricOutputs; i++)
+	  for(j = 0; j < aSwitch->numInputs; j++)
+	    tatraMatrix[i][j] = NONE;
 	tatraState->numOutputs = numFabricOutputs;
 	tatraState->numRows = aSwitch->numInputs;
 	tatraState->headRow = 0;
+	tatraState->seed[0] = 0x11ac;
+	tatraState->seed[1] = 0xf12b;
+	tatraState->seed[2] = 0x2671;
+	tatraState->animFp = NULL;
 	if(anim)
 	  {
-	    animFp = fopen(ANIM_FILE, "wt");
-	    if(!animFp)
+	    tatraState->animFp = fopen(ANIM_FILE, "wt");
+	    if(!tatraState->animFp)
 	      {
 		FatalError("TATRA: Unable to open ANIM_FILE\n");
 	      }
-	    fprintf(animFp, "M %d\nN %d\n", 
+	    fprintf(tatraState->animFp, "M %d\nN %d\n", 
 		    aSwitch->numInputs, aSwitch->numOutputs);
 	  }          
       
@@ -132,7 +156,9 @@ char** argv;
 
     case SCHEDULING_EXEC:
       {
-	static Demand *demand = NULL;
+	Demand *demand;
+	BitsetWord *request;
+	FILE *animFp;
 	int input, output, numNewInputs;
 	struct List *fifo;
 	Cell *aCell;
@@ -141,12 +167,10 @@ char** argv;
 	int numInputs;
 
 	numFabricOutputs = aSwitch->numOutputs * aSwitch->fabric.Xbar_numOutputLines;
-	if(!demand)
-	  {
-	    demand = (Demand*) malloc(sizeof(Demand) * aSwitch->numInputs);
-	  }
 
 	tatraState = (TatraState*)aSwitch->scheduler.schedulingState;
+	demand = tatraState->demand;
+	animFp = tatraState->animFp;
 	tatraMatrix = tatraState->tatraMatrix;
 	headRow = tatraState->headRow;
 	numInputs = aSwitch->numInputs;
@@ -162,8 +186,11 @@ char** argv;
 		if(aCell->commonStats.headArrivalTime == NONE)
 		  {
 		    aCell->commonStats.headArrivalTime = now;
+		    request = tatraState->request[input];
+		    bitmapToBitset(&aCell->outputs, request, numFabricOutputs);
 		    demand[numNewInputs].input = input;
-		    demand[numNewInputs].demand = bitmapNumSet(&aCell->outputs);
+		    demand[numNewInputs].demand = 
+		      bitsetNumSet(request, numFabricOutputs);
 		    numNewInputs++;
 		  }
 	      }
@@ -171,14 +198,14 @@ char** argv;
 
 	/* Sort inputs in order of increasing demands, with demand being 
 	   num of outputs requested*/
-	qsort((char*)demand, numNewInputs, sizeof(Demand), demand_compare);
+	sortByDemand(tatraState, numNewInputs);
+	demand = tatraState->sorted;
 
 	/* Add new cells at the head of queues into the tatraMatrix in order of demand*/
 	for(i = 0; i < numNewInputs; i++)
 	  {
 	    input = demand[i].input;
-	    fifo = aSwitch->inputBuffer[input]->mcastFifo[DEFAULT_PRIORITY];
-	    aCell = (Cell*)fifo->head->Object;
+	    request = tatraState->request[input];
 	    if(debug_tatra)
 	      {
 		int op;
@@ -186,7 +213,7 @@ char** argv;
 		       input);
 		for(op = 0; op < numFabricOutputs; op++)
 		  {
-		    if(bitmapIsBitSet(op, &aCell->outputs))
+		    if(BITSET_IS_SET(request, op))
 		      printf("1 ");
 		    else
 		      printf("0 ");
@@ -203,7 +230,7 @@ char** argv;
 		  {
 		    int height = -1;
             
-		    if(bitmapIsBitSet(op, &aCell->outputs))
+		    if(BITSET_IS_SET(request, op))
 		      {
 			int r;
 			r = headRow;
@@ -217,7 +244,7 @@ char** argv;
 		fprintf(animFp, "\n");
 	      }
         
-	    addToTatraMatrix(tatraState, input, &aCell->outputs);
+	    addToTatraMatrix(tatraState, input, request);
 	    if(debug_tatra)
 	      {
 		printf("After rearrangenment: --------->\n");
@@ -266,35 +293,54 @@ char** argv;
     }
 }
 	    
-static int 
-demand_compare(d1, d2)
-  Demand *d1, *d2;
+/*
+ * Sort the new head of line cells by demand, into sorted[], with a
+ * counting sort.  Cells of equal demand are put in a random order by
+ * shuffling them first, the sort being stable.
+ */
+static void
+sortByDemand(tatraState, numNewInputs)
+  TatraState *tatraState;
+int numNewInputs;
 {
-  double d;
-  static unsigned short seed[3] = {0x11ac, 0xf12b, 0x2671};
-  
-  if(d1->demand < d2->demand)
-    return -1;
-  if(d1->demand > d2->demand)
-    return 1;
-  
-  d = erand48(seed);
-  if(d < 0.5)
-    return 1;
-  else
-    return -1;
+  Demand *demand = tatraState->demand;
+  Demand *sorted = tatraState->sorted;
+  int *numWithDemand = tatraState->numWithDemand;
+  int i, j, d, total;
+  Demand tmp;
+
+  for(i = numNewInputs - 1; i > 0; i--)
+    {
+      j = (int) (nrand48(tatraState->seed) % (i + 1));
+      tmp = demand[i];
+      demand[i] = demand[j];
+      demand[j] = tmp;
+    }
+
+  memset(numWithDemand, 0, (tatraState->numOutputs + 1) * sizeof(int));
+  for(i = 0; i < numNewInputs; i++)
+    numWithDemand[demand[i].demand]++;
+  for(d = 0, total = 0; d <= tatraState->numOutputs; d++)
+    {
+      i = numWithDemand[d];
+      numWithDemand[d] = total;
+      total += i;
+    }
+  for(i = 0; i < numNewInputs; i++)
+    sorted[numWithDemand[demand[i].demand]++] = demand[i];
 }
 
 static void
 addToTatraMatrix(tatraState, input, request)
   TatraState *tatraState;
 int input;
-Bitmap *request;
+BitsetWord *request;
 {
-  int output, row;
+  int numWords = BITSET_NUM_WORDS(tatraState->numOutputs);
+  BitsetWord word;
+  int w, output, row;
   int headRow = tatraState->headRow;
   int numRows = tatraState->numRows;
-  int numOutputs = tatraState->numOutputs;
   int **tatraMatrix = tatraState->tatraMatrix;
   int *peakRow = tatraState->peakRow;
   int maxDD, maxRow, maxOutput;
@@ -308,41 +354,38 @@ Bitmap *request;
   maxOutput = -1;
   maxDD = -1;
   
-  for(output = 0; output < numOutputs; output++)
+  EVERY_BIT_SET(request, numWords, w, word, output)
     {
-      if(bitmapIsBitSet(output, request))
+      int startRow;
+      int opRow=0;
+      int opDD = numRows;
+
+      row = startRow = (headRow - 1 + numRows)%numRows;
+      do
 	{
-	  int startRow;
-	  int opRow=0;
-	  int opDD = numRows;
-      
-	  row = startRow = (headRow - 1 + numRows)%numRows;
-	  do
+	  int ip, raise1;
+
+	  ip = tatraMatrix[output][row];
+	  raise1 = 0;
+	  if(ip != NONE)
 	    {
-	      int ip, raise1;
-        
-	      ip = tatraMatrix[output][row];
-	      raise1 = 0;
-	      if(ip != NONE)
+	      raise1 = (peakRow[ip] - row + numRows)%numRows;
+	      if(debug_tatra)
 		{
-		  raise1 = (peakRow[ip] - row + numRows)%numRows;
-		  if(debug_tatra)
-		    {
-		      printf("op = %d, ip = %d raise = %d\n", output, ip, raise1);
-		    }
-		  if(raise1 == 0)
-		    break;
+		  printf("op = %d, ip = %d raise = %d\n", output, ip, raise1);
 		}
-	      opDD = (row + numRows - headRow)%numRows;
-	      opRow = row;
-	      row = (row - 1 + numRows) % numRows;
-	    }while(row != startRow);
-	  if(opDD > maxDD)
-	    {
-	      maxDD = opDD;
-	      maxRow = opRow;
-	      maxOutput = output;
+	      if(raise1 == 0)
+		break;
 	    }
+	  opDD = (row + numRows - headRow)%numRows;
+	  opRow = row;
+	  row = (row - 1 + numRows) % numRows;
+	}while(row != startRow);
+      if(opDD > maxDD)
+	{
+	  maxDD = opDD;
+	  maxRow = opRow;
+	  maxOutput = output;
 	}
     }
   peakRow[input] = maxRow;
@@ -352,44 +395,41 @@ Bitmap *request;
 	     input, maxRow, maxOutput, maxDD);
     }
   
-  for(output = 0; output < numOutputs; output++)
+  EVERY_BIT_SET(request, numWords, w, word, output)
     {
-      if(bitmapIsBitSet(output, request))
+      row = headRow;
+      do
 	{
-	  row = headRow;
-	  do
+	  int ip;
+	  int thisDD;
+
+	  ip = tatraMatrix[output][row];
+	  if(ip == NONE)
 	    {
-	      int ip;
-	      int thisDD;
+	      tatraMatrix[output][row] = input;
+	      break;
+	    }
+	  thisDD = (peakRow[ip] - headRow + numRows)%numRows;
 
-	      ip = tatraMatrix[output][row];
-	      if(ip == NONE)
-		{
-		  tatraMatrix[output][row] = input;
-		  break;
-		}
-	      thisDD = (peakRow[ip] - headRow + numRows)%numRows;
-          
-	      if(maxDD < thisDD)
+	  if(maxDD < thisDD)
+	    {
+	      int r;
+	      int curValue;
+
+	      curValue = input;
+	      r = row;
+	      do
 		{
-		  int r;
-		  int curValue;
-
-		  curValue = input;
-		  r = row;
-		  do
-		    {
-		      int tmp;
-		      tmp = tatraMatrix[output][r];
-		      tatraMatrix[output][r] = curValue;
-		      curValue = tmp;
-		      r = (r + 1)%numRows;
-		    } while(r != headRow);
-		  break;
-		}
-	      row = (row + 1) % numRows;
-	    }while(row != headRow);
-	}
+		  int tmp;
+		  tmp = tatraMatrix[output][r];
+		  tatraMatrix[output][r] = curValue;
+		  curValue = tmp;
+		  r = (r + 1)%numRows;
+		} while(r != headRow);
+	      break;
+	    }
+	  row = (row + 1) % numRows;
+	}while(row != headRow);
     }
 }
 
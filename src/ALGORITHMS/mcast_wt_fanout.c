@@ -35,6 +35,8 @@
 #include <stdlib.h>
 #include "sim.h"
 #include "algorithm.h"
+#include "miscfns.h"
+#include "mcastRequest.h"
 
 #define debug_wt_fanout 0
 
@@ -49,6 +51,9 @@ typedef struct
   int grantPointer;
   int ageWeight;
   int fanoutWeight;
+  McastRequest request;	/* Head of line requests and fanouts */
+  int *weight;		/* Weight of each input */
+  int *grant;		/* Input granted by each output */
 }WtFanoutState;
 
 void 
@@ -71,6 +76,8 @@ char **argv;
       {
 	int c;
 	int ageWt, demandWt;
+	int numFabricOutputs, pass;
+	ScratchBlock block;
 	extern int optind;
 	extern int optopt;
 	extern int opterr;
@@ -102,6 +109,18 @@ char **argv;
 	  }
 	aSwitch->scheduler.schedulingState = malloc(sizeof(WtFanoutState));
 	wtFanoutState = (WtFanoutState*)aSwitch->scheduler.schedulingState;
+	numFabricOutputs = aSwitch->numOutputs *
+	  aSwitch->fabric.Xbar_numOutputLines;
+	scratchBegin(&block);
+	for(pass=0; pass<2; pass++)
+	  {
+	    if( pass )
+	      scratchAllocate(&block);
+	    layoutMcastRequest(&block, &wtFanoutState->request,
+			       aSwitch->numInputs, numFabricOutputs);
+	    wtFanoutState->weight = scratchInts(&block, aSwitch->numInputs);
+	    wtFanoutState->grant = scratchInts(&block, numFabricOutputs);
+	  }
 	wtFanoutState->grantPointer = 0;
 	wtFanoutState->ageWeight = ageWt;
 	wtFanoutState->fanoutWeight = demandWt;
@@ -111,8 +130,8 @@ char **argv;
 
     case SCHEDULING_EXEC:
       {
-	static int *weight = NULL;
-	static int *grant = NULL;
+	McastRequest *request;
+	int *weight, *grant;
 
 	int input, output, numNewInputs;
 	struct List *fifo;
@@ -123,15 +142,13 @@ char **argv;
 	int firstClashedInput;
 
 	numFabricOutputs = aSwitch->numOutputs * aSwitch->fabric.Xbar_numOutputLines;
-	if(!weight)
-	  {
-	    weight = (int*)malloc(sizeof(int) * aSwitch->numInputs);
-	    grant = (int*)malloc(sizeof(int) * numFabricOutputs);
-	  }
 
 	wtFanoutState = (WtFanoutState*)
 	  aSwitch->scheduler.schedulingState;
 	grantPointer = &(wtFanoutState->grantPointer);
+	request = &wtFanoutState->request;
+	weight = wtFanoutState->weight;
+	grant = wtFanoutState->grant;
 	ageWeight = wtFanoutState->ageWeight;
 	fanoutWeight = wtFanoutState->fanoutWeight;
 
@@ -152,37 +169,15 @@ char **argv;
 	      }
 	  }
 
+	/* Make the request rows and columns */
+	loadMcastRequest(aSwitch, request);
 	if(debug_wt_fanout)
 	  {
 	    printf("Request matrix:\n");
 	    for(input = 0; input < aSwitch->numInputs; input++)
-	      {
-		fifo =  aSwitch->inputBuffer[input]->mcastFifo[DEFAULT_PRIORITY];
-		if(fifo->number)
-		  {
-		    aCell = (Cell *) fifo->head->Object;
-		    for(output = 0; output < numFabricOutputs; output++)
-		      {
-			if(bitmapIsBitSet(output, &aCell->outputs))
-			  printf("1");
-			else
-			  printf("0");
-		      }
-		  }
-		else
-		  {
-		    for(output = 0; output < numFabricOutputs; output++)
-		      {
-			printf("0");
-		      }
-		  }
-		printf("\n");
-	      }
+	      bitsetPrint(stdout, request->row[input], numFabricOutputs);
 	  }
 
-
-
-
 	/* Compute the weight of each input */
 	for(input = 0; input < aSwitch->numInputs; input++)
 	  {
@@ -192,7 +187,7 @@ char **argv;
 		int myFanout, myAge;
 		aCell = (Cell *) fifo->head->Object;
 		myAge = now - aCell->commonStats.headArrivalTime;
-		myFanout = bitmapNumSet(&aCell->outputs);
+		myFanout = request->fanout[input];
 		weight[input] = ageWeight * myAge + 
 		  fanoutWeight * (numFabricOutputs - myFanout);
 	      }
@@ -205,58 +200,9 @@ char **argv;
 	    vectorPrint(stdout, weight, aSwitch->numInputs);
 	  }
 
-	firstClashedInput = NONE;
 	/* Find the input with maximum weight of each output */
-	for(output = 0; output < numFabricOutputs; output++)
-	  {
-	    int maxWeight;
-	    Bitmap maxWeightInputs;
-
-	    maxWeight = -1;
-	    bitmapReset(&maxWeightInputs);
-	    for(input = 0; input < aSwitch->numInputs; input++)
-	      {
-		fifo =  aSwitch->inputBuffer[input]->mcastFifo[DEFAULT_PRIORITY];
-		if(fifo->number)
-		  {
-		    aCell = (Cell *) fifo->head->Object;
-		    if(bitmapIsBitSet(output, &aCell->outputs))
-		      {
-			if(weight[input] == maxWeight)
-			  {
-			    bitmapSetBit(input, &maxWeightInputs);
-			  }
-			else if(weight[input] > maxWeight)
-			  {
-			    bitmapReset(&maxWeightInputs);
-			    bitmapSetBit(input, &maxWeightInputs);
-			    maxWeight = weight[input];
-			  }
-		      }
-		  }
-	      }
-	    grant[output] = NONE;
-	    if(maxWeight >= 0)
-	      {
-		input = *grantPointer;
-		for(;;)
-		  {
-		    if(bitmapIsBitSet(input, &maxWeightInputs))
-		      {
-			grant[output] = input;
-			if(bitmapNumSet(&maxWeightInputs) > 1)
-			  {
-			    if(firstClashedInput == NONE || input < firstClashedInput)
-
-			      firstClashedInput = input;
-			  }
-			break;
-		      }
-		    else
-		      input = (input + 1) % aSwitch->numInputs;
-		  }
-	      }
-	  }
+	firstClashedInput = grantMcastByWeight(request, weight, *grantPointer,
+					       grant);
 	if(debug_wt_fanout)
 	  {
 	    printf("Grants for each output:\n");
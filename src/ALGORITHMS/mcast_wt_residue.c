@@ -33,16 +33,16 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <string.h>
 #include "sim.h"
 #include "algorithm.h"
+#include "miscfns.h"
+#include "mcastRequest.h"
 
 #define debug_wt_residue 0
 
 #ifdef USE_ALL_FUNCS
 static int vectorSum();
 #endif
-static int vectorCommon();
 static void vectorPrint();
 
 typedef struct
@@ -50,6 +50,9 @@ typedef struct
   int grantPointer;
   int ageWeight;
   int residueWeight;
+  McastRequest request;	/* Head of line requests and residue */
+  int *weight;		/* Weight of each input */
+  int *grant;		/* Input granted by each output */
 }WtResidueState;
 
 void 
@@ -72,6 +75,8 @@ char **argv;
       {
 	int c;
 	int ageWt, demandWt;
+	int numFabricOutputs, pass;
+	ScratchBlock block;
 	extern int optind;
 	extern int optopt;
 	extern int opterr;
@@ -103,6 +108,18 @@ char **argv;
 	  }
 	aSwitch->scheduler.schedulingState = malloc(sizeof(WtResidueState));
 	wtResidueState = (WtResidueState*)aSwitch->scheduler.schedulingState;
+	numFabricOutputs = aSwitch->numOutputs *
+	  aSwitch->fabric.Xbar_numOutputLines;
+	scratchBegin(&block);
+	for(pass=0; pass<2; pass++)
+	  {
+	    if( pass )
+	      scratchAllocate(&block);
+	    layoutMcastRequest(&block, &wtResidueState->request,
+			       aSwitch->numInputs, numFabricOutputs);
+	    wtResidueState->weight = scratchInts(&block, aSwitch->numInputs);
+	    wtResidueState->grant = scratchInts(&block, numFabricOutputs);
+	  }
 	wtResidueState->grantPointer = 0;
 	wtResidueState->ageWeight = ageWt;
 	wtResidueState->residueWeight = demandWt;
@@ -112,10 +129,8 @@ char **argv;
 
     case SCHEDULING_EXEC:
       {
-	static int *residue=NULL;
-	static int **request = NULL;
-	static int *weight = NULL;
-	static int *grant = NULL;
+	McastRequest *request;
+	int *weight, *grant;
 
 	int input, output, numNewInputs;
 	struct List *fifo;
@@ -126,32 +141,16 @@ char **argv;
 	int firstClashedInput;
 
 	numFabricOutputs = aSwitch->numOutputs * aSwitch->fabric.Xbar_numOutputLines;
-	if(!residue)
-	  {
-	    residue = (int*)malloc(sizeof(int) * numFabricOutputs);
-	    request = (int**) malloc(sizeof(int*) * aSwitch->numInputs);
-	    for(input = 0; input < aSwitch->numInputs; input++)
-	      {
-		request[input] = (int*)malloc(sizeof(int) * numFabricOutputs);
-	      }
-	    weight = (int*)malloc(sizeof(int) * aSwitch->numInputs);
-	    grant = (int*)malloc(sizeof(int) * numFabricOutputs);
-	  }
 
 	wtResidueState = (WtResidueState*)
 	  aSwitch->scheduler.schedulingState;
 	grantPointer = &(wtResidueState->grantPointer);
+	request = &wtResidueState->request;
+	weight = wtResidueState->weight;
+	grant = wtResidueState->grant;
 	ageWeight = wtResidueState->ageWeight;
 	residueWeight = wtResidueState->residueWeight;
 
-	/* INITIALIZE */
-	for(input=0;input < aSwitch->numInputs; input++)
-	  {
-	    memset(request[input], 0, sizeof(int) * numFabricOutputs);
-	  }
-	memset(residue, 0, sizeof(int) * numFabricOutputs);
-
-
 	/* Mark new cells at head of input queues */
 	numNewInputs = 0;
 	for(input = 0; input < aSwitch->numInputs; input++)
@@ -168,42 +167,16 @@ char **argv;
 	      }
 	  }
 
-	/* Make the Request matrix and Residue vector */
+	/* Make the request rows and columns, and the outputs with residue */
+	loadMcastRequest(aSwitch, request);
 	if(debug_wt_residue)
 	  {
 	    printf("-------------\n");
 	    printf("Request:\n");
-	  }
-
-	for(input=0; input<aSwitch->numInputs; input++)
-	  {
-	    fifo = aSwitch->inputBuffer[input]->mcastFifo[DEFAULT_PRIORITY];
-	    if(fifo->number)
-	      {
-		aCell = (Cell *) fifo->head->Object;
-		for(output=0;output<numFabricOutputs;output++)
-		  {
-		    /* The range of outputs set by the TRAFFIC algo is different from the
-		       range being checked here. ritesh */
-			
-		    if( bitmapIsBitSet(output, &aCell->outputs) )
-		      {
-			residue[output]++;
-			request[input][output]=1;
-		      }
-		  }
-	      }
-
-	    if(debug_wt_residue)
-	      vectorPrint(stdout, request[input], numFabricOutputs);
-	  }
-	for(output=0;output<numFabricOutputs;output++)
-	  if( residue[output]>0 ) residue[output]--;
-
-	if(debug_wt_residue)
-	  {
+	    for(input=0; input<aSwitch->numInputs; input++)
+	      bitsetPrint(stdout, request->row[input], numFabricOutputs);
 	    printf("Residue:\n");
-	    vectorPrint(stdout, residue, numFabricOutputs);
+	    bitsetPrint(stdout, request->contended, numFabricOutputs);
 	    printf("-------------\n");
 	  }
 
@@ -216,8 +189,7 @@ char **argv;
 		int myResidue, myAge;
 		aCell = (Cell *) fifo->head->Object;
 		myAge = now - aCell->commonStats.headArrivalTime;
-		myResidue = vectorCommon(request[input], residue, 
-					 numFabricOutputs);
+		myResidue = commonWithContended(request, input);
 		weight[input] = ageWeight * myAge + 
 		  residueWeight * (numFabricOutputs - myResidue);
 	      }
@@ -231,53 +203,9 @@ char **argv;
 	    vectorPrint(stdout, weight, aSwitch->numInputs);
 	  }
 
-	firstClashedInput = NONE;
 	/* Find the input with maximum weight of each output */
-	for(output = 0; output < numFabricOutputs; output++)
-	  {
-	    int maxWeight;
-	    Bitmap maxWeightInputs;
-
-	    maxWeight = -1;
-	    bitmapReset(&maxWeightInputs);
-	    for(input = 0; input < aSwitch->numInputs; input++)
-	      {
-		if(request[input][output])
-		  {
-		    if(weight[input] == maxWeight)
-		      {
-			bitmapSetBit(input, &maxWeightInputs);
-		      }
-		    else if(weight[input] > maxWeight)
-		      {
-			bitmapReset(&maxWeightInputs);
-			bitmapSetBit(input, &maxWeightInputs);
-			maxWeight = weight[input];
-		      }
-		  }
-	      }
-	    grant[output] = NONE;
-	    if(maxWeight >= 0)
-	      {
-		input = *grantPointer;
-		for(;;)
-		  {
-		    if(bitmapIsBitSet(input, &maxWeightInputs))
-		      {
-			grant[output] = input;
-			if(bitmapNumSet(&maxWeightInputs) > 1)
-			  {
-			    if(firstClashedInput == NONE || input < firstClashedInput)
-
-			      firstClashedInput = input;
-			  }
-			break;
-		      }
-		    else
-		      input = (input + 1) % aSwitch->numInputs;
-		  }
-	      }
-	  }
+	firstClashedInput = grantMcastByWeight(request, weight, *grantPointer,
+					       grant);
 	if(debug_wt_residue)
 	  {
 	    printf("Grants for each output:\n");
@@ -319,20 +247,6 @@ int size;
   return(sum);
 }
 #endif
-static int
-vectorCommon(vector1, vector2, size)
-  int *vector1, *vector2;
-int size;
-{	
-  int i, sum=0;
-  for(i=0;i<size;i++)
-    {
-      if(vector1[i]>0 && vector2[i]>0)
-	sum ++;
-    }
-  return(sum);
-}
-
 static void
 vectorPrint(fp, vector, size)
   FILE *fp;
@@ -0,0 +1,243 @@
+
+/* ****************************************************************
+ * Copyright Stanford University 1998,99 - All Rights Reserved
+ ****************************************************************** 
+
+ * Permission to use, copy, modify, and distribute this software 
+ * and its documentation for any purpose is hereby granted without 
+ * fee, provided that the above copyright notice appears in all copies
+ * and that both the copyright notice, this permission notice, and 
+ * the following disclaimer appear in supporting documentation, and 
+ * that the name of Stanford University, not be used in advertising or 
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.
+ * 
+ * STANFORD UNIVERSITY, DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND 
+ * FITNESS. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE FOR ANY 
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER 
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION 
+ * OF CONTRACT, NEGLIGENCE OR OTHER ACTION, ARISING OUT OF OR IN 
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * The Sim Web Site : http://klamath.stanford.edu/tools/SIM
+ * The SIM Mailing List: sim-simulator@lists.stanford.edu
+
+ * Send mail to the above email address with "subscribe sim-simulator" in
+ * the body of the message.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "sim.h"
+#include "miscfns.h"
+#include "mergeMatch.h"
+
+static void layoutMergeState();
+static long edgeWeight();
+static void drawSample();
+
+
+MergeSchedulerState *
+createMergeSchedulerState(Switch *aSwitch, int numProbes, int wholeMatch)
+{
+  MergeSchedulerState *state =
+    (MergeSchedulerState *) malloc(sizeof(MergeSchedulerState));
+  ScratchBlock block;
+  int pass, port;
+
+  state->n = aSwitch->numInputs > aSwitch->numOutputs ? 
+    aSwitch->numInputs : aSwitch->numOutputs;
+  state->numProbes = numProbes;
+  state->wholeMatch = wholeMatch;
+  state->slot = 0;
+  state->numMerged = 0;
+  state->numCycles = 0;
+
+  scratchBegin(&block);
+  for(pass=0; pass<2; pass++)
+    {
+      if( pass )
+	scratchAllocate(&block);
+      layoutMergeState(&block, state);
+    }
+
+  /* Start from the identity */
+  for(port=0; port<state->n; port++)
+    {
+      state->match[port] = port;
+      state->visited[port] = -1;
+    }
+  return(state);
+}
+
+static void
+layoutMergeState(ScratchBlock *block, MergeSchedulerState *state)
+{
+  state->match = scratchInts(block, state->n);
+  state->sample = scratchInts(block, state->n);
+  state->sampleOf = scratchInts(block, state->n);
+  state->visited = scratchInts(block, state->n);
+  state->spare = scratchInts(block, state->n);
+}
+
+/* Padding edges weigh nothing */
+static long
+edgeWeight(Switch *aSwitch, EdgeWeight weight, int input, int output)
+{
+  if( input >= aSwitch->numInputs || output >= aSwitch->numOutputs )
+    return(0);
+  return( (*weight)(aSwitch, input, output) );
+}
+
+/*
+ * Draw this slot's permutation.  Each input probes numProbes outputs
+ * at random and bids for the heaviest of their queues, if any is not
+ * empty; an output bid for by several inputs keeps the heaviest bid.  The
+ * inputs left over are then paired with the outputs left over at
+ * random.  With numProbes 0 every permutation is equally likely.
+ */
+static void
+drawSample(Switch *aSwitch, MergeSchedulerState *state, EdgeWeight weight)
+{
+  int n = state->n;
+  int *sample = state->sample, *sampleOf = state->sampleOf;
+  int *spare = state->spare;
+  int input, output, other, probe, numSpare, best;
+  long w, bestWeight;
+
+  for(output=0; output<n; output++)
+    sampleOf[output] = NONE;
+  for(input=0; input<n; input++)
+    {
+      sample[input] = NONE;
+      best = NONE;
+      bestWeight = 0;
+      for(probe=0; probe<state->numProbes; probe++)
+	{
+	  output = (int)(lrand48() % n);
+	  w = edgeWeight(aSwitch, weight, input, output);
+	  if( w > bestWeight )
+	    {
+	      best = output;
+	      bestWeight = w;
+	    }
+	}
+      if( best == NONE )
+	continue;
+      other = sampleOf[best];
+      if( other != NONE )
+	{
+	  if( edgeWeight(aSwitch, weight, other, best) >= bestWeight )
+	    continue;
+	  sample[other] = NONE;
+	}
+      sample[input] = best;
+      sampleOf[best] = input;
+    }
+
+  /* Shuffle the spare outputs and hand them out in input order */
+  numSpare = 0;
+  for(output=0; output<n; output++)
+    if( sampleOf[output] == NONE )
+      {
+	other = (int)(lrand48() % (numSpare + 1));
+	spare[numSpare] = spare[other];
+	spare[other] = output;
+	numSpare++;
+      }
+  for(input=0; input<n; input++)
+    if( sample[input] == NONE )
+      {
+	output = spare[--numSpare];
+	sample[input] = output;
+	sampleOf[output] = input;
+      }
+}
+
+/*
+ * Draw a permutation, merge it into the match and configure the
+ * crossbar with the edges of the result whose queues are not empty.
+ * Returns the number of those.
+ */
+int
+mergeMatch(Switch *aSwitch, MergeSchedulerState *state, EdgeWeight weight)
+{
+  int n = state->n;
+  int *match = state->match, *sample = state->sample;
+  int *sampleOf = state->sampleOf;
+  int input, output, other, start, size;
+  long matchWeight, sampleWeight;
+
+  drawSample(aSwitch, state, weight);
+
+  if( state->wholeMatch )
+    {
+      matchWeight = sampleWeight = 0;
+      for(input=0; input<n; input++)
+	{
+	  matchWeight += edgeWeight(aSwitch, weight, input, match[input]);
+	  sampleWeight += edgeWeight(aSwitch, weight, input, sample[input]);
+	}
+      state->numCycles++;
+      if( sampleWeight > matchWeight )
+	{
+	  state->numMerged++;
+	  for(input=0; input<n; input++)
+	    match[input] = sample[input];
+	}
+    }
+  else
+    {
+      /* Follow each cycle from input through its match edge to an */
+      /* output, and back through that output's sample edge.	      */
+      for(start=0; start<n; start++)
+	{
+	  if( state->visited[start] == state->slot )
+	    continue;
+	  matchWeight = sampleWeight = 0;
+	  input = start;
+	  do
+	    {
+	      state->visited[input] = state->slot;
+	      output = match[input];
+	      matchWeight += edgeWeight(aSwitch, weight, input, output);
+	      input = sampleOf[output];
+	      sampleWeight += edgeWeight(aSwitch, weight, input, output);
+	    }
+	  while( input != start );
+
+	  state->numCycles++;
+	  if( sampleWeight > matchWeight )
+	    {
+	      state->numMerged++;
+	      do
+		{
+		  other = sampleOf[match[input]];
+		  match[input] = sample[input];
+		  input = other;
+		}
+	      while( input != start );
+	    }
+	}
+    }
+  state->slot++;
+
+  size = 0;
+  for(input=0; input<aSwitch->numInputs; input++)
+    {
+      output = match[input];
+      if( output >= aSwitch->numOutputs
+	  || aSwitch->inputBuffer[input]->fifo[output]->number == 0 )
+	continue;
+      aSwitch->fabric.Xbar_matrix[output].input = input;
+      aSwitch->fabric.Xbar_matrix[output].cell = (Cell *)
+	aSwitch->inputBuffer[input]->fifo[output]->head->Object;
+      size++;
+    }
+  return(size);
+}
@@ -0,0 +1,75 @@
+
+/* ****************************************************************
+ * Copyright Stanford University 1998,99 - All Rights Reserved
+ ****************************************************************** 
+
+ * Permission to use, copy, modify, and distribute this software 
+ * and its documentation for any purpose is hereby granted without 
+ * fee, provided that the above copyright notice appears in all copies
+ * and that both the copyright notice, this permission notice, and 
+ * the following disclaimer appear in supporting documentation, and 
+ * that the name of Stanford University, not be used in advertising or 
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.
+ * 
+ * STANFORD UNIVERSITY, DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND 
+ * FITNESS. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE FOR ANY 
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER 
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION 
+ * OF CONTRACT, NEGLIGENCE OR OTHER ACTION, ARISING OUT OF OR IN 
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * The Sim Web Site : http://klamath.stanford.edu/tools/SIM
+ * The SIM Mailing List: sim-simulator@lists.stanford.edu
+
+ * Send mail to the above email address with "subscribe sim-simulator" in
+ * the body of the message.
+ *
+ */
+
+
+#ifndef _MERGEMATCH_H_
+#define _MERGEMATCH_H_
+
+/*
+ * Randomized approximation to a maximum weight match that remembers
+ * the last slot's match (Tassiulas, Infocom 98; the merge is that of
+ * Giaccone, Prabhakar and Shah, Infocom 02).
+ *
+ * The match is kept as a permutation of n = max(inputs, outputs)
+ * ports, padded with edges of weight zero.  Each slot a permutation is
+ * drawn at random, leaning towards queues that are not empty when
+ * numProbes > 0 (a uniform draw takes long to find the heavy edges of
+ * a large switch).  Together the two split into cycles that
+ * alternate between them, and on each cycle the edges of whichever is
+ * the heavier are kept.  With wholeMatch set the two are compared as a
+ * whole instead, as in Tassiulas' original.  Only the 2n edges of the
+ * two permutations and the probes are weighed, so a slot costs O(n).
+ */
+
+/* Weight of the edge from input to output; zero if the queue is empty */
+typedef long (*EdgeWeight)(Switch *aSwitch, int input, int output);
+
+typedef struct {
+  int n;		/* max(numInputs, numOutputs) */
+  int numProbes;	/* -d: random outputs each input tries per draw */
+  int wholeMatch;	/* -c: keep the heavier permutation, unmerged */
+  int *match;		/* [input] output in the current match */
+  int *sample;		/* [input] output in this slot's random draw */
+  int *sampleOf;	/* [output] input in this slot's random draw */
+  int *visited;		/* [input] slot in which its cycle was merged */
+  int *spare;		/* [n] outputs not bid for in this slot's draw */
+  long slot;
+  long numMerged;	/* Cycles on which the draw was kept */
+  long numCycles;
+} MergeSchedulerState;
+
+MergeSchedulerState *createMergeSchedulerState(Switch *aSwitch, int numProbes,
+					       int wholeMatch);
+int mergeMatch(Switch *aSwitch, MergeSchedulerState *state, EdgeWeight weight);
+
+#endif /* _MERGEMATCH_H_ */
@@ -0,0 +1,136 @@
+
+/* ****************************************************************
+ * Copyright Stanford University 1998,99 - All Rights Reserved
+ ****************************************************************** 
+
+ * Permission to use, copy, modify, and distribute this software 
+ * and its documentation for any purpose is hereby granted without 
+ * fee, provided that the above copyright notice appears in all copies
+ * and that both the copyright notice, this permission notice, and 
+ * the following disclaimer appear in supporting documentation, and 
+ * that the name of Stanford University, not be used in advertising or 
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.
+ * 
+ * STANFORD UNIVERSITY, DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND 
+ * FITNESS. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE FOR ANY 
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER 
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION 
+ * OF CONTRACT, NEGLIGENCE OR OTHER ACTION, ARISING OUT OF OR IN 
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * The Sim Web Site : http://klamath.stanford.edu/tools/SIM
+ * The SIM Mailing List: sim-simulator@lists.stanford.edu
+
+ * Send mail to the above email address with "subscribe sim-simulator" in
+ * the body of the message.
+ *
+ */
+
+
+#include "sim.h"
+#include "algorithm.h"
+#include "miscfns.h"
+#include "mergeMatch.h"
+
+extern void FatalError(char*);
+
+/*  Determines switch configuration 					*/
+/*  Configuration is filled into aSwitch->fabric.Xbar_matrix array 	*/
+/*  Merges a random permutation into last slot's match, each edge weighing the waiting time of its head of line cell. */
+
+static long
+cellAge(Switch *aSwitch, int input, int output)
+{
+  struct List *fifo = aSwitch->inputBuffer[input]->fifo[output];
+
+  if( fifo->number == 0 )
+    return(0);
+  return( 1 + now - ((Cell *)fifo->head->Object)->commonStats.arrivalTime );
+}
+
+
+void
+merge_ocf(action, aSwitch, argc, argv)
+  SwitchAction action;
+Switch *aSwitch;
+int argc;
+char **argv;
+{
+  MergeSchedulerState *state;
+
+  if(debug_algorithm)
+    printf("Algorithm 'merge_ocf()' called by switch %d\n", aSwitch->switchNumber);
+	
+  switch(action) {
+  case SCHEDULING_USAGE:
+    fprintf(stderr, "Options for \"merge_ocf\" scheduling algorithm:\n");
+    fprintf(stderr, "    -d random outputs each input tries per draw. Default: 4\n");
+    fprintf(stderr, "    -c keep the heavier of the two matches whole. Default: merge them\n");
+    break;
+  case SCHEDULING_INIT:	
+    if(debug_algorithm)
+      printf("	SCHEDULING_INIT\n");
+
+    if( aSwitch->scheduler.schedulingState == NULL )
+      {
+	int c, numProbes=4, wholeMatch=0;
+
+	opterr=0;
+	optind=1;
+	while( (c = getopt(argc, argv, "cd:")) != EOF )
+	  switch (c)
+	    {
+	    case 'd':
+	      numProbes = atoi(optarg);
+	      break;
+	    case 'c':
+	      wholeMatch = 1;
+	      break;
+	    case '?':
+	      fprintf(stderr, "-------------------------------\n");
+	      fprintf(stderr, "merge_ocf: Unrecognized option -%c\n", optopt);
+	      merge_ocf(SCHEDULING_USAGE);
+	      fprintf(stderr, "--------------------------------\n");
+	      exit(1);
+	    default:
+	      break;
+	    }
+	if( aSwitch->fabric.Xbar_numOutputLines != 1 )
+	  FatalError("merge_ocf: needs one line per output");
+	aSwitch->scheduler.schedulingState = 
+	  createMergeSchedulerState(aSwitch, numProbes, wholeMatch);
+	printf("numProbes %d\n", numProbes);
+	if( wholeMatch )
+	  printf("Whole match\n");
+      }
+    break;
+
+  case SCHEDULING_EXEC:
+    {
+      int size;
+
+      state = (MergeSchedulerState *) aSwitch->scheduler.schedulingState;
+      size = mergeMatch(aSwitch, state, cellAge);
+      if( debug_algorithm )
+	printf(" Size: %d\n", size); 
+      break;
+    }
+
+  case SCHEDULING_REPORT_STATS:
+    state = (MergeSchedulerState *) aSwitch->scheduler.schedulingState;
+    printf("merge_ocf: random draw kept on %ld of %ld %s\n",
+	   state->numMerged, state->numCycles,
+	   state->wholeMatch ? "slots" : "cycles");
+    break;
+
+  default:
+    break;
+  }
+
+  if(debug_algorithm)
+    printf("Algorithm 'merge_ocf()' completed for switch %d\n", aSwitch->switchNumber);
+}
@@ -34,6 +34,7 @@
 #include "sim.h"
 #include "rr.h"
 #include "scheduleStats.h"
+#include "miscfns.h"
 
 void countSynch(aSwitch)
   Switch *aSwitch;
@@ -63,3 +64,334 @@ void countSynch(aSwitch)
   scheduleStats(SCHEDULE_STATS_NUM_SYNC, aSwitch, &numSynch);
   /*****************************************************************/
 }
+
+/***********************************************************************/
+/* Per-switch scratch blocks                                           */
+/***********************************************************************/
+
+#define CACHE_ROUND(bytes) \
+  (((bytes) + CACHE_LINE_SIZE - 1) & ~((size_t) CACHE_LINE_SIZE - 1))
+
+void
+scratchBegin(ScratchBlock *block)
+{
+  block->base = NULL;
+  block->used = 0;
+}
+
+void
+scratchAllocate(ScratchBlock *block)
+{
+  void *base;
+
+  if( posix_memalign(&base, CACHE_LINE_SIZE, block->used ? block->used : 1) )
+    {
+      fprintf(stderr, "scratchAllocate: Out of memory (%lu bytes)\n",
+	      (unsigned long) block->used);
+      exit(1);
+    }
+  memset(base, 0, block->used);
+  block->base = (char *) base;
+  block->used = 0;
+}
+
+/* Returns the next cache-aligned piece of the block, or NULL while the
+   block is still being sized. */
+void *
+scratchCarve(ScratchBlock *block, size_t bytes)
+{
+  void *piece = NULL;
+
+  if( block->base )
+    piece = block->base + block->used;
+  block->used += CACHE_ROUND(bytes);
+  return(piece);
+}
+
+int *
+scratchInts(ScratchBlock *block, int n)
+{
+  return((int *) scratchCarve(block, n * sizeof(int)));
+}
+
+double *
+scratchDoubles(ScratchBlock *block, int n)
+{
+  return((double *) scratchCarve(block, n * sizeof(double)));
+}
+
+/* A rows x cols graph indexed [row][col]; the rows are contiguous and
+   each starts on a cache line. */
+int **
+scratchGraph(ScratchBlock *block, int rows, int cols)
+{
+  int **graph = (int **) scratchCarve(block, rows * sizeof(int *));
+  int stride = MATRIX_STRIDE(cols, int);
+  int *cells = scratchInts(block, rows * stride);
+  int row;
+
+  if( graph )
+    for(row=0; row<rows; row++)
+      graph[row] = cells + row * stride;
+  return(graph);
+}
+
+double **
+scratchDoubleGraph(ScratchBlock *block, int rows, int cols)
+{
+  double **graph = (double **) scratchCarve(block, rows * sizeof(double *));
+  int stride = MATRIX_STRIDE(cols, double);
+  double *cells = scratchDoubles(block, rows * stride);
+  int row;
+
+  if( graph )
+    for(row=0; row<rows; row++)
+      graph[row] = cells + row * stride;
+  return(graph);
+}
+
+BitsetWord *
+scratchBitset(ScratchBlock *block, int numBits)
+{
+  int numWords = BITSET_NUM_WORDS(numBits);
+
+  return((BitsetWord *) scratchCarve(block, 
+			     (numWords ? numWords : 1) * sizeof(BitsetWord)));
+}
+
+/* count bitsets of numBits each, indexed [set]. */
+BitsetWord **
+scratchBitsets(ScratchBlock *block, int count, int numBits)
+{
+  BitsetWord **sets =
+    (BitsetWord **) scratchCarve(block, count * sizeof(BitsetWord *));
+  int numWords = BITSET_NUM_WORDS(numBits);
+  BitsetWord *words;
+  int set;
+
+  if( !numWords )
+    numWords = 1;
+  words = (BitsetWord *) scratchCarve(block,
+				      count * numWords * sizeof(BitsetWord));
+  if( sets )
+    for(set=0; set<count; set++)
+      sets[set] = words + set * numWords;
+  return(sets);
+}
+
+/***********************************************************************/
+/* Input fifos changed since the last slot                             */
+/***********************************************************************/
+
+void
+layoutFifoChanges(ScratchBlock *block, FifoChanges *changes, 
+		  int numInputs, int numFifos)
+{
+  changes->numFifos = numFifos;
+  changes->isListed = scratchBitset(block, numInputs * numFifos);
+  changes->listed = scratchInts(block, numInputs * numFifos);
+  changes->numListed = 0;
+}
+
+void
+noteFifoChange(FifoChanges *changes, int input, int fifo)
+{
+  int k = input * changes->numFifos + fifo;
+
+  if( BITSET_IS_SET(changes->isListed, k) )
+    return;
+  BITSET_SET(changes->isListed, k);
+  changes->listed[changes->numListed++] = k;
+}
+
+/* E.g. when the scheduler starts: it has not seen any of the fifos. */
+void
+noteAllFifosChanged(FifoChanges *changes, int numInputs)
+{
+  int input, fifo;
+
+  for(input=0; input<numInputs; input++)
+    for(fifo=0; fifo<changes->numFifos; fifo++)
+      noteFifoChange(changes, input, fifo);
+}
+
+/* Takes a changed fifo off the list: returns it, and its input in */
+/* *input, or NONE once there are no more.                          */
+int
+nextFifoChange(FifoChanges *changes, int *input)
+{
+  int k;
+
+  if( changes->numListed == 0 )
+    return(NONE);
+  k = changes->listed[--changes->numListed];
+  BITSET_RESET(changes->isListed, k);
+  *input = k / changes->numFifos;
+  return(k % changes->numFifos);
+}
+
+/***********************************************************************/
+/* Dense weight matrix kernels                                         */
+/***********************************************************************/
+
+/* Zero a graph from scratchGraph() with one pass over its cells. */
+void
+matrixClear(int **graph, int rows, int cols)
+{
+  if( rows > 0 )
+    memset(graph[0], 0, (size_t) rows * MATRIX_STRIDE(cols, int) * sizeof(int));
+}
+
+/* to = -from, e.g. to turn weights into assignment costs. */
+void
+matrixNegate(int **to, int **from, int rows, int cols)
+{
+  int row, col;
+  int *t, *f;
+
+  for(row=0; row<rows; row++)
+    {
+      t = to[row];
+      f = from[row];
+      for(col=0; col<cols; col++)
+	t[col] = -f[col];
+    }
+}
+
+/* Index of the largest entry in row[0..cols-1]; the lowest index wins
+   ties.  Returns NONE for an empty row. */
+int
+matrixRowArgmax(int *row, int cols)
+{
+  int col, best = NONE;
+
+  for(col=0; col<cols; col++)
+    if( best == NONE || row[col] > row[best] )
+      best = col;
+  return(best);
+}
+
+void
+layoutAp2Workspace(ScratchBlock *block, Ap2Workspace *ws, int n)
+{
+  ws->n = n;
+  ws->stride = MATRIX_STRIDE(n, int);
+  ws->cost = scratchGraph(block, n, n);
+  ws->ccost = ws->cost ? ws->cost[0] : NULL;
+  ws->idual = scratchInts(block, n);
+  ws->jdual = scratchInts(block, n);
+  ws->assn = scratchInts(block, n);
+  ws->match = scratchGraph(block, n, n);
+}
+
+/***********************************************************************/
+/* Shuffled request graphs for the maximum weight matching algorithms */
+/***********************************************************************/
+
+/* Side of the square request graph used by the matching algorithms. */
+int
+matchGraphSize(Switch *aSwitch)
+{
+  int numFabricOutputs;
+
+  numFabricOutputs = aSwitch->numOutputs*aSwitch->fabric.Xbar_numOutputLines;
+  return( (numFabricOutputs > aSwitch->numInputs) ? numFabricOutputs :
+	  aSwitch->numInputs );
+}
+
+void
+layoutMatchScratch(ScratchBlock *block, MatchScratch *scratch, int n)
+{
+  scratch->n = n;
+  scratch->seed[0] = 0x1243;
+  scratch->seed[1] = 0xab43;
+  scratch->seed[2] = 0xfc92;
+  scratch->graph = scratchGraph(block, n, n);
+  scratch->shuffled = scratchGraph(block, n, n);
+  scratch->unshuffled = scratchGraph(block, n, n);
+  scratch->si = scratchInts(block, n);
+  scratch->so = scratchInts(block, n);
+  layoutAp2Workspace(block, &scratch->ap2, n);
+}
+
+MatchScratch *
+createMatchScratch(int n)
+{
+  MatchScratch *scratch = (MatchScratch *) malloc(sizeof(MatchScratch));
+  ScratchBlock block;
+  int pass;
+
+  scratchBegin(&block);
+  for(pass=0; pass<2; pass++)
+    {
+      if( pass )
+	scratchAllocate(&block);
+      layoutMatchScratch(&block, scratch, n);
+    }
+  return(scratch);
+}
+
+/* Randomly permute the inputs and outputs of scratch->graph, so that
+   ties in the matching are not always broken in favour of low numbered
+   ports.  Returns the permuted graph. */
+int **
+shuffleMatchGraph(MatchScratch *scratch)
+{
+  int n = scratch->n;
+  int *si = scratch->si, *so = scratch->so;
+  int input, output;
+  int selection;
+
+  for(input=0; input<n; input++)
+    si[input]=NONE;
+  for(output=0; output<n; output++)
+    so[output]=NONE;
+
+  /* Shuffle set of inputs */
+  for(input=0; input<n; input++)
+    {
+      do {
+	selection = nrand48(scratch->seed)%n;
+      } while(si[selection] != NONE);
+      si[selection] = input;
+    }
+  /* Shuffle set of outputs */
+  for(output=0; output<n; output++)
+    {
+      do {
+	selection = nrand48(scratch->seed)%n;
+      } while(so[selection] != NONE);
+      so[selection] = output;
+    }
+
+  /* Shuffle the graph */
+  for(input=0; input<n; input++)
+    {
+      int *from = scratch->graph[input];
+      int *to = scratch->shuffled[si[input]];
+
+      for(output=0; output<n; output++)
+	to[so[output]] = from[output];
+    }
+
+  return(scratch->shuffled);
+}
+
+/* Map a match found on the shuffled graph back to real port numbers. */
+int **
+unshuffleMatchGraph(MatchScratch *scratch, int **match)
+{
+  int n = scratch->n;
+  int input, output;
+
+  for(input=0; input<n; input++)
+    {
+      int *from = match[scratch->si[input]];
+      int *to = scratch->unshuffled[input];
+
+      for(output=0; output<n; output++)
+	to[output] = from[scratch->so[output]];
+    }
+
+  return(scratch->unshuffled);
+}
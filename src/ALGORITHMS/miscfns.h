@@ -33,6 +33,87 @@
 #ifndef _MISCFNS_H_
 #define _MISCFNS_H_
 
+#include <stddef.h>
+#include "assign2.h"
+
 void countSynch();
 
+/* Scheduling algorithms keep their working buffers in per-switch state
+ * rather than in function-level statics, so that several switches may
+ * run the same algorithm.  Each algorithm lays its buffers out in one
+ * cache-line aligned block at SCHEDULING_INIT: the layout code is run
+ * once after scratchBegin() to add up the space needed, and again after
+ * scratchAllocate() to carve the zeroed block into real pointers.
+ */
+#define CACHE_LINE_SIZE 64
+
+typedef struct {
+  char   *base;		/* NULL while sizing the block */
+  size_t used;		/* Bytes laid out so far */
+} ScratchBlock;
+
+void scratchBegin(ScratchBlock *block);
+void scratchAllocate(ScratchBlock *block);
+void *scratchCarve(ScratchBlock *block, size_t bytes);
+int *scratchInts(ScratchBlock *block, int n);
+double *scratchDoubles(ScratchBlock *block, int n);
+int **scratchGraph(ScratchBlock *block, int rows, int cols);
+double **scratchDoubleGraph(ScratchBlock *block, int rows, int cols);
+BitsetWord *scratchBitset(ScratchBlock *block, int numBits);
+BitsetWord **scratchBitsets(ScratchBlock *block, int count, int numBits);
+
+/* Dense weight matrices.  A graph carved by scratchGraph() is a single
+ * block of rows, each padded out to a whole number of cache lines, with
+ * graph[row] pointing at the start of each row.  The kernels below
+ * work on whole matrices at once; matrixClear() relies on the rows
+ * being contiguous, so use it only on graphs from scratchGraph().
+ */
+#define MATRIX_STRIDE(cols, type) \
+  ((int) ((((cols) * sizeof(type) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE) \
+	  * CACHE_LINE_SIZE / sizeof(type)))
+
+void matrixClear(int **graph, int rows, int cols);
+void matrixNegate(int **to, int **from, int rows, int cols);
+int matrixRowArgmax(int *row, int cols);
+void layoutAp2Workspace(ScratchBlock *block, Ap2Workspace *ws, int n);
+
+/* Buffers shared by the algorithms that shuffle a square request graph,
+ * solve it with ap2driver() (or gsaMatch()) and map the answer back.
+ */
+typedef struct {
+  int  n;			/* Side of the square request graph */
+  unsigned short seed[3];	/* Private stream used by the shuffle */
+  int  **graph;			/* Request weights [input][output] */
+  int  **shuffled;		/* graph with rows and columns permuted */
+  int  **unshuffled;		/* Match mapped back to real ports */
+  int  *si, *so;		/* Input and output permutations */
+  Ap2Workspace ap2;		/* Workspace for ap2driver() */
+} MatchScratch;
+
+int matchGraphSize(Switch *aSwitch);
+void layoutMatchScratch(ScratchBlock *block, MatchScratch *scratch, int n);
+MatchScratch *createMatchScratch(int n);
+int **shuffleMatchGraph(MatchScratch *scratch);
+int **unshuffleMatchGraph(MatchScratch *scratch, int **match);
+
+/* Input fifos changed since the scheduler last looked, for algorithms
+ * that keep their own picture of the queues rather than scanning every
+ * fifo each slot.  The input action reports each fifo that gains or
+ * loses cells through aSwitch->scheduler.fifoChanged (inputQueue.c);
+ * noteFifoChange() lists a fifo once however often it changes, and
+ * nextFifoChange() hands the list back, in no particular order.
+ */
+typedef struct {
+  int  numFifos;		/* Fifos tracked per input */
+  BitsetWord *isListed;		/* [input*numFifos+fifo] */
+  int  *listed;			/* Those changed, each once */
+  int  numListed;
+} FifoChanges;
+
+void layoutFifoChanges(ScratchBlock *block, FifoChanges *changes,
+		       int numInputs, int numFifos);
+void noteFifoChange(FifoChanges *changes, int input, int fifo);
+void noteAllFifosChanged(FifoChanges *changes, int numInputs);
+int nextFifoChange(FifoChanges *changes, int *input);
+
 #endif
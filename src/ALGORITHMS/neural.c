@@ -35,21 +35,50 @@
 #include "sim.h"
 #include "algorithm.h"
 #include "neural.h"
+#include "miscfns.h"
 
-static int **unshuffleGraph();
-static int **shuffleGraph();
-static int **makeGraph();
 static void algorithmStats();
-static int maxrand();
-static void clearGraph();
-static void printGraph();
-static int DepthFirstFromInput();
-static int DepthFirstFromOutput();
-static int FindOutputSet();
-static int numOutputsSet();
+static NeuralState *createNeuralState();
+static int updateRow();
 
+/* Adding 1.5 * 2^52 rounds a double to an integer, left in the low */
+/* bits of the sum.                                                  */
+#define ROUND_MAGIC 6755399441055744.0
+#define ROUND_MAGIC_BITS 0x4338000000000000LL
 
 
+
+/*
+  exp(y) for the amplifiers' sigmoid, 0.5(1+tanh(x)) = 1/(1+exp(-2x)),
+  to within a few parts in 1e13 of the library's. y = k ln2 + r with
+  |r| <= ln2/2: a polynomial gives exp(r) and 2^k is put together in
+  the exponent bits. k is clamped with fabs() rather than compares, so
+  there are no branches or calls and the compiler can vectorize the
+  loops that use it. Beyond +-709 the result saturates rather than
+  being exact, which the sigmoid does not notice.
+*/
+static inline double
+fastExp(double y)
+{
+  double t, k, r, p;
+  long long bits;
+
+  t = y * 1.4426950408889634 + ROUND_MAGIC;	/* round y/ln2 to k */
+  k = t - ROUND_MAGIC;
+  r = y - k * 0.6931471805599453;
+  p = 1.0 + r*(1.0 + r*(1.0/2 + r*(1.0/6 + r*(1.0/24 + r*(1.0/120 +
+      r*(1.0/720 + r*(1.0/5040 + r*(1.0/40320 + r*(1.0/362880 +
+      r*(1.0/3628800))))))))));
+
+  k = 0.5 * (k - 1022.0 + fabs(k + 1022.0));	/* max(k, -1022) */
+  k = 0.5 * (k + 1023.0 - fabs(k - 1023.0));	/* min(k, 1023) */
+  t = k + ROUND_MAGIC;
+  memcpy(&bits, &t, sizeof(bits));
+  bits = (bits - ROUND_MAGIC_BITS + 1023) << 52;
+  memcpy(&t, &bits, sizeof(t));
+  return(p * t);
+}
+
 void
 neural(action, aSwitch, argc, argv)
   SwitchAction action;
@@ -57,30 +86,18 @@ Switch *aSwitch;
 int argc;
 char **argv;
 {
-  static double **u, **v, **gain;
-  static double *ColSum, *RowSum;
-  static int initialized=0;
-  static double threshold=DEFAULT_THRESHOLD;
-  static double stepsize=DEFAULT_STEPSIZE;
-  static double weight_a=A;
-  static double weight_b=B;
-  static double weight_c=C;
-  static double gain_bw=GAIN_BW;
-  static double gainNoiseFactor=0.0;
-  static double rc_value=RC_VALUE;
-
-  static int compareMaxFlag=0;
+  NeuralState *state;
+  double **u, **v, **gain;
+  double *ColSum, *RowSum;
   int size=0, maxSize=0;
 
   InputBuffer  *inputBuffer;
 
   int input,output;
   int selected_input;
-  double temp, rate;
   double bias;
-  double columnSum, rowSum;
-  double diff, maxdiff;
   double gainNoise;
+  int unsettled;
 
   int iterations=0;
   int badChoice=0;
@@ -106,7 +123,7 @@ char **argv;
   case SCHEDULING_INIT:
     if(debug_algorithm) printf("    SCHEDULING_INIT\n");
 
-    if( !initialized )
+    if( aSwitch->scheduler.schedulingState == NULL )
       {
 	/* Parse inputs */
 	extern int opterr;
@@ -115,6 +132,8 @@ char **argv;
 	extern char *optarg;
 	int c;
 
+	state = createNeuralState(aSwitch);
+	aSwitch->scheduler.schedulingState = state;
 
 	opterr=0;
 	optind=1;
@@ -122,31 +141,31 @@ char **argv;
 	  switch (c)
 	    {
 	    case 't':
-	      threshold = atof(optarg);
+	      state->threshold = atof(optarg);
 	      break;
 	    case 's':
-	      stepsize = atof(optarg);
+	      state->stepsize = atof(optarg);
 	      break;
 	    case 'a':
-	      weight_a = atof(optarg);
+	      state->weight_a = atof(optarg);
 	      break;
 	    case 'b':
-	      weight_b = atof(optarg);
+	      state->weight_b = atof(optarg);
 	      break;
 	    case 'c':
-	      weight_c = atof(optarg);
+	      state->weight_c = atof(optarg);
 	      break;
 	    case 'r':
-	      rc_value = atof(optarg);
+	      state->rc_value = atof(optarg);
 	      break;
 	    case 'g':
-	      gain_bw = atof(optarg);
+	      state->gain_bw = atof(optarg);
 	      break;
 	    case 'f':
-	      gainNoiseFactor = atof(optarg);
+	      state->gainNoiseFactor = atof(optarg);
 	      break;
 	    case 'm':
-	      compareMaxFlag++;
+	      state->compareMaxFlag++;
 	      break;
 	    case '?':
 	      fprintf(stderr, "-------------------------------\n");
@@ -157,40 +176,23 @@ char **argv;
 	    default:
 	      break;
 	    }
-	printf("Threshold %f\n", threshold);
-	printf("Stepsize  %f\n", stepsize);
-	printf("Weight A  %f\n", weight_a);
-	printf("Weight B  %f\n", weight_b);
-	printf("Weight C  %f\n", weight_c);
-	printf("RC Value  %f\n", rc_value);
-	printf("Gain BW   %f\n", gain_bw);
-	printf("Gain Noise Factor  %f\n", gainNoiseFactor);
-
-	/* Allocate arrays for input, output and differences */
-	u = (double **) calloc( aSwitch->numInputs, sizeof(double *));
-	v = (double **) calloc( aSwitch->numInputs, sizeof(double *));
-
-	/* Allocate array of gain per amplifier */
-	gain = (double **) calloc( aSwitch->numInputs, sizeof(double *));
-
-	for(input=0;input<aSwitch->numInputs;input++)
-	  {
-	    u[input] = (double *) calloc(aSwitch->numOutputs,sizeof(double));
-	    v[input] = (double *) calloc(aSwitch->numOutputs,sizeof(double));
-	    gain[input] = (double *) calloc(aSwitch->numOutputs,sizeof(double));
-	    RowSum = (double *) calloc(aSwitch->numOutputs, sizeof(double));
-
-	  }
-	for(output=0;output<aSwitch->numOutputs;output++)
-	  ColSum = (double *) calloc(aSwitch->numInputs, sizeof(double));
+	printf("Threshold %f\n", state->threshold);
+	printf("Stepsize  %f\n", state->stepsize);
+	printf("Weight A  %f\n", state->weight_a);
+	printf("Weight B  %f\n", state->weight_b);
+	printf("Weight C  %f\n", state->weight_c);
+	printf("RC Value  %f\n", state->rc_value);
+	printf("Gain BW   %f\n", state->gain_bw);
+	printf("Gain Noise Factor  %f\n", state->gainNoiseFactor);
 
 	/* Initialize random gains for amplifiers */
 	for(input=0;input<aSwitch->numInputs;input++)
 	  {
 	    for(output=0;output<aSwitch->numOutputs;output++)
 	      {
-		gainNoise = (drand48() - 0.5)*gainNoiseFactor;
-		gain[input][output] = (1.0+gainNoise)*gain_bw;
+		gainNoise = (drand48() - 0.5)*state->gainNoiseFactor;
+		state->gain[input][output] = (1.0+gainNoise)*state->gain_bw;
+		state->expScale[input][output] = -2.0/state->gain[input][output];
 	      }
 	  }
 				
@@ -199,14 +201,19 @@ char **argv;
 	aSwitch->scheduler.schedulingStats = 
 	  (void *) malloc(sizeof(struct AlgorithmStats));
 	algorithmStats(INIT_ALGORITHM_STATS, aSwitch);
-
-	initialized = 1;
       }
 
     break;
   case SCHEDULING_EXEC:
     if(debug_algorithm) printf("    SCHEDULING_EXEC\n");
 
+    state = (NeuralState *) aSwitch->scheduler.schedulingState;
+    u = state->u;
+    v = state->v;
+    gain = state->gain;
+    ColSum = state->ColSum;
+    RowSum = state->RowSum;
+
     /* Initialize input and output arrays */
     for (input = 0; input < aSwitch->numInputs; input++){
       inputBuffer = aSwitch->inputBuffer[input];
@@ -223,7 +230,20 @@ char **argv;
 	    u[input][output] = -(1.0+bias) * gain[input][output];
 	  }
 		
-	v[input][output] =  0.5 * ( 1.0 + tanh(u[input][output]/gain[input][output]));  	
+	v[input][output] = 1.0 / 
+	  (1.0 + fastExp(u[input][output] * state->expScale[input][output]));
+      }
+    }
+
+    /* Calculate initial row and column sums */
+    for (output = 0; output < aSwitch->numOutputs; output++){
+      ColSum[output] = 0;
+    }
+    for (input = 0; input < aSwitch->numInputs; input++) {
+      RowSum[input] = 0;
+      for (output = 0; output < aSwitch->numOutputs; output++){
+	RowSum[input] += v[input][output];
+	ColSum[output] += v[input][output];
       }
     }
 
@@ -233,46 +253,23 @@ char **argv;
        consecutive iterations for any output is less than "threshold"
        */
     do {
-      maxdiff=0.0;
-
-      /* Calculate initial row and column sums */
       for (output = 0; output < aSwitch->numOutputs; output++){
-	ColSum[output] = 0;
+	state->NextColSum[output] = 0;
       }
+      unsettled = 0;
       for (input = 0; input < aSwitch->numInputs; input++) {
+	unsettled += updateRow(state, input, aSwitch->numOutputs);
 	RowSum[input] = 0;
 	for (output = 0; output < aSwitch->numOutputs; output++){
 	  RowSum[input] += v[input][output];
-	  ColSum[output] += v[input][output];
-	}
-      }
-
-      for (input = 0; input < aSwitch->numInputs; input++) {
-	for (output = 0; output < aSwitch->numOutputs; output++){
-	  rowSum = RowSum[input] - v[input][output];	 
-	  columnSum = ColSum[output] - v[input][output];	 
-
-	  rate = (-1.0 * u[input][output] / rc_value) - (weight_a * columnSum) - 
-	    (weight_b * rowSum) + (weight_c/2.0); 
-		
-	  u[input][output] += rate * stepsize;
-						
-	}
-      }		
-
-      /* Update outputs */
-      for (input = 0; input < aSwitch->numInputs; input++) {
-	for (output = 0; output < aSwitch->numOutputs; output++){
-	  temp = v[input][output];
-	  v[input][output] = 0.5 * ( 1 + tanh(u[input][output]/gain[input][output]));  	
-		
-	  diff = fabs(v[input][output] - temp);
-	  if (diff > maxdiff) maxdiff = diff;
 	}
       }
+      state->ColSum = state->NextColSum;
+      state->NextColSum = ColSum;
+      ColSum = state->ColSum;
 		
       iterations++;	
-    } while (maxdiff > threshold);
+    } while (unsettled);
 	
     if(debug_algorithm)	
       {
@@ -288,7 +285,7 @@ char **argv;
       }
 
     /* Compare match with the size for a maximum matching */
-    if( compareMaxFlag ) 
+    if( state->compareMaxFlag ) 
       {
 	size=0;
 	for(input=0; input<aSwitch->numInputs; input++)
@@ -304,7 +301,7 @@ char **argv;
 
 	printf("N: %d ", size); 
 	fflush(stdout);
-	maxSize = maxrand(aSwitch);
+	maxSize = findSizeMaxMatch(aSwitch, &state->maxMatchState);
 	printf("M: %d", maxSize);
 	if( maxSize != size )	
 	  printf(" <------------\n");
@@ -360,6 +357,46 @@ char **argv;
 }
 
 
+/*
+  One iteration for the amplifiers of input: update u from the old
+  row and column sums, then v, and add the new v into NextColSum.
+  A single pass over the row with no branches, so that it vectorizes.
+  Returns the number of amplifiers whose v moved by more than
+  threshold.
+*/
+static int
+updateRow(NeuralState *state, int input, int numOutputs)
+{
+  double *restrict u = state->u[input];
+  double *restrict v = state->v[input];
+  const double *restrict expScale = state->expScale[input];
+  const double *restrict colSum = state->ColSum;
+  double *restrict nextColSum = state->NextColSum;
+  double rowSum = state->RowSum[input];
+  double a = state->weight_a, b = state->weight_b;
+  double halfC = state->weight_c/2.0, rc = state->rc_value;
+  double stepsize = state->stepsize, threshold = state->threshold;
+  double rate, newV, slack;
+  unsigned long long sign, unsettled = 0;
+  int output;
+
+  for (output = 0; output < numOutputs; output++){
+    rate = (-1.0 * u[output] / rc) - (a * (colSum[output] - v[output])) -
+      (b * (rowSum - v[output])) + halfC;
+    u[output] += rate * stepsize;
+    newV = 1.0 / (1.0 + fastExp(u[output] * expScale[output]));
+
+    /* Count the moves over threshold from the sign bit of the */
+    /* slack: a compare here would stop the loop vectorizing.   */
+    slack = threshold - fabs(newV - v[output]);
+    memcpy(&sign, &slack, sizeof(sign));
+    unsettled += sign >> 63;
+    nextColSum[output] += newV;
+    v[output] = newV;
+  }
+  return((int) unsettled);
+}
+
 /* Update stats for number of iterations and bad choices 
 	(connections selected for empty queues) */
 void algorithmStats( action, aSwitch, parameter)
@@ -397,279 +434,39 @@ int parameter;
     }
 }
 
-static int 
-maxrand(aSwitch)
+/* Create the state for aSwitch, with default parameters */
+static NeuralState *
+createNeuralState(aSwitch)
   Switch *aSwitch;
 {
-  static int **graph=NULL;
-  static int **match=NULL;
-  static int **path=NULL;
-  static int *si=NULL;
-  static int *so=NULL;
-  int **newgraph;	
-  int size;
-
-  int input, output;
-
-  InputBuffer *inputBuffer;
-
-  if(debug_algorithm)
-    {
-      printf("	MAX\n");
-    }
-
-
-  if( !graph )
-    graph = makeGraph(aSwitch);
-  if( !match )
-    match = makeGraph(aSwitch);
-  if( !path )
-    path = makeGraph(aSwitch);
-  if( !si )
+  NeuralState *state = (NeuralState *) malloc(sizeof(NeuralState));
+  int numInputs = aSwitch->numInputs, numOutputs = aSwitch->numOutputs;
+  ScratchBlock block;
+  int pass;
+
+  state->threshold = DEFAULT_THRESHOLD;
+  state->stepsize = DEFAULT_STEPSIZE;
+  state->weight_a = A;
+  state->weight_b = B;
+  state->weight_c = C;
+  state->gain_bw = GAIN_BW;
+  state->gainNoiseFactor = 0.0;
+  state->rc_value = RC_VALUE;
+  state->compareMaxFlag = 0;
+  state->maxMatchState = NULL;
+
+  scratchBegin(&block);
+  for(pass=0; pass<2; pass++)
     {
-      si = (int *)malloc(sizeof(int)*aSwitch->numInputs);
-      printf("Make si\n");
-    }
-  if( !so )
-    {
-      so = (int *)malloc(sizeof(int)*aSwitch->numOutputs);
-      printf("Make so\n");
-    }
-
-  clearGraph(graph,aSwitch);
-  clearGraph(match,aSwitch);
-  clearGraph(path,aSwitch);
-
-  /* Fill in request graph */
-  size=0;
-  for(input=0; input<aSwitch->numInputs; input++)
-    {
-      inputBuffer = aSwitch->inputBuffer[input];
-      for(output=0; output<aSwitch->numOutputs; output++)
-	{
-	  if(inputBuffer->fifo[output]->number)
-	    {
-	      graph[input][output]=1;
-	      size++;
-	    }
-	}
-    }
-  /* printf(" %d ", size); */
-
-
-  if(debug_algorithm) 
-    {
-      printf("Traffic:\n");
-      printGraph(graph, aSwitch);
-    }
-
-  /* RANDOMIZE GRAPH */
-  newgraph = shuffleGraph(graph, si, so, aSwitch);
-
-  for(input=0; input!=aSwitch->numInputs;)
-    {	
-      for(input=0; input<aSwitch->numInputs; input++)
-	{	
-	  if( (numOutputsSet(match, input, aSwitch) == 0) &&
-	      DepthFirstFromInput(newgraph,match,path,input,aSwitch))	
-	    {
-	      break;
-	    }
-	}
-    }
-  /* UN-RANDOMIZE GRAPH */
-  newgraph = unshuffleGraph(match, si, so, aSwitch);
-  if(debug_algorithm) 
-    {
-      printf("Match:\n");
-      printGraph(newgraph, aSwitch);
-      printf("\n");
-    }
-
-
-  size=0;
-  for(output=0; output<aSwitch->numOutputs; output++)
-    for(input=0; input<aSwitch->numInputs; input++)
-      if(newgraph[input][output])
-	size++;
-  return(size);
-}
-
-static int **
-unshuffleGraph(graph, si, so, aSwitch)
-  int **graph;
-int *si, *so;
-Switch *aSwitch;
-{
-  int input, output;
-
-  static int **newgraph=NULL;
-  if( !newgraph )
-    newgraph = makeGraph(aSwitch);
-
-  /* UnShuffle the graph */
-  for(input=0; input<aSwitch->numInputs; input++)
-    for(output=0; output<aSwitch->numOutputs; output++)
-      newgraph[input][output] = graph[si[input]][so[output]];
-
-  return(newgraph);
-}
-static int **
-shuffleGraph(graph, si, so, aSwitch)
-  int **graph;
-int *si, *so;
-Switch *aSwitch;
-{
-  int input, output;
-  int selection;
-  static int **newgraph=NULL;
-  if( !newgraph )
-    newgraph = makeGraph(aSwitch);
-
-  for(input=0; input<aSwitch->numInputs; input++)
-    si[input]=NONE;
-  for(output=0; output<aSwitch->numOutputs; output++)
-    so[output]=NONE;
-
-  /* Shuffle set of inputs */
-  for(input=0; input<aSwitch->numInputs; input++)
-    {
-      do {
-	selection = lrand48()%aSwitch->numInputs;
-      } while(si[selection] != NONE);
-      si[selection] = input;
-    }
-  /* Shuffle set of outputs */
-  for(output=0; output<aSwitch->numOutputs; output++)
-    {
-      do {
-	selection = lrand48()%aSwitch->numOutputs;
-      } while(so[selection] != NONE);
-      so[selection] = output;
-    }
-
-  /* Shuffle the graph */
-  for(input=0; input<aSwitch->numInputs; input++)
-    for(output=0; output<aSwitch->numOutputs; output++)
-      newgraph[si[input]][so[output]] = graph[input][output];
-
-  return(newgraph);
-	
-}
-
-/***********************************************************************/
-static int
-DepthFirstFromInput(graph, match, path, startVertex, aSwitch)
-  int **graph;
-int **match;
-int **path;
-int startVertex;
-Switch *aSwitch;
-{
-  int output;
-
-  for(output=0; output<aSwitch->numOutputs; output++)
-    {
-      if( graph[startVertex][output] && !path[0][output]
-	  && DepthFirstFromOutput(graph, match, path, output, aSwitch) )
-	{
-	  match[startVertex][output] = 1;
-	  return(1);
-	}
-    }
-  return(0);
-}
-
-static int
-DepthFirstFromOutput(graph, match, path, startVertex, aSwitch)
-  int **graph;
-int **match;
-int **path;
-int startVertex;
-Switch *aSwitch;
-{
-  int result;
-
-  int i = FindOutputSet(match, startVertex, aSwitch);
-
-  if( i == NONE )
-    return( 1 );
-
-  path[0][startVertex] = 1;
-
-  if( (result = DepthFirstFromInput(graph, match, path, i, aSwitch) ))
-    match[i][startVertex]=0;
-  path[0][startVertex]=0;
-  return(result);
-}
-
-static int
-FindOutputSet(graph, output, aSwitch)
-  int **graph;
-int output;
-Switch *aSwitch;
-{
-  int input;
-
-  for(input=0; input<aSwitch->numInputs; input++)
-    {	
-      if( graph[input][output] )
-	return(input);
-    }
-  return(NONE);
-}
-
-
-static int
-numOutputsSet(graph, input, aSwitch)
-  int **graph;
-int input;
-Switch *aSwitch;
-{
-  int output, sum=0;
-
-  for(output=0; output<aSwitch->numOutputs; output++)
-    sum += graph[input][output];
-
-  return(sum);
-}
-
-static int **
-makeGraph(aSwitch)
-  Switch *aSwitch;
-{
-  int input;
-  int **graph;
-
-  graph = (int **) malloc(sizeof(int *) * aSwitch->numInputs);
-  for(input=0;input<aSwitch->numInputs; input++)
-    graph[input] = (int *) malloc(sizeof(int)*aSwitch->numOutputs);
-
-  return(graph);
-}
-
-static 
-void clearGraph(graph, aSwitch)
-  int **graph;
-Switch *aSwitch;
-{
-  int input;
-  for(input=0;input<aSwitch->numInputs; input++)
-    memset(graph[input], 0, sizeof(int)*aSwitch->numOutputs);
-}
-
-static void
-printGraph(graph, aSwitch)
-  int **graph;
-Switch *aSwitch;
-{
-  int input, output;
-  for(input=0;input<aSwitch->numInputs; input++)
-    {
-      for(output=0;output<aSwitch->numOutputs; output++)
-	{
-	  printf("%1d ", graph[input][output]);
-	}
-      printf("\n");
+      if( pass )
+	scratchAllocate(&block);
+      state->u = scratchDoubleGraph(&block, numInputs, numOutputs);
+      state->v = scratchDoubleGraph(&block, numInputs, numOutputs);
+      state->gain = scratchDoubleGraph(&block, numInputs, numOutputs);
+      state->RowSum = scratchDoubles(&block, numInputs);
+      state->ColSum = scratchDoubles(&block, numOutputs);
+      state->NextColSum = scratchDoubles(&block, numOutputs);
+      state->expScale = scratchDoubleGraph(&block, numInputs, numOutputs);
     }
+  return(state);
 }
@@ -49,6 +49,20 @@ typedef enum {
 		PRINT_ALGORITHM_BADCHOICE_STATS
 } AlgorithmStatsAction;
 
+/* Per-switch state: parameters from the command line and the
+   neuron arrays, indexed [input][output]. RowSum and ColSum hold the
+   sums of v; NextColSum gathers the next iteration's column sums. */
+typedef struct {
+	double threshold, stepsize;
+	double weight_a, weight_b, weight_c;
+	double gain_bw, gainNoiseFactor, rc_value;
+	int compareMaxFlag;
+	double **u, **v, **gain;
+	double **expScale;	/* -2/gain, so v = 1/(1+exp(u*expScale)) */
+	double *ColSum, *RowSum, *NextColSum;
+	void *maxMatchState;	/* Used by findSizeMaxMatch() for -m */
+} NeuralState;
+
 struct AlgorithmStats {
 	long sumBadChoice, numBadChoice;
 	long sumIterations, numIterations;
@@ -34,18 +34,14 @@
 #include "sim.h"
 #include "algorithm.h"
 #include "assign2.h"
+#include "miscfns.h"
 
 
 /*  Determines switch configuration 					*/
 /*  Configuration is filled into aSwitch->fabric.Xbar_matrix array 	*/
 /*  Finds maximum sized match using M Saltzman's code */
 
-static int **makeGraph();
-static int **shuffleGraph();
-static int **unshuffleGraph();
-static int **makeGraph();
 static void printGraph();
-static void clearGraph();
 static int **findMaxWeightMatch();
 
 
@@ -69,6 +65,10 @@ char **argv;
     if(debug_algorithm)
       printf("	SCHEDULING_INIT\n");
 
+    /* Working buffers for this switch */
+    if( aSwitch->scheduler.schedulingState == NULL )
+      aSwitch->scheduler.schedulingState =
+	createMatchScratch(matchGraphSize(aSwitch));
     break;
 
   case SCHEDULING_EXEC:
@@ -110,105 +110,7 @@ char **argv;
 }
 
 
-static int **
-unshuffleGraph(graph, si, so, n)
-  int **graph;
-int *si, *so;
-int n;
-{
-  int input, output;
-
-  static int **newgraph=NULL;
-  if( !newgraph )
-    newgraph = makeGraph(n);
-
-  /* UnShuffle the graph */
-  for(input=0; input<n; input++)
-    for(output=0; output<n; output++)
-      newgraph[input][output] = graph[si[input]][so[output]];
-
-  return(newgraph);
-}
-static int **
-shuffleGraph(graph, si, so, n)
-  int **graph;
-int *si, *so;
-int n;
-{
-  static unsigned short int mySeed[3];
-  static int init=0;
-
-  int input, output;
-  int selection;
-  static int **newgraph=NULL;
-
-  if( !newgraph )
-    newgraph = makeGraph(n);
-
-  for(input=0; input<n; input++)
-    si[input]=NONE;
-  for(output=0; output<n; output++)
-    so[output]=NONE;
-
-  if(!init)
-    {
-      mySeed[0] = 0x1243;
-      mySeed[1] = 0xab43;
-      mySeed[2] = 0xfc92;
-      init=1;
-    }
-  /* Shuffle set of inputs */
-  for(input=0; input<n; input++)
-    {
-      do {
-	selection = nrand48(mySeed)%n;
-      } while(si[selection] != NONE);
-      si[selection] = input;
-    }
-  /* Shuffle set of outputs */
-  for(output=0; output<n; output++)
-    {
-      do {
-	selection = nrand48(mySeed)%n;
-      } while(so[selection] != NONE);
-      so[selection] = output;
-    }
-
-  /* Shuffle the graph */
-  for(input=0; input<n; input++)
-    for(output=0; output<n; output++)
-      newgraph[si[input]][so[output]] = graph[input][output];
-
-  return(newgraph);
-	
-}
-
 /***********************************************************************/
-static int **
-makeGraph(n)
-  int n;
-{
-  int input;
-  int **graph;
-
-  graph = (int **) malloc(sizeof(int *) * n);
-  for(input=0;input<n; input++)
-    graph[input] = (int *) malloc(sizeof(int)*n);
-
-  return(graph);
-}
-
-static 
-void
-clearGraph(graph, n)
-  int **graph;
-int n;
-{
-  int input;
-  for(input=0;input<n; input++)
-    memset(graph[input], 0, sizeof(int)*n);
-}
-
 static void
 printGraph(graph, aSwitch)
   int **graph;
@@ -234,9 +136,8 @@ findMaxWeightMatch(aSwitch)
 {
   int input, output, fabricOutput, index;
 
-  static int **graph=NULL;
-  static int *si=NULL;
-  static int *so=NULL;
+  MatchScratch *scratch = (MatchScratch *) aSwitch->scheduler.schedulingState;
+  int **graph = scratch->graph;
   int **match=NULL;
   int **newgraph;	
   unsigned long age;
@@ -255,18 +156,7 @@ findMaxWeightMatch(aSwitch)
     }
 
 
-  if( !graph )
-    graph = makeGraph(n);
-  if( !si )
-    {
-      si = (int *)malloc(sizeof(int)*n);
-    }
-  if( !so )
-    {
-      so = (int *)malloc(sizeof(int)*n);
-    }
-
-  clearGraph(graph,n);
+  matrixClear(graph, n, n);
 
   /* Fill in request graph */
   for(input=0; input<aSwitch->numInputs; input++)
@@ -298,13 +188,13 @@ findMaxWeightMatch(aSwitch)
     }
 
   /* RANDOMIZE GRAPH */
-  newgraph = shuffleGraph(graph, si, so, n);
+  newgraph = shuffleMatchGraph(scratch);
 
-  match = ap2driver(n, newgraph);
+  match = ap2driver(&scratch->ap2, newgraph);
 
 	
   /* UN-RANDOMIZE GRAPH */
-  newgraph = unshuffleGraph(match, si, so, n);
+  newgraph = unshuffleMatchGraph(scratch, match);
   if(debug_algorithm) 
     {
       printf("Match:\n");
@@ -34,15 +34,22 @@
 #include "sim.h"
 #include "algorithm.h"
 #include "assign2.h"
+#include "miscfns.h"
 
 /*  Determines switch configuration 					*/
 /*  Configuration is filled into aSwitch->fabric.Xbar_matrix array 	*/
 /*  Finds maximum sized match using M Saltzman's code */
 
-static int **makeGraph();
-static int **makeGraph();
+/* Working buffers for one switch */
+typedef struct {
+	int **graph;		/* Request weights */
+	int **occupancy;	/* Queue occupancies, for debugging */
+	int **col_sum, **row_sum;	/* Pipelined sums, K slots deep */
+	Ap2Workspace ap2;
+} OpfState;
+
+static OpfState *createOpfState();
 static int printGraph();
-static int clearGraph();
 static int **findMaxWeightMatch();
 
 void
@@ -65,6 +72,10 @@ char **argv;
 			if(debug_algorithm)
 				printf("	SCHEDULING_INIT\n");
 
+			/* Working buffers for this switch */
+			if( aSwitch->scheduler.schedulingState == NULL )
+				aSwitch->scheduler.schedulingState =
+					createOpfState(matchGraphSize(aSwitch));
 			break;
 
 		case SCHEDULING_EXEC:
@@ -107,32 +118,6 @@ char **argv;
 
 
 /***********************************************************************/
-static int **
-makeGraph(n)
-int n;
-{
-	int input;
-	int **graph;
-
-	graph = (int **) malloc(sizeof(int *) * n);
-	for(input=0;input<n; input++)
-		graph[input] = (int *) malloc(sizeof(int)*n);
-
-	return(graph);
-}
-
-static 
-int 
-clearGraph(graph, n)
-int **graph;
-int n;
-{
-	int input;
-	for(input=0;input<n; input++)
-		memset(graph[input], 0, sizeof(int)*n);
-	return (0);
-}
-
 
 static int
 printGraph(graph, aSwitch)
@@ -157,6 +142,36 @@ Switch *aSwitch;
 /* #define P 1 */
 #define P 32
 
+static OpfState *
+createOpfState(n)
+int n;
+{
+	OpfState *state = (OpfState *) malloc(sizeof(OpfState));
+	ScratchBlock block;
+	int pass, i;
+
+	scratchBegin(&block);
+	for(pass=0; pass<2; pass++)
+	{
+		if( pass )
+			scratchAllocate(&block);
+		state->graph = scratchGraph(&block, n, n);
+		state->occupancy = scratchGraph(&block, n, n);
+		state->col_sum = (int **) scratchCarve(&block, sizeof(int *)*K);
+		state->row_sum = (int **) scratchCarve(&block, sizeof(int *)*K);
+		for(i=0; i<K; i++){
+			int *col = scratchInts(&block, n);
+			int *row = scratchInts(&block, n);
+			if( pass ){
+				state->col_sum[i] = col;
+				state->row_sum[i] = row;
+			}
+		}
+		layoutAp2Workspace(&block, &state->ap2, n);
+	}
+	return(state);
+}
+
 static
 int **
 findMaxWeightMatch(aSwitch)
@@ -166,13 +181,11 @@ Switch *aSwitch;
 	int age;
 	Cell *aCell;
 
-	static int **graph=NULL;
-	static int **occupancy=NULL;
-	static int **lqf_match=NULL;
-	static int *si=NULL;
-	static int *so=NULL;
-	static int **col_sum=NULL;
-	static int **row_sum=NULL;
+	OpfState *state = (OpfState *) aSwitch->scheduler.schedulingState;
+	int **graph = state->graph;
+	int **occupancy = state->occupancy;
+	int **col_sum = state->col_sum;
+	int **row_sum = state->row_sum;
 	int **match=NULL;
 	int all_backlog;
 	int i, n, numFabricOutputs;
@@ -189,30 +202,8 @@ Switch *aSwitch;
 	}
 
 
-	if( !graph )
-		graph = makeGraph(n);
-   if( !occupancy )
-      occupancy = makeGraph(n);
-   if( !lqf_match )
-      lqf_match = makeGraph(n);
-	if( !si )
-		si = (int *)malloc(sizeof(int)*n);
-	if( !so )
-		so = (int *)malloc(sizeof(int)*n);
-
-	if( !row_sum ){
-	  row_sum = (int **)malloc(sizeof(int *)*K);
-	  for(i=0; i<K; i++)
-		 row_sum[i] = (int *) malloc(sizeof(int)*n);
-	}
-	if( !col_sum ){
-	  col_sum = (int **)malloc(sizeof(int *)*K);
-	  for(i=0; i<K; i++)
-		 col_sum[i] = (int *) malloc(sizeof(int)*n);
-	}
-
-	clearGraph(graph,n);
-	clearGraph(occupancy,n);
+	matrixClear(graph, n, n);
+	matrixClear(occupancy, n, n);
 	/* clear col. and row sums */
 
 	for(input=0; input<n; input++){
@@ -269,7 +260,7 @@ Switch *aSwitch;
 		printGraph(occupancy, aSwitch);
 	}
 
-	match = ap2driver(n, graph);
+	match = ap2driver(&state->ap2, graph);
 	
 	if(debug_algorithm) 
 	{
@@ -35,9 +35,12 @@
 #include "pim.h"
 #include "scheduleStats.h"
 
+extern void FatalError(char*);
+
 static int selectGrant();
 static int selectAccept();
 static void createScheduleState();
+static void queueChanged();
 static InputSchedulerState *createInScheduler();
 static OutputSchedulerState *createOutScheduler();
 
@@ -65,6 +68,7 @@ char **argv;
   case SCHEDULING_USAGE:
     fprintf(stderr, "Options for \"pim\" scheduling algorithm:\n");
     fprintf(stderr, "    -n number_of_iterations. Default: 1\n");
+    fprintf(stderr, "    -p pipelined: n matches in flight, one iteration each per cell time\n");
     break;
   case SCHEDULING_INIT:	
     if(debug_algorithm)
@@ -77,17 +81,20 @@ char **argv;
 	extern int optopt;
 	extern int optind;
 	extern char *optarg;
-	int c;
+	int c, pipelined=0;
 
 
 	opterr=0;
 	optind=1;
-	while( (c = getopt(argc, argv, "n:")) != EOF )
+	while( (c = getopt(argc, argv, "n:p")) != EOF )
 	  switch (c)
 	    {
 	    case 'n':
 	      numIterations = atoi(optarg);
 	      break;
+	    case 'p':
+	      pipelined = 1;
+	      break;
 	    case '?':
 	      fprintf(stderr, "-------------------------------\n");
 	      fprintf(stderr, "pim: Unrecognized option -%c\n", optopt);
@@ -102,6 +109,16 @@ char **argv;
 	createScheduleState(aSwitch);
 	scheduleState = (SchedulerState *) aSwitch->scheduler.schedulingState;
 	scheduleState->numIterations = numIterations;
+	scheduleState->pipeline = NULL;
+	if( pipelined )
+	  {
+	    if( aSwitch->fabric.Xbar_numOutputLines != 1 )
+	      FatalError("pim: -p needs one line per output");
+	    scheduleState->pipeline = 
+	      createPipelineMatch(aSwitch, numIterations, PIPELINE_RANDOM);
+	    aSwitch->scheduler.fifoChanged = queueChanged;
+	    printf("Pipelined\n");
+	  }
       }
 			
 
@@ -122,6 +139,14 @@ char **argv;
 
       scheduleState = (SchedulerState *) aSwitch->scheduler.schedulingState;
 
+      if( scheduleState->pipeline )
+	{
+	  pipelineMatchExec(aSwitch, scheduleState->pipeline);
+	  scheduleStats(SCHEDULE_STATS_NUM_ITERATIONS, aSwitch,
+			&scheduleState->numIterations);
+	  break;
+	}
+
       /************** INITIALIZE ***************/
       /* Set up inputs (grants and accepts) */
       numFabricOutputs = aSwitch->numOutputs * 
@@ -337,6 +362,18 @@ int input;
 }
 
 
+/* The input action's report of a fifo that gained or lost cells, */
+/* followed only when pipelined                                   */
+static void
+queueChanged(aSwitch, input, fifo)
+  Switch *aSwitch;
+int input, fifo;
+{
+  SchedulerState *scheduleState=aSwitch->scheduler.schedulingState;
+
+  pipelineMatchFifoChanged(aSwitch, scheduleState->pipeline, input, fifo);
+}
+
 /* Create schedule state variables for aSwitch */
 static void
 createScheduleState(aSwitch)
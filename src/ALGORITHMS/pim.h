@@ -30,6 +30,8 @@
  *
  */
 
+#include "pipelineMatch.h"
+
 typedef struct {
 	int		*grant;		/* Array of outputs that have granted to this input */
 	int		accept;		/* Outputs that this input has accepted (None = -1) */
@@ -49,4 +51,5 @@ typedef struct {
 	OutputSchedulerState **outputSched; /* Ptr to array of ptrs to output	*/
 										/* scheduler state. 1 per output.	*/
 	int  numIterations;
+	PipelineMatch *pipeline;	/* -p: matchings in flight, or NULL */
 } SchedulerState;
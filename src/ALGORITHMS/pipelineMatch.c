@@ -0,0 +1,270 @@
+/* ****************************************************************
+ * Copyright Stanford University 1998,99 - All Rights Reserved
+ ****************************************************************** 
+
+ * Permission to use, copy, modify, and distribute this software 
+ * and its documentation for any purpose is hereby granted without 
+ * fee, provided that the above copyright notice appears in all copies
+ * and that both the copyright notice, this permission notice, and 
+ * the following disclaimer appear in supporting documentation, and 
+ * that the name of Stanford University, not be used in advertising or 
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.
+ * 
+ * STANFORD UNIVERSITY, DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND 
+ * FITNESS. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE FOR ANY 
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER 
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION 
+ * OF CONTRACT, NEGLIGENCE OR OTHER ACTION, ARISING OUT OF OR IN 
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * The Sim Web Site : http://klamath.stanford.edu/tools/SIM
+ * The SIM Mailing List: sim-simulator@lists.stanford.edu
+
+ * Send mail to the above email address with "subscribe sim-simulator" in
+ * the body of the message.
+ *
+ */
+
+
+#include <string.h>
+#include "sim.h"
+#include "algorithm.h"
+#include "miscfns.h"
+#include "pipelineMatch.h"
+
+static void layoutPipelineMatch();
+static void clearMatching();
+static void updateAvailable();
+static void iterate();
+static int choose();
+
+/***********************************************************************/
+PipelineMatch *
+createPipelineMatch(aSwitch, numStages, policy)
+  Switch *aSwitch;
+int numStages;
+PipelinePolicy policy;
+{
+  PipelineMatch *pm = (PipelineMatch *) malloc(sizeof(PipelineMatch));
+  ScratchBlock block;
+  int pass, stage, input, output;
+
+  if( numStages < 1 )
+    numStages = 1;
+  pm->numInputs = aSwitch->numInputs;
+  pm->numOutputs = aSwitch->numOutputs;
+  pm->numStages = numStages;
+  pm->policy = policy;
+  pm->newest = 0;
+  pm->seed[0] = 0x1438 ^ aSwitch->switchNumber;
+  pm->seed[1] = 0xbc21;
+  pm->seed[2] = 0x93ac;
+
+  scratchBegin(&block);
+  for(pass=0; pass<2; pass++)
+    {
+      if( pass )
+	scratchAllocate(&block);
+      layoutPipelineMatch(&block, pm);
+    }
+  for(stage=0; stage<numStages; stage++)
+    clearMatching(pm, stage);
+  for(input=0; input<pm->numInputs; input++)
+    for(output=0; output<pm->numOutputs; output++)
+      updateAvailable(aSwitch, pm, input, output);
+  return(pm);
+}
+
+static void
+layoutPipelineMatch(block, pm)
+  ScratchBlock *block;
+PipelineMatch *pm;
+{
+  int numInputs = pm->numInputs, numOutputs = pm->numOutputs;
+
+  pm->reserved = scratchGraph(block, numInputs, numOutputs);
+  pm->available = scratchBitsets(block, numOutputs, numInputs);
+  pm->candidates = scratchBitset(block, numInputs);
+  pm->inputMatch = scratchGraph(block, pm->numStages, numInputs);
+  pm->outputMatch = scratchGraph(block, pm->numStages, numOutputs);
+  pm->freeInputs = scratchBitsets(block, pm->numStages, numInputs);
+  pm->freeOutputs = scratchBitsets(block, pm->numStages, numOutputs);
+  pm->grants = scratchBitsets(block, numInputs, numOutputs);
+  pm->granted = scratchInts(block, numInputs);
+  pm->grantPointer = scratchInts(block, numOutputs);
+  pm->acceptPointer = scratchInts(block, numInputs);
+}
+
+static void
+clearMatching(pm, stage)
+  PipelineMatch *pm;
+int stage;
+{
+  int port;
+
+  for(port=0; port<pm->numInputs; port++)
+    pm->inputMatch[stage][port] = NONE;
+  for(port=0; port<pm->numOutputs; port++)
+    pm->outputMatch[stage][port] = NONE;
+  bitsetFill(pm->freeInputs[stage], pm->numInputs);
+  bitsetFill(pm->freeOutputs[stage], pm->numOutputs);
+}
+
+/* The VOQ from input to output has a cell no matching in flight has */
+/* claimed, or not.                                                   */
+static void
+updateAvailable(aSwitch, pm, input, output)
+  Switch *aSwitch;
+PipelineMatch *pm;
+int input, output;
+{
+  if( aSwitch->inputBuffer[input]->fifo[output]->number
+      > pm->reserved[input][output] )
+    BITSET_SET(pm->available[output], input);
+  else
+    BITSET_RESET(pm->available[output], input);
+}
+
+/* For the algorithm's scheduler.fifoChanged: fifo of input gained or */
+/* lost cells.                                                         */
+void
+pipelineMatchFifoChanged(aSwitch, pm, input, fifo)
+  Switch *aSwitch;
+PipelineMatch *pm;
+int input, fifo;
+{
+  if( fifo < pm->numOutputs )
+    updateAvailable(aSwitch, pm, input, fifo);
+}
+
+/***********************************************************************/
+/* One cell time: start a matching, advance all of them by an iteration */
+/* and issue the oldest to the crossbar. Returns the size of its match. */
+int
+pipelineMatchExec(aSwitch, pm)
+  Switch *aSwitch;
+PipelineMatch *pm;
+{
+  int input, output, stage, age, size=0;
+  int numStages = pm->numStages;
+
+  /* The matching issued last cell time makes way for a new one. */
+  pm->newest = (pm->newest + 1) % numStages;
+  clearMatching(pm, pm->newest);
+
+  /* Older matchings are nearer to being issued: they go first. */
+  for(age=numStages-1; age>=0; age--)
+    {
+      stage = (pm->newest - age + numStages) % numStages;
+      iterate(aSwitch, pm, stage, age == 0);
+    }
+
+  stage = (pm->newest + 1) % numStages;
+  for(output=0; output<pm->numOutputs; output++)
+    {
+      input = pm->outputMatch[stage][output];
+      aSwitch->fabric.Xbar_matrix[output].input = input;
+      if( input != NONE )
+	{
+	  aSwitch->fabric.Xbar_matrix[output].cell = (Cell *)
+	    aSwitch->inputBuffer[input]->fifo[output]->head->Object;
+	  pm->reserved[input][output]--;
+	  updateAvailable(aSwitch, pm, input, output);
+	  size++;
+	}
+    }
+
+  if(debug_algorithm)
+    printf("Pipeline issued match of size %d at time %ld\n", size, now);
+  return(size);
+}
+
+/*
+  One request-grant-accept iteration of the matching in stage. Each
+  unmatched output grants to one of the unmatched inputs that have an
+  unclaimed cell for it, and each input that received grants accepts
+  one of them. Round-robin pointers move as in islip: the accept pointer
+  on every accept, the grant pointer only in a matching's first
+  iteration.
+*/
+static void
+iterate(aSwitch, pm, stage, first)
+  Switch *aSwitch;
+PipelineMatch *pm;
+int stage, first;
+{
+  int numInWords = BITSET_NUM_WORDS(pm->numInputs);
+  int numOutWords = BITSET_NUM_WORDS(pm->numOutputs);
+  BitsetWord *freeInputs = pm->freeInputs[stage];
+  BitsetWord word;
+  int wordIndex, i, input, output, numGranted=0;
+
+  EVERY_BIT_SET(pm->freeOutputs[stage], numOutWords, wordIndex, word, output)
+    {
+      for(i=0; i<numInWords; i++)
+	pm->candidates[i] = pm->available[output][i] & freeInputs[i];
+      input = choose(pm, pm->candidates, pm->numInputs, 
+		     pm->grantPointer[output]);
+      if( input == NONE )
+	continue;
+      if( !bitsetAnySet(pm->grants[input], pm->numOutputs) )
+	pm->granted[numGranted++] = input;
+      BITSET_SET(pm->grants[input], output);
+    }
+
+  for(i=0; i<numGranted; i++)
+    {
+      input = pm->granted[i];
+      output = choose(pm, pm->grants[input], pm->numOutputs,
+		      pm->acceptPointer[input]);
+      bitsetClear(pm->grants[input], pm->numOutputs);
+
+      pm->inputMatch[stage][input] = output;
+      pm->outputMatch[stage][output] = input;
+      BITSET_RESET(freeInputs, input);
+      BITSET_RESET(pm->freeOutputs[stage], output);
+      pm->reserved[input][output]++;
+      updateAvailable(aSwitch, pm, input, output);
+
+      pm->acceptPointer[input] = output;
+      if( first )
+	pm->grantPointer[output] = input;
+    }
+}
+
+/* Pick a member of set: the first after pointer, cyclically, or one */
+/* uniformly at random.                                              */
+static int
+choose(pm, set, numBits, pointer)
+  PipelineMatch *pm;
+BitsetWord *set;
+int numBits, pointer;
+{
+  int bit, rank, wordIndex, count;
+
+  if( pm->policy == PIPELINE_ROUND_ROBIN )
+    {
+      bit = bitsetNextSetCyclic(set, numBits, (pointer + 1) % numBits);
+      return( bit < 0 ? NONE : bit );
+    }
+
+  if( (count = bitsetNumSet(set, numBits)) == 0 )
+    return(NONE);
+  rank = nrand48(pm->seed) % count;
+  for(wordIndex=0; ; wordIndex++)
+    {
+      count = BITSET_WORD_COUNT(set[wordIndex]);
+      if( rank < count )
+	break;
+      rank -= count;
+    }
+  for(bit=0; ; bit++)
+    if( (set[wordIndex] >> bit) & 1 )
+      if( rank-- == 0 )
+	return(wordIndex * BITSET_WORD_BITS + bit);
+}
@@ -0,0 +1,103 @@
+/* ****************************************************************
+ * Copyright Stanford University 1998,99 - All Rights Reserved
+ ****************************************************************** 
+
+ * Permission to use, copy, modify, and distribute this software 
+ * and its documentation for any purpose is hereby granted without 
+ * fee, provided that the above copyright notice appears in all copies
+ * and that both the copyright notice, this permission notice, and 
+ * the following disclaimer appear in supporting documentation, and 
+ * that the name of Stanford University, not be used in advertising or 
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.
+ * 
+ * STANFORD UNIVERSITY, DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND 
+ * FITNESS. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE FOR ANY 
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER 
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION 
+ * OF CONTRACT, NEGLIGENCE OR OTHER ACTION, ARISING OUT OF OR IN 
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * The Sim Web Site : http://klamath.stanford.edu/tools/SIM
+ * The SIM Mailing List: sim-simulator@lists.stanford.edu
+
+ * Send mail to the above email address with "subscribe sim-simulator" in
+ * the body of the message.
+ *
+ */
+
+
+#ifndef _PIPELINEMATCH_H_
+#define _PIPELINEMATCH_H_
+
+/*
+ * Pipelined iterative matching, for islip -p and pim -p.
+ *
+ * Instead of running every iteration within one cell time, K matchings
+ * are kept in flight. Each cell time a new one is started, every one in
+ * flight is given one more request-grant-accept iteration (oldest
+ * first), and the one that has now had K iterations is issued to the
+ * crossbar. A match is thus issued K-1 cell times after it was
+ * started, as in a hardware scheduler with one iteration per pipeline
+ * stage.
+ *
+ * A VOQ may be matched in several of the matchings in flight, but never
+ * in more of them than it holds cells: reserved[input][output] counts
+ * its cells already spoken for, and only the rest may request.  The
+ * bitsets of VOQs with unclaimed cells are kept up to date as cells
+ * are claimed and issued, and by the algorithm passing on its
+ * scheduler.fifoChanged reports to pipelineMatchFifoChanged().
+ *
+ * Each cell time still runs K iterations, one per matching in flight,
+ * as much work as islip -n K; an iteration only looks at the outputs
+ * still unmatched in its matching.  What pipelining changes is when the
+ * work is done: a matching gets its K iterations over K cell times, so
+ * a hardware scheduler needs the time of one iteration per cell time,
+ * not K.
+ *
+ * With K = 1 the round-robin policy makes the same choices as islip -n 1.
+ */
+
+typedef enum {
+  PIPELINE_ROUND_ROBIN,	/* islip: grant and accept pointers */
+  PIPELINE_RANDOM	/* pim: uniform choice */
+} PipelinePolicy;
+
+typedef struct {
+  int numInputs;
+  int numOutputs;
+  int numStages;		/* K: matchings in flight */
+  PipelinePolicy policy;
+
+  int **reserved;		/* [input][output] cells in matchings in flight */
+  BitsetWord **available;	/* [output] inputs with unreserved cells for it */
+  BitsetWord *candidates;	/* Requests to one output in one iteration */
+
+  /* Matchings in flight, indexed [stage]; newest is the one started   */
+  /* this cell time, and the one after it (cyclically) is the oldest.  */
+  int newest;
+  int **inputMatch;		/* Output matched to each input, or NONE */
+  int **outputMatch;		/* Input matched to each output, or NONE */
+  BitsetWord **freeInputs;	/* Inputs not yet matched */
+  BitsetWord **freeOutputs;	/* Outputs not yet matched */
+
+  /* One iteration */
+  BitsetWord **grants;		/* [input] outputs granting to it */
+  int *granted;			/* Inputs that received grants */
+
+  int *grantPointer;		/* Round-robin: last input granted to */
+  int *acceptPointer;		/* Round-robin: last output accepted */
+  unsigned short seed[3];	/* Random: private stream */
+} PipelineMatch;
+
+extern PipelineMatch *createPipelineMatch(Switch *aSwitch, int numStages,
+					  PipelinePolicy policy);
+extern int pipelineMatchExec(Switch *aSwitch, PipelineMatch *pm);
+extern void pipelineMatchFifoChanged(Switch *aSwitch, PipelineMatch *pm,
+				     int input, int fifo);
+
+#endif
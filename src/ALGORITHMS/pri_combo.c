@@ -30,6 +30,7 @@
  *
  */
 
+#include <stdlib.h>
 #include "sim.h"
 #include "algorithm.h"
 
@@ -41,6 +42,12 @@
 extern void pri_fifo();
 extern void pri_mcast_random();
 
+/* Each algorithm keeps its own schedulingState; swap them in and out. */
+typedef struct {
+  void *fifoState;
+  void *mcastState;
+} ComboState;
+
 void
 pri_combo(action, aSwitch, argc, argv)
   SwitchAction action;
@@ -48,6 +55,31 @@ Switch *aSwitch;
 int argc;
 char **argv;
 {
+    ComboState *state;
+
+    if( action == SCHEDULING_USAGE )
+    {
+	pri_fifo(action,aSwitch,argc,argv);
+	pri_mcast_random(action,aSwitch,argc,argv);
+	return;
+    }
+
+    if( aSwitch->scheduler.schedulingState == NULL )
+    {
+	state = (ComboState *) malloc(sizeof(ComboState));
+	state->fifoState = NULL;
+	state->mcastState = NULL;
+    }
+    else
+	state = (ComboState *) aSwitch->scheduler.schedulingState;
+
+    aSwitch->scheduler.schedulingState = state->fifoState;
     pri_fifo(action,aSwitch,argc,argv);
+    state->fifoState = aSwitch->scheduler.schedulingState;
+
+    aSwitch->scheduler.schedulingState = state->mcastState;
     pri_mcast_random(action,aSwitch,argc,argv);
+    state->mcastState = aSwitch->scheduler.schedulingState;
+
+    aSwitch->scheduler.schedulingState = state;
 }
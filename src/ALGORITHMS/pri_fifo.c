@@ -38,6 +38,8 @@
 typedef struct {
   int *oldestCellFifo;
   int *inputList;
+  int *inputSelected;	/* not taken-0 taken-1 -- TL */
+  int *outputSelected;
   int maxCells;	/* Maximum number of cells per output buffer. */
 } SchedulerState;
 
@@ -91,6 +93,11 @@ char **argv;
 	  malloc(aSwitch->numInputs * sizeof(int));
 	scheduleState->oldestCellFifo = (int *) 
 	  malloc(aSwitch->numInputs * sizeof(unsigned long));
+	scheduleState->inputSelected = (int *) 
+	  malloc(aSwitch->numInputs * sizeof(int));
+	scheduleState->outputSelected = (int *) 
+	  malloc(aSwitch->numOutputs * aSwitch->fabric.Xbar_numOutputLines *
+		 sizeof(int));
 	aSwitch->scheduler.schedulingState = scheduleState;
 	scheduleState->maxCells = NONE;
 
@@ -128,23 +135,23 @@ char **argv;
       int numSelectedMe, chosen;
       Cell *aCell;
       int switchOutput, fabricOutput, index;
-      int inputSelected[128];    /* not taken-0 taken-1 -- TL */
-      int outputSelected[128];
+      int *inputSelected, *outputSelected;
       int priority;
       int pri;
 
-      for(index=0;index<128;index++)   /* initialize to be not taken -- TL */
-      {
-	inputSelected[index] = 0;
-	outputSelected[index] = 0;
-      }
-
       if(debug_algorithm)
 	printf("	CONFIG\n");
 
       scheduleState = (SchedulerState *) 
 	aSwitch->scheduler.schedulingState;
 
+      /* initialize to be not taken -- TL */
+      inputSelected = scheduleState->inputSelected;
+      outputSelected = scheduleState->outputSelected;
+      memset(inputSelected, 0, aSwitch->numInputs * sizeof(int));
+      memset(outputSelected, 0, aSwitch->numOutputs *
+	     aSwitch->fabric.Xbar_numOutputLines * sizeof(int));
+
 
       /* Strict Priority -- traffic for the highest priority 
 	 are considered first, then the second highest and so on -- TL */
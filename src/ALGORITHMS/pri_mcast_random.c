@@ -33,6 +33,7 @@
 
 #include "sim.h"
 #include "algorithm.h"
+#include "miscfns.h"
 
 
 
@@ -42,8 +43,16 @@
 
 /* Each output selects randomly and unifromly over the requesting inputs. */
 
-unsigned short int aSeed[3];
+/* Working state for one switch */
+typedef struct {
+  unsigned short int aSeed[3];
+  int *outputSelected;		/* Switch outputs already matched */
+  int *inputMask;		/* Inputs already matched */
+  int *outputMask;		/* Fabric outputs already matched */
+  int *requestors;		/* Inputs requesting the current output */
+} PriMcastRandomState;
 
+static PriMcastRandomState *createPriMcastRandomState();
 static int selectInput();
 
 void
@@ -55,6 +64,7 @@ char **argv;
 {
   int input, output;
   int out;
+  PriMcastRandomState *state;
 
   if(debug_algorithm)
     printf("Algorithm 'pri_mcast_random()' called by switch %d\n", aSwitch->switchNumber);
@@ -67,9 +77,12 @@ char **argv;
     if(debug_algorithm)
       printf("	SCHEDULING_INIT\n");
 
-    aSeed[0] = 0xde76 ^ globalSeed;
-    aSeed[1] = 0xab34 ^ globalSeed;
-    aSeed[2] = 0x7223 ^ globalSeed;
+    if( aSwitch->scheduler.schedulingState == NULL )
+      aSwitch->scheduler.schedulingState = createPriMcastRandomState(aSwitch);
+    state = (PriMcastRandomState *) aSwitch->scheduler.schedulingState;
+    state->aSeed[0] = 0xde76 ^ globalSeed;
+    state->aSeed[1] = 0xab34 ^ globalSeed;
+    state->aSeed[2] = 0x7223 ^ globalSeed;
 
     break;
 
@@ -77,9 +90,7 @@ char **argv;
     {
       int  numFabricOutputs;
       int priority;
-      static int *outputSelected=(int *) NULL;
-      static int *inputMask =(int *) NULL;
-      static int *outputMask =(int *) NULL;
+      int *outputSelected, *inputMask, *outputMask;
 
       if(debug_algorithm)
 	{
@@ -89,20 +100,17 @@ char **argv;
       numFabricOutputs = aSwitch->numOutputs *
 	aSwitch->fabric.Xbar_numOutputLines;
 
-
-      if( !outputSelected )
-      {
-        outputSelected = (int *) malloc(aSwitch->numOutputs * sizeof(int));
-        inputMask = (int *) malloc(aSwitch->numInputs * sizeof(int));
-        outputMask = (int *) malloc(numFabricOutputs * sizeof(int));
-      }
+      state = (PriMcastRandomState *) aSwitch->scheduler.schedulingState;
+      outputSelected = state->outputSelected;
+      inputMask = state->inputMask;
+      outputMask = state->outputMask;
 
       memset(outputSelected, 0, aSwitch->numOutputs * sizeof(int));
 
         /* Build masks of inputs and outputs already selected by
          * a previous scheduling algorithm.
          */ 
-      memset(inputMask, 0, numFabricOutputs * sizeof(int));
+      memset(inputMask, 0, aSwitch->numInputs * sizeof(int));
       for(output=0; output<numFabricOutputs;output++)
         if(aSwitch->fabric.Xbar_matrix[output].input != NONE)
         {
@@ -121,7 +129,7 @@ char **argv;
 	    /* grant an input for this output */
 	    if(debug_algorithm)
 	      printf("Selecting grant for output %d\n", output);
-	    input = selectInput(aSwitch, output, priority, inputMask);
+	    input = selectInput(aSwitch, state, output, priority);
 	    if(debug_algorithm)
 	      printf("Selected input %d\n", input);
 
@@ -152,11 +160,37 @@ char **argv;
 
 /***********************************************************************/
 
+static PriMcastRandomState *
+createPriMcastRandomState(aSwitch)
+  Switch *aSwitch;
+{
+  PriMcastRandomState *state;
+  int numFabricOutputs = aSwitch->numOutputs *
+    aSwitch->fabric.Xbar_numOutputLines;
+  ScratchBlock block;
+  int pass;
+
+  state = (PriMcastRandomState *) malloc(sizeof(PriMcastRandomState));
+  scratchBegin(&block);
+  for(pass=0; pass<2; pass++)
+    {
+      if( pass )
+	scratchAllocate(&block);
+      state->outputSelected = scratchInts(&block, aSwitch->numOutputs);
+      state->inputMask = scratchInts(&block, aSwitch->numInputs);
+      state->outputMask = scratchInts(&block, numFabricOutputs);
+      state->requestors = scratchInts(&block, aSwitch->numInputs);
+    }
+  return(state);
+}
+
+/***********************************************************************/
+
 static int
-selectInput(aSwitch, output, priority, inputMask)
+selectInput(aSwitch, state, output, priority)
   Switch *aSwitch;
+PriMcastRandomState *state;
 int output, priority;
-int *inputMask;
 {
   /*
     Randomly select between all requesting input ports
@@ -166,14 +200,11 @@ int *inputMask;
   int selected;
   InputBuffer  *inputBuffer;
   Cell *aCell;
-  static int * requestors = (int *) NULL;
+  int *inputMask = state->inputMask;
+  int *requestors = state->requestors;
 
   switchOutput = output / aSwitch->fabric.Xbar_numOutputLines;
 
-  /* Allocate temporary array to store inputs that request this output */
-  if(!requestors)
-        requestors = (int *) malloc( aSwitch->numInputs * sizeof(int) );
-
 
   /* Build array of requesting input ports for this output. 		*/
   /* i.e which input ports have a cell destined for this output 	*/
@@ -200,7 +231,7 @@ int *inputMask;
   else if(debug_algorithm)
     printf("Output %d received %d requests\n", output, num_rqsts);
 
-  index = nrand48(aSeed)%num_rqsts; /* U[0,num_rqsts-1] */
+  index = nrand48(state->aSeed)%num_rqsts; /* U[0,num_rqsts-1] */
   selected = requestors[index];
   if(debug_algorithm)
     printf("Output %d granting to input %d\n", output, selected);
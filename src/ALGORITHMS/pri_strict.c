@@ -0,0 +1,511 @@
+
+/* ****************************************************************
+ * Copyright Stanford University 1998,99 - All Rights Reserved
+ ****************************************************************** 
+
+ * Permission to use, copy, modify, and distribute this software 
+ * and its documentation for any purpose is hereby granted without 
+ * fee, provided that the above copyright notice appears in all copies
+ * and that both the copyright notice, this permission notice, and 
+ * the following disclaimer appear in supporting documentation, and 
+ * that the name of Stanford University, not be used in advertising or 
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.
+ * 
+ * STANFORD UNIVERSITY, DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND 
+ * FITNESS. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE FOR ANY 
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER 
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION 
+ * OF CONTRACT, NEGLIGENCE OR OTHER ACTION, ARISING OUT OF OR IN 
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * The Sim Web Site : http://klamath.stanford.edu/tools/SIM
+ * The SIM Mailing List: sim-simulator@lists.stanford.edu
+
+ * Send mail to the above email address with "subscribe sim-simulator" in
+ * the body of the message.
+ *
+ */
+
+
+#include "sim.h"
+#include "algorithm.h"
+#include "miscfns.h"
+
+extern void FatalError(char*);
+extern void lqf();
+extern void ocf();
+
+/*
+ * Strict priority over any unicast scheduling algorithm.
+ *
+ * Each priority class sees the switch through a view of its own: the
+ * same ports, one VOQ per output (fifo[output*numPriorities+priority]
+ * of the real input), its own crossbar matrix and its own instance of
+ * the algorithm's state.  Class 0 is scheduled first.  Before a lower
+ * class runs, the inputs already matched are swapped for an input with
+ * no cells, and the outputs already matched for an empty VOQ, so the
+ * algorithm only ever matches the ports still free.  An algorithm
+ * that follows the fifos (scheduler.fifoChanged) is told both of the
+ * real fifos' changes and of the ports hidden and shown, but only of
+ * VOQs that hold cells, since hiding an empty one changes nothing.  The
+ * same changes keep a bitset of occupied VOQs per class and input; a
+ * class with no cell from a free input to a free output is not run.
+ */
+
+typedef struct {
+  void (*algorithm)();	/* Unicast algorithm run on each class */
+  int numPriorities;
+  int labelStats;	/* Head each class's report with its priority */
+  Switch **view;	/* [priority] the switch as its class sees it */
+  InputBuffer ***viewRows;	/* [priority] each view's inputBuffer array */
+  InputBuffer ***viewInput;	/* [priority][input] its class's VOQs */
+  InputBuffer *emptyInput;	/* Stands in for a matched input */
+  struct List *emptyFifo;	/* Stands in for a VOQ to a matched output */
+  MatrixEntry *matrices;	/* Each view's crossbar matrix */
+  BitsetWord ***occupied;	/* [priority][input] outputs with cells */
+  BitsetWord *freeInputs;
+  BitsetWord *freeOutputs;
+  int *matchedInputs;	/* Inputs and outputs matched so far this slot */
+  int *matchedOutputs;
+  int numMatched;
+} PriStrictState;
+
+static PriStrictState *createPriStrictState();
+static void layoutPriStrictState();
+static int classHasRequests();
+static void maskView();
+static void unmaskView();
+static void viewInputChanged();
+static void viewOutputChanged();
+static void priorityLayer();
+static void priStrictFifoChanged();
+static void viewFifoChanged();
+
+
+/***********************************************************************/
+/* Entry points                                                        */
+/***********************************************************************/
+
+/* With no algorithm named (as schedbench runs it), classes get lqf */
+static char *defaultArgv[] = {"pri_strict", "lqf", NULL};
+
+/* "pri_strict algorithm [options of algorithm]" */
+void
+pri_strict(action, aSwitch, argc, argv)
+  SwitchAction action;
+Switch *aSwitch;
+int argc;
+char **argv;
+{
+  void (*algorithm)();
+
+  if( action == SCHEDULING_USAGE )
+    {
+      fprintf(stderr, "Options for \"pri_strict\" scheduling algorithm:\n");
+      fprintf(stderr, "    algorithm [its options]: unicast algorithm run on each priority, 0 first. Default: %s\n", defaultArgv[1]);
+      return;
+    }
+  if( action == SCHEDULING_INIT && argc < 2 )
+    {
+      argc = 2;
+      argv = defaultArgv;
+    }
+  if( action == SCHEDULING_INIT && aSwitch->scheduler.schedulingState == NULL )
+    {
+      if( argc < 2 || 
+	  !(algorithm = (void (*)()) findFunction(argv[1], algorithmTable)) )
+	FatalError("pri_strict: expected the name of a unicast algorithm");
+      printf("Priority classes scheduled by %s\n", argv[1]);
+      aSwitch->scheduler.schedulingState = 
+	createPriStrictState(aSwitch, algorithm);
+      ((PriStrictState *) aSwitch->scheduler.schedulingState)->labelStats = 1;
+    }
+  priorityLayer(action, aSwitch, argc-1, argv+1);
+}
+
+void
+pristrict_lqf(action, aSwitch, argc, argv)
+  SwitchAction action;
+Switch *aSwitch;
+int argc;
+char **argv;
+{
+  if( action == SCHEDULING_USAGE )
+    {
+      fprintf(stderr, "No Options for \"pristrict_lqf\" scheduling algorithm:\n");
+      return;
+    }
+  if( action == SCHEDULING_INIT && aSwitch->scheduler.schedulingState == NULL )
+    aSwitch->scheduler.schedulingState = createPriStrictState(aSwitch, lqf);
+  priorityLayer(action, aSwitch, argc, argv);
+}
+
+void
+pristrict_ocf(action, aSwitch, argc, argv)
+  SwitchAction action;
+Switch *aSwitch;
+int argc;
+char **argv;
+{
+  if( action == SCHEDULING_USAGE )
+    {
+      fprintf(stderr, "No Options for \"pristrict_ocf\" scheduling algorithm:\n");
+      return;
+    }
+  if( action == SCHEDULING_INIT && aSwitch->scheduler.schedulingState == NULL )
+    aSwitch->scheduler.schedulingState = createPriStrictState(aSwitch, ocf);
+  priorityLayer(action, aSwitch, argc, argv);
+}
+
+/***********************************************************************/
+/* The priority layer                                                  */
+/***********************************************************************/
+
+static void
+priorityLayer(action, aSwitch, argc, argv)
+  SwitchAction action;
+Switch *aSwitch;
+int argc;
+char **argv;
+{
+  PriStrictState *state = 
+    (PriStrictState *) aSwitch->scheduler.schedulingState;
+  int priority, input, output;
+
+  if(debug_algorithm)
+    printf("Priority layer called by switch %d\n", aSwitch->switchNumber);
+
+  switch(action) {
+  case SCHEDULING_EXEC:
+    {
+      int numPriorities = state->numPriorities;
+      int numOutWords = BITSET_NUM_WORDS(aSwitch->numOutputs);
+      MatrixEntry *matrix;
+
+      bitsetFill(state->freeInputs, aSwitch->numInputs);
+      bitsetFill(state->freeOutputs, aSwitch->numOutputs);
+      state->numMatched = 0;
+
+      for(priority=0; priority<numPriorities; priority++)
+	{
+	  if( !classHasRequests(aSwitch, state, priority, numOutWords) )
+	    continue;
+
+	  matrix = state->view[priority]->fabric.Xbar_matrix;
+	  for(output=0; output<aSwitch->numOutputs; output++)
+	    matrix[output].input = NONE;
+
+	  maskView(aSwitch, state, priority);
+	  (*state->algorithm)(SCHEDULING_EXEC, state->view[priority], 
+			      argc, argv);
+	  unmaskView(aSwitch, state, priority);
+
+	  for(output=0; output<aSwitch->numOutputs; output++)
+	    {
+	      input = matrix[output].input;
+	      if( input == NONE || !BITSET_IS_SET(state->freeInputs, input)
+		  || !BITSET_IS_SET(state->freeOutputs, output) )
+		continue;
+	      aSwitch->fabric.Xbar_matrix[output] = matrix[output];
+	      BITSET_RESET(state->freeInputs, input);
+	      BITSET_RESET(state->freeOutputs, output);
+	      state->matchedInputs[state->numMatched] = input;
+	      state->matchedOutputs[state->numMatched] = output;
+	      state->numMatched++;
+	    }
+	}
+      break;
+    }
+
+  case SCHEDULING_REPORT_STATS:
+    for(priority=0; priority<state->numPriorities; priority++)
+      {
+	if( state->labelStats )
+	  printf("Priority %d:\n", priority);
+	(*state->algorithm)(action, state->view[priority], argc, argv);
+      }
+    break;
+
+  case SCHEDULING_INIT:
+    for(priority=0; priority<state->numPriorities; priority++)
+      (*state->algorithm)(action, state->view[priority], argc, argv);
+    aSwitch->scheduler.fifoChanged = priStrictFifoChanged;
+    break;
+
+  case SCHEDULING_INIT_STATS:
+  case SCHEDULING_REPORT_STATE:
+  case SCHEDULING_CHECK_STATE_PERIOD:
+    for(priority=0; priority<state->numPriorities; priority++)
+      (*state->algorithm)(action, state->view[priority], argc, argv);
+    break;
+
+  default:
+    break;
+  }
+}
+
+/* Is there a cell of this class from a free input to a free output? */
+static int
+classHasRequests(aSwitch, state, priority, numOutWords)
+  Switch *aSwitch;
+PriStrictState *state;
+int priority, numOutWords;
+{
+  BitsetWord *row, word;
+  int wordIndex, input, i;
+
+  EVERY_BIT_SET(state->freeInputs, BITSET_NUM_WORDS(aSwitch->numInputs),
+		wordIndex, word, input)
+    {
+      row = state->occupied[priority][input];
+      for(i=0; i<numOutWords; i++)
+	if( row[i] & state->freeOutputs[i] )
+	  return(1);
+    }
+  return(0);
+}
+
+/* Hide the ports matched by the classes above from this one */
+static void
+maskView(aSwitch, state, priority)
+  Switch *aSwitch;
+PriStrictState *state;
+int priority;
+{
+  Switch *view = state->view[priority];
+  int i, input, output;
+
+  for(i=0; i<state->numMatched; i++)
+    {
+      input = state->matchedInputs[i];
+      view->inputBuffer[input] = state->emptyInput;
+      viewInputChanged(aSwitch, state, priority, input);
+    }
+  for(i=0; i<state->numMatched; i++)
+    {
+      output = state->matchedOutputs[i];
+      for(input=0; input<aSwitch->numInputs; input++)
+	state->viewInput[priority][input]->fifo[output] = state->emptyFifo;
+      viewOutputChanged(aSwitch, state, priority, output);
+    }
+}
+
+static void
+unmaskView(aSwitch, state, priority)
+  Switch *aSwitch;
+PriStrictState *state;
+int priority;
+{
+  Switch *view = state->view[priority];
+  int i, input, output;
+
+  for(i=0; i<state->numMatched; i++)
+    {
+      input = state->matchedInputs[i];
+      view->inputBuffer[input] = state->viewInput[priority][input];
+      viewInputChanged(aSwitch, state, priority, input);
+    }
+  for(i=0; i<state->numMatched; i++)
+    {
+      output = state->matchedOutputs[i];
+      for(input=0; input<aSwitch->numInputs; input++)
+	state->viewInput[priority][input]->fifo[output] = 
+	  aSwitch->inputBuffer[input]->fifo[output*state->numPriorities 
+					    + priority];
+      viewOutputChanged(aSwitch, state, priority, output);
+    }
+}
+
+/* The class's view of input was hidden or shown: of its VOQs, only */
+/* those holding cells look any different.                          */
+static void
+viewInputChanged(aSwitch, state, priority, input)
+  Switch *aSwitch;
+PriStrictState *state;
+int priority, input;
+{
+  BitsetWord word;
+  int wordIndex, output;
+
+  EVERY_BIT_SET(state->occupied[priority][input],
+		BITSET_NUM_WORDS(aSwitch->numOutputs), wordIndex, word, output)
+    viewFifoChanged(state, priority, input, output);
+}
+
+/* Likewise for the VOQs to output, leaving out the inputs hidden */
+/* already (they were reported with the input).                  */
+static void
+viewOutputChanged(aSwitch, state, priority, output)
+  Switch *aSwitch;
+PriStrictState *state;
+int priority, output;
+{
+  BitsetWord word;
+  int wordIndex, input;
+
+  EVERY_BIT_SET(state->freeInputs, BITSET_NUM_WORDS(aSwitch->numInputs),
+		wordIndex, word, input)
+    if( BITSET_IS_SET(state->occupied[priority][input], output) )
+      viewFifoChanged(state, priority, input, output);
+}
+
+/* A fifo of the real switch gained or lost cells: note whether it  */
+/* holds any and tell its class.                                    */
+static void
+priStrictFifoChanged(aSwitch, input, fifo)
+  Switch *aSwitch;
+int input, fifo;
+{
+  PriStrictState *state = 
+    (PriStrictState *) aSwitch->scheduler.schedulingState;
+  int priority = fifo % state->numPriorities;
+  int output = fifo / state->numPriorities;
+
+  if( aSwitch->inputBuffer[input]->fifo[fifo]->number )
+    BITSET_SET(state->occupied[priority][input], output);
+  else
+    BITSET_RESET(state->occupied[priority][input], output);
+  viewFifoChanged(state, priority, input, output);
+}
+
+/* Tell the class's algorithm, if it keeps up with the fifos, that */
+/* what it sees of the fifo from input to output has changed.      */
+static void
+viewFifoChanged(state, priority, input, output)
+  PriStrictState *state;
+int priority, input, output;
+{
+  Switch *view = state->view[priority];
+
+  if( view->scheduler.fifoChanged )
+    (view->scheduler.fifoChanged)(view, input, output);
+}
+
+/***********************************************************************/
+static PriStrictState *
+createPriStrictState(aSwitch, algorithm)
+  Switch *aSwitch;
+void (*algorithm)();
+{
+  PriStrictState *state = (PriStrictState *) malloc(sizeof(PriStrictState));
+  ScratchBlock block;
+  int pass, priority, input, output;
+  Switch *view;
+  InputBuffer *buffer;
+  struct List **fifo;
+
+  if( aSwitch->fabric.Xbar_numOutputLines != 1 )
+    FatalError("Strict priority scheduling needs one line per output");
+
+  state->algorithm = algorithm;
+  state->labelStats = 0;
+  state->numPriorities = aSwitch->numPriorities;
+
+  scratchBegin(&block);
+  for(pass=0; pass<2; pass++)
+    {
+      if( pass )
+	scratchAllocate(&block);
+      layoutPriStrictState(&block, state, aSwitch);
+    }
+
+  state->emptyFifo = createList("Empty");
+  for(output=0; output<aSwitch->numOutputs; output++)
+    state->emptyInput->fifo[output] = state->emptyFifo;
+
+  for(priority=0; priority<state->numPriorities; priority++)
+    {
+      view = state->view[priority];
+      *view = *aSwitch;
+      view->numPriorities = 1;
+      view->inputBuffer = state->viewRows[priority];
+      view->scheduler.schedulingState = NULL;
+      view->scheduler.schedulingStats = NULL;
+      view->fabric.Xbar_matrix = state->matrices + 
+	priority*aSwitch->numOutputs;
+      for(input=0; input<aSwitch->numInputs; input++)
+	{
+	  buffer = state->viewInput[priority][input];
+	  fifo = buffer->fifo;
+	  *buffer = *aSwitch->inputBuffer[input];
+	  buffer->fifo = fifo;
+	  view->inputBuffer[input] = buffer;
+	  for(output=0; output<aSwitch->numOutputs; output++)
+	    {
+	      fifo[output] = 
+		aSwitch->inputBuffer[input]->fifo[output*state->numPriorities
+						  + priority];
+	      if( fifo[output]->number )
+		BITSET_SET(state->occupied[priority][input], output);
+	    }
+	}
+    }
+  return(state);
+}
+
+static void
+layoutPriStrictState(block, state, aSwitch)
+  ScratchBlock *block;
+PriStrictState *state;
+Switch *aSwitch;
+{
+  int numPriorities = state->numPriorities;
+  int numInputs = aSwitch->numInputs, numOutputs = aSwitch->numOutputs;
+  int priority, input;
+  InputBuffer *buffer;
+
+  /* On the sizing pass every piece is NULL: only count the bytes. */
+  state->view = (Switch **) scratchCarve(block, numPriorities*sizeof(Switch *));
+  state->viewRows = (InputBuffer ***) 
+    scratchCarve(block, numPriorities*sizeof(InputBuffer **));
+  state->viewInput = (InputBuffer ***) 
+    scratchCarve(block, numPriorities*sizeof(InputBuffer **));
+  state->occupied = (BitsetWord ***) 
+    scratchCarve(block, numPriorities*sizeof(BitsetWord **));
+  state->matrices = (MatrixEntry *)
+    scratchCarve(block, numPriorities*numOutputs*sizeof(MatrixEntry));
+  for(priority=0; priority<numPriorities; priority++)
+    {
+      Switch *view = (Switch *) scratchCarve(block, sizeof(Switch));
+      InputBuffer **rows = (InputBuffer **)
+	scratchCarve(block, numInputs*sizeof(InputBuffer *));
+      InputBuffer **viewInput = (InputBuffer **)
+	scratchCarve(block, numInputs*sizeof(InputBuffer *));
+      BitsetWord **occupied = scratchBitsets(block, numInputs, numOutputs);
+
+      for(input=0; input<numInputs; input++)
+	{
+	  buffer = (InputBuffer *) scratchCarve(block, sizeof(InputBuffer));
+	  if( buffer )
+	    {
+	      viewInput[input] = buffer;
+	      buffer->fifo = (struct List **)
+		scratchCarve(block, numOutputs*sizeof(struct List *));
+	    }
+	  else
+	    scratchCarve(block, numOutputs*sizeof(struct List *));
+	}
+      if( view )
+	{
+	  state->view[priority] = view;
+	  state->viewRows[priority] = rows;
+	  state->viewInput[priority] = viewInput;
+	  state->occupied[priority] = occupied;
+	}
+    }
+  state->emptyInput = (InputBuffer *) scratchCarve(block, sizeof(InputBuffer));
+  buffer = state->emptyInput;
+  if( buffer )
+    buffer->fifo = (struct List **)
+      scratchCarve(block, numOutputs*sizeof(struct List *));
+  else
+    scratchCarve(block, numOutputs*sizeof(struct List *));
+  state->freeInputs = scratchBitset(block, numInputs);
+  state->freeOutputs = scratchBitset(block, numOutputs);
+  state->matchedInputs = scratchInts(block, numInputs);
+  state->matchedOutputs = scratchInts(block, numOutputs);
+}
@@ -30,6 +30,8 @@
  *
  */
 
+#include "pipelineMatch.h"
+
 /* Structures specific to ROUND ROBIN algorithm */
 
 typedef struct {
@@ -54,5 +56,6 @@ typedef struct {
 	OutputSchedulerState **outputSched; /* Ptr to array of ptrs to output	*/
 										/* scheduler state. 1 per output.	*/
 	int numIterations;
+	PipelineMatch *pipeline;	/* -p: matchings in flight, or NULL */
 } SchedulerState;
 
@@ -0,0 +1,126 @@
+/* ****************************************************************
+ * Copyright Stanford University 1998,99 - All Rights Reserved
+ ****************************************************************** 
+
+ * Permission to use, copy, modify, and distribute this software 
+ * and its documentation for any purpose is hereby granted without 
+ * fee, provided that the above copyright notice appears in all copies
+ * and that both the copyright notice, this permission notice, and 
+ * the following disclaimer appear in supporting documentation, and 
+ * that the name of Stanford University, not be used in advertising or 
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.
+ * 
+ * STANFORD UNIVERSITY, DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND 
+ * FITNESS. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE FOR ANY 
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER 
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION 
+ * OF CONTRACT, NEGLIGENCE OR OTHER ACTION, ARISING OUT OF OR IN 
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * The Sim Web Site : http://klamath.stanford.edu/tools/SIM
+ * The SIM Mailing List: sim-simulator@lists.stanford.edu
+
+ * Send mail to the above email address with "subscribe sim-simulator" in
+ * the body of the message.
+ *
+ */
+
+
+
+#include "sim.h"
+#include "miscfns.h"
+#include "tournament.h"
+
+/*  Tournament trees used by the iterative schedulers to find the     */
+/*  longest (or oldest, or most urgent) requesting queue.             */
+
+/* Lay out a tree of numLeaves empty leaves (see ScratchBlock). */
+void
+layoutTournament(block, t, numLeaves)
+  ScratchBlock *block;
+Tournament *t;
+int numLeaves;
+{
+  int node;
+
+  t->numLeaves = numLeaves;
+  for(t->base=1; t->base<numLeaves; t->base <<= 1)
+    ;
+  t->node = (TournamentNode *)
+    scratchCarve(block, 2 * t->base * sizeof(TournamentNode));
+
+  /* All keys start out TOURNAMENT_EMPTY (zero); count the ties. */
+  if( t->node )
+    {
+      for(node=t->base; node<2*t->base; node++)
+	{
+	  t->node[node].key = TOURNAMENT_EMPTY;
+	  t->node[node].count = 1;
+	}
+      for(node=t->base-1; node>=1; node--)
+	{
+	  t->node[node].key = TOURNAMENT_EMPTY;
+	  t->node[node].count = t->node[2*node].count + t->node[2*node+1].count;
+	}
+    }
+}
+
+/* Give leaf a new key and replay its matches up to the root, or until */
+/* a match comes out as it did before.                                 */
+void
+tournamentSet(t, leaf, key)
+  Tournament *t;
+int leaf;
+long key;
+{
+  TournamentNode *n = t->node;
+  int node = t->base + leaf;
+  long winner, numWinners;
+
+  n[node].key = key;
+  for(node >>= 1; node>=1; node >>= 1)
+    {
+      TournamentNode *left = &n[2*node], *right = &n[2*node+1];
+
+      /* Written to compile without branches: which side wins is a */
+      /* coin toss the branch predictor cannot learn.               */
+      winner = (left->key > right->key) ? left->key : right->key;
+      numWinners = ((left->key == winner) ? left->count : 0)
+	+ ((right->key == winner) ? right->count : 0);
+      if( n[node].key == winner && n[node].count == numWinners )
+	break;
+      n[node].key = winner;
+      n[node].count = numWinners;
+    }
+}
+
+/* 
+ * Returns the rank'th (from 0, in leaf order) of the leaves holding
+ * the maximum key.  rank must be less than tournamentNumMax(t).
+ */
+int
+tournamentSelect(t, rank)
+  Tournament *t;
+int rank;
+{
+  TournamentNode *n = t->node;
+  int node = 1, right;
+  long max = n[1].key, below;
+
+  /* Go left while the rank falls among the left child's ties; */
+  /* branch free, as in tournamentSet().                        */
+  while( node < t->base )
+    {
+      node <<= 1;
+      below = (n[node].key == max) ? n[node].count : 0;
+      right = (rank >= below);
+      rank -= right ? below : 0;
+      node += right;
+    }
+  return(node - t->base);
+}
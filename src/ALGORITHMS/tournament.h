@@ -0,0 +1,79 @@
+/* ****************************************************************
+ * Copyright Stanford University 1998,99 - All Rights Reserved
+ ****************************************************************** 
+
+ * Permission to use, copy, modify, and distribute this software 
+ * and its documentation for any purpose is hereby granted without 
+ * fee, provided that the above copyright notice appears in all copies
+ * and that both the copyright notice, this permission notice, and 
+ * the following disclaimer appear in supporting documentation, and 
+ * that the name of Stanford University, not be used in advertising or 
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.
+ * 
+ * STANFORD UNIVERSITY, DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND 
+ * FITNESS. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE FOR ANY 
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER 
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION 
+ * OF CONTRACT, NEGLIGENCE OR OTHER ACTION, ARISING OUT OF OR IN 
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * The Sim Web Site : http://klamath.stanford.edu/tools/SIM
+ * The SIM Mailing List: sim-simulator@lists.stanford.edu
+
+ * Send mail to the above email address with "subscribe sim-simulator" in
+ * the body of the message.
+ *
+ */
+
+
+
+#ifndef _TOURNAMENT_H_
+#define _TOURNAMENT_H_
+
+/*
+ * Tournament tree over a fixed set of leaves, each holding a key.
+ * Every node keeps the largest key below it and the number of leaves
+ * that share that key, so the maximum, the size of the tie and the
+ * k'th tied leaf (in leaf order) are all found in O(log N).  Changing
+ * a key costs O(log N).
+ *
+ * Keys are positive; TOURNAMENT_EMPTY marks a leaf that is not in the
+ * running (an empty queue, or a port matched in an earlier iteration
+ * that the caller has set aside for the rest of the slot).
+ *
+ * Used by the iterative schedulers (ilqf, iocf, mucf): one tree per
+ * output, with a leaf per input, picks the grant.  Picking the k'th
+ * tied leaf with k from lrand48() makes the same choice as scanning
+ * the inputs in order and keeping a list of the ties.
+ */
+
+#define TOURNAMENT_EMPTY	0L
+#define TOURNAMENT_KEY_MAX	(1L<<62)
+
+typedef struct {
+  long key;		/* Largest key below the node */
+  long count;		/* Leaves below the node holding it */
+} TournamentNode;
+
+typedef struct {
+  int  numLeaves;	/* Leaves in use */
+  int  base;		/* First leaf node; a power of two >= numLeaves */
+  TournamentNode *node;	/* [2*base] node 1 is the root; a node's key */
+			/* and count share a cache line */
+} Tournament;
+
+#define tournamentMax(t)		((t)->node[1].key)
+#define tournamentNumMax(t)		((int) (t)->node[1].count)
+#define tournamentKey(t, leaf)		((t)->node[(t)->base + (leaf)].key)
+
+extern void layoutTournament(ScratchBlock *block, Tournament *t,
+			     int numLeaves);
+extern void tournamentSet(Tournament *t, int leaf, long key);
+extern int tournamentSelect(Tournament *t, int rank);
+
+#endif
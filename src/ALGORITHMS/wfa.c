@@ -33,21 +33,23 @@
 #include <string.h> 
 #include "sim.h"
 #include "algorithm.h"
-#include "assign2.h"
+#include "miscfns.h"
 
 
 /*  Determines switch configuration 					*/
 /*  Configuration is filled into aSwitch->fabric.Xbar_matrix array 	*/
 /*  Finds maximum sized match using M Saltzman's code */
 
-static int **makeGraph();
-static int **ReorderGraph();
-static int **RecoverGraph();
-static int **makeGraph();
-static int printGraph();
-static int clearGraph();
-static int **findWfaMatch();
-static int **wfa_match();
+/* Working buffers for one switch */
+typedef struct {
+	BitsetWord **request;	/* [input] fabric outputs requested */
+	BitsetWord *outputFree;	/* Outputs not yet granted this slot */
+	BitsetWord *candidates;	/* Free outputs requested by one input */
+	int col_prt, row_prt;	/* Current rotation */
+} WfaState;
+
+static WfaState *createWfaState();
+static int findWfaMatch();
 
 
 void
@@ -57,8 +59,6 @@ Switch *aSwitch;
 int argc;
 char **argv;
 {
-	int input, output;
-
 	if(debug_algorithm)
 		printf("Algorithm 'wfa()' called by switch %d\n", aSwitch->switchNumber);
 	
@@ -70,30 +70,17 @@ char **argv;
 			if(debug_algorithm)
 				printf("	SCHEDULING_INIT\n");
 
+			/* Working buffers for this switch */
+			if( aSwitch->scheduler.schedulingState == NULL )
+				aSwitch->scheduler.schedulingState =
+					createWfaState(matchGraphSize(aSwitch));
 			break;
 
 		case SCHEDULING_EXEC:
 		{
-			int **match, size=0;
-			int numFabricOutputs = 
-				aSwitch->numOutputs*aSwitch->fabric.Xbar_numOutputLines;
+			int size;
 
-			match = findWfaMatch(aSwitch);
-	
-			for(output=0; output<numFabricOutputs; output++)
-			{
-				for(input=0; input<aSwitch->numInputs; input++)
-				{
-					if(match[input][output])
-					{
-						size++;
-						aSwitch->fabric.Xbar_matrix[output].input = input;
-						if(input!=NONE)
-							aSwitch->fabric.Xbar_matrix[output].cell = (Cell *)
-								aSwitch->inputBuffer[input]->fifo[output]->head->Object;
-					}
-				}
-			}
+			size = findWfaMatch(aSwitch);
 			if( debug_algorithm )
 				printf(" Size: %d\n", size); 
 
@@ -110,175 +97,76 @@ char **argv;
 		printf("Algorithm 'wfa()' completed for switch %d\n", aSwitch->switchNumber);
 }
 
-
-static int **
-RecoverGraph(graph, si, so, n)
-int **graph;
-int *si, *so;
-int n;
-{
-	int input, output;
-
-	static int **newgraph=NULL;
-	if( !newgraph )
-		newgraph = makeGraph(n);
-
-	/* UnShuffle the graph */
-	for(input=0; input<n; input++)
-	for(output=0; output<n; output++)
-		newgraph[si[input]][so[output]] = graph[input][output];
-
-	return(newgraph);
-}
-
-static int **
-ReorderGraph(graph, si, so, n,aSwitch)
-int **graph;
-int *si, *so;
-int n;
-Switch *aSwitch;
-{
-	int input, output;
-	static int **newgraph=NULL;
-	static int col_prt;
-	static int row_prt;
-
-	if( !newgraph )
-		newgraph = makeGraph(n);
-
-	for(input=0; input<n; input++)
-		si[input]=NONE;
-	for(output=0; output<n; output++)
-		so[output]=NONE;
-
-	col_prt++;
-	col_prt = col_prt%n;
-	if ((col_prt%n)==0)
-	  row_prt = (row_prt+1)%n;
-
-	for(output=0; output<n; output++){
-	  si[output] = (output+row_prt)%n;
-	  so[output] = (output+col_prt)%n;
-	}
-	  
-	/* Shuffle the graph */
-	for(input=0; input<n; input++)
-	  for(output=0; output<n; output++)
-		 newgraph[input][output] = graph[si[input]][so[output]];
-
-	if(debug_algorithm){  
-	/*	if(TRUE){ */
-
-	  printf("Order\n");
-	  for(output=0; output<n; output++){
-		 printf("%d:",so[output]); 
-	  }
-	  printf("\n");
-	  for(output=0; output<n; output++){
-		 printf("%d:",si[output]);
-	  }
-	  printf("\n");
-
-	  printf("Original traffic \n");
-	  printGraph(graph, n);	 
-	  printf("Reorderes traffic \n");
-	  printGraph(newgraph, n);
-	 	} 
-	return(newgraph);
-	
-}
-
 /***********************************************************************/
-static int **
-makeGraph(n)
-int n;
-{
-	int input;
-	int **graph;
-
-	graph = (int **) malloc(sizeof(int *) * n);
-	for(input=0;input<n; input++)
-		graph[input] = (int *) malloc(sizeof(int)*n);
-
-	return(graph);
-}
-
-static 
-int 
-clearGraph(graph, n)
-int **graph;
+static WfaState *
+createWfaState(n)
 int n;
 {
-	int input;
-	for(input=0;input<n; input++)
-		memset(graph[input], 0, sizeof(int)*n);
-	return (0);
-}
-
-static int
-printGraph(graph, n)
-int **graph;
-int n;
-{
-	int input, output;
-
+	WfaState *state = (WfaState *) malloc(sizeof(WfaState));
+	ScratchBlock block;
+	int pass;
 
-	for(input=0;input<n; input++)
+	scratchBegin(&block);
+	for(pass=0; pass<2; pass++)
 	{
-		for(output=0;output<n; output++)
-		{
-			printf("%1d ", graph[input][output]);
-		}
-		printf("\n");
+		if( pass )
+			scratchAllocate(&block);
+		state->request = scratchBitsets(&block, n, n);
+		state->outputFree = scratchBitset(&block, n);
+		state->candidates = scratchBitset(&block, n);
 	}
-	return (0);
+	state->col_prt = 0;
+	state->row_prt = 0;
+	return(state);
 }
 
-static
-int **
+/***********************************************************************/
+/* 
+ * Wavefront arbiter over the request matrix with its rows rotated by
+ * row_prt and its columns by col_prt.  The top left cell has highest
+ * priority, and a cell is granted if it requests and no cell above it
+ * or to its left was granted.  That is the same as taking the rotated
+ * inputs in turn and granting each the first free output it requests,
+ * counting from col_prt, which is one word-wide search per input.
+ * Returns the size of the match.
+ */
+static int
 findWfaMatch(aSwitch)
 Switch *aSwitch;
 {
-	int input, output, fabricOutput, index;
+	int input, output, fabricOutput, index, row, wordIndex;
 
-	static int **graph=NULL;
-	static int *si=NULL;
-	static int *so=NULL;
-	int **match=NULL;
-	int **newgraph;	
+	WfaState *state = (WfaState *) aSwitch->scheduler.schedulingState;
+	BitsetWord *request;
+	BitsetWord *outputFree = state->outputFree;
+	BitsetWord *candidates = state->candidates;
 	int size;
-	int n, numFabricOutputs;
+	int n, numFabricOutputs, numWords;
 
 	InputBuffer *inputBuffer;
 
 	numFabricOutputs = aSwitch->numOutputs*aSwitch->fabric.Xbar_numOutputLines;
 	n = (numFabricOutputs > aSwitch->numInputs) ? numFabricOutputs : 
 												aSwitch->numInputs;
+	numWords = BITSET_NUM_WORDS(n);
 
 	if(debug_algorithm)
 	{
 		printf("	SCHEDULING_EXEC\n");
 	}
 
+	/* Move the priority */
+	state->col_prt++;
+	state->col_prt = state->col_prt%n;
+	if ((state->col_prt%n)==0)
+	  state->row_prt = (state->row_prt+1)%n;
 
-	if( !graph )
-		graph = makeGraph(n);
-	if( !si )
-	{
-		si = (int *)malloc(sizeof(int)*n);
-	}
-	if( !so )
-	{
-		so = (int *)malloc(sizeof(int)*n);
-	}
-
-	clearGraph(graph,n);
-
-	/* Fill in request graph */
-	size=0;
+	/* Fill in request bitsets */
 	for(input=0; input<aSwitch->numInputs; input++)
 	{
 		inputBuffer = aSwitch->inputBuffer[input];
+		request = state->request[input];
+		bitsetClear(request, n);
 		for(output=0; output<aSwitch->numOutputs; output++)
 		{
 			if(inputBuffer->fifo[output]->number)
@@ -287,113 +175,39 @@ Switch *aSwitch;
 					fabricOutput=output*aSwitch->fabric.Xbar_numOutputLines;
 					index<aSwitch->fabric.Xbar_numOutputLines;
 					index++, fabricOutput++)
-				{
-					graph[input][fabricOutput]=1;
-					size++;
-				}
+					BITSET_SET(request, fabricOutput);
 			}
 		}
+		if(debug_algorithm) 
+		{
+			printf("Traffic %d: ", input);
+			bitsetPrint(stdout, request, numFabricOutputs);
+		}
 	}
-	/* printf(" %d ", size); */
-
-
-	if(debug_algorithm) 
-	{
-		printf("Traffic:\n");
-		printGraph(graph, n);
-	}
-
-	/* Reorder the columns */
-	newgraph = ReorderGraph(graph, si, so, n, aSwitch); 
 
-	match = wfa_match(n,newgraph, aSwitch);
-
-	/* Reverse the reordering */
-	newgraph = RecoverGraph(match, si, so, n);
-	if(debug_algorithm) 
+	bitsetFill(outputFree, n);
+	size=0;
+	for(row=0; row<n; row++)
 	{
-		printf("Wfa Match:\n");
-		printGraph(newgraph, n);
-		printf("\n");
+		input = (row+state->row_prt)%n;
+		if( input >= aSwitch->numInputs )
+			continue;
+		request = state->request[input];
+		for(wordIndex=0; wordIndex<numWords; wordIndex++)
+			candidates[wordIndex] = request[wordIndex] & outputFree[wordIndex];
+		fabricOutput = bitsetNextSetCyclic(candidates, n, state->col_prt);
+		if( fabricOutput < 0 )
+			continue;
+
+		BITSET_RESET(outputFree, fabricOutput);
+		output = fabricOutput / aSwitch->fabric.Xbar_numOutputLines;
+		aSwitch->fabric.Xbar_matrix[fabricOutput].input = input;
+		aSwitch->fabric.Xbar_matrix[fabricOutput].cell = (Cell *)
+			aSwitch->inputBuffer[input]->fifo[output]->head->Object;
+		size++;
+		if(debug_algorithm) 
+			printf("Wfa Match: %d -> %d\n", input, fabricOutput);
 	}
 
-	return(newgraph); 
+	return(size); 
 }
-
-
-/***********************************************************************/
-static int **
-wfa_match(N, graph, aSwitch)
-int N;
-int **graph;
-Switch *aSwitch;
-{
-	int input, output, cycle, kk, loop2;
-	static int **red=NULL;
-	static int **green_v=NULL;
-	static int **g=NULL;
-	/* reside in sim.h */
-
-	kk = N +1; 
-
-	if( !red )
-	  red = makeGraph(kk);
-
-	if( !green_v )
-	  green_v = makeGraph(kk);
-
-	if( !g )
-	  g = makeGraph(N);
-
-	/* Clear all cells */
-	clearGraph(red,kk);
-	clearGraph(green_v,kk);
-	clearGraph(g,N);
-
-	for(input=0;input<N; input++){
-	  red[input][0] = 1;
-	}
-	for(output=0;output<N; output++){
-	  green_v[0][output] = 1;
-	}
-	loop2 = 2*N;
-	for( cycle=0; cycle<loop2; cycle++){
-	  for(output=0;output<N; output++){
-		 for(input=0;input<N; input++){
-
-			g[input][output] = red[input][output]&&green_v[input][output]&&graph[input][output];
-
-			red[input][N-output] = red[input][N-1-output]&&(!g[input][N-1-output]);
-			green_v[N-input][output] = (green_v[N-1-input][output]&&(!g[N-1-input][output]));
-
-		 }
-	  }
-	  /*
-	  printf("red matrix is:\n");
-	  printGraph(red,kk);
-	  printf("green_v matrix is:\n");
-	  printGraph(green_v,kk);
-	  printf("request matrix is:\n");
-	  printGraph(graph,N);
-	  printf("g matrix is:\n");
-	  printGraph(g,N); 
-	  */
-	}
-
-	if(debug_algorithm) {
-	  printf("Request:\n");
-	  printGraph(graph, N);
-	  printf("\n");
-
-	  printf("Grant:\n");
-	  printGraph(g, N);
-	  printf("\n");
-
-	}
-	return g;
-}
-
-
-
-
-
@@ -34,14 +34,12 @@
 #include "sim.h"
 #include "algorithm.h"
 #include "wwfa.h"
+#include "miscfns.h"
 #include "scheduleStats.h"
 
 static int find_match();
 static int createScheduleState();
-static int **makeGraph();
-static int **makeGraph();
-static int printGraph();
-static int clearGraph();
+static int printMatch();
 
 /*  Determines switch configuration 					*/
 /*  Configuration is filled into aSwitch->fabric.interconnect.matrix array 	*/
@@ -111,90 +109,81 @@ char **argv;
 }
 
 /***********************************************************************/
+/* 
+ * Wrapped wavefront arbiter.  Cell (output, input) lies on diagonal
+ * (output+input)%N and each wave evaluates one diagonal, starting at
+ * scheduleState->pointer.  A cell is granted if it requests and neither
+ * its output nor its input was granted by an earlier wave.  The cells
+ * of a diagonal never share an output or an input, so a whole wave is
+ * found a word at a time from the request, free output and (rotated)
+ * free input bitsets, with no limit on N.
+ */
 static int
 find_match(aSwitch)
 Switch *aSwitch;
 {
 
-	int input, output, i, j, k, wave, diag, point;
+	int input, output, wave, diag, point, wordIndex;
 	SchedulerState	*scheduleState=(SchedulerState *)aSwitch->scheduler.schedulingState;
 	InputBuffer  *inputBuffer;
 	int N = aSwitch->numInputs;
-	int cell_S[30][30];
-	int cell_E[30][30];
-	static int **graph=NULL;
-
-	if( !graph )
-	  graph = makeGraph(N);
+	int numWords = BITSET_NUM_WORDS(N);
+	BitsetWord *request;
+	BitsetWord *outputFree = scheduleState->outputFree;
+	BitsetWord *inputFreeRev = scheduleState->inputFreeRev;
+	BitsetWord *inputFree = scheduleState->inputFree;
+	BitsetWord *grant = scheduleState->grant;
+	BitsetWord word;
 
-	clearGraph(graph,N);
-	
 	point = scheduleState->pointer;
 	if ((point<0)||(point >= N))
 	  point = 0;
 	scheduleState->pointer = point+1;
 
-	/* note i == output, j = input */
-	/* Clear all cells */
-	for( i=0; i<N; i++)
-	  for( j=0; j<N; j++)
-		 {
-			cell_E[i][j] = 1;
-			cell_S[i][j] = 1;
-		 }
 	/* clear the macthing */
 	for ( output=0; output<N; output++)
 	  aSwitch->fabric.Xbar_matrix[output].input = NONE;
 
+	/* Sort the requests by diagonal */
+	for( diag=0; diag<N; diag++)
+	  bitsetClear(scheduleState->diagRequest[diag], N);
+	for( input=0; input<N; input++)
+	  {
+		 inputBuffer = aSwitch->inputBuffer[input];
+		 for( output=0; output<N; output++)
+			if ( inputBuffer->fifo[output]->number > 0 )
+			  BITSET_SET(scheduleState->diagRequest[(input+output)%N], output);
+	  }
 
-	/* Now do arbitration start with the first wave */
+	bitsetFill(outputFree, N);
+	bitsetFill(inputFreeRev, N);
 
+	/* Now do arbitration start with the first wave */
 	for( wave=0; wave<N; wave++)
 	  {
 		 diag = (point+wave)%N;
-		 for( k=0; k<N; k++)
+		 request = scheduleState->diagRequest[diag];
+
+		 /* Bit "output" of inputFree is input (diag-output)%N */
+		 bitsetRotate(inputFree, inputFreeRev, N, N-1-diag);
+		 for( wordIndex=0; wordIndex<numWords; wordIndex++)
+			grant[wordIndex] = request[wordIndex] & outputFree[wordIndex] &
+			  inputFree[wordIndex];
+
+		 EVERY_BIT_SET(grant, numWords, wordIndex, word, output)
 			{
-			  i = k;
-			  j = ((diag-k+N)%N);
-			  output = i;
-			  input = j;
-			  inputBuffer = aSwitch->inputBuffer[input];
-			  if (wave==0)
-				 { 
-					/* this is the highest priority diagonal, all requests will be granted */
-
-					if ( inputBuffer->fifo[output]->number > 0 )
-					  {
-						 /* mark granted */
-						 cell_E[i][j] = 0;
-						 cell_S[i][j] = 0;
-						 graph[input][output] = 1;
-						 aSwitch->fabric.Xbar_matrix[output].input = input;
-						 aSwitch->fabric.Xbar_matrix[output].cell = (Cell *)
-                        aSwitch->inputBuffer[input]->fifo[output]->head->Object;
-					  }
-				 }
-			  else
-				 if (( inputBuffer->fifo[output]->number > 0 ) && cell_E[i][(j-1+N)%N] && cell_S[(i-1+N)%N][j])
-					{
-					  cell_E[i][j] = 0;
-					  cell_S[i][j] = 0;
-					  graph[input][output] = 1;
-					  aSwitch->fabric.Xbar_matrix[output].input = input;
-					  aSwitch->fabric.Xbar_matrix[output].cell = (Cell *)
-                        aSwitch->inputBuffer[input]->fifo[output]->head->Object;
-					}
-				 else
-					{
-					  cell_E[i][j] = cell_E[i][(j-1+N)%N];
-					  cell_S[i][j] = cell_S[(i-1+N)%N][j];
-					}
+			  input = (diag-output+N)%N;
+			  BITSET_RESET(outputFree, output);
+			  BITSET_RESET(inputFreeRev, N-1-input);
+			  aSwitch->fabric.Xbar_matrix[output].input = input;
+			  aSwitch->fabric.Xbar_matrix[output].cell = (Cell *)
+				 aSwitch->inputBuffer[input]->fifo[output]->head->Object;
 			}
 	  }
 	if(debug_algorithm)
 	  {
 		 printf("WWFA Match:\n");
-		 printGraph(graph, aSwitch);
+		 printMatch(aSwitch);
 		 printf("\n");
 	  }
 
@@ -207,44 +196,31 @@ createScheduleState(aSwitch)
 Switch *aSwitch;
 {
 	SchedulerState *scheduleState;
+	ScratchBlock block;
+	int pass, n = aSwitch->numInputs;
 
 	
 	scheduleState = (SchedulerState *) malloc(sizeof(SchedulerState));
 	aSwitch->scheduler.schedulingState = scheduleState;
-   return (0);
-}
-
+	scheduleState->pointer = 0;
 
-/***********************************************************************/
-static int **
-makeGraph(n)
-int n;
-{
-	int input;
-	int **graph;
-
-	graph = (int **) malloc(sizeof(int *) * n);
-	for(input=0;input<n; input++)
-		graph[input] = (int *) malloc(sizeof(int)*n);
-
-	return(graph);
-}
-
-static 
-int 
-clearGraph(graph, n)
-int **graph;
-int n;
-{
-	int input;
-	for(input=0;input<n; input++)
-		memset(graph[input], 0, sizeof(int)*n);
+	scratchBegin(&block);
+	for(pass=0; pass<2; pass++)
+	{
+		if( pass )
+			scratchAllocate(&block);
+		scheduleState->diagRequest = scratchBitsets(&block, n, n);
+		scheduleState->outputFree = scratchBitset(&block, n);
+		scheduleState->inputFreeRev = scratchBitset(&block, n);
+		scheduleState->inputFree = scratchBitset(&block, n);
+		scheduleState->grant = scratchBitset(&block, n);
+	}
    return (0);
 }
 
+
 static int
-printGraph(graph, aSwitch)
-int **graph;
+printMatch(aSwitch)
 Switch *aSwitch;
 {
 	int input, output, numFabricOutputs;
@@ -254,7 +230,8 @@ Switch *aSwitch;
 	{
 		for(output=0;output<numFabricOutputs; output++)
 		{
-			printf("%1d ", graph[input][output]);
+			printf("%1d ", 
+			  aSwitch->fabric.Xbar_matrix[output].input == input);
 		}
 		printf("\n");
 	}
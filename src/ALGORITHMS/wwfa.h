@@ -35,5 +35,10 @@
 
 typedef struct {
   int pointer;           /* pointer to the first wave location */
+  BitsetWord **diagRequest; /* [diagonal] outputs requested on it */
+  BitsetWord *outputFree;   /* outputs not yet granted this slot */
+  BitsetWord *inputFreeRev; /* inputs not yet granted, input j at bit N-1-j */
+  BitsetWord *inputFree;    /* inputFreeRev lined up with one diagonal */
+  BitsetWord *grant;        /* grants made by the current wave */
 } SchedulerState;
 
@@ -0,0 +1,356 @@
+/* ****************************************************************
+ * Copyright Stanford University 1998,99 - All Rights Reserved
+ ****************************************************************** 
+
+ * Permission to use, copy, modify, and distribute this software 
+ * and its documentation for any purpose is hereby granted without 
+ * fee, provided that the above copyright notice appears in all copies
+ * and that both the copyright notice, this permission notice, and 
+ * the following disclaimer appear in supporting documentation, and 
+ * that the name of Stanford University, not be used in advertising or 
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.
+ * 
+ * STANFORD UNIVERSITY, DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND 
+ * FITNESS. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE FOR ANY 
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER 
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION 
+ * OF CONTRACT, NEGLIGENCE OR OTHER ACTION, ARISING OUT OF OR IN 
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * The Sim Web Site : http://klamath.stanford.edu/tools/SIM
+ * The SIM Mailing List: sim-simulator@lists.stanford.edu
+
+ * Send mail to the above email address with "subscribe sim-simulator" in
+ * the body of the message.
+ *
+ */
+
+#include "sim.h"
+#include "fabric.h"
+#include "inputAction.h"
+
+#define DEFAULT_CROSSPOINT_SIZE 1
+
+/* 
+   Buffered crossbar (combined input and crosspoint queued) switch.
+   Each crosspoint holds a fifo of up to Bxbar_size cells. Every cell
+   time, each input arbiter sends one cell from its input buffer to a
+   crosspoint with room in its row, and then each output arbiter takes
+   one cell from a crosspoint in its column to its output buffer.
+   An arbiter looks only at its own port's queues and crosspoints, so
+   the ports decide independently in O(N) and there is no matching:
+   the switch's scheduling algorithm must be "null".
+   Both arbiters serve the highest priority first, and round robin 
+   within a priority. A multicast cell at the head of its input fifo 
+   is sent to every crosspoint of its fanout with room at once, and
+   leaves the input when its fanout is covered.
+*/
+
+struct BufferedCrossbarState {
+  int *inputPointer;	/* Output each input arbiter serves first. */
+  int *outputPointer;	/* Input each output arbiter serves first. */
+  int numCells;		/* Cells held in all crosspoints. */
+};
+
+struct BufferedCrossbarStats {
+  Stat inputSends;	/* Cells into crosspoints per cell time. */
+  Stat outputSends;	/* Cells out of crosspoints per cell time. */
+  Stat crosspointCells;	/* Cells held in the crosspoints. */
+};
+
+static int arbitrateInput();
+static int arbitrateOutput();
+static int sendMulticastCell();
+static struct List *crosspoint();
+extern void nullSchedulingAlgorithm();
+
+int 
+bufferedCrossbar(action, aSwitch, argc, argv)
+  FabricAction action;
+Switch *aSwitch;
+int argc;
+char **argv;
+{
+  struct BufferedCrossbarState *fabricState;
+  struct BufferedCrossbarStats *fabricStats;
+
+  if(debug_fabric)
+    printf("Fabric 'bufferedCrossbar()' called by switch %d\n",
+	   aSwitch->switchNumber);
+
+  switch(action)
+    {
+    case FABRIC_USAGE:
+      fprintf(stderr, "Options for \"bufferedCrossbar\" fabric:\n");
+      fprintf(stderr, "  -b crosspointSize in cells. Default: %d\n",
+	      DEFAULT_CROSSPOINT_SIZE);
+      break;
+    case FABRIC_INIT:
+      {
+	extern int opterr, optind;
+	extern int optopt;
+	extern char *optarg;
+	int c, i, numCrosspoints;
+
+	if( debug_fabric )
+	  printf("     Fabric: INIT bufferedCrossbar\n");
+	if( aSwitch->fabric.Bxbar_crosspoint )
+	  break;
+
+	aSwitch->fabric.Bxbar_size = DEFAULT_CROSSPOINT_SIZE;
+	opterr=0; optind=1;
+	while( (c = getopt(argc, argv, "b:")) != EOF )
+	  switch (c)
+	    {
+	    case 'b':
+	      aSwitch->fabric.Bxbar_size = atoi(optarg);
+	      break;
+	    case '?':
+	      fprintf(stderr, "--------------------------------------------\n");
+	      fprintf(stderr, "bufferedCrossbar: Unrecognized option -%c\n", 
+		      optopt);
+	      bufferedCrossbar(FABRIC_USAGE);
+	      fprintf(stderr, "--------------------------------------------\n");
+	      exit(1);
+	    default:
+	      break;
+	    }
+	if( aSwitch->fabric.Bxbar_size < 1 )
+	  {
+	    fprintf(stderr, "bufferedCrossbar: crosspointSize must be at least 1\n");
+	    exit(1);
+	  }
+	printf("    Crosspoint size: %d\n", aSwitch->fabric.Bxbar_size);
+
+	numCrosspoints = aSwitch->numInputs * aSwitch->numOutputs;
+	aSwitch->fabric.Bxbar_crosspoint = (struct List **)
+	  malloc(numCrosspoints * sizeof(struct List *));
+	for(i=0; i<numCrosspoints; i++)
+	  aSwitch->fabric.Bxbar_crosspoint[i] = createLiteList("Crosspoint");
+
+	fabricState = (struct BufferedCrossbarState *)
+	  malloc(sizeof(struct BufferedCrossbarState));
+	fabricState->inputPointer = (int *) 
+	  calloc(aSwitch->numInputs, sizeof(int));
+	fabricState->outputPointer = (int *) 
+	  calloc(aSwitch->numOutputs, sizeof(int));
+	fabricState->numCells = 0;
+	aSwitch->fabric.fabricState = fabricState;
+	break;
+      }
+    case FABRIC_EXEC:
+      {
+	int input, output, numIn=0, numOut=0;
+
+	if( debug_fabric )
+	  printf("     Fabric: EXEC bufferedCrossbar\n");
+
+	fabricState = aSwitch->fabric.fabricState;
+	fabricStats = aSwitch->fabric.fabricStats;
+
+	for(input=0; input<aSwitch->numInputs; input++)
+	  numIn += arbitrateInput(aSwitch, fabricState, input);
+	for(output=0; output<aSwitch->numOutputs; output++)
+	  numOut += arbitrateOutput(aSwitch, fabricState, output);
+	fabricState->numCells += numIn - numOut;
+
+	updateStat(&fabricStats->inputSends, (long) numIn, now);
+	updateStat(&fabricStats->outputSends, (long) numOut, now);
+	updateStat(&fabricStats->crosspointCells, 
+		   (long) fabricState->numCells, now);
+	break;
+      }
+    case FABRIC_STATS_PRINT:
+      {
+	fabricStats = aSwitch->fabric.fabricStats;
+
+	printf("\n");
+	printf("  Buffered crossbar statistics\n");
+	printf("  ----------------------------\n");
+	printf("                       Avg       SD     Number\n");
+	printf("                     -------------------------\n");
+	printStat(stdout, "Cells In:           ", &fabricStats->inputSends);
+	printStat(stdout, "Cells Out:          ", &fabricStats->outputSends);
+	printStat(stdout, "Crosspoint Cells:   ", 
+		  &fabricStats->crosspointCells);
+	break;
+      }
+    case FABRIC_STATS_INIT:
+      {
+	if( aSwitch->scheduler.schedulingAlgorithm != 
+	    (void (*)()) nullSchedulingAlgorithm )
+	  {
+	    fprintf(stderr, "bufferedCrossbar: arbitrates for itself, use the \"null\" algorithm.\n");
+	    exit(1);
+	  }
+	fabricStats = aSwitch->fabric.fabricStats;
+	if( !fabricStats )
+	  {
+	    fabricStats = (struct BufferedCrossbarStats *)
+	      malloc(sizeof(struct BufferedCrossbarStats));
+	    aSwitch->fabric.fabricStats = (void *) fabricStats;
+	  }
+	initStat(&fabricStats->inputSends, STAT_TYPE_AVERAGE, now);
+	initStat(&fabricStats->outputSends, STAT_TYPE_AVERAGE, now);
+	initStat(&fabricStats->crosspointCells, STAT_TYPE_AVERAGE, now);
+	enableStat(&fabricStats->inputSends);
+	enableStat(&fabricStats->outputSends);
+	enableStat(&fabricStats->crosspointCells);
+	break;
+      }
+    default:
+      fprintf(stderr, "\nCommand not implemented in bufferedCrossbar.c\n");
+      exit(2);
+    }
+  if( debug_fabric )
+    printf("     Fabric: Completed\n");
+
+  return (0);
+}
+
+static struct List *
+crosspoint(Switch *aSwitch, int input, int output)
+{
+  return( aSwitch->fabric.Bxbar_crosspoint[input*aSwitch->numOutputs+output] );
+}
+
+/* 
+   Input arbiter: send one cell from input to a crosspoint with room.
+   Of the unicast fifos with cells, the one of highest priority and 
+   nearest the pointer wins; a multicast cell of at least its priority
+   goes first. Returns the number of cells sent to crosspoints.
+*/
+static int
+arbitrateInput(Switch *aSwitch, struct BufferedCrossbarState *fabricState,
+	       int input)
+{
+  InputBuffer *inputBuffer = aSwitch->inputBuffer[input];
+  int numOutputs = aSwitch->numOutputs;
+  int numPriorities = aSwitch->numPriorities;
+  int numFIFOs = numOutputs * numPriorities;
+  int w, fifo, output, priority, best=NONE, bestKey=0, key, numSent;
+  BitsetWord word;
+  Cell *aCell;
+
+  for(w=0; w<BITSET_NUM_WORDS(numFIFOs); w++)
+    for(word=inputBuffer->fifosPending[w]; word; word &= word-1)
+      {
+	fifo = w*BITSET_WORD_BITS + BITSET_WORD_FFS(word);
+	output = fifo / numPriorities;
+	priority = fifo % numPriorities;
+	if( crosspoint(aSwitch, input, output)->number >= 
+	    aSwitch->fabric.Bxbar_size )
+	  continue;
+	key = priority*numOutputs + 
+	  (output - fabricState->inputPointer[input] + numOutputs) % numOutputs;
+	if( best == NONE || key < bestKey )
+	  {
+	    best = fifo;
+	    bestKey = key;
+	  }
+      }
+
+  for(priority=0; priority<numPriorities; priority++)
+    {
+      if( best != NONE && priority > best % numPriorities )
+	break;
+      if( inputBuffer->mcastFifo[priority]->number )
+	{
+	  numSent = sendMulticastCell(aSwitch, input, priority);
+	  if( numSent )
+	    return(numSent);
+	}
+    }
+  if( best == NONE )
+    return(0);
+
+  output = best / numPriorities;
+  aCell = (Cell *) inputBuffer->fifo[best]->head->Object;
+  aCell = (aSwitch->inputAction)(INPUTACTION_TRANSMIT, aSwitch, input, 
+				 aCell, output);
+  addObject(crosspoint(aSwitch, input, output), aCell);
+  latencyStats(LATENCY_STATS_ARRIVE_FABRIC, NULL, aCell);
+  fabricState->inputPointer[input] = (output + 1) % numOutputs;
+  if( debug_fabric )
+    printf("Cell from input %d to crosspoint %d at time %lu\n",
+	   input, output, now);
+  return(1);
+}
+
+/* 
+   Copy the multicast cell at the head of input's fifo for priority to
+   each crosspoint of its fanout with room. The copies leave for their
+   outputs at different times, so each gets a cell of its own.
+   Returns the number of copies sent.
+*/
+static int
+sendMulticastCell(Switch *aSwitch, int input, int priority)
+{
+  struct List *mcastFifo = aSwitch->inputBuffer[input]->mcastFifo[priority];
+  Cell *aCell, *copy;
+  int output, numSent=0;
+
+  aCell = (Cell *) mcastFifo->head->Object;
+  for(output=0; output<aSwitch->numOutputs; output++)
+    {
+      if( !bitmapIsBitSet(output, &aCell->outputs) ||
+	  crosspoint(aSwitch, input, output)->number >= 
+	  aSwitch->fabric.Bxbar_size )
+	continue;
+      copy = (aSwitch->inputAction)(INPUTACTION_TRANSMIT, aSwitch, input, 
+				    aCell, output);
+      copy = unshareCell(copy, output);
+      addObject(crosspoint(aSwitch, input, output), copy);
+      latencyStats(LATENCY_STATS_ARRIVE_FABRIC, NULL, copy);
+      numSent++;
+      if( copy == aCell )
+	break;		/* Fanout covered: aCell has left the input. */
+    }
+  return(numSent);
+}
+
+/* 
+   Output arbiter: move one cell from a crosspoint in output's column
+   to the output buffer, highest priority and nearest the pointer 
+   first. Returns the number of cells moved.
+*/
+static int
+arbitrateOutput(Switch *aSwitch, struct BufferedCrossbarState *fabricState,
+		int output)
+{
+  int numInputs = aSwitch->numInputs;
+  int input, best=NONE, bestKey=0, key;
+  struct List *aCrosspoint;
+  Cell *aCell;
+
+  for(input=0; input<numInputs; input++)
+    {
+      aCrosspoint = crosspoint(aSwitch, input, output);
+      if( aCrosspoint->number == 0 )
+	continue;
+      aCell = (Cell *) aCrosspoint->head->Object;
+      key = aCell->priority*numInputs + 
+	(input - fabricState->outputPointer[output] + numInputs) % numInputs;
+      if( best == NONE || key < bestKey )
+	{
+	  best = input;
+	  bestKey = key;
+	}
+    }
+  if( best == NONE )
+    return(0);
+
+  aCell = (Cell *) removeObject(crosspoint(aSwitch, best, output));
+  enqueueOutputCell(aSwitch, output, aCell->priority, aCell);
+  latencyStats(LATENCY_STATS_ARRIVE_OUTPUT, NULL, aCell);
+  fabricState->outputPointer[output] = (best + 1) % numInputs;
+  if( debug_fabric )
+    printf("Cell from crosspoint %d to output %d at time %lu\n",
+	   best, output, now);
+  return(1);
+}
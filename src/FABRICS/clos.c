@@ -0,0 +1,400 @@
+/* ****************************************************************
+ * Copyright Stanford University 1998,99 - All Rights Reserved
+ ****************************************************************** 
+
+ * Permission to use, copy, modify, and distribute this software 
+ * and its documentation for any purpose is hereby granted without 
+ * fee, provided that the above copyright notice appears in all copies
+ * and that both the copyright notice, this permission notice, and 
+ * the following disclaimer appear in supporting documentation, and 
+ * that the name of Stanford University, not be used in advertising or 
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.
+ * 
+ * STANFORD UNIVERSITY, DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND 
+ * FITNESS. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE FOR ANY 
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER 
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION 
+ * OF CONTRACT, NEGLIGENCE OR OTHER ACTION, ARISING OUT OF OR IN 
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * The Sim Web Site : http://klamath.stanford.edu/tools/SIM
+ * The SIM Mailing List: sim-simulator@lists.stanford.edu
+
+ * Send mail to the above email address with "subscribe sim-simulator" in
+ * the body of the message.
+ *
+ */
+
+#include "sim.h"
+#include "fabric.h"
+#include "inputAction.h"
+
+#define DEFAULT_MIDDLE_BUFFER 1
+
+/* 
+   Three stage Clos switch built from N/n input modules of n ports,
+   m middle modules and N/n output modules of n ports.
+   Each input module has one link to each middle module, and each 
+   middle module one link to each output module; a link carries one
+   cell per cell time. A middle module queues up to Clos_bufferSize 
+   cells for each switch output (Clos_middle[middle*N+output]).
+
+   Every cell time each input module dispatches: its inputs, in round
+   robin order, each offer one cell, and the cell is sent on the first
+   link not yet used this cell time whose middle module has room for 
+   it. Then each middle to output module link carries one cell from 
+   the queues of the outputs it leads to, and the output module puts 
+   it in the output buffer. Scheduling is per module, so its work and
+   the fabric's state grow with m*N rather than N*N: the switch's 
+   scheduling algorithm must be "null".
+   Cells of higher priority go first, round robin within a priority.
+   A multicast cell sends one copy per cell time, as a unicast cell to 
+   the first output of its remaining fanout.
+*/
+
+struct ClosFabricState {
+  int numModules;	/* Input (and output) modules: N/n */
+  int *inputPointer;	/* Output each input serves first. */
+  int *modulePointer;	/* Input each input module serves first. */
+  int *linkPointer;	/* Middle module each input module tries first. */
+  int *outputPointer;	/* Per middle-output module link: output */
+			/* served first.			     */
+  int *linkUsed;	/* Scratch: middle links used by a module. */
+  int numCells;		/* Cells held in the middle modules. */
+};
+
+struct ClosStats {
+  Stat dispatched;	/* Cells into middle modules per cell time. */
+  Stat middleCells;	/* Cells held in the middle modules. */
+};
+
+static int dispatchModule();
+static int forwardMiddle();
+static Cell *inputCandidate();
+static struct List *middleQueue();
+extern void nullSchedulingAlgorithm();
+
+int 
+clos(action, aSwitch, argc, argv)
+  FabricAction action;
+Switch *aSwitch;
+int argc;
+char **argv;
+{
+  struct ClosFabricState *fabricState;
+  struct ClosStats *fabricStats;
+
+  if(debug_fabric)
+    printf("Fabric 'clos()' called by switch %d\n",aSwitch->switchNumber);
+
+  switch(action)
+    {
+    case FABRIC_USAGE:
+      fprintf(stderr, "Options for \"clos\" fabric:\n");
+      fprintf(stderr, "  -n portsPerModule. Default: largest divisor of N <= sqrt(N)\n");
+      fprintf(stderr, "  -m numMiddleModules. Default: portsPerModule\n");
+      fprintf(stderr, "  -b middle module cells per output. Default: %d\n",
+	      DEFAULT_MIDDLE_BUFFER);
+      break;
+    case FABRIC_INIT:
+      {
+	extern int opterr, optind;
+	extern int optopt;
+	extern char *optarg;
+	int c, i, n=0, m=0, numQueues;
+	int numPorts = aSwitch->numInputs;
+
+	if( debug_fabric )
+	  printf("     Fabric: INIT clos\n");
+	if( aSwitch->fabric.Clos_middle )
+	  break;
+
+	aSwitch->fabric.Clos_bufferSize = DEFAULT_MIDDLE_BUFFER;
+	opterr=0; optind=1;
+	while( (c = getopt(argc, argv, "n:m:b:")) != EOF )
+	  switch (c)
+	    {
+	    case 'n':
+	      n = atoi(optarg);
+	      break;
+	    case 'm':
+	      m = atoi(optarg);
+	      break;
+	    case 'b':
+	      aSwitch->fabric.Clos_bufferSize = atoi(optarg);
+	      break;
+	    case '?':
+	      fprintf(stderr, "--------------------------------------------\n");
+	      fprintf(stderr, "clos: Unrecognized option -%c\n", optopt);
+	      clos(FABRIC_USAGE);
+	      fprintf(stderr, "--------------------------------------------\n");
+	      exit(1);
+	    default:
+	      break;
+	    }
+
+	if( aSwitch->numInputs != aSwitch->numOutputs )
+	  {
+	    fprintf(stderr, "clos: needs as many inputs as outputs\n");
+	    exit(1);
+	  }
+	if( !n )
+	  for(n=1, i=1; i*i<=numPorts; i++)
+	    if( numPorts % i == 0 )
+	      n = i;
+	if( !m )
+	  m = n;
+	if( n < 1 || numPorts % n || m < 1 || 
+	    aSwitch->fabric.Clos_bufferSize < 1 )
+	  {
+	    fprintf(stderr, "clos: portsPerModule must divide %d, and numMiddleModules and buffer be at least 1\n", numPorts);
+	    exit(1);
+	  }
+	aSwitch->fabric.Clos_portsPerModule = n;
+	aSwitch->fabric.Clos_numMiddle = m;
+	printf("    Clos modules: %d of %d ports, %d middle, %d cells per output\n",
+	       numPorts/n, n, m, aSwitch->fabric.Clos_bufferSize);
+
+	numQueues = m * numPorts;
+	aSwitch->fabric.Clos_middle = (struct List **)
+	  malloc(numQueues * sizeof(struct List *));
+	for(i=0; i<numQueues; i++)
+	  aSwitch->fabric.Clos_middle[i] = createLiteList("ClosMiddle");
+
+	fabricState = (struct ClosFabricState *)
+	  malloc(sizeof(struct ClosFabricState));
+	fabricState->numModules = numPorts / n;
+	fabricState->inputPointer = (int *) calloc(numPorts, sizeof(int));
+	fabricState->modulePointer = (int *) 
+	  calloc(fabricState->numModules, sizeof(int));
+	fabricState->linkPointer = (int *) 
+	  calloc(fabricState->numModules, sizeof(int));
+	fabricState->outputPointer = (int *) 
+	  calloc(m * fabricState->numModules, sizeof(int));
+	fabricState->linkUsed = (int *) calloc(m, sizeof(int));
+	fabricState->numCells = 0;
+	aSwitch->fabric.fabricState = fabricState;
+	break;
+      }
+    case FABRIC_EXEC:
+      {
+	int module, middle, numIn=0, numOut=0;
+
+	if( debug_fabric )
+	  printf("     Fabric: EXEC clos\n");
+
+	fabricState = aSwitch->fabric.fabricState;
+	fabricStats = aSwitch->fabric.fabricStats;
+
+	for(module=0; module<fabricState->numModules; module++)
+	  numIn += dispatchModule(aSwitch, fabricState, module);
+	for(middle=0; middle<aSwitch->fabric.Clos_numMiddle; middle++)
+	  for(module=0; module<fabricState->numModules; module++)
+	    numOut += forwardMiddle(aSwitch, fabricState, middle, module);
+	fabricState->numCells += numIn - numOut;
+
+	updateStat(&fabricStats->dispatched, (long) numIn, now);
+	updateStat(&fabricStats->middleCells, 
+		   (long) fabricState->numCells, now);
+	break;
+      }
+    case FABRIC_STATS_PRINT:
+      {
+	fabricStats = aSwitch->fabric.fabricStats;
+
+	printf("\n");
+	printf("  Clos statistics\n");
+	printf("  ---------------\n");
+	printf("                       Avg       SD     Number\n");
+	printf("                     -------------------------\n");
+	printStat(stdout, "Cells Dispatched:   ", &fabricStats->dispatched);
+	printStat(stdout, "Middle Cells:       ", &fabricStats->middleCells);
+	break;
+      }
+    case FABRIC_STATS_INIT:
+      {
+	if( aSwitch->scheduler.schedulingAlgorithm != 
+	    (void (*)()) nullSchedulingAlgorithm )
+	  {
+	    fprintf(stderr, "clos: schedules its own modules, use the \"null\" algorithm.\n");
+	    exit(1);
+	  }
+	fabricStats = aSwitch->fabric.fabricStats;
+	if( !fabricStats )
+	  {
+	    fabricStats = (struct ClosStats *) malloc(sizeof(struct ClosStats));
+	    aSwitch->fabric.fabricStats = (void *) fabricStats;
+	  }
+	initStat(&fabricStats->dispatched, STAT_TYPE_AVERAGE, now);
+	initStat(&fabricStats->middleCells, STAT_TYPE_AVERAGE, now);
+	enableStat(&fabricStats->dispatched);
+	enableStat(&fabricStats->middleCells);
+	break;
+      }
+    default:
+      fprintf(stderr, "\nCommand not implemented in clos.c\n");
+      exit(2);
+    }
+  if( debug_fabric )
+    printf("     Fabric: Completed\n");
+
+  return (0);
+}
+
+static struct List *
+middleQueue(Switch *aSwitch, int middle, int output)
+{
+  return( aSwitch->fabric.Clos_middle[middle*aSwitch->numOutputs+output] );
+}
+
+/* 
+   The cell input offers this cell time: its unicast fifo of highest 
+   priority nearest its pointer, unless a multicast cell of at least 
+   that priority waits. Returns the cell, NULL if none, and its output.
+*/
+static Cell *
+inputCandidate(Switch *aSwitch, struct ClosFabricState *fabricState,
+	       int input, int *output)
+{
+  InputBuffer *inputBuffer = aSwitch->inputBuffer[input];
+  int numOutputs = aSwitch->numOutputs;
+  int numPriorities = aSwitch->numPriorities;
+  int numFIFOs = numOutputs * numPriorities;
+  int w, fifo, priority, best=NONE, bestKey=0, key;
+  BitsetWord word;
+  Cell *aCell;
+
+  for(w=0; w<BITSET_NUM_WORDS(numFIFOs); w++)
+    for(word=inputBuffer->fifosPending[w]; word; word &= word-1)
+      {
+	fifo = w*BITSET_WORD_BITS + BITSET_WORD_FFS(word);
+	key = (fifo % numPriorities)*numOutputs + 
+	  (fifo/numPriorities - fabricState->inputPointer[input] + numOutputs) 
+	  % numOutputs;
+	if( best == NONE || key < bestKey )
+	  {
+	    best = fifo;
+	    bestKey = key;
+	  }
+      }
+
+  for(priority=0; priority<numPriorities; priority++)
+    {
+      if( best != NONE && priority > best % numPriorities )
+	break;
+      if( inputBuffer->mcastFifo[priority]->number )
+	{
+	  aCell = (Cell *) inputBuffer->mcastFifo[priority]->head->Object;
+	  for(*output=0; !bitmapIsBitSet(*output, &aCell->outputs); (*output)++)
+	    ;
+	  return(aCell);
+	}
+    }
+  if( best == NONE )
+    return(NULL);
+  *output = best / numPriorities;
+  return( (Cell *) inputBuffer->fifo[best]->head->Object );
+}
+
+/* 
+   Input module: send at most one cell from each of its inputs, and at
+   most one on each middle link. Returns the number of cells sent.
+*/
+static int
+dispatchModule(Switch *aSwitch, struct ClosFabricState *fabricState,
+	       int module)
+{
+  int n = aSwitch->fabric.Clos_portsPerModule;
+  int m = aSwitch->fabric.Clos_numMiddle;
+  int *linkUsed = fabricState->linkUsed;
+  int i, j, input, output, middle, numLinks=0, numSent=0;
+  Cell *aCell;
+
+  for(j=0; j<m; j++)
+    linkUsed[j] = NO;
+
+  for(i=0; i<n && numLinks<m; i++)
+    {
+      input = module*n + (fabricState->modulePointer[module] + i) % n;
+      aCell = inputCandidate(aSwitch, fabricState, input, &output);
+      if( aCell == NULL )
+	continue;
+
+      for(j=0; j<m; j++)
+	{
+	  middle = (fabricState->linkPointer[module] + j) % m;
+	  if( !linkUsed[middle] && middleQueue(aSwitch, middle, output)->number
+	      < aSwitch->fabric.Clos_bufferSize )
+	    break;
+	}
+      if( j == m )
+	continue;	/* No middle module has room: try next time */
+
+      aCell = (aSwitch->inputAction)(INPUTACTION_TRANSMIT, aSwitch, input, 
+				     aCell, output);
+      aCell = unshareCell(aCell, output);
+      addObject(middleQueue(aSwitch, middle, output), aCell);
+      latencyStats(LATENCY_STATS_ARRIVE_FABRIC, NULL, aCell);
+      linkUsed[middle] = YES;
+      numLinks++;
+      numSent++;
+      fabricState->inputPointer[input] = (output + 1) % aSwitch->numOutputs;
+      if( debug_fabric )
+	printf("Cell from input %d to middle module %d at time %lu\n",
+	       input, middle, now);
+    }
+
+  fabricState->modulePointer[module] = 
+    (fabricState->modulePointer[module] + 1) % n;
+  fabricState->linkPointer[module] = 
+    (fabricState->linkPointer[module] + 1) % m;
+  return(numSent);
+}
+
+/* 
+   Link from middle module to output module: carry the cell of highest
+   priority, nearest the link's pointer, to its output buffer. Returns
+   the number of cells carried.
+*/
+static int
+forwardMiddle(Switch *aSwitch, struct ClosFabricState *fabricState,
+	      int middle, int module)
+{
+  int n = aSwitch->fabric.Clos_portsPerModule;
+  int *pointer = &fabricState->outputPointer[middle*fabricState->numModules
+					     + module];
+  int i, output, best=NONE, bestKey=0, key;
+  struct List *aQueue;
+  Cell *aCell;
+
+  for(i=0; i<n; i++)
+    {
+      output = module*n + i;
+      aQueue = middleQueue(aSwitch, middle, output);
+      if( aQueue->number == 0 )
+	continue;
+      aCell = (Cell *) aQueue->head->Object;
+      key = aCell->priority*n + (i - *pointer + n) % n;
+      if( best == NONE || key < bestKey )
+	{
+	  best = output;
+	  bestKey = key;
+	}
+    }
+  if( best == NONE )
+    return(0);
+
+  aCell = (Cell *) removeObject(middleQueue(aSwitch, middle, best));
+  enqueueOutputCell(aSwitch, best, aCell->priority, aCell);
+  latencyStats(LATENCY_STATS_ARRIVE_OUTPUT, NULL, aCell);
+  *pointer = (best - module*n + 1) % n;
+  if( debug_fabric )
+    printf("Cell from middle module %d to output %d at time %lu\n",
+	   middle, best, now);
+  return(1);
+}
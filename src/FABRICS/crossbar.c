@@ -33,21 +33,41 @@
 #include "sim.h"
 #include "fabric.h"
 #include "inputAction.h"
+#include "algorithm.h"
 #include <string.h>
 
 
+/* Speedup is kept in thousandths of a phase per cell time, so that */
+/* a fractional speedup gives an exact, repeating phase schedule.     */
+#define SPEEDUP_UNIT 1000
+
 struct CrossbarFabricState {
   int maxCompare;   /* If set, compare size of match with max sized match. */
+  void *maxMatchState; /* Matcher used for the comparison. */
+  int speedup;	    /* Phases per cell time, in SPEEDUP_UNITs. */
+  int phaseCredit;  /* Fraction of a phase carried to the next cell time. */
+  int maxOutputCells; /* Extra phases skip outputs holding this many. */
+  struct List *emptyFifo; /* Stands in for a VOQ to a full output. */
+  struct List **heldFifo; /* VOQs hidden from an extra phase, */
+  int *heldInput;	  /* their inputs */
+  int *heldIndex;	  /* and their places in fifo[]. */
+  int numHeld;
 };
 
 struct CrossbarStats {
   Stat matchSize;
   Stat matchCompare;
+  Stat numPhases;
 };
 
 int resetMatrix(Switch *aSwitch );
-extern int findSizeMaxMatch(Switch *aSwitch);
+extern int findSizeMaxMatch(Switch *aSwitch, void **matcherState);
 extern void printCell(FILE*, Cell*);
+static int transferMatrix();
+static int inputsPending();
+static int outputCells();
+static void hideFullOutputs();
+static void showFullOutputs();
 
 /* 
    Crossbar switch. 
@@ -55,6 +75,15 @@ extern void printCell(FILE*, Cell*);
    input fifo and move to output fifo. 
    Only one cell may be taken from each input buffer.
    Only one cell may be added to each output buffer.
+
+   With a speedup S the fabric runs S phases per cell time: the 
+   scheduler is called again before each phase after the first, so
+   up to S cells may leave each input and reach each output. 
+   A fractional S is met on average, e.g. S=1.5 alternates 1 and 2 
+   phases. With -q the extra phases leave cells at the input rather
+   than send them to an output already holding maxOutputCells: before
+   such a phase is scheduled the VOQs to those outputs are swapped for
+   an empty list, so the scheduler matches the other outputs instead.
 */
 int 
 crossbar(action, aSwitch, argc, argv)
@@ -70,7 +99,6 @@ char **argv;
      if so, add it to the input buffer at its destination
      if not, destroy the cell
      */
-  Cell *aCell;
   struct CrossbarFabricState *fabricState;
   struct CrossbarStats *fabricStats;
 
@@ -85,6 +113,8 @@ char **argv;
       fprintf(stderr, "Options for \"crossbar\" fabric:\n");
       fprintf(stderr, "  -m Compare match with maximum size\n");
       fprintf(stderr, "  -o numOutputLines per output. Default: 1\n");
+      fprintf(stderr, "  -S speedup (phases per cell time, >= 1). Default: 1\n");
+      fprintf(stderr, "  -q maxOutputCells fed by extra phases. Default: Infinite\n");
       break;
     case FABRIC_INIT:
       {
@@ -106,10 +136,14 @@ char **argv;
 	      malloc( sizeof(struct CrossbarFabricState) );
 	    aSwitch->fabric.fabricState = fabricState;
 	    fabricState->maxCompare = 0;
+	    fabricState->maxMatchState = NULL;
+	    fabricState->speedup = SPEEDUP_UNIT;
+	    fabricState->phaseCredit = 0;
+	    fabricState->maxOutputCells = NONE;
 
 	    for(i=0; i<=argc; i++)
 	      {
-		c = getopt(argc, argv, "mo:");
+		c = getopt(argc, argv, "mo:S:q:");
 		switch (c)
 		  {
 		  case 'm':
@@ -118,6 +152,13 @@ char **argv;
 		  case 'o':
 		    outputLineWidth = atoi(optarg);
 		    break;
+		  case 'S':
+		    fabricState->speedup = (int)
+		      (atof(optarg) * SPEEDUP_UNIT + 0.5);
+		    break;
+		  case 'q':
+		    fabricState->maxOutputCells = atoi(optarg);
+		    break;
 		  default:
 		    optind++;
 		    break;
@@ -134,6 +175,32 @@ char **argv;
 	    if( outputLineWidth != 1 )
 	      printf("Crossbar output line width: %d\n", 
 		     aSwitch->fabric.Xbar_numOutputLines);
+	    if( fabricState->speedup < SPEEDUP_UNIT )
+	      {
+		fprintf(stderr, "crossbar: speedup must be at least 1\n");
+		exit(1);
+	      }
+	    if( fabricState->speedup != SPEEDUP_UNIT )
+	      {
+		printf("Crossbar speedup: %g\n", 
+		       (double) fabricState->speedup / SPEEDUP_UNIT);
+		if( fabricState->maxOutputCells != NONE )
+		  printf("Crossbar max output cells for extra phases: %d\n",
+			 fabricState->maxOutputCells);
+	      }
+	    if( fabricState->speedup != SPEEDUP_UNIT
+		&& fabricState->maxOutputCells != NONE )
+	      {
+		int numFIFOs = aSwitch->numInputs * aSwitch->numOutputs
+		  * aSwitch->numPriorities;
+
+		fabricState->emptyFifo = createList("Empty");
+		fabricState->heldFifo = (struct List **)
+		  malloc(numFIFOs * sizeof(struct List *));
+		fabricState->heldInput = (int *) malloc(numFIFOs * sizeof(int));
+		fabricState->heldIndex = (int *) malloc(numFIFOs * sizeof(int));
+		fabricState->numHeld = 0;
+	      }
 	  }
 	/* Init switch routing matrix */
 	resetMatrix(aSwitch);
@@ -142,12 +209,7 @@ char **argv;
       }
     case FABRIC_EXEC:
       {
-	struct List  *toFifo;
-	struct Element *anElement;
-	int switchInput, switchOutput;
-	int fabricOutput;
-	int matchSize=0, maxSizeMatch=0, numFabricOutputs;
-	int priority;
+	int phase, numPhases;
 
 	if( debug_fabric )
 	  printf("     Fabric: EXEC crossbar matrix\n");
@@ -155,49 +217,27 @@ char **argv;
 	fabricState = aSwitch->fabric.fabricState;
 	fabricStats = aSwitch->fabric.fabricStats;
 
-	if( fabricState->maxCompare )
-	  maxSizeMatch = findSizeMaxMatch(aSwitch);
-
-	numFabricOutputs =
-	  aSwitch->numOutputs * aSwitch->fabric.Xbar_numOutputLines;
-	for(fabricOutput=0; fabricOutput<numFabricOutputs; fabricOutput++)
-	  {
-	    switchOutput = fabricOutput/aSwitch->fabric.Xbar_numOutputLines;
-	    switchInput = aSwitch->fabric.Xbar_matrix[fabricOutput].input;
-	    aCell = aSwitch->fabric.Xbar_matrix[fabricOutput].cell;
-	    if( switchInput != NONE )
-	      {
-
-		aCell = (aSwitch->inputAction)(INPUTACTION_TRANSMIT, 
-					       aSwitch, switchInput, (Cell *)aCell, fabricOutput);
-		priority = aCell->priority;
-		toFifo = aSwitch->outputBuffer[switchOutput]->fifo[priority];   /* TL */
-		anElement = createElement(aCell);
-		addElement(toFifo, anElement);
+	/* The first phase was scheduled by the caller. */
+	fabricState->phaseCredit += fabricState->speedup;
+	numPhases = fabricState->phaseCredit / SPEEDUP_UNIT;
+	fabricState->phaseCredit -= numPhases * SPEEDUP_UNIT;
 
-		matchSize++;
-		
-		if( debug_fabric )
-		  printf("     Fabric: Update stats\n");
-		/* Update latency stats for this cell */
-		latencyStats(LATENCY_STATS_ARRIVE_FABRIC, NULL, aCell);
-		latencyStats(LATENCY_STATS_ARRIVE_OUTPUT, NULL, aCell);
-		if(debug_fabric)
-		  printf("Cell from input %d to output %d priority %d at time %lu\n",
-			 switchInput, fabricOutput, priority, now);
-		if(debug_fabric)
-		  printCell(stdout, aCell);
-		
-	      }
-	  }
-	updateStat(&fabricStats->matchSize, (long) matchSize, now);
-
-	if( fabricState->maxCompare )
+	transferMatrix(aSwitch, fabricState, fabricStats, 0);
+	for(phase=1; phase<numPhases; phase++)
 	  {
-	    updateStat(&fabricStats->matchCompare, 
-		       (long) maxSizeMatch-matchSize, now);
+	    if( !inputsPending(aSwitch) )
+	      break;
+	    if( debug_fabric )
+	      printf("     Fabric: crossbar phase %d\n", phase);
+	    if( fabricState->maxOutputCells != NONE )
+	      hideFullOutputs(aSwitch, fabricState);
+	    (aSwitch->scheduler.schedulingAlgorithm)(SCHEDULING_EXEC, aSwitch);
+	    if( fabricState->maxOutputCells != NONE )
+	      showFullOutputs(aSwitch, fabricState);
+	    transferMatrix(aSwitch, fabricState, fabricStats, phase);
 	  }
-	resetMatrix(aSwitch);
+	if( fabricState->speedup != SPEEDUP_UNIT )
+	  updateStat(&fabricStats->numPhases, (long) phase, now);
 
 	break;
       }
@@ -216,6 +256,9 @@ char **argv;
 	if( fabricState->maxCompare )
 	  printStat(stdout, "Match diff from Max:", 
 		    &fabricStats->matchCompare);
+	if( fabricState->speedup != SPEEDUP_UNIT )
+	  printStat(stdout, "Phases per cell:    ", 
+		    &fabricStats->numPhases);
 	break;
       }
     case FABRIC_STATS_INIT:
@@ -231,9 +274,12 @@ char **argv;
 	  }
 	initStat(&fabricStats->matchSize, STAT_TYPE_AVERAGE, now);
 	initStat(&fabricStats->matchCompare, STAT_TYPE_AVERAGE, now);
+	initStat(&fabricStats->numPhases, STAT_TYPE_AVERAGE, now);
 	enableStat(&fabricStats->matchSize);
 	if( fabricState->maxCompare )
 	  enableStat(&fabricStats->matchCompare);
+	if( fabricState->speedup != SPEEDUP_UNIT )
+	  enableStat(&fabricStats->numPhases);
 	break;
       }
     default:
@@ -258,3 +304,148 @@ int resetMatrix( aSwitch )
   memset(aSwitch->fabric.Xbar_matrix, NONE, numFabricOutputs*sizeof(MatrixEntry));
   return (0);
 }
+
+/* 
+   Move the cells configured in the matrix from the inputs to the 
+   outputs, then clear the matrix for the next phase. 
+   Returns the number of cells moved.
+*/
+static int
+transferMatrix(Switch *aSwitch, struct CrossbarFabricState *fabricState,
+	       struct CrossbarStats *fabricStats, int phase)
+{
+  int switchInput, switchOutput;
+  int fabricOutput;
+  int matchSize=0, maxSizeMatch=0, numFabricOutputs;
+  int priority;
+  Cell *aCell;
+
+  if( fabricState->maxCompare )
+    maxSizeMatch = findSizeMaxMatch(aSwitch, &fabricState->maxMatchState);
+
+  numFabricOutputs =
+    aSwitch->numOutputs * aSwitch->fabric.Xbar_numOutputLines;
+  for(fabricOutput=0; fabricOutput<numFabricOutputs; fabricOutput++)
+    {
+      switchOutput = fabricOutput/aSwitch->fabric.Xbar_numOutputLines;
+      switchInput = aSwitch->fabric.Xbar_matrix[fabricOutput].input;
+      aCell = aSwitch->fabric.Xbar_matrix[fabricOutput].cell;
+      if( switchInput == NONE )
+	continue;
+      /* Multicast cells are not hidden from the scheduler */
+      if( phase && fabricState->maxOutputCells != NONE
+	  && aCell->multicast != UCAST
+	  && outputCells(aSwitch, switchOutput) >= fabricState->maxOutputCells )
+	continue;
+
+      aCell = (aSwitch->inputAction)(INPUTACTION_TRANSMIT, 
+				     aSwitch, switchInput, (Cell *)aCell, fabricOutput);
+      priority = aCell->priority;
+      enqueueOutputCell(aSwitch, switchOutput, priority, aCell);
+
+      matchSize++;
+		
+      if( debug_fabric )
+	printf("     Fabric: Update stats\n");
+      /* Update latency stats for this cell */
+      latencyStats(LATENCY_STATS_ARRIVE_FABRIC, NULL, aCell);
+      latencyStats(LATENCY_STATS_ARRIVE_OUTPUT, NULL, aCell);
+      if(debug_fabric)
+	printf("Cell from input %d to output %d priority %d at time %lu\n",
+	       switchInput, fabricOutput, priority, now);
+      if(debug_fabric)
+	printCell(stdout, aCell);
+    }
+  updateStat(&fabricStats->matchSize, (long) matchSize, now);
+
+  if( fabricState->maxCompare )
+    {
+      updateStat(&fabricStats->matchCompare, 
+		 (long) maxSizeMatch-matchSize, now);
+    }
+  resetMatrix(aSwitch);
+
+  return(matchSize);
+}
+
+/* Is there a cell at any input for another phase to move? */
+static int
+inputsPending(Switch *aSwitch)
+{
+  int input, priority;
+  int numFIFOs = aSwitch->numOutputs * aSwitch->numPriorities;
+  InputBuffer *inputBuffer;
+
+  for(input=0; input<aSwitch->numInputs; input++)
+    {
+      inputBuffer = aSwitch->inputBuffer[input];
+      if( bitsetAnySet(inputBuffer->fifosPending, numFIFOs) )
+	return(YES);
+      for(priority=0; priority<aSwitch->numPriorities; priority++)
+	if( inputBuffer->mcastFifo[priority]->number )
+	  return(YES);
+    }
+  return(NO);
+}
+
+/* Number of cells queued at an output, over all priorities. */
+static int
+outputCells(Switch *aSwitch, int output)
+{
+  int priority, numCells=0;
+
+  for(priority=0; priority<aSwitch->numPriorities; priority++)
+    numCells += aSwitch->outputBuffer[output]->fifo[priority]->number;
+  return(numCells);
+}
+
+/* 
+   Before an extra phase is scheduled, swap each input's VOQs to the
+   outputs holding maxOutputCells for an empty list. An algorithm that
+   follows the fifos is told of those that held cells.
+*/
+static void
+hideFullOutputs(Switch *aSwitch, struct CrossbarFabricState *fabricState)
+{
+  int input, output, priority, k;
+  struct List **fifo;
+
+  fabricState->numHeld = 0;
+  for(output=0; output<aSwitch->numOutputs; output++)
+    {
+      if( outputCells(aSwitch, output) < fabricState->maxOutputCells )
+	continue;
+      for(input=0; input<aSwitch->numInputs; input++)
+	for(priority=0; priority<aSwitch->numPriorities; priority++)
+	  {
+	    k = output*aSwitch->numPriorities + priority;
+	    fifo = &aSwitch->inputBuffer[input]->fifo[k];
+	    if( (*fifo)->number == 0 )
+	      continue;
+	    fabricState->heldFifo[fabricState->numHeld] = *fifo;
+	    fabricState->heldInput[fabricState->numHeld] = input;
+	    fabricState->heldIndex[fabricState->numHeld] = k;
+	    fabricState->numHeld++;
+	    *fifo = fabricState->emptyFifo;
+	    if( aSwitch->scheduler.fifoChanged )
+	      (aSwitch->scheduler.fifoChanged)(aSwitch, input, k);
+	  }
+    }
+}
+
+/* Put back the VOQs hidden by hideFullOutputs(). */
+static void
+showFullOutputs(Switch *aSwitch, struct CrossbarFabricState *fabricState)
+{
+  int i, input, k;
+
+  for(i=0; i<fabricState->numHeld; i++)
+    {
+      input = fabricState->heldInput[i];
+      k = fabricState->heldIndex[i];
+      aSwitch->inputBuffer[input]->fifo[k] = fabricState->heldFifo[i];
+      if( aSwitch->scheduler.fifoChanged )
+	(aSwitch->scheduler.fifoChanged)(aSwitch, input, k);
+    }
+  fabricState->numHeld = 0;
+}
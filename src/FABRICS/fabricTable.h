@@ -34,10 +34,16 @@
 
 extern int    crossbar();
 extern int    outputQueued();
+extern int    bufferedCrossbar();
+extern int    clos();
+extern int    loadBalanced();
 
 FunctionTable fabricTable[] = {
     {"crossbar",  "Crossbar switch",    (void *) crossbar},
     {"outputQueued",  "Output Queued  switch",    (void *) outputQueued},
+    {"bufferedCrossbar",  "Buffered crossbar (CICQ) switch",    (void *) bufferedCrossbar},
+    {"clos",  "Three stage Clos switch",    (void *) clos},
+    {"loadBalanced",  "Load balanced two stage switch",    (void *) loadBalanced},
 	{NULL,NULL,NULL}
 };
 
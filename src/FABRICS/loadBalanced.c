@@ -0,0 +1,258 @@
+/* ****************************************************************
+ * Copyright Stanford University 1998,99 - All Rights Reserved
+ ****************************************************************** 
+
+ * Permission to use, copy, modify, and distribute this software 
+ * and its documentation for any purpose is hereby granted without 
+ * fee, provided that the above copyright notice appears in all copies
+ * and that both the copyright notice, this permission notice, and 
+ * the following disclaimer appear in supporting documentation, and 
+ * that the name of Stanford University, not be used in advertising or 
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.
+ * 
+ * STANFORD UNIVERSITY, DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND 
+ * FITNESS. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE FOR ANY 
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER 
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION 
+ * OF CONTRACT, NEGLIGENCE OR OTHER ACTION, ARISING OUT OF OR IN 
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * The Sim Web Site : http://klamath.stanford.edu/tools/SIM
+ * The SIM Mailing List: sim-simulator@lists.stanford.edu
+
+ * Send mail to the above email address with "subscribe sim-simulator" in
+ * the body of the message.
+ *
+ */
+
+#include "sim.h"
+#include "fabric.h"
+#include "inputAction.h"
+
+/* 
+   Load balanced (two stage Birkhoff-von Neumann) switch.
+   Both stages are crossbars that step through a fixed cyclic set of
+   permutations: in slot t, input i is connected to intermediate port 
+   (i+t) mod N, and intermediate port j to output (j+t) mod N. 
+   Each intermediate port has a fifo per output 
+   (LB_intermediate[port*N+output]). 
+   Every slot each input sends one cell to the intermediate port it is
+   connected to, taken round robin over its fifos with cells, and each
+   intermediate port sends the cell at the head of its fifo for the 
+   output it is connected to. There is no matching, so a slot costs 
+   O(N) whatever the load, and the switch's scheduling algorithm must
+   be "null". 
+   A multicast cell, which goes first, sends one copy per slot, as a 
+   unicast cell to the first output of its remaining fanout.
+   Cells of a flow may take different intermediate ports and leave 
+   out of order: the fabric counts the cells reaching their output 
+   behind a later cell of the same input.
+*/
+
+struct LoadBalancedState {
+  long slot;		/* Slot number: selects the permutations. */
+  int *inputPointer;	/* Input fifo each input serves first. */
+  unsigned long *lastID; /* Latest cell of each flow (input*N+output) */
+			 /* to reach its output.		      */
+  int numCells;		/* Cells held at the intermediate ports. */
+};
+
+struct LoadBalancedStats {
+  Stat intermediateCells;	/* Cells held at the intermediate ports. */
+  Stat outOfOrder;		/* 1 for each cell out of order, else 0. */
+};
+
+static int firstStage();
+static int secondStage();
+extern void nullSchedulingAlgorithm();
+
+int 
+loadBalanced(action, aSwitch, argc, argv)
+  FabricAction action;
+Switch *aSwitch;
+int argc;
+char **argv;
+{
+  struct LoadBalancedState *fabricState;
+  struct LoadBalancedStats *fabricStats;
+
+  if(debug_fabric)
+    printf("Fabric 'loadBalanced()' called by switch %d\n",
+	   aSwitch->switchNumber);
+
+  switch(action)
+    {
+    case FABRIC_USAGE:
+      fprintf(stderr, "No options for \"loadBalanced\" fabric.\n");
+      break;
+    case FABRIC_INIT:
+      {
+	int i, numPorts = aSwitch->numInputs;
+
+	if( debug_fabric )
+	  printf("     Fabric: INIT loadBalanced\n");
+	if( aSwitch->fabric.LB_intermediate )
+	  break;
+
+	if( aSwitch->numInputs != aSwitch->numOutputs )
+	  {
+	    fprintf(stderr, "loadBalanced: needs as many inputs as outputs\n");
+	    exit(1);
+	  }
+	aSwitch->fabric.LB_intermediate = (struct List **)
+	  malloc(numPorts * numPorts * sizeof(struct List *));
+	for(i=0; i<numPorts*numPorts; i++)
+	  aSwitch->fabric.LB_intermediate[i] = createLiteList("Intermediate");
+
+	fabricState = (struct LoadBalancedState *)
+	  malloc(sizeof(struct LoadBalancedState));
+	fabricState->slot = 0;
+	fabricState->inputPointer = (int *) calloc(numPorts, sizeof(int));
+	fabricState->lastID = (unsigned long *) 
+	  calloc(numPorts * numPorts, sizeof(unsigned long));
+	fabricState->numCells = 0;
+	aSwitch->fabric.fabricState = fabricState;
+	break;
+      }
+    case FABRIC_EXEC:
+      {
+	int port, numIn=0, numOut=0;
+
+	if( debug_fabric )
+	  printf("     Fabric: EXEC loadBalanced\n");
+
+	fabricState = aSwitch->fabric.fabricState;
+	fabricStats = aSwitch->fabric.fabricStats;
+
+	for(port=0; port<aSwitch->numInputs; port++)
+	  numIn += firstStage(aSwitch, fabricState, port);
+	for(port=0; port<aSwitch->numInputs; port++)
+	  numOut += secondStage(aSwitch, fabricState, fabricStats, port);
+	fabricState->numCells += numIn - numOut;
+	fabricState->slot++;
+
+	updateStat(&fabricStats->intermediateCells, 
+		   (long) fabricState->numCells, now);
+	break;
+      }
+    case FABRIC_STATS_PRINT:
+      {
+	fabricStats = aSwitch->fabric.fabricStats;
+
+	printf("\n");
+	printf("  Load balanced statistics\n");
+	printf("  ------------------------\n");
+	printf("                       Avg       SD     Number\n");
+	printf("                     -------------------------\n");
+	printStat(stdout, "Intermediate Cells: ", 
+		  &fabricStats->intermediateCells);
+	printStat(stdout, "Out of Order:       ", &fabricStats->outOfOrder);
+	break;
+      }
+    case FABRIC_STATS_INIT:
+      {
+	if( aSwitch->scheduler.schedulingAlgorithm != 
+	    (void (*)()) nullSchedulingAlgorithm )
+	  {
+	    fprintf(stderr, "loadBalanced: needs no scheduling, use the \"null\" algorithm.\n");
+	    exit(1);
+	  }
+	fabricStats = aSwitch->fabric.fabricStats;
+	if( !fabricStats )
+	  {
+	    fabricStats = (struct LoadBalancedStats *)
+	      malloc(sizeof(struct LoadBalancedStats));
+	    aSwitch->fabric.fabricStats = (void *) fabricStats;
+	  }
+	initStat(&fabricStats->intermediateCells, STAT_TYPE_AVERAGE, now);
+	initStat(&fabricStats->outOfOrder, STAT_TYPE_AVERAGE, now);
+	enableStat(&fabricStats->intermediateCells);
+	enableStat(&fabricStats->outOfOrder);
+	break;
+      }
+    default:
+      fprintf(stderr, "\nCommand not implemented in loadBalanced.c\n");
+      exit(2);
+    }
+  if( debug_fabric )
+    printf("     Fabric: Completed\n");
+
+  return (0);
+}
+
+/* Input sends one cell to its intermediate port for this slot. */
+static int
+firstStage(Switch *aSwitch, struct LoadBalancedState *fabricState, int input)
+{
+  InputBuffer *inputBuffer = aSwitch->inputBuffer[input];
+  int numPorts = aSwitch->numInputs;
+  int numFIFOs = aSwitch->numOutputs * aSwitch->numPriorities;
+  int port = (int) ((input + fabricState->slot) % numPorts);
+  int fifo, output, priority;
+  Cell *aCell = NULL;
+
+  for(priority=0; priority<aSwitch->numPriorities; priority++)
+    if( inputBuffer->mcastFifo[priority]->number )
+      {
+	aCell = (Cell *) inputBuffer->mcastFifo[priority]->head->Object;
+	for(output=0; !bitmapIsBitSet(output, &aCell->outputs); output++)
+	  ;
+	break;
+      }
+  if( aCell == NULL )
+    {
+      fifo = bitsetNextSetCyclic(inputBuffer->fifosPending, numFIFOs,
+				 fabricState->inputPointer[input]);
+      if( fifo < 0 )
+	return(0);
+      fabricState->inputPointer[input] = (fifo + 1) % numFIFOs;
+      aCell = (Cell *) inputBuffer->fifo[fifo]->head->Object;
+      output = fifo / aSwitch->numPriorities;
+    }
+
+  aCell = (aSwitch->inputAction)(INPUTACTION_TRANSMIT, aSwitch, input, 
+				 aCell, output);
+  aCell = unshareCell(aCell, output);
+  addObject(aSwitch->fabric.LB_intermediate[port*numPorts + output], aCell);
+  latencyStats(LATENCY_STATS_ARRIVE_FABRIC, NULL, aCell);
+  if( debug_fabric )
+    printf("Cell from input %d to intermediate port %d at time %lu\n",
+	   input, port, now);
+  return(1);
+}
+
+/* Intermediate port sends one cell to its output for this slot. */
+static int
+secondStage(Switch *aSwitch, struct LoadBalancedState *fabricState, 
+	    struct LoadBalancedStats *fabricStats, int port)
+{
+  int numPorts = aSwitch->numInputs;
+  int output = (int) ((port + fabricState->slot) % numPorts);
+  struct List *fifo = aSwitch->fabric.LB_intermediate[port*numPorts + output];
+  unsigned long *lastID;
+  Cell *aCell;
+
+  if( fifo->number == 0 )
+    return(0);
+  aCell = (Cell *) removeObject(fifo);
+  enqueueOutputCell(aSwitch, output, aCell->priority, aCell);
+  latencyStats(LATENCY_STATS_ARRIVE_OUTPUT, NULL, aCell);
+
+  lastID = &fabricState->lastID[aCell->commonStats.inputPort*numPorts + output];
+  if( aCell->commonStats.ID < *lastID )
+    updateStat(&fabricStats->outOfOrder, 1L, now);
+  else
+    {
+      updateStat(&fabricStats->outOfOrder, 0L, now);
+      *lastID = aCell->commonStats.ID;
+    }
+  if( debug_fabric )
+    printf("Cell from intermediate port %d to output %d at time %lu\n",
+	   port, output, now);
+  return(1);
+}
@@ -67,10 +67,11 @@ char **argv;
       }
     case FABRIC_EXEC:
       {
-	struct List  *toFifo;
         InputBuffer *inputBuffer;
 	struct Element *anElement;
 	int input, output, out, priority;
+	int wordIndex, numWords;
+	BitsetWord word;
 
 	if( debug_fabric )
 	  printf("     Fabric: EXEC outputQueued \n");
@@ -90,9 +91,7 @@ char **argv;
                                 if( bitmapIsBitSet(output, &aCell->outputs))
                                 {
 		                        outCell = (aSwitch->inputAction)(INPUTACTION_TRANSMIT, aSwitch, input, (Cell *)aCell, output);
-                                        toFifo = aSwitch->outputBuffer[output]->fifo[priority];
-                                        anElement = createElement(outCell);
-                                        addElement(toFifo, anElement);
+                                        enqueueOutputCell(aSwitch, output, priority, outCell);
                                         if( debug_fabric )
                                                 printf("     Fabric: Update stats\n");
                                         /* Update latency stats for this cell */
@@ -107,30 +106,31 @@ char **argv;
                         }
                     }
                 }
-                /* Transfer all UCAST cells to outputs */
-	        for(output=0; output<aSwitch->numOutputs; output++)
-                    for(priority=0;priority<aSwitch->numPriorities;priority++)
-	            {
-                            out = aSwitch->numPriorities*output + priority;
-                            while(inputBuffer->fifo[out]->number)
+                /* Move each unicast fifo with cells to its output whole. */
+                numWords = BITSET_NUM_WORDS(aSwitch->numOutputs * aSwitch->numPriorities);
+                for(wordIndex=0; wordIndex<numWords; wordIndex++)
+                    for(word=inputBuffer->fifosPending[wordIndex]; word; word &= word-1)
+                    {
+                            out = wordIndex*BITSET_WORD_BITS + BITSET_WORD_FFS(word);
+                            output = out / aSwitch->numPriorities;
+                            priority = out % aSwitch->numPriorities;
+                            aCell = (Cell *) inputBuffer->fifo[out]->head->Object;
+                            (aSwitch->inputAction)(INPUTACTION_TRANSMIT_FIFO, aSwitch, input, aCell, output);
+                            anElement = spliceOutputCells(aSwitch, output, priority, inputBuffer->fifo[out]);
+                            if( debug_fabric )
+                                    printf("     Fabric: Update stats\n");
+                            /* Update latency stats for the cells moved */
+                            for( ; anElement; anElement=anElement->next)
                             {
-	                        anElement = inputBuffer->fifo[out]->head;
-                                aCell = (Cell *) anElement->Object;
-		                aCell = (aSwitch->inputAction)(INPUTACTION_TRANSMIT, aSwitch, input, (Cell *)aCell, output);
-                                toFifo = aSwitch->outputBuffer[output]->fifo[priority];
-                                anElement = createElement(aCell);
-                                addElement(toFifo, anElement);
-                                if( debug_fabric )
-                                   printf("     Fabric: Update stats\n");
-                                /* Update latency stats for this cell */
-                                latencyStats(LATENCY_STATS_ARRIVE_FABRIC, NULL, aCell);
-                                latencyStats(LATENCY_STATS_ARRIVE_OUTPUT, NULL, aCell);
-                                if(debug_fabric)
-                                {
-                                        printf("Cell from input %d to output %d priority %d at time %lu\n", input, output, priority, now);
-                                        printCell(stdout, aCell);
-                                }
-                             }
+                                    aCell = (Cell *) anElement->Object;
+                                    latencyStats(LATENCY_STATS_ARRIVE_FABRIC, NULL, aCell);
+                                    latencyStats(LATENCY_STATS_ARRIVE_OUTPUT, NULL, aCell);
+                                    if(debug_fabric)
+                                    {
+                                            printf("Cell from input %d to output %d priority %d at time %lu\n", input, output, priority, now);
+                                            printCell(stdout, aCell);
+                                    }
+                            }
                     }
 
         }
@@ -32,6 +32,7 @@
 
 #include "sim.h"
 #include "inputAction.h"
+#include "inputQueue.h"
 
 #define DEFAULT_MAX_CELLS NONE
 
@@ -39,11 +40,64 @@ struct inputActionState {
 	int maxCellsPerInputBuffer;
 	int maxCellsPerFIFO;
 	int insertOutputQueueingTimes;
+	InputQueueState queue;	/* Occupancy counters */
 };
 
-extern void switchStats();
-
 /* IFF input queue is not blocked, accept cell. */
+static void
+receiveCell(Switch *aSwitch, struct inputActionState *actionState,
+	    int input, Cell *aCell)
+{
+  int out, pri, priority;
+
+  out = aCell->vci;
+  priority = aCell->priority;
+  if(priority > aSwitch->numPriorities)
+    {
+      fprintf(stderr, "defaultInputAction.c:\n");
+      fprintf(stderr, "Cells has priorities %d not supported by switch %d.\n", priority, aSwitch->numPriorities);
+      exit(1);
+    }
+
+  pri = out * aSwitch->numPriorities + priority;
+	
+  if(actionState->insertOutputQueueingTimes == YES)
+    aCell->commonStats.oqDepartTime = 
+      outputQueuedDepartTime(aSwitch, &actionState->queue, aCell);
+    
+  if( actionState->maxCellsPerInputBuffer != NONE )
+    {
+      /**************************************/
+      /* Determine whether FIFO is blocked. */
+      /**************************************/	
+      if( ((aCell->multicast == UCAST ) && 
+	   (aSwitch->inputBuffer[input]->fifo[pri]->number > 
+	    actionState->maxCellsPerFIFO)) ||
+	  ((aCell->multicast == MCAST ) &&    
+	   (aSwitch->inputBuffer[input]->mcastFifo[priority]->number > 
+	    actionState->maxCellsPerFIFO))) 
+	{
+	  dropInputCell(aSwitch, input, aCell);
+	  return;
+	}
+	
+      /**********************************************/
+      /* Determine whether input buffer is blocked. */
+      /**********************************************/
+      if(actionState->queue.inputCells[input] > 
+	 actionState->maxCellsPerInputBuffer)
+	{
+	  dropInputCell(aSwitch, input, aCell);
+	  return;
+	}
+    }
+    
+  /*****************************************/
+  /* Input buffer has room: cell accepted. */
+  /*****************************************/
+  enqueueInputCell(aSwitch, &actionState->queue, input, aCell);
+}
+
 
 Cell *
 defaultInputAction(cmd, aSwitch, input, aCell, output, mcastflag, argc, argv)
@@ -57,9 +111,7 @@ int argc;
 char **argv;
 {
 	struct inputActionState *actionState;
-	struct Element *anElement;
-	int out, pri, priority;
-	int numFIFOs;
+
 	switch( cmd )
 	{
 	case INPUTACTION_USAGE:
@@ -135,6 +187,8 @@ char **argv;
 	    else
 	      printf("    Max cells per input FIFO: %d\n", 
 		     actionState->maxCellsPerFIFO);
+
+	    initInputQueueState(aSwitch, &actionState->queue);
 			
 	    /*******************************************/
 	    /* Attach switch dependent state to switch */
@@ -143,186 +197,45 @@ char **argv;
 	    break;
 	  }
 	case INPUTACTION_RECEIVE:
+	  actionState =
+	    (struct inputActionState *) aSwitch->inputActionState;
+	  receiveCell(aSwitch, actionState, input, aCell);
+	  break;
+
+	case INPUTACTION_RECEIVE_BATCH:
 	  {
-	    int inputBufferOccupancy=0;
-	    long numAhead=0;
-            int anInput;
+	    ArrivalBatch *batch = &aSwitch->arrivals;
+	    int i;
+
 	    actionState =
 	      (struct inputActionState *) aSwitch->inputActionState;
-	    
-	    
-	    out = aCell->vci;
-	    priority = aCell->priority;
-	    if(priority > aSwitch->numPriorities)
-	      {
-		fprintf(stderr, "defaultInputAction.c:\n");
-		fprintf(stderr, "Cells has priorities %d not supported by switch %d.\n", priority, aSwitch->numPriorities);
-		exit(1);
-	      }
-
-	    pri = out * aSwitch->numPriorities + priority;
-		
-	    if(actionState->insertOutputQueueingTimes == YES)
-	      {
-		/* Determine the numahead of cell for this output */
-		numAhead += aSwitch->outputBuffer[out]->fifo[priority]->number;
-		for(anInput=0; anInput<aSwitch->numInputs; anInput++)
-		  numAhead += aSwitch->inputBuffer[anInput]->fifo[pri]->number;
-		aCell->commonStats.oqDepartTime = now + numAhead;
-	      }
-	    
-	    if( actionState->maxCellsPerInputBuffer != NONE )
-	      {
-		/**************************************/
-		/* Determine whether FIFO is blocked. */
-		/**************************************/	
-		if( ((aCell->multicast == UCAST ) && 
-		     (aSwitch->inputBuffer[input]->fifo[pri]->number > 
-		      actionState->maxCellsPerFIFO)) ||
-		    ((aCell->multicast == MCAST ) &&    
-		     (aSwitch->inputBuffer[input]->mcastFifo[priority]->number > 
-		      actionState->maxCellsPerFIFO))) 
-		  {
-		    /******************************/
-		    /* No room for cell. Drop it. */
-		    /******************************/
-		    aSwitch->inputBuffer[input]->numOverflows++;
-		    destroyCell(aCell);
-		    return (Cell*)0;
-		  }
-		
-		/**********************************************/
-		/* Determine whether input buffer is blocked. */
-		/**********************************************/
-		numFIFOs = aSwitch->numOutputs * aSwitch->numPriorities;
-		for(pri=0; pri< numFIFOs; pri++)
-		  {
-		    inputBufferOccupancy += 
-		      aSwitch->inputBuffer[input]->fifo[pri]->number;
-		  }
-		for(pri=0; pri< aSwitch->numPriorities; pri++)
-		  inputBufferOccupancy += aSwitch->inputBuffer[input]->mcastFifo[pri]->number;
-		if(inputBufferOccupancy > actionState->maxCellsPerInputBuffer)
-		  {
-		    /******************************/
-		    /* No room for cell. Drop it. */
-		    /******************************/
-		    aSwitch->inputBuffer[input]->numOverflows++;
-		    destroyCell(aCell);
-		    return (Cell*)0;
-		  }
-	      }
-	    
-	    
-	    /*****************************************/
-	    /* Input buffer has room: cell accepted. */
-	    /*****************************************/
-	    anElement=createElement(aCell);
-	    
-	    /* VCI not implemented yet. VCI = output port. */
-	    pri = aCell->vci * aSwitch->numPriorities + aCell->priority;
-	    	    
-	    /* Mark which input port cell arrived on */
-	    aCell->commonStats.inputPort = input;
-	    
-	    /* Add cell to input fifo. */
-	    if(aCell->multicast == UCAST ) 
-	      addElement(aSwitch->inputBuffer[input]->fifo[pri], anElement);
-	    if(aCell->multicast == MCAST ) 
-	      addElement(aSwitch->inputBuffer[input]->mcastFifo[aCell->priority], anElement);
-	    
-	    /* Update latency statistics for cell arrival at switch. */
-	    latencyStats(LATENCY_STATS_ARRIVAL_TIME, NULL, aCell); 
-	    switchStats(SWITCH_STATS_NEW_ARRIVAL, aSwitch, input);
-	    
+	    for(i=0; i<batch->numCells; i++)
+	      receiveCell(aSwitch, actionState, batch->input[i], batch->cell[i]);
 	    break;
 	  }
 	  
 	case INPUTACTION_TRANSMIT:
 	  {
-	    struct List *fromFifo;
-	    
-	    /* Remove next cell for given output and return pointer to cell */
-	    priority = aCell->priority;
-	    if( aCell->multicast == UCAST )
-	      {
-		pri = priority + aSwitch->numPriorities * output;
-		fromFifo = aSwitch->inputBuffer[input]->fifo[pri];
-		anElement = removeElement(fromFifo);
-		aCell = (Cell *) anElement->Object;
-		destroyElement(anElement);
-	      }
-	    else 
-	      {
-		
-		fromFifo = aSwitch->inputBuffer[input]->mcastFifo[priority];
-		/* Reset bit in bitmap */
-		bitmapResetBit(output, &aCell->outputs);
-		if( bitmapAnyBitSet(&aCell->outputs))
-		  {
-		    anElement = fromFifo->head;
-		    aCell = (Cell *) anElement->Object;
-		    aCell = copyCell(aCell);
-		  }
-		else
-		  {
-		    anElement = removeElement(fromFifo);
-		    aCell = (Cell *) anElement->Object;
-		    destroyElement(anElement);
-		  }
-		
-	      }
-	    return(aCell);
+	    actionState =
+	      (struct inputActionState *) aSwitch->inputActionState;
+	    return( transmitInputCell(aSwitch, &actionState->queue, input,
+				      aCell, output) );
 	    
 	    break;
 	  }
+	case INPUTACTION_TRANSMIT_FIFO:
+	  actionState =
+	    (struct inputActionState *) aSwitch->inputActionState;
+	  transmitInputFifo(aSwitch, &actionState->queue, input, aCell, output);
+	  break;
         case INPUTACTION_STATS_PRINT:
         {
-	    int numArrivals=0;
-	    int allOutputsEnabled=1;
-            struct List *fifo;
-
 	    actionState =
 	      (struct inputActionState *) aSwitch->inputActionState;
                
             if( (actionState->maxCellsPerFIFO != NONE) || 
                 (actionState->maxCellsPerInputBuffer != NONE)  )
-            {
-	        printf("\n");
-	        printf("  OVERFLOWS AT EACH INPUT BUFFER:\n");
-	        printf("  -------------------------------\n");
-	        printf("  I/P    Num  Arrivals\n");
-	        printf("  ---------------------\n");
-	        for(input=0; input<aSwitch->numInputs; input++)
-	                {
-	                /* Number of arrivals to an input queue is the sum
-	                across all output fifos for that input. */
-	                /* The count of cells by each "list" excludes overflows. */
-	                /* The number of arrivals to a queue =      */
-	                /*	numOverflows + arrivalStat->number      */
-         
-	                numFIFOs = aSwitch->numOutputs * aSwitch->numPriorities;
-	                for(output=0; output<numFIFOs; output++ )
-	                {
-		                fifo = aSwitch->inputBuffer[input]->fifo[output];
-		                if( !LIST_STAT_IS_ENABLED(fifo, LIST_STATS_ARRIVALS) )
-		                allOutputsEnabled=0;
-		                numArrivals += 
-		                returnNumberStat(&fifo->listStats[LIST_STATS_ARRIVALS]);
-	                }
-	                numArrivals += aSwitch->inputBuffer[input]->numOverflows;
-														                	
-	                if( numArrivals  &&  allOutputsEnabled )
-	                        printf("  %3d  %8d  (%g%%)\n", input, 
-		                aSwitch->inputBuffer[input]->numOverflows,
-		                100.0 * 
-		                (double)aSwitch->inputBuffer[input]->numOverflows /
-		                (double)numArrivals);
-	                else 
-                                printf("  %3d  %8d \n", input, 
-		                aSwitch->inputBuffer[input]->numOverflows);
-	                }
-             }
+	      printInputOverflows(aSwitch, NULL);
         }
 	default:
 	  break;
@@ -40,6 +40,8 @@ typedef enum {
 	INPUTACTION_PER_CELL_UPDATE,
 	INPUTACTION_STATS_PRINT,
 	INPUTACTION_PERCELL_CHECK,
+	INPUTACTION_RECEIVE_BATCH,
+	INPUTACTION_TRANSMIT_FIFO,
 } InputActionCmd;
 
 extern FunctionTable inputActionTable[];
@@ -39,9 +39,11 @@
 /* extern void     defaultInputAction(); */
 
 extern Cell *  defaultInputAction(); 
+extern Cell *  sharedBufferInputAction(); 
 
 FunctionTable inputActionTable[] = {
     {"defaultInputAction", "Default action. No VCI translation.", (void *)defaultInputAction},
+    {"sharedBufferInputAction", "Input buffer shared by its queues.", (void *)sharedBufferInputAction},
 	{NULL,NULL,NULL}
 };
 
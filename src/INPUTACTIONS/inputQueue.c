@@ -0,0 +1,247 @@
+/* ****************************************************************
+ * Copyright Stanford University 1998,99 - All Rights Reserved
+ ****************************************************************** 
+
+ * Permission to use, copy, modify, and distribute this software 
+ * and its documentation for any purpose is hereby granted without 
+ * fee, provided that the above copyright notice appears in all copies
+ * and that both the copyright notice, this permission notice, and 
+ * the following disclaimer appear in supporting documentation, and 
+ * that the name of Stanford University, not be used in advertising or 
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.
+ * 
+ * STANFORD UNIVERSITY, DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND 
+ * FITNESS. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE FOR ANY 
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER 
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION 
+ * OF CONTRACT, NEGLIGENCE OR OTHER ACTION, ARISING OUT OF OR IN 
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * The Sim Web Site : http://klamath.stanford.edu/tools/SIM
+ * The SIM Mailing List: sim-simulator@lists.stanford.edu
+
+ * Send mail to the above email address with "subscribe sim-simulator" in
+ * the body of the message.
+ *
+ */
+
+#include "sim.h"
+#include "inputAction.h"
+#include "inputQueue.h"
+
+extern void switchStats();
+
+/* Tell the scheduler, if it keeps up with the fifos, that a unicast */
+/* fifo has gained or lost cells.                                     */
+static void
+fifoChanged(Switch *aSwitch, int input, int pri)
+{
+  if( aSwitch->scheduler.fifoChanged )
+    (aSwitch->scheduler.fifoChanged)(aSwitch, input, pri);
+}
+
+void
+initInputQueueState(Switch *aSwitch, InputQueueState *queue)
+{
+  queue->inputCells = (int *) calloc(aSwitch->numInputs, sizeof(int));
+  queue->voqCells = (int *) 
+    calloc(aSwitch->numOutputs * aSwitch->numPriorities, sizeof(int));
+  queue->lastCopy = (CellCopy *)
+    calloc(aSwitch->numInputs * aSwitch->numPriorities, sizeof(CellCopy));
+}
+
+/* Time aCell would leave an output queued switch: after the cells */
+/* already in its output queue and those for it at every input.    */
+long
+outputQueuedDepartTime(Switch *aSwitch, InputQueueState *queue, Cell *aCell)
+{
+  int out = aCell->vci;
+  int priority = aCell->priority;
+
+  return( now + aSwitch->outputBuffer[out]->fifo[priority]->number
+	  + queue->voqCells[out * aSwitch->numPriorities + priority] );
+}
+
+/* Add an accepted cell to its input fifo. */
+void
+enqueueInputCell(Switch *aSwitch, InputQueueState *queue, int input,
+		 Cell *aCell)
+{
+  struct Element *anElement;
+  int pri;
+
+  anElement=createElement(aCell);
+    
+  /* VCI not implemented yet. VCI = output port. */
+  pri = aCell->vci * aSwitch->numPriorities + aCell->priority;
+	    
+  /* Mark which input port cell arrived on */
+  aCell->commonStats.inputPort = input;
+    
+  /* Add cell to input fifo. */
+  if(aCell->multicast == UCAST ) 
+    {
+      addElement(aSwitch->inputBuffer[input]->fifo[pri], anElement);
+      BITSET_SET(aSwitch->inputBuffer[input]->fifosPending, pri);
+      queue->voqCells[pri]++;
+      fifoChanged(aSwitch, input, pri);
+    }
+  if(aCell->multicast == MCAST ) 
+    addElement(aSwitch->inputBuffer[input]->mcastFifo[aCell->priority], anElement);
+  queue->inputCells[input]++;
+    
+  /* Update latency statistics for cell arrival at switch. */
+  latencyStats(LATENCY_STATS_ARRIVAL_TIME, NULL, aCell); 
+  switchStats(SWITCH_STATS_NEW_ARRIVAL, aSwitch, input);
+}
+
+/* Remove next cell for given output and return pointer to cell.    */
+/* A multicast cell leaves its fifo once sent to its last output;   */
+/* until then each output is sent a copy.                           */
+Cell *
+transmitInputCell(Switch *aSwitch, InputQueueState *queue, int input,
+		  Cell *aCell, int output)
+{
+  struct List *fromFifo;
+  struct Element *anElement;
+  CellCopy *last;
+  int pri, priority;
+    
+  priority = aCell->priority;
+  if( aCell->multicast == UCAST )
+    {
+      pri = priority + aSwitch->numPriorities * output;
+      fromFifo = aSwitch->inputBuffer[input]->fifo[pri];
+      anElement = removeElement(fromFifo);
+      aCell = (Cell *) anElement->Object;
+      destroyElement(anElement);
+      if( fromFifo->number == 0 )
+	BITSET_RESET(aSwitch->inputBuffer[input]->fifosPending, pri);
+      queue->voqCells[pri]--;
+      queue->inputCells[input]--;
+      fifoChanged(aSwitch, input, pri);
+    }
+  else 
+    {
+      last = &queue->lastCopy[input * aSwitch->numPriorities + priority];
+      fromFifo = aSwitch->inputBuffer[input]->mcastFifo[priority];
+      /* Reset bit in bitmap */
+      bitmapResetBit(output, &aCell->outputs);
+      if( bitmapAnyBitSet(&aCell->outputs))
+	{
+	  anElement = fromFifo->head;
+	  aCell = (Cell *) anElement->Object;
+	  aCell = shareCell(aCell, output, last);
+	}
+      else
+	{
+	  anElement = removeElement(fromFifo);
+	  aCell = (Cell *) anElement->Object;
+	  destroyElement(anElement);
+	  if( last->original == aCell )
+	    last->original = NULL;
+	  queue->inputCells[input]--;
+	}
+    }
+  return(aCell);
+}
+
+/* Unicast cell aCell, at the head of its fifo, and all the cells */
+/* behind it leave for output.  They are left in the fifo for the  */
+/* fabric to move.                                                  */
+void
+transmitInputFifo(Switch *aSwitch, InputQueueState *queue, int input,
+		  Cell *aCell, int output)
+{
+  int pri, numCells;
+
+  pri = aCell->priority + aSwitch->numPriorities * output;
+  numCells = aSwitch->inputBuffer[input]->fifo[pri]->number;
+  BITSET_RESET(aSwitch->inputBuffer[input]->fifosPending, pri);
+  queue->voqCells[pri] -= numCells;
+  queue->inputCells[input] -= numCells;
+  fifoChanged(aSwitch, input, pri);
+}
+
+/* No room for cell. Drop it. */
+void
+dropInputCell(Switch *aSwitch, int input, Cell *aCell)
+{
+  aSwitch->inputBuffer[input]->numOverflows++;
+  destroyCell(aCell);
+}
+
+/* Drop the cell at the tail of an input fifo to make room for */
+/* another.  The fifo must hold more than its head of line cell. */
+void
+pushOutInputCell(Switch *aSwitch, InputQueueState *queue, int input,
+		 struct List *fifo)
+{
+  struct Element *anElement;
+  Cell *aCell;
+
+  anElement = removeElementFromTail(fifo);
+  aCell = (Cell *) anElement->Object;
+  destroyElement(anElement);
+  if( aCell->multicast == UCAST )
+    {
+      queue->voqCells[aCell->vci * aSwitch->numPriorities + aCell->priority]--;
+      if( fifo->number == 0 )
+	BITSET_RESET(aSwitch->inputBuffer[input]->fifosPending, 
+		     aCell->vci * aSwitch->numPriorities + aCell->priority);
+      fifoChanged(aSwitch, input, 
+		  aCell->vci * aSwitch->numPriorities + aCell->priority);
+    }
+  queue->inputCells[input]--;
+  destroyCell(aCell);
+}
+
+/* Cells dropped at each input; numPushedOut, if not NULL, counts the */
+/* accepted cells later pushed out to make room for others.           */
+void
+printInputOverflows(Switch *aSwitch, int *numPushedOut)
+{
+  int input, fifoNum, numFIFOs, numArrivals, numLost;
+  int allOutputsEnabled=1;
+  struct List *fifo;
+
+  printf("\n");
+  printf("  OVERFLOWS AT EACH INPUT BUFFER:\n");
+  printf("  -------------------------------\n");
+  printf("  I/P    Num  Arrivals\n");
+  printf("  ---------------------\n");
+  numArrivals=0;
+  for(input=0; input<aSwitch->numInputs; input++)
+    {
+      /* Number of arrivals to an input queue is the sum
+	 across all output fifos for that input. */
+      /* The count of cells by each "list" excludes overflows. */
+      /* The number of arrivals to a queue =      */
+      /*	numOverflows + arrivalStat->number      */
+	 
+      numFIFOs = aSwitch->numOutputs * aSwitch->numPriorities;
+      for(fifoNum=0; fifoNum<numFIFOs; fifoNum++ )
+	{
+	  fifo = aSwitch->inputBuffer[input]->fifo[fifoNum];
+	  if( !LIST_STAT_IS_ENABLED(fifo, LIST_STATS_ARRIVALS) )
+	    allOutputsEnabled=0;
+	  numArrivals += 
+	    returnNumberStat(&fifo->listStats[LIST_STATS_ARRIVALS]);
+	}
+      numArrivals += aSwitch->inputBuffer[input]->numOverflows;
+      numLost = aSwitch->inputBuffer[input]->numOverflows;
+      if( numPushedOut )
+	numLost += numPushedOut[input];
+							                	
+      if( numArrivals  &&  allOutputsEnabled )
+	printf("  %3d  %8d  (%g%%)\n", input, numLost,
+	       100.0 * (double)numLost / (double)numArrivals);
+      else 
+	printf("  %3d  %8d \n", input, numLost);
+    }
+}
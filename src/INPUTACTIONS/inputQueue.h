@@ -0,0 +1,64 @@
+/* ****************************************************************
+ * Copyright Stanford University 1998,99 - All Rights Reserved
+ ****************************************************************** 
+
+ * Permission to use, copy, modify, and distribute this software 
+ * and its documentation for any purpose is hereby granted without 
+ * fee, provided that the above copyright notice appears in all copies
+ * and that both the copyright notice, this permission notice, and 
+ * the following disclaimer appear in supporting documentation, and 
+ * that the name of Stanford University, not be used in advertising or 
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.
+ * 
+ * STANFORD UNIVERSITY, DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND 
+ * FITNESS. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE FOR ANY 
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER 
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION 
+ * OF CONTRACT, NEGLIGENCE OR OTHER ACTION, ARISING OUT OF OR IN 
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * The Sim Web Site : http://klamath.stanford.edu/tools/SIM
+ * The SIM Mailing List: sim-simulator@lists.stanford.edu
+
+ * Send mail to the above email address with "subscribe sim-simulator" in
+ * the body of the message.
+ *
+ */
+
+#ifndef _INPUTQUEUE_H_
+#define _INPUTQUEUE_H_
+
+/*
+ * Queueing common to the input actions.  The number of cells in each
+ * input buffer and the number of unicast cells waiting anywhere for
+ * each output and priority are kept up to date as cells are queued
+ * and sent, so that admission and output queued departure times cost
+ * O(1) a cell rather than a pass over the fifos.
+ */
+typedef struct {
+  int *inputCells;	/* [input] cells in its input buffer */
+  int *voqCells;	/* [output*numPriorities+priority] unicast cells */
+			/* for it at all inputs */
+  CellCopy *lastCopy;	/* [input*numPriorities+priority] see shareCell() */
+} InputQueueState;
+
+void initInputQueueState(Switch *aSwitch, InputQueueState *queue);
+long outputQueuedDepartTime(Switch *aSwitch, InputQueueState *queue, 
+			    Cell *aCell);
+void enqueueInputCell(Switch *aSwitch, InputQueueState *queue, int input,
+		      Cell *aCell);
+Cell *transmitInputCell(Switch *aSwitch, InputQueueState *queue, int input,
+			Cell *aCell, int output);
+void transmitInputFifo(Switch *aSwitch, InputQueueState *queue, int input,
+		       Cell *aCell, int output);
+void dropInputCell(Switch *aSwitch, int input, Cell *aCell);
+void pushOutInputCell(Switch *aSwitch, InputQueueState *queue, int input,
+		      struct List *fifo);
+void printInputOverflows(Switch *aSwitch, int *numPushedOut);
+
+#endif /* _INPUTQUEUE_H_ */
@@ -0,0 +1,404 @@
+/* ****************************************************************
+ * Copyright Stanford University 1998,99 - All Rights Reserved
+ ****************************************************************** 
+
+ * Permission to use, copy, modify, and distribute this software 
+ * and its documentation for any purpose is hereby granted without 
+ * fee, provided that the above copyright notice appears in all copies
+ * and that both the copyright notice, this permission notice, and 
+ * the following disclaimer appear in supporting documentation, and 
+ * that the name of Stanford University, not be used in advertising or 
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.
+ * 
+ * STANFORD UNIVERSITY, DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND 
+ * FITNESS. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE FOR ANY 
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER 
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION 
+ * OF CONTRACT, NEGLIGENCE OR OTHER ACTION, ARISING OUT OF OR IN 
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * The Sim Web Site : http://klamath.stanford.edu/tools/SIM
+ * The SIM Mailing List: sim-simulator@lists.stanford.edu
+
+ * Send mail to the above email address with "subscribe sim-simulator" in
+ * the body of the message.
+ *
+ */
+
+#include "sim.h"
+#include "inputAction.h"
+#include "inputQueue.h"
+
+/*
+ * The queues at each input (one per output and priority, and one per
+ * priority for multicast) share a buffer of -b cells.  How it is
+ * shared is set by -p:
+ *   cs  Complete sharing: a cell is accepted while the buffer has room.
+ *   dt  Dynamic thresholds (Choudhury and Hahne): a cell is accepted
+ *       only if its queue is shorter than -a times the free space.
+ *   po  Push-out: when the buffer is full, the cell at the tail of the
+ *       longest queue is dropped to make room, unless the arriving
+ *       cell's queue is as long.  The longest queue is found in O(1)
+ *       from the queues at each input bucketed by length.
+ */
+
+typedef enum {
+  SHARE_COMPLETE,
+  SHARE_DYNAMIC_THRESHOLD,
+  SHARE_PUSH_OUT
+} SharingPolicy;
+
+/* The non-empty queues of an input, in lists by length. */
+typedef struct {
+  int *next, *prev;	/* [queue] neighbours in its length's list */
+  int *head;		/* [length] first queue of that length, or NONE */
+  int longest;		/* Length of the longest queue */
+} QueueLengths;
+
+struct inputActionState {
+  SharingPolicy policy;
+  int bufferSize;		/* Cells shared at each input */
+  double alpha;			/* Dynamic threshold, times free space */
+  int insertOutputQueueingTimes;
+  int numQueues;		/* Unicast fifos, then multicast fifos */
+  QueueLengths *lengths;	/* [input], for push-out */
+  int *numPushedOut;		/* [input] accepted cells pushed out */
+  InputQueueState queue;	/* Occupancy counters */
+};
+
+static char *policyNames[] = {"cs", "dt", "po"};
+
+static void unlinkQueue(QueueLengths *lengths, int q, int length);
+static void linkQueue(QueueLengths *lengths, int q, int length);
+
+static void
+unlinkQueue(QueueLengths *lengths, int q, int length)
+{
+  if( lengths->prev[q] != NONE )
+    lengths->next[lengths->prev[q]] = lengths->next[q];
+  else
+    lengths->head[length] = lengths->next[q];
+  if( lengths->next[q] != NONE )
+    lengths->prev[lengths->next[q]] = lengths->prev[q];
+}
+
+static void
+linkQueue(QueueLengths *lengths, int q, int length)
+{
+  lengths->prev[q] = NONE;
+  lengths->next[q] = lengths->head[length];
+  if( lengths->head[length] != NONE )
+    lengths->prev[lengths->head[length]] = q;
+  lengths->head[length] = q;
+  if( length > lengths->longest )
+    lengths->longest = length;
+}
+
+/* Queue q has grown or shrunk by a cell, to length. */
+static void
+queueGrew(QueueLengths *lengths, int q, int length)
+{
+  if( length > 1 )
+    unlinkQueue(lengths, q, length-1);
+  linkQueue(lengths, q, length);
+}
+
+static void
+queueShrank(QueueLengths *lengths, int q, int length)
+{
+  unlinkQueue(lengths, q, length+1);
+  if( length > 0 )
+    linkQueue(lengths, q, length);
+  while( lengths->longest > 0 && lengths->head[lengths->longest] == NONE )
+    lengths->longest--;
+}
+
+/* Queue q, of length, has been emptied. */
+static void
+queueEmptied(QueueLengths *lengths, int q, int length)
+{
+  unlinkQueue(lengths, q, length);
+  while( lengths->longest > 0 && lengths->head[lengths->longest] == NONE )
+    lengths->longest--;
+}
+
+static struct List *
+queueFifo(Switch *aSwitch, int input, int q)
+{
+  int numFIFOs = aSwitch->numOutputs * aSwitch->numPriorities;
+
+  if( q < numFIFOs )
+    return(aSwitch->inputBuffer[input]->fifo[q]);
+  return(aSwitch->inputBuffer[input]->mcastFifo[q - numFIFOs]);
+}
+
+static int
+cellQueue(Switch *aSwitch, Cell *aCell)
+{
+  if( aCell->multicast == MCAST )
+    return(aSwitch->numOutputs * aSwitch->numPriorities + aCell->priority);
+  return(aCell->vci * aSwitch->numPriorities + aCell->priority);
+}
+
+/* Admit aCell to its queue at input, or drop it, as the policy says. */
+static void
+receiveCell(Switch *aSwitch, struct inputActionState *actionState,
+	    int input, Cell *aCell)
+{
+  QueueLengths *lengths;
+  struct List *fifo;
+  int q, length, occupied;
+
+  if(aCell->priority >= aSwitch->numPriorities)
+    {
+      fprintf(stderr, "sharedBufferInputAction.c:\n");
+      fprintf(stderr, "Cells has priorities %d not supported by switch %d.\n", aCell->priority, aSwitch->numPriorities);
+      exit(1);
+    }
+
+  if(actionState->insertOutputQueueingTimes == YES)
+    aCell->commonStats.oqDepartTime = 
+      outputQueuedDepartTime(aSwitch, &actionState->queue, aCell);
+
+  q = cellQueue(aSwitch, aCell);
+  fifo = queueFifo(aSwitch, input, q);
+  lengths = actionState->lengths ? &actionState->lengths[input] : NULL;
+  if( actionState->bufferSize != NONE )
+    {
+      occupied = actionState->queue.inputCells[input];
+      length = fifo->number;
+      switch( actionState->policy )
+	{
+	case SHARE_COMPLETE:
+	  if( occupied >= actionState->bufferSize )
+	    {
+	      dropInputCell(aSwitch, input, aCell);
+	      return;
+	    }
+	  break;
+	case SHARE_DYNAMIC_THRESHOLD:
+	  if( occupied >= actionState->bufferSize ||
+	      length >= actionState->alpha * 
+	      (actionState->bufferSize - occupied) )
+	    {
+	      dropInputCell(aSwitch, input, aCell);
+	      return;
+	    }
+	  break;
+	case SHARE_PUSH_OUT:
+	  if( occupied < actionState->bufferSize )
+	    break;
+	  if( lengths->longest <= length || lengths->longest < 2 )
+	    {
+	      dropInputCell(aSwitch, input, aCell);
+	      return;
+	    }
+	  q = lengths->head[lengths->longest];
+	  pushOutInputCell(aSwitch, &actionState->queue, input,
+			   queueFifo(aSwitch, input, q));
+	  queueShrank(lengths, q, lengths->longest - 1);
+	  actionState->numPushedOut[input]++;
+	  q = cellQueue(aSwitch, aCell);
+	  break;
+	}
+    }
+
+  /*****************************************/
+  /* Input buffer has room: cell accepted. */
+  /*****************************************/
+  enqueueInputCell(aSwitch, &actionState->queue, input, aCell);
+  if( lengths )
+    queueGrew(lengths, q, fifo->number);
+}
+
+Cell *
+sharedBufferInputAction(cmd, aSwitch, input, aCell, output, mcastflag, argc, argv)
+InputActionCmd cmd;
+Switch *aSwitch;
+int input;
+Cell *aCell;
+int output;
+int mcastflag;
+int argc;
+char **argv;
+{
+	struct inputActionState *actionState;
+	QueueLengths *lengths;
+	struct List *fifo;
+	int q, length;
+	
+	switch( cmd )
+	{
+	case INPUTACTION_USAGE:
+	  fprintf(stderr, "Options for \"sharedBufferInputAction\" input action:\n");
+	  fprintf(stderr, "  -b  Cells shared by the queues at each input. Default: Infinite\n");
+	  fprintf(stderr, "  -p  Sharing policy: cs (complete sharing), dt (dynamic\n");
+	  fprintf(stderr, "      thresholds) or po (push-out longest queue). Default: dt\n");
+	  fprintf(stderr, "  -a  Dynamic threshold, as a multiple of free space. Default: 1.0\n");
+	  fprintf(stderr, "  -o  Measure output queueing departure times. Default: off\n");
+	  break;
+	case INPUTACTION_INIT:
+	  {
+	    extern int opterr;
+	    extern int optopt;
+	    extern int optind;
+	    extern char *optarg;
+	    int c, i;
+	    
+	    actionState = (struct inputActionState * )
+	      malloc(sizeof(struct inputActionState));
+	    
+	    actionState->policy = SHARE_DYNAMIC_THRESHOLD;
+	    actionState->bufferSize = NONE;
+	    actionState->alpha = 1.0;
+	    actionState->insertOutputQueueingTimes = NO;
+	    opterr=0; optind=1; 
+	    while( (c = getopt(argc, argv, "b:p:a:o")) != EOF)
+	      switch (c)
+		{			
+		case 'b':
+		  actionState->bufferSize = atoi(optarg);
+		  break;
+		case 'p':
+		  for(i=0; i<3 && strcmp(optarg, policyNames[i]); i++)
+		    ;
+		  if( i == 3 )
+		    {
+		      fprintf(stderr, "sharedBufferInputAction: Unknown policy %s\n",
+			      optarg);
+		      sharedBufferInputAction(INPUTACTION_USAGE);
+		      exit(1);
+		    }
+		  actionState->policy = (SharingPolicy) i;
+		  break;
+		case 'a':
+		  actionState->alpha = atof(optarg);
+		  break;
+		case 'o':
+		  actionState->insertOutputQueueingTimes = YES;
+		  break;
+		case '?':
+		  fprintf(stderr, "--------------------------------------------\n");
+		  fprintf(stderr, "sharedBufferInputAction: Unrecognized option -%c\n", optopt);
+		  sharedBufferInputAction(INPUTACTION_USAGE);
+		  fprintf(stderr, "--------------------------------------------\n");
+		  exit(1);
+		  
+		  break;
+		default:
+		  break;
+		}
+
+	    if( actionState->insertOutputQueueingTimes == YES )
+	      printf("Determining output queue departure times.\n");
+	    if( actionState->bufferSize == NONE )
+	      printf("    Shared cells per input buffer: INFINITE\n");
+	    else
+	      {
+		printf("    Shared cells per input buffer: %d\n", 
+		       actionState->bufferSize);
+		printf("    Sharing policy: %s", 
+		       policyNames[actionState->policy]);
+		if( actionState->policy == SHARE_DYNAMIC_THRESHOLD )
+		  printf(" (threshold %g times free space)", actionState->alpha);
+		printf("\n");
+	      }
+
+	    initInputQueueState(aSwitch, &actionState->queue);
+	    actionState->numQueues = 
+	      (aSwitch->numOutputs + 1) * aSwitch->numPriorities;
+	    actionState->numPushedOut = (int *) 
+	      calloc(aSwitch->numInputs, sizeof(int));
+	    actionState->lengths = NULL;
+	    if( actionState->policy == SHARE_PUSH_OUT 
+		&& actionState->bufferSize != NONE )
+	      {
+		actionState->lengths = (QueueLengths *)
+		  malloc(aSwitch->numInputs * sizeof(QueueLengths));
+		for(i=0; i<aSwitch->numInputs; i++)
+		  {
+		    lengths = &actionState->lengths[i];
+		    lengths->next = (int *) 
+		      malloc(actionState->numQueues * sizeof(int));
+		    lengths->prev = (int *) 
+		      malloc(actionState->numQueues * sizeof(int));
+		    lengths->head = (int *)
+		      malloc((actionState->bufferSize + 2) * sizeof(int));
+		    for(c=0; c<actionState->bufferSize+2; c++)
+		      lengths->head[c] = NONE;
+		    lengths->longest = 0;
+		  }
+	      }
+			
+	    /*******************************************/
+	    /* Attach switch dependent state to switch */
+	    /*******************************************/
+	    aSwitch->inputActionState = (void *) actionState;
+	    break;
+	  }
+	case INPUTACTION_RECEIVE:
+	  actionState =
+	    (struct inputActionState *) aSwitch->inputActionState;
+	  receiveCell(aSwitch, actionState, input, aCell);
+	  break;
+
+	case INPUTACTION_RECEIVE_BATCH:
+	  {
+	    ArrivalBatch *batch = &aSwitch->arrivals;
+	    int i;
+
+	    actionState =
+	      (struct inputActionState *) aSwitch->inputActionState;
+	    for(i=0; i<batch->numCells; i++)
+	      receiveCell(aSwitch, actionState, batch->input[i], batch->cell[i]);
+	    break;
+	  }
+	  
+	case INPUTACTION_TRANSMIT:
+	  {
+	    actionState =
+	      (struct inputActionState *) aSwitch->inputActionState;
+	    lengths = actionState->lengths ? &actionState->lengths[input] : NULL;
+	    if( !lengths )
+	      return( transmitInputCell(aSwitch, &actionState->queue, input,
+					aCell, output) );
+	    if( aCell->multicast == MCAST )
+	      q = cellQueue(aSwitch, aCell);
+	    else
+	      q = output * aSwitch->numPriorities + aCell->priority;
+	    fifo = queueFifo(aSwitch, input, q);
+	    length = fifo->number;
+	    aCell = transmitInputCell(aSwitch, &actionState->queue, input,
+				      aCell, output);
+	    if( fifo->number < length )
+	      queueShrank(lengths, q, fifo->number);
+	    return(aCell);
+	  }
+	case INPUTACTION_TRANSMIT_FIFO:
+	  actionState =
+	    (struct inputActionState *) aSwitch->inputActionState;
+	  lengths = actionState->lengths ? &actionState->lengths[input] : NULL;
+	  if( lengths )
+	    {
+	      q = output * aSwitch->numPriorities + aCell->priority;
+	      queueEmptied(lengths, q, queueFifo(aSwitch, input, q)->number);
+	    }
+	  transmitInputFifo(aSwitch, &actionState->queue, input, aCell, output);
+	  break;
+        case INPUTACTION_STATS_PRINT:
+	  actionState =
+	    (struct inputActionState *) aSwitch->inputActionState;
+	  if( actionState->bufferSize != NONE )
+	    printInputOverflows(aSwitch, actionState->numPushedOut);
+	  break;
+	default:
+	  break;
+	}
+	return (Cell*)0;
+
+}
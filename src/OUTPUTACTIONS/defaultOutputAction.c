@@ -32,10 +32,11 @@
 
 #include "sim.h"
 #include "outputAction.h"
+#include "outputDepartures.h"
 
-extern int burstStats( BurstStatsCommand mode, Switch *aSwitch, 
-		       int output,
-		       int input );
+struct OutputActionState {
+  OutputDepartures departures;
+};
 
 /* Take next cell from each output buffer and destroy. */
 int defaultOutputAction(cmd, aSwitch, argc, argv)
@@ -44,10 +45,9 @@ Switch *aSwitch;
 int argc;
 char **argv;
 {
-  Cell *aCell;
-  int output;
-  struct Element *anElement;
-  struct List *fromFifo;
+  struct OutputActionState *outputActionState;
+  int output, wordIndex, numWords;
+  BitsetWord word;
 
   switch(cmd)
     {
@@ -58,45 +58,25 @@ char **argv;
         	fprintf(stderr,"defaultOuputAction, number of priorities: %d is not supported by this outputAction.  Please use just one priority.\n",aSwitch->numPriorities);
 			exit(1);
         }
+      outputActionState = (struct OutputActionState *)
+	malloc(sizeof(struct OutputActionState));
+      initOutputDepartures(aSwitch, &outputActionState->departures);
+      aSwitch->outputActionState = (void *) outputActionState;
       break;
     case OUTPUTACTION_EXEC:
-      for(output=0; output<aSwitch->numOutputs; output++)
-	{
-	  fromFifo = aSwitch->outputBuffer[output]->fifo[DEFAULT_PRIORITY];    /* TL */
+      outputActionState = 
+	(struct OutputActionState *) aSwitch->outputActionState;
 
-	  /* If the output queue has a cell, remove it. */
-	  if( fromFifo->number )
-	    {
-	      anElement = removeElement(fromFifo);
-	      aCell = anElement->Object;
-
-			
-	      /* This switch has finished with this cell.    */
-	      /* If any, remove the switch dependent header. */
-	      if( aCell->switchDependentHeader )
-		{
-		  free(aCell->switchDependentHeader);
-		  aCell->switchDependentHeader = NULL;
-		}
-
-	      /* Update burstiness stats for this output. */
-	      burstStats(BURST_STATS_UPDATE, aSwitch, 
-			 output, aCell->commonStats.inputPort);
-
-	      /* Update latency statistics for cell and switch. */
-	      latencyStats(LATENCY_STATS_SWITCH_UPDATE, aSwitch, aCell);
-	      latencyStats(LATENCY_STATS_CELL_UPDATE, NULL, aCell);
-
-	      destroyElement(anElement);
-	      destroyCell(aCell);
-	    }
-	  else
-	    {
-	      /* Update burstiness stats for this output. */
-	      burstStats(BURST_STATS_UPDATE, aSwitch, 
-			 output, NONE);
-	    }
-	}
+      /* Each output with a cell sends one. */
+      numWords = BITSET_NUM_WORDS(aSwitch->numOutputs);
+      for(wordIndex=0; wordIndex<numWords; wordIndex++)
+	for(word=aSwitch->outputsPending[wordIndex]; word; word &= word-1)
+	  {
+	    output = wordIndex*BITSET_WORD_BITS + BITSET_WORD_FFS(word);
+	    departOutputCell(aSwitch, &outputActionState->departures,
+			     output, DEFAULT_PRIORITY);
+	  }
+      finishOutputDepartures(aSwitch, &outputActionState->departures);
       break;
     default:
       fprintf(stderr, "Illegal OutputAction cmd: %d\n", cmd);
@@ -105,4 +85,3 @@ char **argv;
     }
   return (0);
 }
-
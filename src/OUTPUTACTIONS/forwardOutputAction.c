@@ -0,0 +1,101 @@
+/* ****************************************************************
+ * Copyright Stanford University 1998,99 - All Rights Reserved
+ ****************************************************************** 
+
+ * Permission to use, copy, modify, and distribute this software 
+ * and its documentation for any purpose is hereby granted without 
+ * fee, provided that the above copyright notice appears in all copies
+ * and that both the copyright notice, this permission notice, and 
+ * the following disclaimer appear in supporting documentation, and 
+ * that the name of Stanford University, not be used in advertising or 
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.
+ * 
+ * STANFORD UNIVERSITY, DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND 
+ * FITNESS. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE FOR ANY 
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER 
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION 
+ * OF CONTRACT, NEGLIGENCE OR OTHER ACTION, ARISING OUT OF OR IN 
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * The Sim Web Site : http://klamath.stanford.edu/tools/SIM
+ * The SIM Mailing List: sim-simulator@lists.stanford.edu
+
+ * Send mail to the above email address with "subscribe sim-simulator" in
+ * the body of the message.
+ *
+ */
+
+#include "sim.h"
+#include "outputAction.h"
+#include "outputDepartures.h"
+
+
+extern int burstStats( BurstStatsCommand mode, Switch *aSwitch, 
+		       int output,
+		       int input );
+
+struct OutputActionState {
+  OutputDepartures departures;
+};
+
+/* Take next cell from each output buffer. A cell at an output with */
+/* a link (see the Topology section of the configuration file) goes */
+/* on to the next switch; others leave the network and are destroyed. */
+/* Each output sends from its highest priority with a cell. */
+int forwardOutputAction(cmd, aSwitch, argc, argv)
+  OutputActionCmd cmd;
+Switch *aSwitch;
+int argc;
+char **argv;
+{
+  struct OutputActionState *outputActionState;
+  int output, wordIndex, numWords;
+  BitsetWord word;
+  int priority;
+
+  switch(cmd)
+    {
+    case OUTPUTACTION_USAGE:
+      break;
+    case OUTPUTACTION_INIT:
+      outputActionState = (struct OutputActionState *)
+	malloc(sizeof(struct OutputActionState));
+      initOutputDepartures(aSwitch, &outputActionState->departures);
+      aSwitch->outputActionState = (void *) outputActionState;
+      break;
+    case OUTPUTACTION_EXEC:
+      outputActionState = 
+	(struct OutputActionState *) aSwitch->outputActionState;
+
+      numWords = BITSET_NUM_WORDS(aSwitch->numOutputs);
+      for(wordIndex=0; wordIndex<numWords; wordIndex++)
+	for(word=aSwitch->outputsPending[wordIndex]; word; word &= word-1)
+	  {
+	    output = wordIndex*BITSET_WORD_BITS + BITSET_WORD_FFS(word);
+	    priority = outputHighestPriority(aSwitch, output);
+
+	    /* An empty higher priority fifo ends the output's burst. */
+	    if( priority > 0 )
+	      burstStats(BURST_STATS_UPDATE, aSwitch, output, NONE);
+
+	    if( aSwitch->outputLink && aSwitch->outputLink[output] )
+	      forwardOutputCell(aSwitch, &outputActionState->departures,
+				output, priority);
+	    else
+	      departOutputCell(aSwitch, &outputActionState->departures,
+			       output, priority);
+	  }
+      finishOutputDepartures(aSwitch, &outputActionState->departures);
+      break;
+    default:
+      fprintf(stderr, "Illegal OutputAction cmd: %d\n", cmd);
+      exit(1);
+      break;
+    }
+  return (0);
+}
@@ -38,11 +38,13 @@
 extern int defaultOutputAction();
 extern int strictPriorityOutputAction();
 extern int subportOutputAction();
+extern int forwardOutputAction();
     
 FunctionTable outputActionTable[] = {
     {"defaultOutputAction", "Default action.", (void *) defaultOutputAction},
     {"strictPriorityOutputAction", "Default action with strict priorities", (void *) strictPriorityOutputAction},
     {"subportOutputAction", "Default action for subportting", (void *) subportOutputAction},
+    {"forwardOutputAction", "Strict priorities, cells sent over links to other switches", (void *) forwardOutputAction},
 	{NULL,NULL,NULL}
 };
 
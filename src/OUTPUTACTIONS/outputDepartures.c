@@ -0,0 +1,139 @@
+/* ****************************************************************
+ * Copyright Stanford University 1998,99 - All Rights Reserved
+ ****************************************************************** 
+
+ * Permission to use, copy, modify, and distribute this software 
+ * and its documentation for any purpose is hereby granted without 
+ * fee, provided that the above copyright notice appears in all copies
+ * and that both the copyright notice, this permission notice, and 
+ * the following disclaimer appear in supporting documentation, and 
+ * that the name of Stanford University, not be used in advertising or 
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.
+ * 
+ * STANFORD UNIVERSITY, DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND 
+ * FITNESS. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE FOR ANY 
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER 
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION 
+ * OF CONTRACT, NEGLIGENCE OR OTHER ACTION, ARISING OUT OF OR IN 
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * The Sim Web Site : http://klamath.stanford.edu/tools/SIM
+ * The SIM Mailing List: sim-simulator@lists.stanford.edu
+
+ * Send mail to the above email address with "subscribe sim-simulator" in
+ * the body of the message.
+ *
+ */
+
+#include "sim.h"
+#include "outputAction.h"
+#include "outputDepartures.h"
+
+extern int burstStats( BurstStatsCommand mode, Switch *aSwitch, 
+		       int output,
+		       int input );
+
+void
+initOutputDepartures(Switch *aSwitch, OutputDepartures *departures)
+{
+  departures->sent = createBitset(aSwitch->numOutputs);
+  departures->sending = createBitset(aSwitch->numOutputs);
+}
+
+/* Take the next cell of priority from output's buffer: this switch */
+/* has finished with it. */
+static Cell *
+leaveOutput(Switch *aSwitch, int output, int priority)
+{
+  Cell *aCell;
+
+  aCell = dequeueOutputCell(aSwitch, output, priority);
+
+  /* If any, remove the switch dependent header. */
+  if( aCell->switchDependentHeader )
+    {
+      free(aCell->switchDependentHeader);
+      aCell->switchDependentHeader = NULL;
+    }
+
+  /* Update burstiness stats for this output. */
+  burstStats(BURST_STATS_UPDATE, aSwitch, 
+	     output, aCell->commonStats.inputPort);
+
+  /* Update latency statistics for switch. */
+  latencyStats(LATENCY_STATS_SWITCH_UPDATE, aSwitch, aCell);
+  return(aCell);
+}
+
+/* Take the next cell of priority from output's buffer and destroy it. */
+void
+departOutputCell(Switch *aSwitch, OutputDepartures *departures,
+		 int output, int priority)
+{
+  Cell *aCell;
+
+  aCell = leaveOutput(aSwitch, output, priority);
+
+  /* Update latency statistics for cell. */
+  latencyStats(LATENCY_STATS_CELL_UPDATE, NULL, aCell);
+
+  releaseCellCopy(aCell, output);
+  BITSET_SET(departures->sending, output);
+
+  if(debug_output)
+    printf("Output %d Priority %d: A Cell Is Sent\n", output, priority);
+}
+
+/* Take the next cell of priority from output's buffer and send it */
+/* over the output's link to the next switch.                      */
+void
+forwardOutputCell(Switch *aSwitch, OutputDepartures *departures,
+		  int output, int priority)
+{
+  Cell *aCell;
+
+  aCell = leaveOutput(aSwitch, output, priority);
+
+  /* The next switch keeps its own fabric and algorithm stats. */
+  aCell = unshareCell(aCell, output);
+  if( aCell->fabricStats )
+    {
+      free(aCell->fabricStats);
+      aCell->fabricStats = NULL;
+    }
+  if( aCell->algorithmStats )
+    {
+      free(aCell->algorithmStats);
+      aCell->algorithmStats = NULL;
+    }
+
+  sendLinkCell(aSwitch, output, aCell);
+  BITSET_SET(departures->sending, output);
+
+  if(debug_output)
+    printf("Output %d Priority %d: A Cell Is Forwarded\n", output, priority);
+}
+
+/* End the burst at each output that sent a cell the last time but */
+/* not this time.  Outputs idle both times are not visited.         */
+void
+finishOutputDepartures(Switch *aSwitch, OutputDepartures *departures)
+{
+  int wordIndex, numWords = BITSET_NUM_WORDS(aSwitch->numOutputs);
+  BitsetWord word;
+
+  for(wordIndex=0; wordIndex<numWords; wordIndex++)
+    {
+      for(word = departures->sent[wordIndex] & ~departures->sending[wordIndex];
+	  word; word &= word-1)
+	burstStats(BURST_STATS_UPDATE, aSwitch, 
+		   wordIndex*BITSET_WORD_BITS + BITSET_WORD_FFS(word), NONE);
+      departures->sent[wordIndex] = departures->sending[wordIndex];
+      departures->sending[wordIndex] = 0;
+    }
+}
@@ -0,0 +1,49 @@
+/* ****************************************************************
+ * Copyright Stanford University 1998,99 - All Rights Reserved
+ ****************************************************************** 
+
+ * Permission to use, copy, modify, and distribute this software 
+ * and its documentation for any purpose is hereby granted without 
+ * fee, provided that the above copyright notice appears in all copies
+ * and that both the copyright notice, this permission notice, and 
+ * the following disclaimer appear in supporting documentation, and 
+ * that the name of Stanford University, not be used in advertising or 
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.
+ * 
+ * STANFORD UNIVERSITY, DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND 
+ * FITNESS. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE FOR ANY 
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER 
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION 
+ * OF CONTRACT, NEGLIGENCE OR OTHER ACTION, ARISING OUT OF OR IN 
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * The Sim Web Site : http://klamath.stanford.edu/tools/SIM
+ * The SIM Mailing List: sim-simulator@lists.stanford.edu
+
+ * Send mail to the above email address with "subscribe sim-simulator" in
+ * the body of the message.
+ *
+ */
+
+#ifndef _OUTPUTDEPARTURES_H_
+#define _OUTPUTDEPARTURES_H_
+
+/* Outputs that send a cell, for ending their bursts when they stop. */
+typedef struct {
+  BitsetWord *sent;	/* Outputs that sent a cell the last time */
+  BitsetWord *sending;	/* Outputs sending a cell this time */
+} OutputDepartures;
+
+void initOutputDepartures(Switch *aSwitch, OutputDepartures *departures);
+void departOutputCell(Switch *aSwitch, OutputDepartures *departures,
+		      int output, int priority);
+void forwardOutputCell(Switch *aSwitch, OutputDepartures *departures,
+		       int output, int priority);
+void finishOutputDepartures(Switch *aSwitch, OutputDepartures *departures);
+
+#endif
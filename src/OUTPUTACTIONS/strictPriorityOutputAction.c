@@ -32,24 +32,28 @@
 
 #include "sim.h"
 #include "outputAction.h"
+#include "outputDepartures.h"
 
 
 extern int burstStats( BurstStatsCommand mode, Switch *aSwitch, 
 		       int output,
 		       int input );
 
+struct OutputActionState {
+  OutputDepartures departures;
+};
+
 /* Take next cell from each output buffer and destroy. */
+/* Each output sends from its highest priority with a cell. */
 int strictPriorityOutputAction(cmd, aSwitch, argc, argv)
   OutputActionCmd cmd;
 Switch *aSwitch;
 int argc;
 char **argv;
 {
-  Cell *aCell;
-  int output;
-  struct Element *anElement;
-  struct List *fromFifo;
-  static int *outputTaken = (int *) NULL;
+  struct OutputActionState *outputActionState;
+  int output, wordIndex, numWords;
+  BitsetWord word;
   int priority;
 
   switch(cmd)
@@ -57,61 +61,30 @@ char **argv;
     case OUTPUTACTION_USAGE:
       break;
     case OUTPUTACTION_INIT:
+      outputActionState = (struct OutputActionState *)
+	malloc(sizeof(struct OutputActionState));
+      initOutputDepartures(aSwitch, &outputActionState->departures);
+      aSwitch->outputActionState = (void *) outputActionState;
       break;
     case OUTPUTACTION_EXEC:
+      outputActionState = 
+	(struct OutputActionState *) aSwitch->outputActionState;
 
-        if(!outputTaken)
-                outputTaken = (int *) malloc(aSwitch->numOutputs * sizeof(int));
-        memset(outputTaken, 0, sizeof(int) * aSwitch->numOutputs);
-
-      for(priority=0; priority<aSwitch->numPriorities; priority++)
-	for(output=0; output<aSwitch->numOutputs; output++)
+      numWords = BITSET_NUM_WORDS(aSwitch->numOutputs);
+      for(wordIndex=0; wordIndex<numWords; wordIndex++)
+	for(word=aSwitch->outputsPending[wordIndex]; word; word &= word-1)
 	  {
-	    if(outputTaken[output]) continue; 
-
-	    fromFifo = aSwitch->outputBuffer[output]->fifo[priority];    /* TL */
-
-	    /* If the output queue has a cell, remove it. */
-	    if( fromFifo->number )
-	      {
-		anElement = removeElement(fromFifo);
-		aCell = anElement->Object;
-		
-		
-		/* This switch has finished with this cell.    */
-		/* If any, remove the switch dependent header. */
-		if( aCell->switchDependentHeader )
-		  {
-		    free(aCell->switchDependentHeader);
-		    aCell->switchDependentHeader = NULL;
-		  }
-		
-		/* Update burstiness stats for this output. */
-		burstStats(BURST_STATS_UPDATE, aSwitch, 
-			   output, aCell->commonStats.inputPort);
-		
-		/* Update latency statistics for cell and switch. */
-		latencyStats(LATENCY_STATS_SWITCH_UPDATE, aSwitch, aCell);
-		latencyStats(LATENCY_STATS_CELL_UPDATE, NULL, aCell);
+	    output = wordIndex*BITSET_WORD_BITS + BITSET_WORD_FFS(word);
+	    priority = outputHighestPriority(aSwitch, output);
 
-                /*
-                printf("t: %lu out: %d cell: %lu\n", now, output, aCell->commonStats.ID);
-                */
-		
-		destroyElement(anElement);
-		destroyCell(aCell);
+	    /* An empty higher priority fifo ends the output's burst. */
+	    if( priority > 0 )
+	      burstStats(BURST_STATS_UPDATE, aSwitch, output, NONE);
 
-		outputTaken[output] = 1;
-		if(debug_output)
-		  printf("Output %d Priority %d: A Cell Is Sent\n", output, priority);
-	      }
-	    else
-	      {
-		/* Update burstiness stats for this output. */
-		burstStats(BURST_STATS_UPDATE, aSwitch, 
-			   output, NONE);
-	      }
+	    departOutputCell(aSwitch, &outputActionState->departures,
+			     output, priority);
 	  }
+      finishOutputDepartures(aSwitch, &outputActionState->departures);
       break;
     default:
       fprintf(stderr, "Illegal OutputAction cmd: %d\n", cmd);
@@ -120,6 +93,3 @@ char **argv;
     }
   return (0);
 }
-
-
-
@@ -33,15 +33,13 @@
 
 #include "sim.h"
 #include "outputAction.h"
+#include "outputDepartures.h"
 
 
-extern int burstStats( BurstStatsCommand mode, Switch *aSwitch, 
-		       int output,
-		       int input );
-
 struct OutputActionState {
 	unsigned long numTimesCalled; /* number of times the routine has been called. 
 									Used for maintaining TDM channels. */
+	OutputDepartures departures;
 };
 
 /***************************************************************/
@@ -61,12 +59,10 @@ Switch *aSwitch;
 int argc;
 char **argv;
 {
-  Cell *aCell;
   struct OutputActionState *outputActionState;
-  int output;
-  struct Element *anElement;
-  struct List *fromFifo;
-  int numPriorities, channel, priority;
+  int output, wordIndex, numWords;
+  BitsetWord word;
+  int numPriorities, channel;
 
   switch(cmd)
     {
@@ -75,6 +71,7 @@ char **argv;
     case OUTPUTACTION_INIT:
 		outputActionState = (struct OutputActionState *) malloc(sizeof(struct OutputActionState));
 		outputActionState->numTimesCalled = 0;
+		initOutputDepartures(aSwitch, &outputActionState->departures);
 		aSwitch->outputActionState = (void *) outputActionState;
       break;
     case OUTPUTACTION_EXEC:
@@ -91,49 +88,17 @@ char **argv;
 		channel = numPriorities - 1 - (outputActionState->numTimesCalled % numPriorities);
 		outputActionState->numTimesCalled++;
 
-		for(output=0; output<aSwitch->numOutputs; output++)
-	  	{
-	    	fromFifo = aSwitch->outputBuffer[output]->fifo[channel];    
-
-	    	/* If the output queue has a cell, remove it. */
-	    	if( fromFifo->number )
-	    	{
-				anElement = removeElement(fromFifo);
-				aCell = anElement->Object;
-		
-				/* This switch has finished with this cell.    */
-				/* If any, remove the switch dependent header. */
-				if( aCell->switchDependentHeader )
-		  		{
-		    		free(aCell->switchDependentHeader);
-		    		aCell->switchDependentHeader = NULL;
-		  		}
-				
-				/* Update burstiness stats for this output. */
-				burstStats(BURST_STATS_UPDATE, aSwitch, 
-			   		output, aCell->commonStats.inputPort);
-				
-				/* Update latency statistics for cell and switch. */
-				latencyStats(LATENCY_STATS_SWITCH_UPDATE, aSwitch, aCell);
-				latencyStats(LATENCY_STATS_CELL_UPDATE, NULL, aCell);
-		
-                /*
-                printf("t: %lu out: %d cell: %lu\n", now, output, aCell->commonStats.ID);
-                */
-		
-				destroyElement(anElement);
-				destroyCell(aCell);
-
-				if(debug_output)
-			  		printf("Output %d Priority %d: A Cell Is Sent\n", output, priority);
-	    }
-	    else
-	    {
-			/* Update burstiness stats for this output. */
-			burstStats(BURST_STATS_UPDATE, aSwitch, 
-			   output, NONE);
-	    }
-	  }
+		/* Outputs with a cell on this channel send one. */
+		numWords = BITSET_NUM_WORDS(aSwitch->numOutputs);
+		for(wordIndex=0; wordIndex<numWords; wordIndex++)
+			for(word=aSwitch->outputsPending[wordIndex]; word; word &= word-1)
+			{
+				output = wordIndex*BITSET_WORD_BITS + BITSET_WORD_FFS(word);
+				if( BITSET_IS_SET(aSwitch->outputBuffer[output]->prioritiesPending, channel) )
+					departOutputCell(aSwitch, &outputActionState->departures,
+									 output, channel);
+			}
+		finishOutputDepartures(aSwitch, &outputActionState->departures);
 	}
     break;
 
@@ -144,6 +109,3 @@ char **argv;
     }
   return (0);
 }
-
-
-
@@ -95,6 +95,7 @@ char **argv;
   int index;
 
   int reindex = 0;
+  double *row;
   double prioritysum = 0;
   int cellType;
 
@@ -107,6 +108,7 @@ char **argv;
     case TRAFFIC_USAGE:
       fprintf(stderr, "Options for \"bernoulli_iid_nonuniform\" traffic model:\n");
       fprintf(stderr, "    -u u0 u1 u2 u3 ... uN-1. Default: %f\n", utilization);
+      fprintf(stderr, "    -u matrix: take u0 ... uN-1 from the TrafficMatrix\n");
       fprintf(stderr, "    -m fraction (in range [0-1]) of cells that are multicast. Default: %f\n", mcastFraction);
       fprintf(stderr, "    -R r0:r1:r2:r3... rP-1, multicast utilization tatio per priority level, defaults to unicast utilization per priority level if not specified\n");
       fprintf(stderr, "    -f fixed fanout for multicast cells. If not set, fanout U[0,2^N]\n");
@@ -171,13 +173,21 @@ char **argv;
 	       break;
 	    case 'u':
 	   	   uflag = YES;
+		   /* "-u matrix": this input's row of the traffic matrix */
+		   row = strcmp(optarg, "matrix") ? NULL :
+		     trafficMatrixRow(aSwitch, input);
 	     	/* optind points to next arg string */
 	      	traffic->totalUtilization = 0; 
 	      	for(output=0; output<aSwitch->numOutputs; output++) {
+		  		if( row )
+		  			traffic->utilization[output] = row[output];
+		  		else
+		  		{
 		  		sscanf(argv[output+optind-1], "%lf",
 			 		&traffic->utilization[output]);
 		  		printf("      Output: %d utilization: %f\n",
 					output, traffic->utilization[output]);
+		  		}
 		  		/* Actually keep partial sum of utilizations */
 		  		if(output>0) {
 		    		traffic->utilization[output] += 
@@ -186,7 +196,8 @@ char **argv;
 		 	 	traffic->totalUtilization = traffic->utilization[output];
 			}
 
-            optind = optind + aSwitch->numOutputs - 1; 
+            if( !row )
+              optind = optind + aSwitch->numOutputs - 1; 
 
 			/* Bug Fix v2.01 - optind must be incremented.! Error carried 
                over from 1.x SIM versions */
@@ -492,11 +503,9 @@ traffic->totalUtilization;
 
 		} /* Cell type is MULTICAST */
 
-	    /* Execute the switch inputAction to accept cell */
+	    /* Hand the cell to the switch's input action */
 		/* YOUNGMI: BUG FIX */
-		/* ?? Sundar - check this, why so many parameters ? */
-	    (aSwitch->inputAction)(INPUTACTION_RECEIVE, aSwitch, input, aCell,
-			NULL, NULL, NULL, NULL);
+	    deliverCell(aSwitch, input, aCell);
 	  }
 	else {
 	    if(debug_traffic)
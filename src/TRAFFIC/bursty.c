@@ -553,9 +553,8 @@ utilization;
 	}
 	
 	traffic->numCellsGenerated++;
-	/* Execute the switch inputAction to accept cell */
-	(aSwitch->inputAction)(INPUTACTION_RECEIVE, aSwitch, input, aCell,
-		NULL, NULL, NULL, NULL);
+	/* Hand the cell to the switch's input action */
+	deliverCell(aSwitch, input, aCell);
 		
     }
 	else {
@@ -125,6 +125,7 @@ char **argv;
   int index;
    
   int reindex = 0;
+  double *row;
   double prioritysum = 0;
   int priorityLevels=1;
 
@@ -132,7 +133,8 @@ char **argv;
     {
     case TRAFFIC_USAGE:
       fprintf(stderr, "Options for \"bursty_nonuniform\" traffic model:\n");
-      fprintf(stderr, "    -u u0 u1 u2 u3 ... uN-1. [Seperate with spaces.]");
+      fprintf(stderr, "    -u u0 u1 u2 u3 ... uN-1. [Seperate with spaces.]\n");
+      fprintf(stderr, "    -u matrix: take u0 ... uN-1 from the TrafficMatrix\n");
 	  fprintf(stderr, "    -p number of prioritylevels of traffic generated. Default: %d\n", priorityLevels);
 	  fprintf(stderr, "    -r r0:r1:r2:...rN-1 ratio of unicast utilization in  a priority level \n");
       fprintf(stderr, "    -b mean_burst_length. Default: %f\n", burstLength);
@@ -172,12 +174,20 @@ char **argv;
 	      break;
 	    case 'u':
 		  uflag = YES;
+		  /* "-u matrix": this input's row of the traffic matrix */
+		  row = strcmp(optarg, "matrix") ? NULL :
+		    trafficMatrixRow(aSwitch, input);
 		  traffic->totalUtilization = 0; 
 		  for(output=0; output<aSwitch->numOutputs; output++) {
+			if( row )
+			  traffic->utilization[output] = row[output];
+			else
+			{
 			sscanf(argv[output+optind-1], "%lf",
 				   &traffic->utilization[output]);
 			printf("      Output: %d utilization: %f\n",
 				   output, traffic->utilization[output]);
+			}
 			/* Actually keep partial sum of utilizations */
 			if(output>0) {
 			  traffic->utilization[output] += 
@@ -186,7 +196,8 @@ char **argv;
 			traffic->totalUtilization = traffic->utilization[output];
 		  }
 
-		  optind += aSwitch->numOutputs -1;
+		  if( !row )
+		    optind += aSwitch->numOutputs -1;
 		  
 		  if( traffic->totalUtilization > 1.0 ) {
 			fprintf(stderr, "Total utilization of input %d exceeds 1.0!\n", input);
@@ -554,9 +565,8 @@ traffic->totalUtilization;
 	}
 	
 	traffic->numCellsGenerated++;
-	/* Execute the switch inputAction to accept cell */
-	(aSwitch->inputAction)(INPUTACTION_RECEIVE, aSwitch, input, aCell,
-		NULL, NULL, NULL, NULL);
+	/* Hand the cell to the switch's input action */
+	deliverCell(aSwitch, input, aCell);
 		
     }
 	else {
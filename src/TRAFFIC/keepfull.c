@@ -33,6 +33,7 @@
 #include "sim.h"
 #include "traffic.h"
 #include "inputAction.h"
+#include <string.h>
 
 typedef struct {
   long int numCellsGenerated; /* Total number of cells generated */
@@ -59,6 +60,7 @@ char **argv;
   double psend;
   int output;
   int cflag=NO;
+  double *row;
 
 
 
@@ -67,6 +69,7 @@ char **argv;
     case TRAFFIC_USAGE:
       fprintf(stderr, "Options for \"keepfull\" traffic model:\n");
       fprintf(stderr, "    -c c0 c1 c2 c3 ... cN-1. \n");
+      fprintf(stderr, "    -c matrix: connected where the TrafficMatrix is not 0\n");
       break;
     case TRAFFIC_INIT:
       {
@@ -95,6 +98,14 @@ char **argv;
             {
 	    case 'c':
 	      cflag = YES;
+	      if( strcmp(optarg, "matrix") == 0 )
+		{
+		  /* This input's row of the traffic matrix */
+		  row = trafficMatrixRow(aSwitch, input);
+		  for(output=0; output<aSwitch->numOutputs; output++)
+		    traffic->connected[output] = (row[output] != 0);
+		  break;
+		}
 	      /* optind points to next arg string */
 	      for(output=0; output<aSwitch->numOutputs; output++)
 		sscanf(argv[output+optind-1], "%d",
@@ -157,9 +168,9 @@ char **argv;
 		aCell = createCell(output, UCAST, DEFAULT_PRIORITY);	
 		traffic->numCellsGenerated++;
 
-                /* Execute the switch inputAction to accept cell */
+                /* Hand the cell to the switch's input action */
 								/* YOUNGMI: BUG FIX */
-                (aSwitch->inputAction)(INPUTACTION_RECEIVE, aSwitch, input, aCell, NULL, NULL, NULL, NULL);
+                deliverCell(aSwitch, input, aCell);
 
 	      }
 	    else
@@ -183,9 +183,9 @@ char **argv;
 		    aCell = createCell(output, UCAST);	
 		    traffic->numCellsGenerated++;
 	
-		    /* Execute the switch inputAction to accept cell */
+		    /* Hand the cell to the switch's input action */
 				/* YOUNGMI: BUG FIX */
-		    (aSwitch->inputAction)(INPUTACTION_RECEIVE, aSwitch, input, aCell);
+		    deliverCell(aSwitch, input, aCell);
 	
 		  }
 		else
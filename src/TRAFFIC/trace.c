@@ -229,8 +229,8 @@ char **argv;
 	  printf("Switch %d,  Input %d, has new cell for %d\n", aSwitch->switchNumber, input, output);
 	traffic->numCellsGenerated++;
 
-	/* Execute the switch inputAction to accept cell */
-	(aSwitch->inputAction)(INPUTACTION_RECEIVE, aSwitch, input, aCell, NULL, NULL, NULL, NULL);
+	/* Hand the cell to the switch's input action */
+	deliverCell(aSwitch, input, aCell);
 
 	/* Read time of next cell. */
 	switch(readNextCellTime(traffic->fp, traffic))
@@ -270,9 +270,9 @@ char **argv;
 	    traffic->numCellsLeft--;
 
 	
-	    /* Execute the switch inputAction to accept cell */
+	    /* Hand the cell to the switch's input action */
 			/* YOUNGMI: BUG FIX */
-	    (aSwitch->inputAction)(INPUTACTION_RECEIVE, aSwitch, input, aCell, NULL, NULL, NULL, NULL);
+	    deliverCell(aSwitch, input, aCell);
 	  }
 
 	if( !traffic->numCellsLeft )
@@ -129,6 +129,24 @@ int bitmapNumSet(Bitmap *bitmap)
 }
 
 
+/* Copies the first numBits bits of bitmap into a bitset (see bitset.h) */
+/* of as many bits, a byte at a time.  Bits beyond the bitmap are clear. */
+void bitmapToBitset(Bitmap *bitmap, unsigned long *set, int numBits)
+{
+  int wordBytes = sizeof(unsigned long);
+  int numWords = (numBits + 8*wordBytes - 1)/(8*wordBytes);
+  int numBytes = (numBits + 7)/8;
+  int i;
+
+  memset(set, 0, numWords * wordBytes);
+  if( numBytes > BITMAP_BYTES )
+    numBytes = BITMAP_BYTES;
+  for(i = 0; i < numBytes; i++)
+    set[i/wordBytes] |= ((unsigned long) bitmap->byte[i]) << (8*(i%wordBytes));
+  if( numBits % (8*wordBytes) )
+    set[numWords-1] &= (1UL << (numBits % (8*wordBytes))) - 1;
+}
+
 void bitmapPrint(FILE *fp, Bitmap *bitmap, int length)
 {
   int bit;
@@ -48,6 +48,7 @@ extern int bitmapAnyBitSet(Bitmap *bitmap);
 extern int bitmapNumSet(Bitmap *bitmap);
 extern void bitmapPrint(FILE *fp, Bitmap *bitmap, int length);
 extern int bitmapRead(FILE *fp, Bitmap *bitmap);
+extern void bitmapToBitset(Bitmap *bitmap, unsigned long *set, int numBits);
 
 #endif
 
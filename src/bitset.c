@@ -0,0 +1,197 @@
+/* ****************************************************************
+ * Copyright Stanford University 1998,99 - All Rights Reserved
+ ****************************************************************** 
+
+ * Permission to use, copy, modify, and distribute this software 
+ * and its documentation for any purpose is hereby granted without 
+ * fee, provided that the above copyright notice appears in all copies
+ * and that both the copyright notice, this permission notice, and 
+ * the following disclaimer appear in supporting documentation, and 
+ * that the name of Stanford University, not be used in advertising or 
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.
+ * 
+ * STANFORD UNIVERSITY, DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND 
+ * FITNESS. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE FOR ANY 
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER 
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION 
+ * OF CONTRACT, NEGLIGENCE OR OTHER ACTION, ARISING OUT OF OR IN 
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * The Sim Web Site : http://klamath.stanford.edu/tools/SIM
+ * The SIM Mailing List: sim-simulator@lists.stanford.edu
+
+ * Send mail to the above email address with "subscribe sim-simulator" in
+ * the body of the message.
+ *
+ */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bitset.h"
+
+BitsetWord *createBitset(int numBits)
+{
+  BitsetWord *set;
+  int numWords = BITSET_NUM_WORDS(numBits);
+
+  /* Always allocate at least one word so that empty sets are valid. */
+  if( numWords == 0 )
+    numWords = 1;
+  set = (BitsetWord *) malloc(numWords*sizeof(BitsetWord));
+  memset(set, 0, numWords*sizeof(BitsetWord));
+  return(set);
+}
+
+void destroyBitset(BitsetWord *set)
+{
+  free(set);
+}
+
+void bitsetClear(BitsetWord *set, int numBits)
+{
+  memset(set, 0, BITSET_NUM_WORDS(numBits)*sizeof(BitsetWord));
+}
+
+/* Set bits 0..numBits-1, leaving the unused tail of the last word clear. */
+void bitsetFill(BitsetWord *set, int numBits)
+{
+  int numWords = BITSET_NUM_WORDS(numBits);
+  int tail = numBits%BITSET_WORD_BITS;
+
+  if( !numWords )
+    return;
+  memset(set, 0xff, numWords*sizeof(BitsetWord));
+  if( tail )
+    set[numWords-1] = (((BitsetWord) 1)<<tail) - 1;
+}
+
+void bitsetCopy(BitsetWord *toSet, BitsetWord *fromSet, int numBits)
+{
+  memcpy(toSet, fromSet, BITSET_NUM_WORDS(numBits)*sizeof(BitsetWord));
+}
+
+int bitsetAnySet(BitsetWord *set, int numBits)
+{
+  int i, numWords = BITSET_NUM_WORDS(numBits);
+
+  for(i=0; i<numWords; i++)
+    if( set[i] )
+      return(1);
+  return(0);
+}
+
+int bitsetNumSet(BitsetWord *set, int numBits)
+{
+  int i, sum=0, numWords = BITSET_NUM_WORDS(numBits);
+
+  for(i=0; i<numWords; i++)
+    sum += BITSET_WORD_COUNT(set[i]);
+  return(sum);
+}
+
+/* Returns lowest set bit, or -1 if none are set. */
+int bitsetFirstSet(BitsetWord *set, int numBits)
+{
+  int i, numWords = BITSET_NUM_WORDS(numBits);
+
+  for(i=0; i<numWords; i++)
+    if( set[i] )
+      return(i*BITSET_WORD_BITS + BITSET_WORD_FFS(set[i]));
+  return(-1);
+}
+
+/* Returns lowest set bit >= from, or -1 if none are set. */
+int bitsetNextSet(BitsetWord *set, int numBits, int from)
+{
+  int i, numWords = BITSET_NUM_WORDS(numBits);
+  BitsetWord word;
+
+  if( from >= numBits )
+    return(-1);
+  if( from < 0 )
+    from = 0;
+  i = BITSET_WORD(from);
+  word = set[i] & ~(BITSET_MASK(from)-1);
+  for(;;)
+    {
+      if( word )
+	return(i*BITSET_WORD_BITS + BITSET_WORD_FFS(word));
+      if( ++i >= numWords )
+	return(-1);
+      word = set[i];
+    }
+}
+
+/* 
+ * Returns first set bit at or after from, wrapping around to bit 0,
+ * or -1 if none are set. This is the round-robin pointer search
+ * used by the arbiters.
+ */
+int bitsetNextSetCyclic(BitsetWord *set, int numBits, int from)
+{
+  int bit;
+
+  if( (bit = bitsetNextSet(set, numBits, from)) >= 0 )
+    return(bit);
+  bit = bitsetFirstSet(set, numBits);
+  return( (bit >= 0 && bit < from) ? bit : -1 );
+}
+
+/* Returns bits start..start+count-1 of set as the low bits of a word. */
+/* The bits must lie within the set and count <= BITSET_WORD_BITS. */
+static BitsetWord bitsetWindow(BitsetWord *set, int start, int count)
+{
+  int i = BITSET_WORD(start);
+  int offset = start%BITSET_WORD_BITS;
+  BitsetWord word = set[i] >> offset;
+
+  if( offset && offset+count > BITSET_WORD_BITS )
+    word |= set[i+1] << (BITSET_WORD_BITS-offset);
+  if( count < BITSET_WORD_BITS )
+    word &= (((BitsetWord) 1)<<count) - 1;
+  return(word);
+}
+
+/* 
+ * Cyclic rotation: bit i of toSet becomes bit (i+shift)%numBits of
+ * fromSet, for 0 <= shift < numBits. Works a word at a time. The sets
+ * must be distinct.
+ */
+void bitsetRotate(BitsetWord *toSet, BitsetWord *fromSet, int numBits, 
+		  int shift)
+{
+  int i, base, count, start, first;
+  int numWords = BITSET_NUM_WORDS(numBits);
+
+  for(i=0; i<numWords; i++)
+    {
+      base = i*BITSET_WORD_BITS;
+      count = numBits - base;
+      if( count > BITSET_WORD_BITS )
+	count = BITSET_WORD_BITS;
+      start = (base+shift)%numBits;
+      first = numBits - start;
+      if( first >= count )
+	toSet[i] = bitsetWindow(fromSet, start, count);
+      else
+	toSet[i] = bitsetWindow(fromSet, start, first) |
+	  (bitsetWindow(fromSet, 0, count-first) << first);
+    }
+}
+
+void bitsetPrint(FILE *fp, BitsetWord *set, int numBits)
+{
+  int bit;
+
+  for(bit=0; bit<numBits; bit++)
+    fprintf(fp, "%c", BITSET_IS_SET(set, bit) ? '1' : '0');
+  fprintf(fp, "\n");
+}
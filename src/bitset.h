@@ -0,0 +1,83 @@
+/* ****************************************************************
+ * Copyright Stanford University 1998,99 - All Rights Reserved
+ ****************************************************************** 
+
+ * Permission to use, copy, modify, and distribute this software 
+ * and its documentation for any purpose is hereby granted without 
+ * fee, provided that the above copyright notice appears in all copies
+ * and that both the copyright notice, this permission notice, and 
+ * the following disclaimer appear in supporting documentation, and 
+ * that the name of Stanford University, not be used in advertising or 
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.
+ * 
+ * STANFORD UNIVERSITY, DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND 
+ * FITNESS. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE FOR ANY 
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER 
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION 
+ * OF CONTRACT, NEGLIGENCE OR OTHER ACTION, ARISING OUT OF OR IN 
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * The Sim Web Site : http://klamath.stanford.edu/tools/SIM
+ * The SIM Mailing List: sim-simulator@lists.stanford.edu
+
+ * Send mail to the above email address with "subscribe sim-simulator" in
+ * the body of the message.
+ *
+ */
+
+
+#ifndef _BITSET_H
+#define _BITSET_H
+
+/* 
+ * Variable length bitsets packed into machine words.
+ * Unlike a Bitmap (which is a fixed size field carried by every cell),
+ * a bitset is sized when it is created, so it is used for scheduler
+ * and fabric state that grows with the number of ports.
+ * Bits beyond numBits in the last word are always kept clear.
+ */
+
+typedef unsigned long BitsetWord;
+
+#define BITSET_WORD_BITS	((int) (8*sizeof(BitsetWord)))
+#define BITSET_NUM_WORDS(numBits) \
+            (((numBits)+BITSET_WORD_BITS-1)/BITSET_WORD_BITS)
+#define BITSET_WORD(bit)	((bit)/BITSET_WORD_BITS)
+#define BITSET_MASK(bit)	(((BitsetWord) 1)<<((bit)%BITSET_WORD_BITS))
+
+#define BITSET_SET(set, bit)	((set)[BITSET_WORD(bit)] |= BITSET_MASK(bit))
+#define BITSET_RESET(set, bit)	((set)[BITSET_WORD(bit)] &= ~BITSET_MASK(bit))
+#define BITSET_IS_SET(set, bit)	(((set)[BITSET_WORD(bit)] & BITSET_MASK(bit)) != 0)
+
+/* Index of lowest set bit in a non-zero word. */
+#define BITSET_WORD_FFS(word)	(__builtin_ctzl(word))
+#define BITSET_WORD_COUNT(word)	(__builtin_popcountl(word))
+
+/* Iterate over every set bit of a bitset, in increasing order. */
+/* The set must not be modified while iterating. */
+#define EVERY_BIT_SET(set, numWords, wordIndex, word, bit) \
+  for(wordIndex=0; wordIndex<(numWords); wordIndex++) \
+    for(word=(set)[wordIndex]; \
+        word && ((bit)=wordIndex*BITSET_WORD_BITS+BITSET_WORD_FFS(word),1); \
+        word &= word-1)
+
+extern BitsetWord *createBitset(int numBits);
+extern void destroyBitset(BitsetWord *set);
+extern void bitsetClear(BitsetWord *set, int numBits);
+extern void bitsetFill(BitsetWord *set, int numBits);
+extern void bitsetCopy(BitsetWord *toSet, BitsetWord *fromSet, int numBits);
+extern int bitsetAnySet(BitsetWord *set, int numBits);
+extern int bitsetNumSet(BitsetWord *set, int numBits);
+extern int bitsetFirstSet(BitsetWord *set, int numBits);
+extern int bitsetNextSet(BitsetWord *set, int numBits, int from);
+extern int bitsetNextSetCyclic(BitsetWord *set, int numBits, int from);
+extern void bitsetRotate(BitsetWord *toSet, BitsetWord *fromSet, int numBits,
+			 int shift);
+extern void bitsetPrint(FILE *fp, BitsetWord *set, int numBits);
+
+#endif
@@ -68,6 +68,7 @@ createCell(vci, mcastFlag, priority)
     FatalError("CreateCell(): malloc failed.\n");
 
   cell->vci = vci;
+  cell->destination = NONE;	/* Until it enters a network */
 
   if(priority <= MAX_PRIORITY)
     cell->priority = priority;   
@@ -171,11 +172,129 @@ copyCell(aCell)
   return(newCell);
 }
 
+/*
+  A copy of multicast cell aCell for output. The copies made in one
+  cell time reach their outputs together and do not differ, so the
+  first is allocated and the rest share it: numShares counts the
+  outputs at which it is queued, and each hands it back with
+  releaseCellCopy(), which frees it when the last is done with it. 
+  last holds the copy made this cell
+  time, if any. Copies do not take aCell's headers, which stay with
+  aCell until it leaves the input.
+*/
+Cell *
+shareCell(aCell, output, last)
+  Cell *aCell;
+int output;
+CellCopy *last;
+{
+  Cell *copy;
+
+  if( last->original == aCell && last->time == now )
+    {
+      bitmapSetBit(output, &last->copy->outputs);
+      last->copy->numShares++;
+      return(last->copy);
+    }
+
+  copy = createCell(0,0,0);
+  memcpy(copy, aCell, sizeof(Cell));
+  copy->switchDependentHeader = NULL;
+  copy->fabricStats = NULL;
+  copy->algorithmStats = NULL;
+  bitmapReset(&copy->outputs);
+  bitmapSetBit(output, &copy->outputs);
+  copy->numShares = 1;
+
+  last->original = aCell;
+  last->copy = copy;
+  last->time = now;
+  return(copy);
+}
+
+/*
+  A copy of multicast cell aCell, made by shareCell(), that is queued 
+  only at output: if other outputs share aCell, output is given a 
+  copy of its own. Needed when the copies will not reach their 
+  outputs together. The last copy handed over by the input is the
+  multicast cell itself, with no outputs left: it is not shared.
+*/
+Cell *
+unshareCell(aCell, output)
+  Cell *aCell;
+int output;
+{
+  Cell *copy;
+
+  if( aCell->multicast == UCAST || aCell->numShares <= 1 )
+    return(aCell);
+
+  copy = createCell(0,0,0);
+  memcpy(copy, aCell, sizeof(Cell));
+  bitmapReset(&copy->outputs);
+  bitmapSetBit(output, &copy->outputs);
+  copy->numShares = 1;
+  bitmapResetBit(output, &aCell->outputs);
+  aCell->numShares--;
+  return(copy);
+}
+
+/*
+  Output is done with cell, which may be a copy it shares with other
+  outputs (see shareCell()): the last of them frees it.
+*/
+void
+releaseCellCopy(cell, output)
+  Cell *cell;
+int output;
+{
+  if( cell->numShares > 1 )
+    {
+      bitmapResetBit(output, &cell->outputs);
+      cell->numShares--;
+      return;
+    }
+  destroyCell(cell);
+}
+
+/*
+  Hand a new cell arriving at input to aSwitch. The cells delivered
+  in a cell time are kept, in order, until the input action admits
+  them together (INPUTACTION_RECEIVE_BATCH) once every input's
+  traffic is in.
+*/
+void
+deliverCell(aSwitch, input, aCell)
+  Switch *aSwitch;
+int input;
+Cell *aCell;
+{
+  ArrivalBatch *batch = &aSwitch->arrivals;
+
+  /* A cell new to a network of switches gets its address there. */
+  if( aSwitch->route && aCell->destination == NONE )
+    addressCell(aSwitch, aCell);
+
+  if( batch->numCells == batch->maxCells )
+    {
+      batch->maxCells = batch->maxCells ? 2 * batch->maxCells
+	: aSwitch->numInputs;
+      batch->input = (int *) 
+	realloc(batch->input, batch->maxCells * sizeof(int));
+      batch->cell = (Cell **) 
+	realloc(batch->cell, batch->maxCells * sizeof(Cell *));
+      if( batch->input == NULL || batch->cell == NULL )
+	FatalError("deliverCell(): Realloc failed.\n");
+    }
+  batch->input[batch->numCells] = input;
+  batch->cell[batch->numCells] = aCell;
+  batch->numCells++;
+}
+
 void 
 destroyCell(cell)
   Cell *cell;
 {
-
   if(cell->switchDependentHeader)
     free(cell->switchDependentHeader);
   if(cell->fabricStats)
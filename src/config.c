@@ -45,11 +45,12 @@
 			OutputAction %s ( parameters of action)
 			Fabric     %s  ( parameters of fabric)
 			Algorithm  %s  ( parameters of algorithm, e.g: "-N 4" )
+			TrafficMatrix %s (optional: file of N values per input)
 			Input       TrafficModel       Parameters
 			0	    %s                 %s (e.g: "-u 0.5")
-			1	    %s                 %s (e.g: "-u 0.5")
+			1-5	    %s                 %s (e.g: "-u 0.5")
 			...			...
-			Numinputs-1 %s	               %s (e.g: "-u 0.5")
+			*	    %s	               %s (e.g: "-u 0.5")
 			Stats
 				Arrivals	(0,0) (0,1) ... 
 				Departures 	(0,0) (0,1) ... 
@@ -63,6 +64,29 @@
 		Switch 1
 		...
 		Switch Numswitches-1
+		Topology	(optional)
+			Link  0  0-3  1  0  5	(switch 0 outputs 0-3 to switch 1
+						 inputs 0-3, delay 5 cells)
+			Address 0  0-3  2  0	(cells made at switch 0 with
+						 VCIs 0-3 are for switch 2
+						 ports 0-3)
+			Route 1  2  0-3  4	(at switch 1, cells for switch 2
+						 ports 0-3 to outputs 4-7)
+
+Inputs: A line gives the traffic model of one input, of the range
+        first-last or, with "*", of the remaining inputs. Each line 
+        starts at the input after the last one.
+TrafficMatrix: Text (e.g. CSV) or, if the name ends in ".bin", binary
+        doubles; read by traffic model options such as "-u matrix".
+
+Topology: Links carry the cells leaving an output of a switch, whose
+        output action is "forwardOutputAction", to an input of another
+        switch. A unicast cell is for a network address, a port of a
+        switch: by default the output of its first switch that its
+        traffic model chose, else as Address lines say. At every
+        switch Route lines map addresses to outputs (default: the
+        output numbered as the port). The switches are simulated in
+        turn; there is no parallel execution.
 
 Stats/Histograms: Determines which stats/histograms to gather for general
                   input and output fifos only. 
@@ -119,6 +143,10 @@ extern void FatalError(); /* in sim.c */
 /*********************  Defined here ********************/
 static int parseTuples();
 static void parseRestOfLine();
+static void loadTrafficMatrix();
+static void parseTopology();
+static void parseRange();
+static void skipLine();
 
 
 
@@ -138,7 +166,9 @@ parseConfigurationFile( configFilename )
   int pri, start, numFIFOs;
 
   int numArgs;
-  char **argVector;
+  char **argVector, **argCopy;
+  int lastInput;
+  int (*trafficFunction)();
 
   /* int i, type, input, output; CHANGED */
   int i, type, input, output,inputs,outputs;
@@ -152,6 +182,7 @@ parseConfigurationFile( configFilename )
   argVector = (char **) malloc( MAXSTRING * sizeof(char *) );
   for(i=0; i<MAXSTRING; i++)
     argVector[i] = (char *) malloc( MAXSTRING * sizeof(char) );
+  argCopy = (char **) malloc( MAXSTRING * sizeof(char *) );
 
   if( (strcmp(configFilename, "-") == 0) 
       || (strcmp(configFilename, "stdin") == 0) )
@@ -319,34 +350,63 @@ parseConfigurationFile( configFilename )
       /********************************************************************/
       /***** For each input: Parse and init traffic Model   ***************/
       /********************************************************************/
-      for( input=0; input<aSwitch->numInputs; input++ )
+      fscanf(fp, "%s", aString);
+      if( strcasecmp(aString, "trafficmatrix") == 0 )
+	{
+	  fscanf(fp, "%s", aString);
+	  loadTrafficMatrix(aSwitch, aString);
+	  fscanf(fp, "%s", aString);
+	}
+      for( input=0; input<aSwitch->numInputs; input=lastInput+1 )
 	  {
+	    /* Read the inputs of this line: "n", "first-last" or "*" */
+	    if( strcmp(aString, "*") == 0 )
+	      lastInput = aSwitch->numInputs - 1;
+	    else
+	      switch( sscanf(aString, "%d-%d", &anInt, &lastInput) )
+		{
+		case 1:
+		  lastInput = anInt;
+		  /* Fall through */
+		case 2:
+		  if( anInt == input && lastInput >= input &&
+		      lastInput < aSwitch->numInputs )
+		    break;
+		  /* Fall through */
+		default:
+		  fprintf(stderr, "Wrong input number: %s, expected: %d", 
+			  aString, input);
+		  exit(1);
+		}
+
 	    /* Read and set traffic algorithm */
-	    fscanf(fp, "%d", &anInt);
-	    if( anInt != input )
-	        {
-	        fprintf(stderr, "Wrong input number: %d, expected: %d", 
-		        anInt, input);
-	         exit(1);
-	    }
 	    fscanf(fp, "%s", trafficModel);
-	    printf("Input: %d  Traffic model: %s\n", input, trafficModel);
-
-        aSwitch->inputBuffer[input]->trafficModel = (int (*)()) 
-            findFunction(trafficModel, trafficTable);
-        if( aSwitch->inputBuffer[input]->trafficModel)
-	    {
-            parseRestOfLine( fp, &numArgs, argVector );
-	        (aSwitch->inputBuffer[input]->trafficModel)
-	            (TRAFFIC_INIT, aSwitch, input, numArgs, argVector);
-        }
-        else
-        {
-	        fprintf(stderr,"Traffic Model %s at switch %d input %d is unknown.\n",
-		        trafficModel, aSwitch->switchNumber, input);
-	        exit(1);
-        }
-      } 
+	    if( lastInput == input )
+	      printf("Input: %d  Traffic model: %s\n", input, trafficModel);
+	    else
+	      printf("Inputs: %d-%d  Traffic model: %s\n", input, lastInput,
+		     trafficModel);
+
+	    trafficFunction = (int (*)()) findFunction(trafficModel, trafficTable);
+	    if( !trafficFunction )
+	      {
+		fprintf(stderr,"Traffic Model %s at switch %d input %d is unknown.\n",
+			trafficModel, aSwitch->switchNumber, input);
+		exit(1);
+	      }
+
+	    /* The inputs of a line share its parse; each inits its own */
+	    /* traffic state. getopt() may permute the pointers.        */
+	    parseRestOfLine( fp, &numArgs, argVector );
+	    for(i=input; i<=lastInput; i++)
+	      {
+		memcpy(argCopy, argVector, (numArgs+1) * sizeof(char *));
+		aSwitch->inputBuffer[i]->trafficModel = trafficFunction;
+		(trafficFunction)(TRAFFIC_INIT, aSwitch, i, numArgs, argCopy);
+	      }
+	    if( lastInput < aSwitch->numInputs - 1 )
+	      fscanf(fp, "%s", aString);
+	  } 
 
 
 
@@ -752,10 +812,22 @@ parseConfigurationFile( configFilename )
 		
   }
 
+  /* Optional Topology section: links between the switches */
+  while( fscanf(fp, "%s", aString) == 1 )
+    {
+      if( aString[0] == '#' )
+	skipLine(fp);
+      else if( strcasecmp(aString, "topology") == 0 )
+	parseTopology(fp);
+      else
+	FatalError("Expected \"Topology\" or end of file");
+    }
+
   /* Free malloc'd space for argVector */
   for(i=0; i<MAXSTRING; i++)
     free(argVector[i]);
   free(argVector);
+  free(argCopy);
 
   /* Close configuration file and return */
   fclose(fp);
@@ -860,20 +932,26 @@ char **argVector;
 {
   char line[MAXSTRING];
   char *aWord;
-  int i=0;
+  int i=0, c;
 
 
   /* Read rest of line */
   /* Remove leading white space */
   do {
-    fread(&line[0], 1, 1, fp);
-  } while(line[0] == ' ' || line[0] == '\t');
-  i=1;
-  if( line[0] != '\n' )
-    do {
-      fread(&line[i], 1, 1, fp);
-    } while( line[i++] != '\n' );
-  line[--i] = '\0';
+    c = getc(fp);
+  } while(c == ' ' || c == '\t');
+  line[0] = '\0';
+  if( c != '\n' && c != EOF )
+    {
+      ungetc(c, fp);
+      if( fgets(line, MAXSTRING, fp) == NULL )
+	line[0] = '\0';
+      i = strlen(line);
+      if( i > 0 && line[i-1] == '\n' )
+	line[--i] = '\0';
+      else if( !feof(fp) )
+	FatalError("parseRestOfLine(): line too long.");
+    }
 
   if(debug_sim)
     printf("Line: %s\n", line);
@@ -908,3 +986,161 @@ char **argVector;
       printf("Arg: %d, %s\n", i, argVector[i]);
 
 }
+
+/*
+  Read a traffic matrix for aSwitch: a row of numOutputs values for
+  each input. A file named *.bin holds the values as doubles, row by
+  row; any other file is text, with the values separated by commas
+  or white space (e.g. CSV). Traffic models read a row with
+  trafficMatrixRow(), e.g. "-u matrix".
+*/
+static void loadTrafficMatrix( aSwitch, filename )
+  Switch *aSwitch;
+char *filename;
+{
+  FILE *fp;
+  int i, len, numValues = aSwitch->numInputs * aSwitch->numOutputs;
+
+  printf("Traffic matrix: %s\n", filename);
+  aSwitch->trafficMatrix = (double *) malloc(numValues * sizeof(double));
+  if( aSwitch->trafficMatrix == NULL )
+    FatalError("loadTrafficMatrix(): Malloc failed.");
+
+  len = strlen(filename);
+  if( len > 4 && strcmp(filename+len-4, ".bin") == 0 )
+    {
+      if( (fp = fopen(filename, "rb")) == NULL )
+	FatalError("loadTrafficMatrix(): couldn't open file.");
+      if( fread(aSwitch->trafficMatrix, sizeof(double), numValues, fp) 
+	  != numValues )
+	FatalError("loadTrafficMatrix(): file too short.");
+    }
+  else
+    {
+      if( (fp = fopen(filename, "r")) == NULL )
+	FatalError("loadTrafficMatrix(): couldn't open file.");
+      for(i=0; i<numValues; i++)
+	{
+	  if( fscanf(fp, "%lf", &aSwitch->trafficMatrix[i]) != 1 )
+	    FatalError("loadTrafficMatrix(): file too short.");
+	  fscanf(fp, " ,");
+	}
+    }
+  fclose(fp);
+}
+
+/* The traffic matrix row for input, given by the TrafficMatrix line. */
+double *
+trafficMatrixRow( aSwitch, input )
+  Switch *aSwitch;
+int input;
+{
+  if( aSwitch->trafficMatrix == NULL )
+    FatalError("Traffic model uses a traffic matrix, but switch has no TrafficMatrix");
+  return( aSwitch->trafficMatrix + input * aSwitch->numOutputs );
+}
+
+/*
+  Read the Topology section, to the end of the file:
+	Link	fromSwitch  outputs  toSwitch  firstInput  delay
+	Address	switch	    VCIs     toSwitch  firstPort
+	Route	switch	    toSwitch ports     firstOutput
+  outputs, VCIs and ports are "n" or "first-last". The outputs of a
+  Link line are linked in turn to the inputs of toSwitch from
+  firstInput on, each taking delay (at least 1) cell times. Unicast
+  cells made at switch with the VCIs of an Address line are for the
+  ports of toSwitch from firstPort on. At switch, the cells for the
+  ports of toSwitch of a Route line go in turn to the outputs from
+  firstOutput on. See topology.c.
+*/
+static void parseTopology( fp )
+  FILE *fp;
+{
+  char aString[MAXSTRING], range[MAXSTRING];
+  int aSwitch, toSwitch, first, last, to, delay, n;
+  int numLinks=0;
+
+  printf("============================================\n");
+  printf("================ Topology ==================\n");
+  printf("============================================\n");
+  createNetwork();
+  while( fscanf(fp, "%s", aString) == 1 )
+    {
+      if( aString[0] == '#' )
+	skipLine(fp);
+      else if( strcasecmp(aString, "link") == 0 )
+	{
+	  if( fscanf(fp, "%d %s %d %d %d", &aSwitch, range, &toSwitch,
+		     &to, &delay) != 5 )
+	    FatalError("Expected \"Link fromSwitch outputs toSwitch firstInput delay\"");
+	  if( aSwitch < 0 || aSwitch >= numSwitches )
+	    FatalError("Link from unknown switch");
+	  parseRange(range, &first, &last);
+	  printf("Link: switch %d outputs %d-%d to switch %d inputs %d-%d, delay %d\n",
+		 aSwitch, first, last, toSwitch, to, to + last - first, delay);
+	  for(n=first; n<=last; n++)
+	    createLink(switches[aSwitch], n, toSwitch, to + n - first, delay);
+	  numLinks += last - first + 1;
+	}
+      else if( strcasecmp(aString, "address") == 0 )
+	{
+	  if( fscanf(fp, "%d %s %d %d", &aSwitch, range, &toSwitch, &to) != 4 )
+	    FatalError("Expected \"Address switch VCIs toSwitch firstPort\"");
+	  if( aSwitch < 0 || aSwitch >= numSwitches )
+	    FatalError("Address at unknown switch");
+	  parseRange(range, &first, &last);
+	  printf("Address: switch %d VCIs %d-%d for switch %d ports %d-%d\n",
+		 aSwitch, first, last, toSwitch, to, to + last - first);
+	  for(n=first; n<=last; n++)
+	    setAddress(switches[aSwitch], n, 
+		       networkAddress(toSwitch, to + n - first));
+	}
+      else if( strcasecmp(aString, "route") == 0 )
+	{
+	  if( fscanf(fp, "%d %d %s %d", &aSwitch, &toSwitch, range, &to) != 4 )
+	    FatalError("Expected \"Route switch toSwitch ports firstOutput\"");
+	  if( aSwitch < 0 || aSwitch >= numSwitches )
+	    FatalError("Route at unknown switch");
+	  parseRange(range, &first, &last);
+	  printf("Route: switch %d, switch %d ports %d-%d to outputs %d-%d\n",
+		 aSwitch, toSwitch, first, last, to, to + last - first);
+	  for(n=first; n<=last; n++)
+	    setRoute(switches[aSwitch], networkAddress(toSwitch, n), 
+		     to + n - first);
+	}
+      else
+	FatalError("Expected \"Link\", \"Address\" or \"Route\"");
+    }
+
+  printf("Number of links: %d\n", numLinks);
+}
+
+/* Read "n" or "first-last" from aString. */
+static void parseRange( aString, first, last )
+  char *aString;
+int *first, *last;
+{
+  switch( sscanf(aString, "%d-%d", first, last) )
+    {
+    case 1:
+      *last = *first;
+      /* Fall through */
+    case 2:
+      if( *first >= 0 && *last >= *first )
+	break;
+      /* Fall through */
+    default:
+      fprintf(stderr, "Wrong range: %s\n", aString);
+      exit(1);
+    }
+}
+
+/* Skip the rest of the line, e.g. a comment. */
+static void skipLine( fp )
+  FILE *fp;
+{
+  int c;
+
+  while( (c = fgetc(fp)) != '\n' && c != EOF )
+    ;
+}
@@ -64,11 +64,20 @@ createSwitch( number, inputs, outputs, priorities )
     FatalError("createSwitch(): Malloc failed for outputs.\n");
   for( output=0; output<outputs; output++ )
     aSwitch->outputBuffer[output] = createOutputBuffer(output, priorities);
+  aSwitch->outputsPending = createBitset(outputs);
+  aSwitch->trafficMatrix = NULL;
+  aSwitch->outputLink = NULL;
+  aSwitch->address = NULL;
+  aSwitch->route = NULL;
 
   aSwitch->scheduler.schedulingAlgorithm = (void (*)()) NULL;
   aSwitch->scheduler.schedulingStats = (void *) NULL;
   aSwitch->scheduler.schedulingState = (void *) NULL;
+  aSwitch->scheduler.fifoChanged = NULL;
   aSwitch->fabric.fabricState = (void *) NULL;
+  aSwitch->fabric.fabricStats = (void *) NULL;
+  memset(&aSwitch->fabric.Interconnect, 0, 
+	 sizeof(aSwitch->fabric.Interconnect));
   aSwitch->inputAction = (void *) NULL;
   aSwitch->inputActionState = (void *) NULL;
   aSwitch->outputAction = (void *) NULL;
@@ -114,6 +123,7 @@ createInputBuffer( input, outputs, priorities )
       sprintf(inputBufferName, "Input %d mcast buffer, pri=%d", input,pri);
       inputBuffer->mcastFifo[pri] = createList(inputBufferName);
     }
+  inputBuffer->fifosPending = createBitset(numFIFOs);
   
   
   return( inputBuffer );
@@ -140,6 +150,7 @@ createOutputBuffer(output, priorities)
       sprintf(outputBufferName, "Output Buffer %d, pri=%d", output,pri);
       outputBuffer->fifo[pri] = createList(outputBufferName);
     }
+  outputBuffer->prioritiesPending = createBitset(priorities);
   return( outputBuffer );
 
 }
@@ -429,6 +429,101 @@ int moveElement(struct List *fromList, struct List *toList,
 }
 	
 
+#if defined(LIST_STATS) || defined(LIST_HISTOGRAM)
+/* Whether aList keeps any statistic or histogram. */
+static int listKeepsStats(struct List *aList)
+{
+  int type;
+
+#ifdef LIST_STATS
+  if( aList->listStats )
+    for( type=0; type<NUM_LIST_STATS_TYPES; type++ )
+      if( LIST_STAT_IS_ENABLED(aList, type) )
+	return(1);
+#endif // LIST_STATS
+#ifdef LIST_HISTOGRAM
+  if( aList->listHistogram )
+    for( type=0; type<NUM_LIST_HISTOGRAM_TYPES; type++ )
+      if( LIST_HISTOGRAM_IS_ENABLED(aList, type) )
+	return(1);
+#endif // LIST_HISTOGRAM
+  return(0);
+}
+#endif
+
+/*****************************************************************/
+/*************************** spliceList() ************************/
+/*****************************************************************/
+/* Move every element of fromList, in order, to the tail of toList. */
+/* The elements themselves move: none is created or destroyed.      */
+/* Lists that keep statistics see each element leave and arrive in  */
+/* turn, as with removeElement() and addElement(); between lists    */
+/* that keep none the move costs O(1).                              */
+int spliceList(struct List *fromList, struct List *toList)
+{
+  int numMoved = fromList->number;
+#if defined(LIST_STATS) || defined(LIST_HISTOGRAM)
+  struct Element *anElement;
+  int i;
+#endif
+
+  if( numMoved == 0 )
+    return(LIST_OK);
+  if( toList->maxNumber >= 0 && 
+      toList->number + numMoved > toList->maxNumber )
+    return(LIST_ERROR_FULL);
+
+#if defined(LIST_STATS) || defined(LIST_HISTOGRAM)
+  if( listKeepsStats(fromList) || listKeepsStats(toList) )
+    for(anElement=fromList->head, i=0; anElement; 
+	anElement=anElement->next, i++)
+      {
+#ifdef LIST_STATS
+	updateListStats(fromList, LIST_STATS_DEPARTURES, numMoved-i, now);
+	updateListStats(fromList, LIST_STATS_LATENCY, 
+			now - anElement->arrivalTime, now);
+	updateListStats(fromList, LIST_STATS_TA_OCCUPANCY, numMoved-i, now);
+	updateListStats(toList, LIST_STATS_ARRIVALS, toList->number+i, now);
+	updateListStats(toList, LIST_STATS_TA_OCCUPANCY, 
+			toList->number+i, now);
+#endif // LIST_STATS
+#ifdef LIST_HISTOGRAM
+	updateListHistogram(fromList, LIST_HISTOGRAM_DEPARTURES, numMoved-i);
+	updateListHistogram(fromList, LIST_HISTOGRAM_LATENCY, 
+			    now - anElement->arrivalTime);
+	updateListHistogram(toList, LIST_HISTOGRAM_ARRIVALS, 
+			    toList->number+i);
+#endif // LIST_HISTOGRAM
+	anElement->arrivalTime = now;
+      }
+#endif
+
+  if( toList->number )
+    {
+      toList->tail->next = fromList->head;
+      fromList->head->prev = toList->tail;
+    }
+  else
+    toList->head = fromList->head;
+  toList->tail = fromList->tail;
+  toList->number += numMoved;
+  fromList->head = fromList->tail = NULL;
+  fromList->number = 0;
+
+#ifdef LIST_MINMAX
+  if(toList->number > toList->max)
+    toList->max = toList->number;
+  fromList->min = 0;
+#endif
+
+  if(listDebug)
+    if( !checkList(fromList, "spliceList") || 
+	!checkList(toList, "spliceList") ) 
+      exit(1);
+
+  return(LIST_OK);
+}
+
 /*******************************************************************/
 /*************************** deleteElement() ***********************/
 /*******************************************************************/
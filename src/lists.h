@@ -138,6 +138,7 @@ extern int addElementAfter(struct List *aList, struct Element *afterElement,
                     struct Element *anElement);
 extern int addElementAtHead(struct List *aList, struct Element *anElement);
 extern struct Element *removeElementFromTail(struct List *aList);
+extern int spliceList(struct List *fromList, struct List *toList);
 extern int moveElement(struct List *fromList, struct List *toList, 
                        struct Element *anElement);
 extern struct Element *deleteElement(struct List *aList, 
@@ -0,0 +1,96 @@
+/* ****************************************************************
+ * Copyright Stanford University 1998,99 - All Rights Reserved
+ ****************************************************************** 
+
+ * Permission to use, copy, modify, and distribute this software 
+ * and its documentation for any purpose is hereby granted without 
+ * fee, provided that the above copyright notice appears in all copies
+ * and that both the copyright notice, this permission notice, and 
+ * the following disclaimer appear in supporting documentation, and 
+ * that the name of Stanford University, not be used in advertising or 
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.
+ * 
+ * STANFORD UNIVERSITY, DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND 
+ * FITNESS. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE FOR ANY 
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER 
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION 
+ * OF CONTRACT, NEGLIGENCE OR OTHER ACTION, ARISING OUT OF OR IN 
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * The Sim Web Site : http://klamath.stanford.edu/tools/SIM
+ * The SIM Mailing List: sim-simulator@lists.stanford.edu
+
+ * Send mail to the above email address with "subscribe sim-simulator" in
+ * the body of the message.
+ *
+ */
+
+#include "sim.h"
+
+/*
+ * Cells enter and leave the output queues of a switch only through
+ * these, which keep a bitset per output of the priorities with cells
+ * queued (prioritiesPending) and one per switch of the outputs with
+ * any (outputsPending).  An output action then finds the outputs with
+ * work and each one's highest priority a word at a time.
+ */
+
+void
+enqueueOutputCell(Switch *aSwitch, int output, int priority, Cell *aCell)
+{
+  OutputBuffer *outputBuffer = aSwitch->outputBuffer[output];
+
+  addElement(outputBuffer->fifo[priority], createElement(aCell));
+  BITSET_SET(outputBuffer->prioritiesPending, priority);
+  BITSET_SET(aSwitch->outputsPending, output);
+}
+
+/* Move every cell of fromFifo to the tail of output's fifo for */
+/* priority, and return the first of them (see spliceList()).     */
+struct Element *
+spliceOutputCells(Switch *aSwitch, int output, int priority, 
+		  struct List *fromFifo)
+{
+  OutputBuffer *outputBuffer = aSwitch->outputBuffer[output];
+  struct Element *first = fromFifo->head;
+
+  if( first == NULL )
+    return(NULL);
+  spliceList(fromFifo, outputBuffer->fifo[priority]);
+  BITSET_SET(outputBuffer->prioritiesPending, priority);
+  BITSET_SET(aSwitch->outputsPending, output);
+  return(first);
+}
+
+Cell *
+dequeueOutputCell(Switch *aSwitch, int output, int priority)
+{
+  OutputBuffer *outputBuffer = aSwitch->outputBuffer[output];
+  struct Element *anElement;
+  Cell *aCell;
+
+  anElement = removeElement(outputBuffer->fifo[priority]);
+  aCell = (Cell *) anElement->Object;
+  destroyElement(anElement);
+  if( outputBuffer->fifo[priority]->number == 0 )
+    {
+      BITSET_RESET(outputBuffer->prioritiesPending, priority);
+      if( !bitsetAnySet(outputBuffer->prioritiesPending, 
+			aSwitch->numPriorities) )
+	BITSET_RESET(aSwitch->outputsPending, output);
+    }
+  return(aCell);
+}
+
+/* Highest (lowest numbered) priority with cells at output, or NONE. */
+int
+outputHighestPriority(Switch *aSwitch, int output)
+{
+  return( bitsetFirstSet(aSwitch->outputBuffer[output]->prioritiesPending,
+			 aSwitch->numPriorities) );
+}
@@ -0,0 +1,568 @@
+/* ****************************************************************
+ * Copyright Stanford University 1998,99 - All Rights Reserved
+ ****************************************************************** 
+
+ * Permission to use, copy, modify, and distribute this software 
+ * and its documentation for any purpose is hereby granted without 
+ * fee, provided that the above copyright notice appears in all copies
+ * and that both the copyright notice, this permission notice, and 
+ * the following disclaimer appear in supporting documentation, and 
+ * that the name of Stanford University, not be used in advertising or 
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.
+ * 
+ * STANFORD UNIVERSITY, DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND 
+ * FITNESS. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE FOR ANY 
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER 
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION 
+ * OF CONTRACT, NEGLIGENCE OR OTHER ACTION, ARISING OUT OF OR IN 
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * The Sim Web Site : http://klamath.stanford.edu/tools/SIM
+ * The SIM Mailing List: sim-simulator@lists.stanford.edu
+
+ * Send mail to the above email address with "subscribe sim-simulator" in
+ * the body of the message.
+ *
+ */
+
+
+/*
+  schedbench: Cost of one scheduling decision, without a simulation.
+
+  Builds a switch with createSwitch() and a crossbar fabric, fills its
+  VOQs with one of a few crafted occupancy patterns, then for each entry
+  of algorithmTable calls SCHEDULING_INIT once and SCHEDULING_EXEC over
+  and over. Each call is a cell time: after it the matched cells leave
+  the head of their VOQs and come back at the tail as that cell time's
+  arrivals, and now moves on. The VOQ lengths, and so the pattern and
+  its maximum size match, stay as they were filled, while cell ages,
+  round robin pointers, frames and reservations evolve as in sim. The
+  switch is filled afresh for each algorithm, and now never goes back.
+  Only SCHEDULING_EXEC is timed, less the cost of reading the clock.
+
+  One CSV line is printed per (algorithm, pattern, N):
+    algorithm,pattern,N,iterations,ns_per_decision,match_size,
+    max_match_size,allocs_per_decision
+  match_size is the mean over the timed calls and max_match_size the
+  maximum size match of the requests. Algorithms the patterns cannot
+  exercise are listed with NA (see benchable()). allocs is
+  the number of malloc(), calloc(), realloc() and posix_memalign() calls
+  per decision; it is -1 unless built with COUNT_ALLOCS (see "make bench").
+
+  Patterns (L is a random length in 1..MAX_QUEUE):
+    full      every VOQ holds L cells.
+    uniform   every VOQ holds L cells with probability 1/2.
+    diagonal  input i holds 2L cells for output i and L for output i+1.
+    hotspot   every input holds L cells for output 0, and 1 cell for
+              each other output with probability 1/4.
+    sparse    every VOQ holds 1 cell with probability 2/N.
+*/
+
+#include <unistd.h>
+#include <time.h>
+#include "sim.h"
+#include "algorithm.h"
+#include "fabric.h"
+
+#define MAX_QUEUE 8		/* Longest VOQ built by a pattern */
+#define MAX_AGE 1000		/* Oldest head of line cell, in cell times */
+#define DEFAULT_MIN_TIME 200	/* Milliseconds spent timing each algorithm */
+#define MAX_SIZES 32
+
+typedef enum {
+  PATTERN_FULL,
+  PATTERN_UNIFORM,
+  PATTERN_DIAGONAL,
+  PATTERN_HOTSPOT,
+  PATTERN_SPARSE,
+  NUM_PATTERNS
+} Pattern;
+
+static char *patternName[NUM_PATTERNS] = 
+  {"full", "uniform", "diagonal", "hotspot", "sparse"};
+
+/* Globals otherwise defined in sim.c */
+long now=0;
+long resetStatsTime=NONE;
+unsigned long globalSeed=0;
+Switch **switches;
+int numSwitches=1;
+
+static long numAllocs=0;
+
+static void usage();
+static int inList();
+static int benchable();
+static void fillSwitch();
+static void fillVOQ();
+static void emptySwitch();
+static void fifosChanged();
+static void benchAlgorithm();
+static int moveMatchedCells();
+static long elapsedNs();
+static long clockCost();
+
+void FatalError();
+
+/**************************************************/
+/*************main function ***********************/
+/**************************************************/
+int main(argc, argv)
+  int argc;
+char **argv;
+{
+  extern char *optarg;
+  extern int optind;
+  extern int opterr;
+  int c;
+
+  int sizes[MAX_SIZES] = {8, 16, 32, 64, 128, 256};
+  int numSizes = 6;
+  char *algorithmList = NULL;
+  char *patternList = NULL;
+  long minTime = DEFAULT_MIN_TIME;
+  FILE *fp = stdout;
+
+  Switch *aSwitch;
+  Scheduler *schedulers;
+  char *initialized;
+  void *maxMatchState;
+  int numAlgorithms, alg, size, pattern, maxSize;
+  long clockNs;
+  char *token;
+  /* As with config.c's argVector, the entries past argc must be valid */
+  /* strings: the modules' getopt loops step optind past the end.      */
+  static char *noArgs[] = {"nothing", "", "", ""};
+
+  opterr=0;
+  optind=1;
+  while( (c = getopt(argc, argv, "hn:a:p:t:u:o:")) != -1 )
+    {
+      switch (c)
+	{
+	case 'n':	/* Comma separated list of switch sizes */
+	  numSizes = 0;
+	  for(token=strtok(optarg, ","); token && numSizes<MAX_SIZES; 
+	      token=strtok(NULL, ","))
+	    sizes[numSizes++] = atoi(token);
+	  break;
+	case 'a':	/* Comma separated list of algorithms */
+	  algorithmList = optarg;
+	  break;
+	case 'p':	/* Comma separated list of patterns */
+	  patternList = optarg;
+	  break;
+	case 't':	/* Minimum time per measurement, in ms */
+	  minTime = atol(optarg);
+	  break;
+	case 'u':	/* Random seed */
+	  globalSeed = atol(optarg);
+	  break;
+	case 'o':	/* Output file */
+	  if( (fp = fopen(optarg, "w")) == NULL )
+	    FatalError("Cannot open output file");
+	  break;
+	case 'h':
+	default:
+	  usage(argv[0]);
+	  exit(0);
+	}
+    }
+
+  /* The algorithms print their settings to stdout: send them to stderr */
+  /* and keep stdout for the results.                                   */
+  if( fp == stdout )
+    {
+      fp = fdopen(dup(fileno(stdout)), "w");
+      dup2(fileno(stderr), fileno(stdout));
+    }
+
+  for(numAlgorithms=0; algorithmTable[numAlgorithms].name; numAlgorithms++);
+  schedulers = (Scheduler *) malloc(numAlgorithms*sizeof(Scheduler));
+  initialized = (char *) malloc(numAlgorithms);
+
+  clockNs = clockCost();
+  fprintf(fp, "algorithm,pattern,N,iterations,ns_per_decision,"
+	  "match_size,max_match_size,allocs_per_decision\n");
+  fflush(fp);
+
+  for(size=0; size<numSizes; size++)
+    {
+      aSwitch = createSwitch(0, sizes[size], sizes[size], 1);
+      aSwitch->fabric.fabricAction = (void (*) ()) 
+	findFunction("crossbar", fabricTable);
+      (aSwitch->fabric.fabricAction)(FABRIC_INIT, aSwitch, 1, noArgs);
+      memset(schedulers, 0, numAlgorithms*sizeof(Scheduler));
+      memset(initialized, 0, numAlgorithms);
+      maxMatchState = NULL;
+      now = 2*MAX_AGE;
+
+      for(pattern=0; pattern<NUM_PATTERNS; pattern++)
+	{
+	  if( patternList && !inList(patternList, patternName[pattern]) )
+	    continue;
+	  maxSize = NONE;
+
+	  for(alg=0; alg<numAlgorithms; alg++)
+	    {
+	      if( algorithmList && 
+		  !inList(algorithmList, algorithmTable[alg].name) )
+		continue;
+
+	      srand48(globalSeed + sizes[size]*NUM_PATTERNS + pattern);
+	      fillSwitch(aSwitch, pattern);
+	      if( maxSize == NONE )
+		maxSize = findSizeMaxMatch(aSwitch, &maxMatchState);
+	      if( !benchable(algorithmTable[alg].name) )
+		{
+		  fprintf(fp, "%s,%s,%d,0,NA,NA,%d,NA\n", 
+			  algorithmTable[alg].name, patternName[pattern],
+			  aSwitch->numInputs, maxSize);
+		  emptySwitch(aSwitch);
+		  continue;
+		}
+
+	      /* Each algorithm keeps its own state from pattern to pattern. */
+	      aSwitch->scheduler = schedulers[alg];
+	      aSwitch->scheduler.schedulingAlgorithm = (void (*) ())
+		algorithmTable[alg].func;
+	      if( !initialized[alg] )
+		{
+		  initialized[alg] = 1;
+		  optind=1;
+		  (aSwitch->scheduler.schedulingAlgorithm)
+		    (SCHEDULING_INIT, aSwitch, 1, noArgs);
+		  (aSwitch->scheduler.schedulingAlgorithm)
+		    (SCHEDULING_INIT_STATS, aSwitch, aSwitch, NULL);
+		}
+	      else
+		fifosChanged(aSwitch);
+	      benchAlgorithm(fp, aSwitch, algorithmTable[alg].name, 
+			     patternName[pattern], maxSize, minTime, clockNs);
+	      schedulers[alg] = aSwitch->scheduler;
+	      emptySwitch(aSwitch);
+	    }
+	}
+    }
+
+  fclose(fp);
+  exit(0);
+}
+
+/**************************************************************/
+static void usage(name)
+  char *name;
+{
+  fprintf(stderr, "usage: %s \n", name);
+  fprintf(stderr, "    -h This help message \n");
+  fprintf(stderr, "    -n sizes. Default: 8,16,32,64,128,256\n");
+  fprintf(stderr, "    -a algorithms. Default: all\n");
+  fprintf(stderr, "    -p patterns (full,uniform,diagonal,hotspot,sparse)."
+	  " Default: all\n");
+  fprintf(stderr, "    -t ms per measurement. Default: %d\n", 
+	  DEFAULT_MIN_TIME);
+  fprintf(stderr, "    -u globalSeed. Default: 0 \n");  
+  fprintf(stderr, "    -o output file. Default: stdout\n");
+}
+
+/* Is name one of the entries of a comma separated list? */
+static int inList(list, name)
+  char *list, *name;
+{
+  int length = strlen(name);
+  char *entry;
+
+  for(entry=list; entry; entry=strchr(entry, ','))
+    {
+      if( *entry == ',' )
+	entry++;
+      if( !strncmp(entry, name, length) && 
+	  (entry[length] == ',' || entry[length] == '\0') )
+	return(1);
+    }
+  return(0);
+}
+
+/* 
+   Can the algorithm be timed on the patterns? The multicast algorithms
+   find no multicast cells, and future only schedules the cells it sees
+   arrive, never a backlog that was already queued.
+*/
+static int benchable(name)
+  char *name;
+{
+  return( !strstr(name, "mcast") && strcmp(name, "future") );
+}
+
+/**************************************************************/
+static void fillSwitch(aSwitch, pattern)
+  Switch *aSwitch;
+Pattern pattern;
+{
+  int input, output, length;
+  int numPorts = aSwitch->numOutputs;
+
+  for(input=0; input<aSwitch->numInputs; input++)
+    for(output=0; output<numPorts; output++)
+      {
+	length = 1 + lrand48() % MAX_QUEUE;
+	switch( pattern )
+	  {
+	  case PATTERN_FULL:
+	    break;
+	  case PATTERN_UNIFORM:
+	    if( lrand48() & 1 )
+	      length = 0;
+	    break;
+	  case PATTERN_DIAGONAL:
+	    if( output == input % numPorts )
+	      length *= 2;
+	    else if( output != (input+1) % numPorts )
+	      length = 0;
+	    break;
+	  case PATTERN_HOTSPOT:
+	    if( output != 0 )
+	      length = (lrand48() % 4) ? 0 : 1;
+	    break;
+	  case PATTERN_SPARSE:
+	    length = (lrand48() % numPorts < 2) ? 1 : 0;
+	    break;
+	  default:
+	    length = 0;
+	  }
+	fillVOQ(aSwitch, input, output, length);
+      }
+}
+
+/* 
+   Queue length cells, oldest first. The head of line cell arrived up to
+   MAX_AGE cell times ago and the output queued departure times are
+   spread over the next 2N cell times.
+*/
+static void fillVOQ(aSwitch, input, output, length)
+  Switch *aSwitch;
+int input, output, length;
+{
+  Cell *aCell;
+  long arrivalTime;
+  int i;
+
+  arrivalTime = now - length - lrand48() % MAX_AGE;
+  for(i=0; i<length; i++, arrivalTime++)
+    {
+      aCell = createCell(output, UCAST, DEFAULT_PRIORITY);
+      aCell->commonStats.arrivalTime = arrivalTime;
+      aCell->commonStats.headArrivalTime = arrivalTime;
+      aCell->commonStats.fabricArrivalTime = arrivalTime;
+      aCell->commonStats.oqDepartTime = 
+	now + lrand48() % (2*aSwitch->numOutputs);
+      aCell->commonStats.inputPort = input;
+      addElement(aSwitch->inputBuffer[input]->fifo[output], 
+		 createElement(aCell));
+    }
+}
+
+/**************************************************************/
+static void emptySwitch(aSwitch)
+  Switch *aSwitch;
+{
+  int input, output;
+  struct List *fifo;
+  struct Element *anElement;
+
+  for(input=0; input<aSwitch->numInputs; input++)
+    for(output=0; output<aSwitch->numOutputs; output++)
+      {
+	fifo = aSwitch->inputBuffer[input]->fifo[output];
+	while( fifo->number )
+	  {
+	    anElement = removeElement(fifo);
+	    destroyCell((Cell *) anElement->Object);
+	    destroyElement(anElement);
+	  }
+      }
+}
+
+/* The fifos were filled behind the input action's back: tell the */
+/* scheduler, if it follows them, that they have all changed.      */
+static void fifosChanged(aSwitch)
+  Switch *aSwitch;
+{
+  int input, output;
+
+  if( aSwitch->scheduler.fifoChanged == NULL )
+    return;
+  for(input=0; input<aSwitch->numInputs; input++)
+    for(output=0; output<aSwitch->numOutputs; output++)
+      (aSwitch->scheduler.fifoChanged)(aSwitch, input, output);
+}
+
+/*
+  Time SCHEDULING_EXEC, doubling the number of calls until a run takes
+  at least minTime ms of wall time. Each call starts from an empty crossbar matrix,
+  as in sim, and its match is then carried out by moveMatchedCells().
+  A first, untimed call lets the algorithm set up anything it builds
+  lazily.
+*/
+static void benchAlgorithm(fp, aSwitch, name, pattern, maxSize, minTime,
+			   clockNs)
+  FILE *fp;
+Switch *aSwitch;
+char *name, *pattern;
+int maxSize;
+long minTime, clockNs;
+{
+  struct timespec start, stop, runStart, runStop;
+  long iterations, i, allocs, ns, matchSize;
+  int output;
+  int numFabricOutputs = 
+    aSwitch->numOutputs * aSwitch->fabric.Xbar_numOutputLines;
+
+  for(iterations=0; ; iterations=(iterations ? 2*iterations : 1))
+    {
+      allocs = numAllocs;
+      ns = 0;
+      matchSize = 0;
+      clock_gettime(CLOCK_MONOTONIC, &runStart);
+      for(i=0; i<(iterations ? iterations : 1); i++)
+	{
+	  for(output=0; output<numFabricOutputs; output++)
+	    {
+	      aSwitch->fabric.Xbar_matrix[output].input = NONE;
+	      aSwitch->fabric.Xbar_matrix[output].cell = NULL;
+	    }
+	  clock_gettime(CLOCK_MONOTONIC, &start);
+	  (aSwitch->scheduler.schedulingAlgorithm)(SCHEDULING_EXEC, aSwitch);
+	  clock_gettime(CLOCK_MONOTONIC, &stop);
+	  ns += elapsedNs(&start, &stop) - clockNs;
+	  matchSize += moveMatchedCells(aSwitch);
+	}
+      clock_gettime(CLOCK_MONOTONIC, &runStop);
+      allocs = numAllocs - allocs;
+      if( iterations && elapsedNs(&runStart, &runStop) >= minTime*1000000L )
+	break;
+    }
+
+  fprintf(fp, "%s,%s,%d,%ld,%.1f,%.1f,%d,", name, pattern, 
+	  aSwitch->numInputs, iterations, (double) ns / iterations, 
+	  (double) matchSize / iterations, maxSize);
+#ifdef COUNT_ALLOCS
+  fprintf(fp, "%.2f\n", (double) allocs / iterations);
+#else
+  fprintf(fp, "-1\n");
+#endif
+  fflush(fp);
+}
+
+/*
+  End the cell time: each matched cell leaves the head of its VOQ and
+  is queued again at the tail as an arrival of the next cell time.
+  Returns the size of the match.
+*/
+static int moveMatchedCells(aSwitch)
+  Switch *aSwitch;
+{
+  int fabricOutput, input, output, matchSize=0;
+  int numFabricOutputs = 
+    aSwitch->numOutputs * aSwitch->fabric.Xbar_numOutputLines;
+  struct List *fifo;
+  struct Element *anElement;
+  Cell *aCell;
+
+  now++;
+  for(fabricOutput=0; fabricOutput<numFabricOutputs; fabricOutput++)
+    {
+      input = aSwitch->fabric.Xbar_matrix[fabricOutput].input;
+      if( input == NONE )
+	continue;
+      output = fabricOutput / aSwitch->fabric.Xbar_numOutputLines;
+      fifo = aSwitch->inputBuffer[input]->fifo[output];
+      matchSize++;
+      if( fifo->number == 0 )
+	continue;
+      anElement = removeElement(fifo);
+      aCell = (Cell *) anElement->Object;
+      aCell->commonStats.arrivalTime = now;
+      aCell->commonStats.headArrivalTime = now;
+      aCell->commonStats.fabricArrivalTime = now;
+      aCell->commonStats.oqDepartTime = 
+	now + lrand48() % (2*aSwitch->numOutputs);
+      if( fifo->number )
+	((Cell *) fifo->head->Object)->commonStats.headArrivalTime = now;
+      addElement(fifo, anElement);
+      if( aSwitch->scheduler.fifoChanged )
+	(aSwitch->scheduler.fifoChanged)(aSwitch, input, output);
+    }
+  return(matchSize);
+}
+
+/* Mean time between two back to back reads of the clock. */
+static long clockCost()
+{
+  struct timespec start, stop;
+  long i, ns=0;
+
+  for(i=0; i<1000; i++)
+    {
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      clock_gettime(CLOCK_MONOTONIC, &stop);
+      ns += elapsedNs(&start, &stop);
+    }
+  return(ns/1000);
+}
+
+static long elapsedNs(start, stop)
+  struct timespec *start, *stop;
+{
+  return( (stop->tv_sec - start->tv_sec)*1000000000L + 
+	  (stop->tv_nsec - start->tv_nsec) );
+}
+
+/***************************************************************/
+void FatalError(aString)
+  char *aString;
+{
+  fprintf(stderr, "schedbench: Fatal Error at time %ld.\n", now);
+  fprintf(stderr, "schedbench: %s.\n", aString);
+  exit(1);
+}
+
+#ifdef COUNT_ALLOCS
+/***************************************************************/
+/* Linked with -Wl,--wrap for each of these, so that every      */
+/* allocation made by the schedulers is counted.                 */
+/***************************************************************/
+void *__real_malloc(size_t);
+void *__real_calloc(size_t, size_t);
+void *__real_realloc(void *, size_t);
+int __real_posix_memalign(void **, size_t, size_t);
+
+void *__wrap_malloc(size_t size)
+{
+  numAllocs++;
+  return( __real_malloc(size) );
+}
+
+void *__wrap_calloc(size_t number, size_t size)
+{
+  numAllocs++;
+  return( __real_calloc(number, size) );
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+  numAllocs++;
+  return( __real_realloc(ptr, size) );
+}
+
+int __wrap_posix_memalign(void **ptr, size_t alignment, size_t size)
+{
+  numAllocs++;
+  return( __real_posix_memalign(ptr, alignment, size) );
+}
+#endif // COUNT_ALLOCS
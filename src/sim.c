@@ -347,34 +347,54 @@ char **argv;
 	}
 
 
+      /******************************************************/
+      /********* Cells due off links between switches *******/
+      /******************************************************/
+      /* Links take a cell time or more: these cells were all */
+      /* sent in earlier cell times (see topology.c).          */
+      for( switchNumber=0; switchNumber<numSwitches; switchNumber++)
+	if( switches[switchNumber]->outputLink )
+	  receiveLinkCells(switches[switchNumber]);
+
       /******************************************************/
       /********* Determine new traffic **********************/
       /************** for every switch **********************/
       /******************************************************/
       for( switchNumber=0; switchNumber<numSwitches; switchNumber++)
 	{
-	  if(now%trafficPeriod) continue;
+	  aSwitch = switches[switchNumber];
 
-	  if(debug_sim)
+	  if( now%trafficPeriod == 0 )
 	    {
-	      printf("SWITCH %d:\n", switchNumber);
-	      printf("---------\n");
+	      if(debug_sim)
+		{
+		  printf("SWITCH %d:\n", switchNumber);
+		  printf("---------\n");
+		}
+
+	      /*******************************************************/
+	      /* The following is temporary until separate traffic  */
+	      /* units are implemented: */
+	      /*******************************************************/
+	      /* Determine new traffic for each input of switch */
+	      if(debug_sim) printf("	New traffic\n");
+
+	      for( input=0; input<aSwitch->numInputs; input++ )
+		{
+		  if( (aSwitch->inputBuffer[input]->trafficModel)
+		      (TRAFFIC_GENERATE, aSwitch, input, NULL, NULL) == 
+		      STOP_SIMULATION)
+		    simStopped = STOP_SIMULATION;
+		}
 	    }
-	  aSwitch = switches[switchNumber];
 
-	  /***********************************************************/
-	  /* The following is temporary until separate traffic units */
-	  /* are implemented: */
-	  /***********************************************************/
-	  /* Determine new traffic for each input of switch */
-	  if(debug_sim) printf("	New traffic\n");
-
-	  for( input=0; input<aSwitch->numInputs; input++ )
+	  /* Input action admits the new cells, and those off */
+	  /* links, in one call. */
+	  if( aSwitch->arrivals.numCells )
 	    {
-	      if( (aSwitch->inputBuffer[input]->trafficModel)
-		  (TRAFFIC_GENERATE, aSwitch, input, NULL, NULL) == 
-		  STOP_SIMULATION)
-		simStopped = STOP_SIMULATION;
+	      (aSwitch->inputAction)(INPUTACTION_RECEIVE_BATCH, aSwitch, 
+				     NONE, NULL);
+	      aSwitch->arrivals.numCells = 0;
 	    }
 	  if(debug_sim) printf("	Finished New traffic\n");
 
@@ -37,6 +37,7 @@
 #include <sys/types.h>
 #include <math.h>
 #include "bitmap.h"
+#include "bitset.h"
 #include "stat.h"
 #include "histogram.h"
 #include "lists.h"
@@ -58,10 +59,28 @@ extern OutputBuffer *createOutputBuffer();
 extern InputBuffer  *createLiteInputBuffer();
 extern OutputBuffer *createLiteOutputBuffer();
 
+extern void	enqueueOutputCell();
+extern Cell    *dequeueOutputCell();
+extern struct Element *spliceOutputCells();
+extern int	outputHighestPriority();
+
 extern Cell     *createCell();
 extern void     destroyCell();
 extern Cell    *createMulticastCell();
 extern Cell    *copyCell();
+extern Cell    *shareCell();
+extern Cell    *unshareCell();
+extern void     releaseCellCopy();
+extern void     deliverCell();
+extern double  *trafficMatrixRow();
+extern void     createLink();
+extern void     createNetwork();
+extern int      networkAddress();
+extern void     setAddress();
+extern void     setRoute();
+extern void     addressCell();
+extern void     sendLinkCell();
+extern void     receiveLinkCells();
 extern double   erand48();
 extern double   drand48();
 extern long   lrand48();
@@ -0,0 +1,294 @@
+/* ****************************************************************
+ * Copyright Stanford University 1998,99 - All Rights Reserved
+ ****************************************************************** 
+
+ * Permission to use, copy, modify, and distribute this software 
+ * and its documentation for any purpose is hereby granted without 
+ * fee, provided that the above copyright notice appears in all copies
+ * and that both the copyright notice, this permission notice, and 
+ * the following disclaimer appear in supporting documentation, and 
+ * that the name of Stanford University, not be used in advertising or 
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.
+ * 
+ * STANFORD UNIVERSITY, DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND 
+ * FITNESS. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE FOR ANY 
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER 
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION 
+ * OF CONTRACT, NEGLIGENCE OR OTHER ACTION, ARISING OUT OF OR IN 
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/*
+ * The Sim Web Site : http://klamath.stanford.edu/tools/SIM
+ * The SIM Mailing List: sim-simulator@lists.stanford.edu
+
+ * Send mail to the above email address with "subscribe sim-simulator" in
+ * the body of the message.
+ *
+ */
+
+
+/*
+  Links between switches. A link carries the cells leaving an output
+  of one switch to an input of another, delay cell times later. Each
+  link is a delay line of delay slots: an output sends at most one
+  cell per cell time, so the cell sent at time t waits in slot
+  t % delay and is handed to the next switch at the start of cell
+  time t+delay, before the slot is used again.
+
+  Every output of every switch has a network address,
+  networkAddress(switch, port) = switch * P + port, where P is the
+  number of outputs of the largest switch. A unicast cell is given
+  the address it is for when its traffic model hands it to its first
+  switch: the address set for its VCI there (see setAddress()), or by
+  default that switch's output of the same number. It keeps the
+  address from hop to hop, and at each switch, the first included,
+  the route table keyed on addresses gives its output (see
+  setRoute()). By default a switch sends an address to the output
+  numbered as its port. Multicast cells are unicast once they leave
+  a switch, each copy addressed to the output it left by.
+
+  The switches are simulated one after another in a single thread.
+  There is no parallel execution: although every link takes at least
+  a cell time, so that within a cell time the switches do not depend
+  on one another, nothing here partitions them or runs them apart.
+*/
+
+#include "sim.h"
+
+extern void FatalError(); /* in sim.c */
+
+static int linkInto();
+static int numNetworkPorts();
+
+
+/* Link output of aSwitch to input toInput of switch toSwitch. */
+void
+createLink(aSwitch, output, toSwitch, toInput, delay)
+  Switch *aSwitch;
+int output, toSwitch, toInput, delay;
+{
+  Link *link;
+
+  if( output < 0 || output >= aSwitch->numOutputs )
+    FatalError("createLink(): no such output");
+  if( toSwitch < 0 || toSwitch >= numSwitches )
+    FatalError("createLink(): no such switch");
+  if( toInput < 0 || toInput >= switches[toSwitch]->numInputs )
+    FatalError("createLink(): no such input");
+  if( delay < 1 )
+    FatalError("createLink(): link delay must be at least 1");
+
+  if( aSwitch->outputLink == NULL )
+    {
+      aSwitch->outputLink = (Link **) 
+	calloc(aSwitch->numOutputs, sizeof(Link *));
+      if( aSwitch->outputLink == NULL )
+	FatalError("createLink(): Malloc failed.");
+    }
+  if( aSwitch->outputLink[output] )
+    FatalError("createLink(): output already has a link");
+  if( linkInto(toSwitch, toInput) )
+    FatalError("createLink(): input already has a link");
+
+  link = (Link *) malloc(sizeof(Link));
+  if( link == NULL )
+    FatalError("createLink(): Malloc failed.");
+  link->toSwitch = toSwitch;
+  link->toInput = toInput;
+  link->delay = delay;
+  link->line = (Cell **) calloc(delay, sizeof(Cell *));
+  if( link->line == NULL )
+    FatalError("createLink(): Malloc failed.");
+  aSwitch->outputLink[output] = link;
+}
+
+/* Whether a link already leads to input of switch toSwitch. */
+static int
+linkInto(toSwitch, toInput)
+  int toSwitch, toInput;
+{
+  int switchNumber, output;
+  Link *link;
+
+  for(switchNumber=0; switchNumber<numSwitches; switchNumber++)
+    {
+      if( switches[switchNumber]->outputLink == NULL )
+	continue;
+      for(output=0; output<switches[switchNumber]->numOutputs; output++)
+	{
+	  link = switches[switchNumber]->outputLink[output];
+	  if( link && link->toSwitch == toSwitch && link->toInput == toInput )
+	    return(YES);
+	}
+    }
+  return(NO);
+}
+
+/* Ports per switch in the network address space. */
+static int
+numNetworkPorts()
+{
+  static int numPorts = 0;
+  int switchNumber;
+
+  if( numPorts == 0 )
+    for(switchNumber=0; switchNumber<numSwitches; switchNumber++)
+      if( switches[switchNumber]->numOutputs > numPorts )
+	numPorts = switches[switchNumber]->numOutputs;
+  return(numPorts);
+}
+
+/* Network address of output port of switch switchNumber. */
+int
+networkAddress(switchNumber, port)
+  int switchNumber, port;
+{
+  if( switchNumber < 0 || switchNumber >= numSwitches )
+    FatalError("networkAddress(): no such switch");
+  if( port < 0 || port >= switches[switchNumber]->numOutputs )
+    FatalError("networkAddress(): no such port");
+  return( switchNumber * numNetworkPorts() + port );
+}
+
+/* 
+  Make every switch part of the network: give each a route table
+  sending each address to the output numbered as its port, where the
+  switch has one. Called once, before any setAddress() or setRoute().
+*/
+void
+createNetwork()
+{
+  Switch *aSwitch;
+  int switchNumber, address, port;
+  int numPorts = numNetworkPorts();
+  int numAddresses = numSwitches * numPorts;
+
+  for(switchNumber=0; switchNumber<numSwitches; switchNumber++)
+    {
+      aSwitch = switches[switchNumber];
+      aSwitch->route = (int *) malloc(numAddresses * sizeof(int));
+      if( aSwitch->route == NULL )
+	FatalError("createNetwork(): Malloc failed.");
+      for(address=0; address<numAddresses; address++)
+	{
+	  port = address % numPorts;
+	  aSwitch->route[address] = (port < aSwitch->numOutputs) ? port : NONE;
+	}
+    }
+}
+
+/* Unicast cells made with vci at aSwitch are for network address. */
+void
+setAddress(aSwitch, vci, address)
+  Switch *aSwitch;
+int vci, address;
+{
+  int n;
+
+  if( vci < 0 || vci >= aSwitch->numOutputs )
+    FatalError("setAddress(): no such VCI");
+  if( aSwitch->address == NULL )
+    {
+      aSwitch->address = (int *) malloc(aSwitch->numOutputs * sizeof(int));
+      if( aSwitch->address == NULL )
+	FatalError("setAddress(): Malloc failed.");
+      for(n=0; n<aSwitch->numOutputs; n++)
+	aSwitch->address[n] = networkAddress(aSwitch->switchNumber, n);
+    }
+  aSwitch->address[vci] = address;
+}
+
+/* At aSwitch, cells for network address go to output. */
+void
+setRoute(aSwitch, address, output)
+  Switch *aSwitch;
+int address, output;
+{
+  if( aSwitch->route == NULL )
+    FatalError("setRoute(): switch is not in a network");
+  if( output < 0 || output >= aSwitch->numOutputs )
+    FatalError("setRoute(): no such output");
+  aSwitch->route[address] = output;
+}
+
+/* 
+  aCell, new from a traffic model at aSwitch, enters the network:
+  give a unicast cell its network address and route it to its output.
+  A multicast cell keeps the outputs of its bitmap.
+*/
+void
+addressCell(aSwitch, aCell)
+  Switch *aSwitch;
+Cell *aCell;
+{
+  if( aCell->multicast == MCAST )
+    return;
+  if( aSwitch->address )
+    aCell->destination = aSwitch->address[aCell->vci];
+  else
+    aCell->destination = aCell->vci + 
+      aSwitch->switchNumber * numNetworkPorts();
+  aCell->vci = aSwitch->route[aCell->destination];
+  if( aCell->vci == NONE )
+    FatalError("addressCell(): cell has no route at its first switch");
+}
+
+/* Put aCell, leaving aSwitch by output, on the output's link. */
+void
+sendLinkCell(aSwitch, output, aCell)
+  Switch *aSwitch;
+int output;
+Cell *aCell;
+{
+  Link *link = aSwitch->outputLink[output];
+  int slot = now % link->delay;
+
+  if( link->line[slot] )
+    FatalError("sendLinkCell(): output sent two cells in a cell time");
+
+  /* A multicast copy (only ever at its first switch) is for the */
+  /* output it leaves by.                                        */
+  if( aCell->multicast == MCAST )
+    aCell->destination = networkAddress(aSwitch->switchNumber, output);
+  link->line[slot] = aCell;
+
+  if(debug_sim)
+    printf("Switch %d output %d: cell onto link to switch %d input %d\n",
+	   aSwitch->switchNumber, output, link->toSwitch, link->toInput);
+}
+
+/* Hand the cells due now on aSwitch's links to the switches they lead to. */
+void
+receiveLinkCells(aSwitch)
+  Switch *aSwitch;
+{
+  Switch *toSwitch;
+  Link *link;
+  Cell *aCell;
+  int output, slot;
+
+  for(output=0; output<aSwitch->numOutputs; output++)
+    {
+      if( (link = aSwitch->outputLink[output]) == NULL )
+	continue;
+      slot = now % link->delay;
+      if( (aCell = link->line[slot]) == NULL )
+	continue;
+      link->line[slot] = NULL;
+
+      toSwitch = switches[link->toSwitch];
+      aCell->vci = toSwitch->route[aCell->destination];
+      if( aCell->vci == NONE )
+	FatalError("receiveLinkCells(): cell has no route at next switch");
+      if( aCell->multicast == MCAST )
+	{
+	  aCell->multicast = UCAST;
+	  bitmapReset(&aCell->outputs);
+	}
+      deliverCell(toSwitch, link->toInput, aCell);
+    }
+}
@@ -55,8 +55,10 @@ extern long resetStatsTime;
 typedef struct Cell *CellPtr;
 typedef struct {
   int vci;
-  int priority;   
-  int multicast;	/* Set if cell is multicast. */
+  int destination;	/* Network address it is for: see topology.c */
+  unsigned char priority;   
+  unsigned char multicast;	/* Set if cell is multicast. */
+  short numShares;	/* Outputs sharing this multicast copy: see shareCell() */
   Bitmap outputs;	/* Which outputs to send this cell to at this switch */
 
   /* Switch dependent information, derived from VCI and specific to switch.*/
@@ -93,6 +95,23 @@ typedef struct {
   
 } Cell;
 
+/* The copy of a multicast cell made in the current cell time. Later */
+/* copies of the cell in the same cell time share it: see shareCell(). */
+typedef struct {
+  Cell *original;
+  Cell *copy;
+  long time;
+} CellCopy;
+
+/* Cells handed to a switch by its traffic models in this cell time, */
+/* admitted together by the input action: see deliverCell(). */
+typedef struct {
+  int numCells;
+  int maxCells;
+  int *input;		/* Arrival input of each cell */
+  Cell **cell;
+} ArrivalBatch;
+
 /****************************************************************/
 /******* Structure and Elements of a Switch *********************/
 /****************************************************************/
@@ -109,6 +128,8 @@ typedef struct {
   int  numOverflows;		/* Total number of cells dropped at this input. */
   
   struct List **mcastFifo;		/* Multicast queue for this input. */
+  BitsetWord *fifosPending;	/* Unicast fifos with cells, kept by the */
+				/* input action (inputQueue.c). */
 
 } InputBuffer;
 
@@ -121,6 +142,10 @@ typedef struct {
   void 		(*mcast_schedulingAlgorithm)();
   void 		*mcast_schedulingState;	/* Algorithm dependent state      */	
   void		*mcast_schedulingStats;	/* Algorithm dependent statistics */ 		
+
+  /* If set, called (aSwitch, input, fifo) as each unicast input fifo */
+  /* gains or loses cells: see inputQueue.c.                         */
+  void		(*fifoChanged)();
 } Scheduler;
 
 typedef struct {
@@ -148,6 +173,32 @@ typedef struct {
 #define Xbar_matrix Interconnect.Crossbar.Matrix
 #define Xbar_numOutputLines Interconnect.Crossbar.NumOutputs
 
+    /* Buffered crossbar fabric: a fifo at each crosspoint */
+    struct {
+      int Size;			/* Cells held by each crosspoint. */
+      struct List **Crosspoint;	/* Indexed input*numOutputs+output */
+    } BufferedCrossbar;
+#define Bxbar_size Interconnect.BufferedCrossbar.Size
+#define Bxbar_crosspoint Interconnect.BufferedCrossbar.Crosspoint
+
+    /* Clos fabric: middle module queues for each output */
+    struct {
+      int PortsPerModule;	/* n: ports of an input or output module */
+      int NumMiddle;		/* m: middle modules */
+      int BufferSize;		/* Cells a middle module holds per output */
+      struct List **Middle;	/* Indexed middle*numOutputs+output */
+    } Clos;
+#define Clos_portsPerModule Interconnect.Clos.PortsPerModule
+#define Clos_numMiddle Interconnect.Clos.NumMiddle
+#define Clos_bufferSize Interconnect.Clos.BufferSize
+#define Clos_middle Interconnect.Clos.Middle
+
+    /* Load balanced fabric: intermediate port fifos for each output */
+    struct {
+      struct List **Intermediate;	/* Indexed port*numOutputs+output */
+    } LoadBalanced;
+#define LB_intermediate Interconnect.LoadBalanced.Intermediate
+
     /* Other interconnects (e.g buffered Banyan) will go here. */
   } Interconnect;
 
@@ -159,9 +210,19 @@ typedef struct {
 typedef struct OutputBuffer *OutputBufferPtr;
 typedef struct {
   struct List **fifo;           /* add priorities to the output buffer queues */ 
+  BitsetWord *prioritiesPending; /* Priorities with cells: see outputQueue.c */
   BurstStat burstinessStats;	/* Burstiness statistics for this buffer */
 } OutputBuffer;
 
+/* Link from a switch output to an input of another switch: see topology.c */
+typedef struct {
+  int toSwitch;
+  int toInput;
+  int delay;		/* Cell times to cross the link, at least 1. */
+  Cell **line;		/* Delay line: the cell due at time t is in */
+			/* line[t % delay].			    */
+} Link;
+
 /* Structure of a switch */
 typedef struct {
   int switchNumber;	 /* Unique switch identifier. 		*/
@@ -176,12 +237,21 @@ typedef struct {
   Scheduler   scheduler;		 /* Scheduling Algorithm. 			*/
   Fabric		fabric;
   OutputBuffer **outputBuffer; /* numOutput Output buffers.		*/
+  BitsetWord *outputsPending;	 /* Outputs with cells queued.		*/
+  double *trafficMatrix;	 /* numOutputs values per input, from  */
+				 /* the config's TrafficMatrix or NULL */
+  Link **outputLink;	 /* Per output: link onward, or NULL.	*/
+  int *address;		 /* Network address of each VCI its traffic */
+			 /* uses; NULL: the output of that number.  */
+  int *route;		 /* Output for each network address; NULL:  */
+			 /* not in a network (see topology.c).	    */
 
   /******************************************************/
   /* Actions for cells entering and exiting from switch */
   /******************************************************/
   Cell * (*inputAction)();	/* Action for adding cells to input. */
   void *inputActionState; /* Action dependent state for this switch. */
+  ArrivalBatch arrivals;  /* New cells not yet seen by the input action. */
   void (*outputAction)();	/* Action for removing cells from output */
   void *outputActionState;/* Action dependent state for this switch. */
   